@@ -49,6 +49,36 @@ if test "${ginac_cv_std_cxx_headers}" != "yes"; then
 fi
 ])
 
+dnl Usage: GINAC_CXX11
+dnl Make sure the compiler accepts C++11 (rvalue references, std::move and
+dnl std::unique_ptr), adding -std=c++11 to CXXFLAGS if necessary.
+m4_define([_GINAC_CXX11_PROGRAM], [AC_LANG_PROGRAM([[
+	#include <memory>
+	#include <utility>
+	#include <vector>
+	]], [[
+	std::vector<int> v(3);
+	std::vector<int> && r = std::move(v);
+	std::unique_ptr<int> p(new int(r.size()));
+	return *p != 3;
+	]])])
+AC_DEFUN([GINAC_CXX11], [
+AC_LANG_PUSH([C++])
+AC_MSG_CHECKING([whether $CXX supports C++11])
+AC_COMPILE_IFELSE([_GINAC_CXX11_PROGRAM],
+	[AC_MSG_RESULT([yes])],
+	[AC_MSG_RESULT([no])
+	 ginac_save_CXXFLAGS="$CXXFLAGS"
+	 CXXFLAGS="$CXXFLAGS -std=c++11"
+	 AC_MSG_CHECKING([whether $CXX supports C++11 with -std=c++11])
+	 AC_COMPILE_IFELSE([_GINAC_CXX11_PROGRAM],
+		[AC_MSG_RESULT([yes])],
+		[AC_MSG_RESULT([no])
+		 CXXFLAGS="$ginac_save_CXXFLAGS"
+		 AC_MSG_ERROR([GiNaC needs a C++11 compiler])])])
+AC_LANG_POP([C++])
+])
+
 dnl Usage: GINAC_LIBREADLINE
 dnl
 dnl Check if GNU readline library and headers are avialable.
@@ -234,3 +264,38 @@ fi
 AC_SUBST(DL_LIBS)
 AC_SUBST(CONFIG_EXCOMPILER)])
 
+
+dnl Usage: GINAC_THREAD_SAFE
+dnl - Allows user to build a library whose expressions may be shared between
+dnl   threads (atomic reference counting and hash value caching)
+dnl Sets GINACLIB_CPPFLAGS, PTHREAD_LIBS and CONFIG_THREAD_SAFE variables.
+AC_DEFUN([GINAC_THREAD_SAFE], [
+CONFIG_THREAD_SAFE=no
+GINACLIB_CPPFLAGS=""
+PTHREAD_LIBS=""
+
+AC_ARG_ENABLE([thread-safe],
+	[AS_HELP_STRING([--enable-thread-safe], [Make reference counting thread-safe (default: no)])],
+	[if test "$enableval" = "yes"; then
+		CONFIG_THREAD_SAFE="yes"
+	fi],
+	[CONFIG_THREAD_SAFE="no"])
+
+if test "$CONFIG_THREAD_SAFE" = "yes"; then
+	AC_MSG_CHECKING([for atomic builtins])
+	AC_LINK_IFELSE([AC_LANG_PROGRAM([[unsigned v = 0;]],
+		[[__atomic_add_fetch(&v, 1, __ATOMIC_RELAXED);
+		  __atomic_fetch_or(&v, 2, __ATOMIC_ACQ_REL);
+		  return __atomic_load_n(&v, __ATOMIC_ACQUIRE) != 3;]])],
+		[AC_MSG_RESULT([yes])],
+		[AC_MSG_RESULT([no])
+		 AC_MSG_ERROR([--enable-thread-safe requires a compiler with __atomic builtins (GCC >= 4.7)])])
+	AC_CHECK_HEADER([pthread.h], [],
+		[AC_MSG_ERROR([--enable-thread-safe requires pthread.h])])
+	AC_CHECK_LIB(pthread, pthread_create, [PTHREAD_LIBS="-lpthread"])
+	GINACLIB_CPPFLAGS="-DGINAC_THREAD_SAFE"
+	CPPFLAGS="$CPPFLAGS $GINACLIB_CPPFLAGS"
+fi
+AC_SUBST(GINACLIB_CPPFLAGS)
+AC_SUBST(PTHREAD_LIBS)
+AC_SUBST(CONFIG_THREAD_SAFE)])
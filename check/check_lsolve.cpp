@@ -164,6 +164,60 @@ static unsigned check_inifcns_lsolve(unsigned n)
 	return result;
 }
 
+/* Large sparse systems are eliminated with Markowitz pivoting on compressed
+ * rows.  The equations have a dominant diagonal element, some of them a
+ * coefficient depending on d.  With underdetermined, the last equation is
+ * dropped, with inconsistent, it is repeated with a different constant. */
+static unsigned check_sparse_lsolve(unsigned n, bool underdetermined, bool inconsistent)
+{
+	const symbol d("d");
+	vector<symbol> x;
+	for (unsigned i=0; i<n; ++i) {
+		ostringstream buf;
+		buf << "x" << i;
+		x.push_back(symbol(buf.str()));
+	}
+	lst eqns, vars;
+	for (unsigned i=0; i<n; ++i) {
+		ex lhs = (rand()%11+20)*x[i];
+		if (i%7 == 0)
+			lhs += d*x[i]/(d+1);
+		for (unsigned k=0; k<3; ++k)
+			lhs += numeric(rand()%7-3, rand()%2+1)*x[rand()%n];
+		ex rhs = rand()%21-10;
+		if (i%5 == 0)
+			rhs += d;
+		if (i+1 < n || !underdetermined)
+			eqns.append(lhs==rhs);
+		if (i+1 == n && inconsistent)
+			eqns.append(lhs==rhs+1);
+		vars.append(x[i]);
+	}
+	
+	const ex sol = lsolve(eqns, vars);
+	if (inconsistent) {
+		if (sol.nops() != 0) {
+			clog << "inconsistent sparse system of size " << n
+			     << " erroneously returned " << sol << endl;
+			return 1;
+		}
+		return 0;
+	}
+	if (sol.nops() != n) {
+		clog << "solution of sparse system of size " << n
+		     << " was not found" << endl;
+		return 1;
+	}
+	for (size_t i=0; i<eqns.nops(); ++i) {
+		if (!normal(eqns.op(i).lhs().subs(sol) - eqns.op(i).rhs()).is_zero()) {
+			clog << "solution of sparse system of size " << n
+			     << " does not satisfy equation " << eqns.op(i) << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
 unsigned check_lsolve()
 {
 	unsigned result = 0;
@@ -197,6 +251,11 @@ unsigned check_lsolve()
 	result += check_inifcns_lsolve(4);  cout << '.' << flush;
 	result += check_inifcns_lsolve(5);  cout << '.' << flush;
 	result += check_inifcns_lsolve(6);  cout << '.' << flush;
+	
+	// check the sparse code path of lsolve
+	result += check_sparse_lsolve(100, false, false);  cout << '.' << flush;
+	result += check_sparse_lsolve(100, true, false);  cout << '.' << flush;
+	result += check_sparse_lsolve(100, false, true);  cout << '.' << flush;
 		
 	return result;
 }
@@ -27,6 +27,7 @@ using namespace GiNaC;
 
 #include <cstdlib> // for rand(), RAND_MAX
 #include <iostream>
+#include <stdexcept>
 using namespace std;
 
 extern const ex 
@@ -153,18 +154,217 @@ static unsigned compare_matrix_determinants()
 		ex det_laplace = A.determinant(determinant_algo::laplace);
 		ex det_divfree = A.determinant(determinant_algo::divfree);
 		ex det_bareiss = A.determinant(determinant_algo::bareiss);
+		ex det_interpolation = A.determinant(determinant_algo::interpolation);
 		if ((det_gauss-det_laplace).normal() != 0 ||
 			(det_bareiss-det_laplace).normal() != 0 ||
-			(det_divfree-det_laplace).normal() != 0) {
+			(det_divfree-det_laplace).normal() != 0 ||
+			(det_interpolation-det_laplace).normal() != 0) {
 			clog << "Determinant of " << size << "x" << size << " matrix "
 			     << endl << A << endl
 			     << "is inconsistent between different algorithms:" << endl
 			     << "Gauss elimination:   " << det_gauss << endl
 			     << "Minor elimination:   " << det_laplace << endl
 			     << "Division-free elim.: " << det_divfree << endl
+			     << "Fraction-free elim.: " << det_bareiss << endl
+			     << "Interpolation:       " << det_interpolation << endl;
+			++result;
+		}
+	}
+	
+	return result;
+}
+
+/* Determinants of matrices of polynomials in several variables with large
+ * rational coefficients, computed by interpolation and by minor expansion. */
+static unsigned polynomial_matrix_determinants()
+{
+	unsigned result = 0;
+	symbol a("a"), b("b"), c("c");
+	
+	for (unsigned size=2; size<7; ++size) {
+		matrix A(size,size);
+		for (unsigned ro=0; ro<size; ++ro) {
+			for (unsigned co=0; co<size; ++co) {
+				ex elem = 0;
+				for (unsigned t=0; t<3; ++t)
+					elem += numeric(rand()%2000001-1000000, rand()%4+1)
+					      * pow(a,rand()%3) * pow(b-c,rand()%3) * pow(c,rand()%2);
+				A.set(ro,co,elem);
+			}
+		}
+		// make the last matrix singular
+		if (size == 6)
+			for (unsigned co=0; co<size; ++co)
+				A.set(size-1,co,(a*A(0,co)-b*A(1,co)).expand());
+		
+		ex det_interpolation = A.determinant(determinant_algo::interpolation);
+		ex det_laplace = A.determinant(determinant_algo::laplace);
+		if ((det_interpolation-det_laplace).expand() != 0) {
+			clog << "Determinant of " << size << "x" << size << " matrix "
+			     << endl << A << endl
+			     << "is inconsistent between different algorithms:" << endl
+			     << "Interpolation:       " << det_interpolation << endl
+			     << "Minor elimination:   " << det_laplace << endl;
+			++result;
+		}
+	}
+	
+	// Functions of the variables pass as polynomials but must not be
+	// interpolated as constants.
+	for (unsigned size=4; size<7; ++size) {
+		matrix A(size,size);
+		for (unsigned ro=0; ro<size; ++ro)
+			for (unsigned co=0; co<size; ++co)
+				A.set(ro,co,pow(a,(ro*co)%3) + numeric(rand()%21-10)*b
+				            + (ro == co ? conjugate(a) : (ro+1 == co ? real_part(c) : imag_part(c))));
+		ex det_auto = A.determinant();
+		ex det_interpolation = A.determinant(determinant_algo::interpolation);
+		ex det_laplace = A.determinant(determinant_algo::laplace);
+		if ((det_auto-det_laplace).expand() != 0 || (det_interpolation-det_laplace).expand() != 0) {
+			clog << "Determinant of " << size << "x" << size << " matrix "
+			     << endl << A << endl
+			     << "is inconsistent between different algorithms:" << endl
+			     << "automatic:           " << det_auto << endl
+			     << "Interpolation:       " << det_interpolation << endl
+			     << "Minor elimination:   " << det_laplace << endl;
+			++result;
+		}
+	}
+	
+	return result;
+}
+
+/* Determinants, inverses and solutions of matrices of rational and complex
+ * rational numbers, compared with the general algorithms. */
+static unsigned numeric_matrices()
+{
+	unsigned result = 0;
+	
+	for (unsigned size=2; size<10; ++size) {
+		matrix A(size,size), B(size,1), X(size,1);
+		const bool complex = size%3 == 0;
+		for (unsigned ro=0; ro<size; ++ro) {
+			for (unsigned co=0; co<size; ++co) {
+				if (rand()%4 != 0) {
+					numeric elem(rand()%201-100, rand()%5+1);
+					if (complex)
+						elem += I*numeric(rand()%21-10, rand()%3+1);
+					A.set(ro,co,elem);
+				}
+			}
+			B.set(ro,0,numeric(rand()%21-10));
+			X.set(ro,0,symbol());
+		}
+		// make every third matrix singular
+		if (size%3 == 1)
+			for (unsigned co=0; co<size; ++co)
+				A.set(size-1,co,A(0,co)-2*A(1,co));
+		
+		ex det_auto = A.determinant();
+		ex det_laplace = A.determinant(determinant_algo::laplace);
+		ex det_divfree = A.determinant(determinant_algo::divfree);
+		if (det_auto != det_laplace || det_auto != det_divfree) {
+			clog << "Determinant of " << size << "x" << size << " matrix "
+			     << endl << A << endl
+			     << "is inconsistent between different algorithms:" << endl
+			     << "automatic:           " << det_auto << endl
+			     << "Minor elimination:   " << det_laplace << endl
+			     << "Division-free elim.: " << det_divfree << endl;
+			++result;
+		}
+		
+		if (det_auto.is_zero()) {
+			if (A.rank() == size) {
+				clog << "Rank of singular " << size << "x" << size << " matrix "
+				     << endl << A << endl << "was found to be " << size << endl;
+				++result;
+			}
+			continue;
+		}
+		
+		matrix inv = A.inverse();
+		if (!(A.mul(inv) - ex_to<matrix>(unit_matrix(size))).is_zero_matrix()) {
+			clog << "Inverse of " << size << "x" << size << " matrix "
+			     << endl << A << endl << "erroneously returned " << inv << endl;
+			++result;
+		}
+		
+		matrix sol = A.solve(X, B);
+		matrix sol_divfree = A.solve(X, B, solve_algo::divfree);
+		if (!(sol - sol_divfree).is_zero_matrix() || !(inv.mul(B) - sol).is_zero_matrix()) {
+			clog << "Solution of " << size << "x" << size << " system "
+			     << endl << A << endl << "with right hand side " << B << endl
+			     << "is inconsistent between different algorithms:" << endl
+			     << "automatic:           " << sol << endl
+			     << "Division-free elim.: " << sol_divfree << endl;
+			++result;
+		}
+	}
+	
+	return result;
+}
+
+/* Large matrices of rational numbers are handled by multi-modular
+ * algorithms, compare them with Bareiss elimination. */
+static unsigned modular_matrices()
+{
+	unsigned result = 0;
+	
+	for (unsigned size=20; size<=30; size+=5) {
+		matrix A(size,size), B(size,2), X(size,2);
+		for (unsigned ro=0; ro<size; ++ro) {
+			for (unsigned co=0; co<size; ++co)
+				if (rand()%3 != 0)
+					A.set(ro,co,numeric(rand()%20001-10000, rand()%3+1));
+			B.set(ro,0,numeric(rand()%201-100));
+			B.set(ro,1,numeric(rand()%201-100, 7));
+			X.set(ro,0,symbol());
+			X.set(ro,1,symbol());
+		}
+		// make the last matrix singular
+		if (size == 30)
+			for (unsigned co=0; co<size; ++co)
+				A.set(size-1,co,3*A(0,co)-A(1,co));
+		
+		ex det_auto = A.determinant();
+		ex det_bareiss = A.determinant(determinant_algo::bareiss);
+		if (det_auto != det_bareiss) {
+			clog << "Determinant of " << size << "x" << size << " matrix "
+			     << endl << A << endl
+			     << "is inconsistent between different algorithms:" << endl
+			     << "automatic:           " << det_auto << endl
 			     << "Fraction-free elim.: " << det_bareiss << endl;
 			++result;
 		}
+		
+		if (det_auto.is_zero()) {
+			try {
+				A.inverse();
+				clog << "Inverse of singular " << size << "x" << size << " matrix "
+				     << endl << A << endl << "did not throw" << endl;
+				++result;
+			} catch (const std::runtime_error &) {
+			}
+			continue;
+		}
+		
+		matrix sol = A.solve(X, B);
+		matrix sol_bareiss = A.solve(X, B, solve_algo::bareiss);
+		if (!(sol - sol_bareiss).is_zero_matrix() || !(A.mul(sol) - B).is_zero_matrix()) {
+			clog << "Solution of " << size << "x" << size << " system "
+			     << endl << A << endl << "with right hand side " << B << endl
+			     << "is inconsistent between different algorithms:" << endl
+			     << "automatic:           " << sol << endl
+			     << "Fraction-free elim.: " << sol_bareiss << endl;
+			++result;
+		}
+		
+		matrix inv = A.inverse();
+		if (!(A.mul(inv) - ex_to<matrix>(unit_matrix(size))).is_zero_matrix()) {
+			clog << "Inverse of " << size << "x" << size << " matrix "
+			     << endl << A << endl << "erroneously returned " << inv << endl;
+			++result;
+		}
 	}
 	
 	return result;
@@ -217,6 +417,9 @@ unsigned check_matrices()
 	result += rational_matrix_determinants();  cout << '.' << flush;
 	result += funny_matrix_determinants();  cout << '.' << flush;
 	result += compare_matrix_determinants();  cout << '.' << flush;
+	result += polynomial_matrix_determinants();  cout << '.' << flush;
+	result += numeric_matrices();  cout << '.' << flush;
+	result += modular_matrices();  cout << '.' << flush;
 	result += symbolic_matrix_inverse();  cout << '.' << flush;
 	
 	return result;
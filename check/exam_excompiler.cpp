@@ -0,0 +1,192 @@
+/** @file exam_excompiler.cpp
+ *
+ *  Checks for the built-in code generator of compile_ex: the machine code
+ *  for all three function signatures must agree with evalf(). */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "excompiler_jit.h"
+using namespace GiNaC;
+
+#include <cmath>
+#include <iostream>
+using namespace std;
+
+// The code generator is only available on x86-64; elsewhere jit_compile
+// returns NULL and there is nothing to check.
+#if defined(__x86_64__) && !defined(_WIN32)
+static const bool jit_available = true;
+#else
+static const bool jit_available = false;
+#endif
+
+static const double xs[] = { 0.3, 1.7 };
+static const double ys[] = { 0.6, 2.2 };
+static const double zs[] = { -0.8, 1.1 };
+
+static double reference(const ex & e, const lst & subs)
+{
+	return ex_to<numeric>(e.subs(subs).evalf()).to_double();
+}
+
+static bool close(double val, double ref)
+{
+	return std::fabs(val - ref) <= 1e-12 * (1 + std::fabs(ref));
+}
+
+/* Compile exprs with the code generator.  Returns NULL (counting a failure
+ * if the code generator is available) if this is not possible. */
+static void *compile(const lst & exprs, const lst & params, jit_signature sig, unsigned & result)
+{
+	void *code = jit_compile(exvector(exprs.begin(), exprs.end()),
+	                         exvector(params.begin(), params.end()), sig);
+	if (code == NULL && jit_available) {
+		clog << "code generator failed on " << exprs << endl;
+		++result;
+	}
+	return code;
+}
+
+/* Release the code with unlink_ex, which must free it. */
+template<class FUNCP>
+static void release(FUNCP fp, unsigned & result)
+{
+	unlink_ex(fp);
+	// This is not standard compliant! ... no conversion between
+	// pointer-to-functions and pointer-to-objects ...
+	if (jit_release((void *) fp)) {
+		clog << "unlink_ex did not release the generated code" << endl;
+		++result;
+	}
+}
+
+static unsigned exam_excompiler_1p()
+{
+	unsigned result = 0;
+	const symbol x("x");
+	const ex exprs[] = {
+		pow(x, -3) + 2*pow(x, -1) - pow(1 + x, -2),
+		Pi*x + Euler/x + Catalan*pow(x, 2),
+		sqrt(x)*exp(-x) - pow(x, numeric(-1, 2)) + atan2(x, 1 - x)
+	};
+
+	for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); ++i) {
+		FUNCP_1P fp = (FUNCP_1P) compile(lst(exprs[i]), lst(x), jit_1p, result);
+		if (fp == NULL)
+			continue;
+		for (size_t j = 0; j < sizeof(xs) / sizeof(xs[0]); ++j) {
+			const double ref = reference(exprs[i], lst(x == xs[j]));
+			const double val = fp(xs[j]);
+			if (!close(val, ref)) {
+				clog << "compiled " << exprs[i] << " at x==" << xs[j]
+				     << " erroneously returned " << val << " instead of " << ref << endl;
+				++result;
+			}
+		}
+		release(fp, result);
+	}
+	return result;
+}
+
+static unsigned exam_excompiler_2p()
+{
+	unsigned result = 0;
+	const symbol x("x"), y("y");
+	const ex exprs[] = {
+		pow(x - y, -2) + x*pow(y, -3),
+		Pi/y - Catalan*pow(y, -4),  // the first parameter is unused
+		atan2(y, x)*log(x + y) + Euler*pow(x*y, 3)
+	};
+
+	for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); ++i) {
+		FUNCP_2P fp = (FUNCP_2P) compile(lst(exprs[i]), lst(x, y), jit_2p, result);
+		if (fp == NULL)
+			continue;
+		for (size_t j = 0; j < sizeof(xs) / sizeof(xs[0]); ++j) {
+			for (size_t k = 0; k < sizeof(ys) / sizeof(ys[0]); ++k) {
+				const double ref = reference(exprs[i], lst(x == xs[j], y == ys[k]));
+				const double val = fp(xs[j], ys[k]);
+				if (!close(val, ref)) {
+					clog << "compiled " << exprs[i] << " at x==" << xs[j] << ", y==" << ys[k]
+					     << " erroneously returned " << val << " instead of " << ref << endl;
+					++result;
+				}
+			}
+		}
+		release(fp, result);
+	}
+	return result;
+}
+
+static unsigned exam_excompiler_cuba()
+{
+	unsigned result = 0;
+	const symbol x("x"), y("y"), z("z");
+	const lst params(x, y, z);
+	const lst exprs(pow(x + y*z, -1) - 3*pow(z, -2),
+	                Pi + Euler*Catalan,  // constant
+	                sqrt(x*y)*pow(z, 5),
+	                cos(z)/z,  // only the last parameter
+	                pow(x, -4)*atan2(z, y) + sin(x*y*z));
+	const int ndim = params.nops();
+	const int ncomp = exprs.nops();
+
+	FUNCP_CUBA fp = (FUNCP_CUBA) compile(exprs, params, jit_cuba, result);
+	if (fp == NULL)
+		return result;
+	for (size_t i = 0; i < sizeof(xs) / sizeof(xs[0]); ++i) {
+		for (size_t j = 0; j < sizeof(ys) / sizeof(ys[0]); ++j) {
+			for (size_t k = 0; k < sizeof(zs) / sizeof(zs[0]); ++k) {
+				const double a[] = { xs[i], ys[j], zs[k] };
+				double f[5];
+				fp(&ndim, a, &ncomp, f);
+				for (int n = 0; n < ncomp; ++n) {
+					const double ref = reference(exprs.op(n), lst(x == a[0], y == a[1], z == a[2]));
+					if (!close(f[n], ref)) {
+						clog << "compiled " << exprs.op(n) << " at x==" << a[0] << ", y==" << a[1]
+						     << ", z==" << a[2] << " erroneously returned " << f[n]
+						     << " instead of " << ref << endl;
+						++result;
+					}
+				}
+			}
+		}
+	}
+	release(fp, result);
+	return result;
+}
+
+unsigned exam_excompiler()
+{
+	unsigned result = 0;
+
+	cout << "examining built-in code generator of compile_ex" << flush;
+
+	result += exam_excompiler_1p();  cout << '.' << flush;
+	result += exam_excompiler_2p();  cout << '.' << flush;
+	result += exam_excompiler_cuba();  cout << '.' << flush;
+
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	return exam_excompiler();
+}
@@ -211,6 +211,38 @@ static unsigned factor_integer_content_bug()
 	return check_factorization(factors);
 }
 
+/* Swinnerton-Dyer polynomial of the first n primes, the product of the
+ * x + s_1*sqrt(2) + ... + s_n*sqrt(p_n) for all signs s_i. It is irreducible,
+ * but splits into factors of degree at most 2 modulo every prime. */
+static ex swinnerton_dyer(const symbol& x, unsigned n)
+{
+	static const int primes[] = { 2, 3, 5, 7, 11 };
+	ex e = x;
+	for (unsigned i = 0; i < n; ++i) {
+		const ex s = sqrt(numeric(primes[i]));
+		e = expand(e.subs(x == x + s).expand() * e.subs(x == x - s).expand());
+	}
+	return e;
+}
+
+/* Many modular factors are recombined by lattice reduction. */
+static unsigned exam_factor_swinnerton_dyer()
+{
+	unsigned result = 0;
+	const symbol x("x");
+
+	result += check_factor(swinnerton_dyer(x, 4));
+	result += check_factor(swinnerton_dyer(x, 5));
+
+	exvector factors;
+	factors.push_back(swinnerton_dyer(x, 3));
+	factors.push_back(swinnerton_dyer(x, 4));
+	factors.push_back(expand(pow(x, 2) + 3));
+	result += check_factorization(factors);
+
+	return result;
+}
+
 unsigned exam_factor()
 {
 	unsigned result = 0;
@@ -222,6 +254,8 @@ unsigned exam_factor()
 	result += exam_factor3(); cout << '.' << flush;
 	result += factor_integer_content_bug();
 	cout << '.' << flush;
+	result += exam_factor_swinnerton_dyer();
+	cout << '.' << flush;
 
 	return result;
 }
@@ -25,6 +25,8 @@
 using namespace GiNaC;
 
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 using namespace std;
 
 /* Assorted tests on other transcendental functions. */
@@ -343,6 +345,49 @@ static unsigned inifcns_consist_various()
 	return result;
 }
 
+/* lsolve() must reject nonlinear systems on the sparse path also when the
+ * unknowns are realsymbols or possymbols. */
+static unsigned inifcns_consist_lsolve()
+{
+	unsigned result = 0;
+	const unsigned n = 40;
+	lst vars, eqns;
+	for (unsigned i=0; i<n; ++i) {
+		ostringstream name;
+		name << "x" << i;
+		if (i % 2)
+			vars.append(possymbol(name.str()));
+		else
+			vars.append(realsymbol(name.str()));
+	}
+	for (unsigned i=0; i+1<n; ++i)
+		eqns.append(vars.op(i) - vars.op(i+1) == i);
+	lst linear = eqns, product = eqns, square = eqns;
+	linear.append(vars.op(n-1) + vars.op(0) == 1);
+	product.append(vars.op(n-1) + vars.op(0)*vars.op(1) == 1);
+	square.append(vars.op(n-1) + pow(vars.op(0), 2) == 1);
+
+	const ex sol = lsolve(linear, vars);
+	if (sol.nops() != n || !(vars.op(0) - vars.op(n-1)).subs(sol).is_equal(numeric((n-1)*(n-2), 2))) {
+		clog << "lsolve() of a linear system in " << n << " realsymbols erroneously returned " << sol << endl;
+		++result;
+	}
+
+	const lst nonlinear[] = { product, square };
+	for (unsigned k=0; k<2; ++k) {
+		try {
+			const ex wrong = lsolve(nonlinear[k], vars);
+			clog << "lsolve() of the nonlinear system " << nonlinear[k].op(n-1)
+			     << ",... erroneously returned " << wrong << endl;
+			++result;
+		} catch (const std::logic_error & e) {
+			// expected
+		}
+	}
+
+	return result;
+}
+
 unsigned exam_inifcns()
 {
 	unsigned result = 0;
@@ -357,6 +402,7 @@ unsigned exam_inifcns()
 	result += inifcns_consist_exp();  cout << '.' << flush;
 	result += inifcns_consist_log();  cout << '.' << flush;
 	result += inifcns_consist_various();  cout << '.' << flush;
+	result += inifcns_consist_lsolve();  cout << '.' << flush;
 	
 	return result;
 }
@@ -393,6 +393,84 @@ static unsigned check_G_y_one_bug()
 	return err;
 }
 
+// compares results of the batched evaluation with those of evalf()
+// The reference values are computed one by one, each with freshly computed
+// transformations, so that a transformation wrongly reused for another point
+// shows up as a difference.
+static unsigned compare_batch(const exvector& exprs, const exvector& batch, const ex& prec)
+{
+	unsigned result = 0;
+	for (size_t i = 0; i < exprs.size(); ++i) {
+		clear_polylog_transformations();
+		const ex scalar = exprs[i].evalf();
+		bool differs;
+		if (is_a<numeric>(scalar)) {
+			differs = abs(batch[i] - scalar) > prec;
+		} else {
+			differs = !batch[i].is_equal(scalar);
+		}
+		if (differs) {
+			clog << "batched evaluation of " << exprs[i] << " gave " << batch[i]
+			     << " instead of " << scalar << endl;
+			result++;
+		}
+	}
+	return result;
+}
+
+static unsigned check_evalf_batch()
+{
+	unsigned result = 0;
+	const symbol x("x");
+
+	exvector points;
+	points.push_back(numeric(1, 3));
+	points.push_back(numeric(-3, 10));
+	points.push_back(numeric(98, 100));
+	points.push_back(numeric(245, 100));
+	points.push_back(numeric(-3, 2));
+	points.push_back(numeric(5.0) - numeric(5.0)*I);
+	points.push_back(numeric(0.5) + numeric(1.5)*I);
+	points.push_back(x);
+
+	// the same function families at all points
+	const ex Hm = lst(2, 1, -1, 1);
+	const ex Lim = lst(2, 1, 1);
+	const int Sn[] = { 2, 1, 3, 1 }, Sp[] = { 2, 3, 1, 1 };
+	const size_t Sfamilies = sizeof(Sn) / sizeof(Sn[0]);
+	exvector Hexprs, Sexprs[Sfamilies], Lix, Liexprs, Ga, Gy, Gexprs, G3exprs;
+	for (size_t i = 0; i < points.size(); ++i) {
+		Hexprs.push_back(H(Hm, points[i]));
+		for (size_t f = 0; f < Sfamilies; ++f)
+			Sexprs[f].push_back(S(Sn[f], Sp[f], points[i]));
+		Lix.push_back(lst(points[i], numeric(3, 4), -numeric(int(i) + 1, 5)));
+		Liexprs.push_back(Li(Lim, Lix.back()));
+		Ga.push_back(lst(numeric(int(i) + 1, 3), -numeric(1, 2), 0, numeric(7, 4)));
+		Gy.push_back(numeric(int(i) + 2, 4));
+		Gexprs.push_back(G(Ga.back(), Gy.back()));
+		G3exprs.push_back(G(Ga.back(), lst(1, -1, 1, 1), Gy.back()));
+	}
+
+	const int digitsbuf = Digits;
+	for (int digits = 17; digits <= 30; digits += 13) {
+		digits_guard guard(digits);
+		const ex prec = 5 * pow(10, 2 - digits);
+		result += compare_batch(Hexprs, H_evalf_batch(Hm, points), prec);
+		for (size_t f = 0; f < Sfamilies; ++f)
+			result += compare_batch(Sexprs[f], S_evalf_batch(Sn[f], Sp[f], points), prec);
+		result += compare_batch(Liexprs, Li_evalf_batch(Lim, Lix), prec);
+		result += compare_batch(Gexprs, G_evalf_batch(Ga, Gy), prec);
+		result += compare_batch(G3exprs, G_evalf_batch(Ga, lst(1, -1, 1, 1), Gy), prec);
+		cout << "." << flush;
+	}
+	if (Digits != digitsbuf) {
+		clog << "batched evaluation changed Digits to " << Digits << endl;
+		result++;
+	}
+
+	return result;
+}
+
 unsigned exam_inifcns_nstdsums(void)
 {
 	unsigned result = 0;
@@ -405,6 +483,7 @@ unsigned exam_inifcns_nstdsums(void)
 	result += inifcns_test_LiG();
 	result += inifcns_test_legacy();
 	result += check_G_y_one_bug();
+	result += check_evalf_batch();
 	
 	return result;
 }
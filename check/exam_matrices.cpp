@@ -36,6 +36,20 @@ static unsigned matrix_determinants()
 	symbol d("d"), e("e"), f("f");
 	symbol g("g"), h("h"), i("i");
 	
+	// check determinant of empty matrix
+	const matrix m0(0,0);
+	const unsigned algos[] = { determinant_algo::automatic,
+	                           determinant_algo::gauss,
+	                           determinant_algo::bareiss };
+	for (size_t k = 0; k < sizeof(algos)/sizeof(algos[0]); ++k) {
+		det = m0.determinant(algos[k]);
+		if (det != 1) {
+			clog << "determinant of 0x0 matrix with algorithm " << algos[k]
+			     << " erroneously returned " << det << endl;
+			++result;
+		}
+	}
+	
 	// check symbolic trivial matrix determinant
 	m1.set(0,0,a);
 	det = m1.determinant();
@@ -318,6 +332,19 @@ static unsigned matrix_misc()
 		++result;
 	}
 	
+	// products with an empty dimension
+	matrix m6 = matrix(2,0).mul(matrix(0,3));
+	if (m6.rows() != 2 || m6.cols() != 3 || !m6.is_zero_matrix()) {
+		clog << "product of 2x0 and 0x3 matrices erroneously returned " << m6 << endl;
+		++result;
+	}
+	m6 = m3.mul(matrix(2,0));
+	if (m6.rows() != 3 || m6.cols() != 0) {
+		clog << "product of 3x2 and 2x0 matrices erroneously returned a "
+		     << m6.rows() << "x" << m6.cols() << " matrix" << endl;
+		++result;
+	}
+	
 	// produce a runtime-error by inverting a singular matrix and catch it
 	matrix m4(2,2);
 	matrix m5;
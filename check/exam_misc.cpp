@@ -24,6 +24,8 @@
 using namespace GiNaC;
 
 #include <iostream>
+#include <sstream>
+#include <utility>
 using namespace std;
 
 #define VECSIZE 30
@@ -89,6 +91,247 @@ static unsigned exam_expand_power()
 	return result;
 }
 
+/* Expanding products of polynomials over Q takes a shortcut through a sparse
+ * distributed representation.  Check it against the generic expansion, which
+ * is forced by disguising x as a function. */
+static unsigned exam_expand_sparse()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y"), z("z"), t("t");
+	ex e, e1, e2, q;
+
+	e = pow(x/2+y-3, 5) * pow(x-y/3+z+1, 4) * (x*y*z-numeric(2,7));
+	e1 = e.expand();
+	e2 = e.subs(x == sin(t)).expand().subs(sin(t) == x);
+	if (!e1.is_equal(e2)) {
+		clog << "expand(" << e << ") erroneously returned " << e1
+		     << " instead of " << e2 << endl;
+		++result;
+	}
+
+	// Exponents too large to be packed into a machine word
+	e = (x+y)*pow(x, 100000000);
+	e1 = e.expand();
+	if (!e1.is_equal(pow(x, 100000001) + y*pow(x, 100000000))) {
+		clog << "expand(" << e << ") erroneously returned " << e1 << endl;
+		++result;
+	}
+
+	// Exact division
+	e = pow(x/2+y-3, 5) * pow(x-y/3+z+1, 4);
+	if (!divide(e.expand(), pow(x-y/3+z+1, 2).expand(), q) ||
+	    !(q - pow(x/2+y-3, 5) * pow(x-y/3+z+1, 2)).expand().is_zero()) {
+		clog << "divide(" << e << ", " << pow(x-y/3+z+1, 2)
+		     << ") erroneously returned " << q << endl;
+		++result;
+	}
+	if (divide(e.expand() + 1, (x-y/3+z+1).expand(), q)) {
+		clog << "divide(" << e << "+1, " << x-y/3+z+1
+		     << ") erroneously returned " << q << endl;
+		++result;
+	}
+
+	return result;
+}
+
+static unsigned exam_hash_consing()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y");
+
+	const ex reference = diff(exp(sin(x*y) + pow(x+y, 3)), x, 4);
+	const size_t before = hash_consing_table_size();
+	set_hash_consing(true);
+	{
+		const ex e = diff(exp(sin(x*y) + pow(x+y, 3)), x, 4);
+		if (!e.is_equal(reference)) {
+			clog << "differentiation with hash-consing erroneously returned "
+			     << e << " instead of " << reference << endl;
+			++result;
+		}
+		const size_t n = hash_consing_table_size();
+		const ex e2 = diff(exp(sin(x*y) + pow(x+y, 3)), x, 4);
+		if (hash_consing_table_size() != n) {
+			clog << "recomputing an expression added "
+			     << hash_consing_table_size() - n
+			     << " objects to the hash-consing table" << endl;
+			++result;
+		}
+	}
+	set_hash_consing(false);
+	if (hash_consing_table_size() != before) {
+		clog << "hash-consing table still contains "
+		     << hash_consing_table_size() - before
+		     << " deleted objects" << endl;
+		++result;
+	}
+
+	return result;
+}
+
+/* Sums and products with many operands combine their terms with a hash
+ * table.  Make sure the result is the same as when they are built up one
+ * term at a time. */
+static unsigned exam_large_sums()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y");
+
+	// 2*x^i for i<500, minus 2*x^i for i<250, plus y
+	exvector v;
+	for (int i = 0; i < 500; ++i) {
+		v.push_back(pow(x, i));
+		v.push_back(pow(x, 499-i));
+		if (i < 250)
+			v.push_back(-2*pow(x, i));
+	}
+	v.push_back(y);
+	ex reference = y;
+	for (int i = 250; i < 500; ++i)
+		reference += 2*pow(x, i);
+	const ex s = add(v);
+	if (!s.is_equal(reference) || s.nops() != 251) {
+		clog << "sum of " << v.size() << " terms erroneously has "
+		     << s.nops() << " terms" << endl;
+		++result;
+	}
+
+	// a product where combined factors have to be processed further
+	vector<symbol> syms;
+	for (int i = 0; i < 200; ++i)
+		syms.push_back(symbol());
+	exvector f;
+	for (int i = 0; i < 200; ++i) {
+		f.push_back(syms[i]);
+		f.push_back(pow(syms[199-i], 2));
+	}
+	f.push_back(sqrt(ex(2)));
+	f.push_back(sqrt(ex(2)));
+	f.push_back(pow(x*y, numeric(1, 2)));
+	f.push_back(pow(x*y, numeric(1, 2)));
+	ex reference2 = 2*x*y;
+	for (int i = 0; i < 200; ++i)
+		reference2 *= pow(syms[i], 3);
+	const ex p = mul(f);
+	if (!p.is_equal(reference2)) {
+		clog << "product of " << f.size() << " factors erroneously returned "
+		     << p << endl;
+		++result;
+	}
+
+	return result;
+}
+
+static unsigned exam_stats()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y");
+
+	stats::reset();
+	stats::enable();
+	const ex e = expand(pow(x+y, 5) - pow(x-y, 5));
+	stats::disable();
+	const stats::counters c = stats::snapshot();
+	if (c[stats::compares] == 0 || c[stats::evals] == 0 || c[stats::expands] == 0) {
+		clog << "expansion was not counted:" << endl << c;
+		++result;
+	}
+	if (c.allocations.find("add") == c.allocations.end()) {
+		clog << "allocation of sums was not counted:" << endl << c;
+		++result;
+	}
+
+	stats::reset();
+	const ex e2 = expand(pow(x+y, 5) - pow(x-y, 5));
+	const stats::counters c2 = stats::snapshot();
+	for (unsigned i = 0; i < stats::num_events; ++i) {
+		if (c2[stats::event(i)] != 0) {
+			clog << "event \"" << stats::event_name(stats::event(i))
+			     << "\" was counted while counting was off" << endl;
+			++result;
+		}
+	}
+	if (!c2.allocations.empty()) {
+		clog << "allocations were counted while counting was off" << endl;
+		++result;
+	}
+
+	return result;
+}
+
+/* A moved-from expression must still be usable. */
+static unsigned exam_move()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y");
+
+	ex e = pow(x+y, 3);
+	const ex moved(std::move(e));
+	if (!moved.is_equal(pow(x+y, 3))) {
+		clog << "moving pow(x+y,3) gave " << moved << endl;
+		++result;
+	}
+	ostringstream os;
+	os << e;
+	if (!e.is_zero() || e.nops() != 0 || os.str() != "0") {
+		clog << "moved-from expression is " << os.str() << " instead of 0" << endl;
+		++result;
+	}
+
+	ex f = x*y;
+	f = std::move(e);
+	if (!f.is_zero() || !e.is_equal(x*y)) {
+		clog << "move assignment gave " << f << " and left " << e << endl;
+		++result;
+	}
+
+	return result;
+}
+
+static unsigned count_occurrences(const string & s, const string & what)
+{
+	unsigned n = 0;
+	for (size_t pos = s.find(what); pos != string::npos; pos = s.find(what, pos + 1))
+		++n;
+	return n;
+}
+
+static unsigned exam_print_csrc_cse()
+{
+	unsigned result = 0;
+	symbol x("x"), y("y");
+
+	const ex e = pow(x, 7)*sin(y) + cos(pow(x, 7)*sin(y)) + pow(x, 4);
+	ostringstream s;
+	e.print(print_csrc_cse(s, "r"));
+	const string out = s.str();
+	if (count_occurrences(out, "sin(") != 1 || count_occurrences(out, "x*x") != 1
+	 || count_occurrences(out, "double cse") != 3 || out.find("\nr = ") == string::npos) {
+		clog << "print_csrc_cse output of " << e << " is not optimal:" << endl << out;
+		++result;
+	}
+
+	// functions have a print dispatch of their own
+	const ex e1 = cos(pow(x, 2)*sin(x*y) + sin(x*y));
+	ostringstream s1;
+	e1.print(print_csrc_cse(s1, "r"));
+	const string out1 = s1.str();
+	if (count_occurrences(out1, "sin(") != 1 || out1.find("r = cos(") == string::npos) {
+		clog << "print_csrc_cse output of " << e1 << " is wrong:" << endl << out1;
+		++result;
+	}
+
+	ostringstream s2;
+	print_csrc_statements(lst(sin(y), pow(sin(y), 2)), s2, "f");
+	const string out2 = s2.str();
+	if (count_occurrences(out2, "sin(") != 1 || out2.find("f[1] = ") == string::npos) {
+		clog << "print_csrc_statements output of a list is wrong:" << endl << out2;
+		++result;
+	}
+
+	return result;
+}
+
 static unsigned exam_sqrfree()
 {
 	unsigned result = 0;
@@ -307,7 +550,13 @@ unsigned exam_misc()
 	result += exam_expand_subs();  cout << '.' << flush;
 	result += exam_expand_subs2();  cout << '.' << flush;
 	result += exam_expand_power(); cout << '.' << flush;
+	result += exam_expand_sparse(); cout << '.' << flush;
 	result += exam_sqrfree(); cout << '.' << flush;
+	result += exam_hash_consing(); cout << '.' << flush;
+	result += exam_large_sums(); cout << '.' << flush;
+	result += exam_stats(); cout << '.' << flush;
+	result += exam_move(); cout << '.' << flush;
+	result += exam_print_csrc_cse(); cout << '.' << flush;
 	result += exam_operator_semantics(); cout << '.' << flush;
 	result += exam_subs(); cout << '.' << flush;
 	result += exam_joris(); cout << '.' << flush;
@@ -218,6 +218,109 @@ static unsigned exam_content()
 	return result;
 }
 
+/* Large sums of fractions are added over a coprime basis of the
+ * denominators; compare with adding one fraction after the other. */
+static unsigned exam_normal_large_sums()
+{
+	unsigned result = 0;
+	ex e, d;
+
+	// Telescoping sum
+	e = 0;
+	for (int i = 1; i <= 20; ++i)
+		e += 1/((x + i)*(x + i + 1));
+	d = e.normal();
+	if (!(d - 20/((x + 1)*(x + 21))).normal().is_zero() || d.denom().expand().degree(x) != 2) {
+		clog << "normal form of " << e << " erroneously returned " << d << endl;
+		++result;
+	}
+
+	// Denominators with common factors, in varying multiplicities
+	const ex factors[] = { x + y, x - y, x*x - y*y, 2*x + 2*z, pow(x + y, 2), y*z - 1, x*(x + y) };
+	const int nfactors = sizeof(factors) / sizeof(factors[0]);
+	e = 0;
+	ex sum = 0;
+	for (int i = 0; i < 30; ++i) {
+		ex t = (i*x - y + 3)/(factors[i % nfactors] * factors[(i*i + 1) % nfactors]);
+		if (i % 5 == 0)
+			t /= 7;
+		e += t;
+		sum = (sum + t).normal();
+	}
+	d = e.normal();
+	if (!(d - sum).normal().is_zero() ||
+	    d.denom().expand().degree(x) != sum.denom().expand().degree(x) ||
+	    d.numer().expand().degree(x) != sum.numer().expand().degree(x)) {
+		clog << "normal form of " << e << " erroneously returned " << d
+		     << " (should be " << sum << ")" << endl;
+		++result;
+	}
+
+	return result;
+}
+
+static unsigned exam_normal_cache()
+{
+	unsigned result = 0;
+	const size_t capacity = normal_cache::get_capacity();
+
+	ex e;
+	for (int i = 1; i <= 5; ++i)
+		e += (x + i*y)/(x*x - y*y) + 1/(x + y + i);
+	normal_cache::set_capacity(0);
+	ex uncached = e.normal();
+	normal_cache::set_capacity(100);
+	normal_cache::clear();
+	normal_cache::reset_statistics();
+	ex first = e.normal();
+	ex second = e.normal();
+	if (!first.is_equal(uncached) || !second.is_equal(uncached)) {
+		clog << "normal form of " << e << " with cache returned " << first
+		     << " and " << second << " (should be " << uncached << ")" << endl;
+		++result;
+	}
+	normal_cache::statistics s = normal_cache::get_statistics(normal_cache::normal_results);
+	if (s.hits == 0 || s.size == 0) {
+		clog << "normal(): repeated normalization not found in cache: " << s << endl;
+		++result;
+	}
+
+	ex a = expand((x + y)*(x - 2*z)), b = expand((x + y)*(y + z)), ca1, cb1, ca2, cb2;
+	ex g1 = gcd(a, b, &ca1, &cb1);
+	ex g2 = gcd(a, b, &ca2, &cb2);
+	s = normal_cache::get_statistics(normal_cache::gcd_results);
+	if (!g1.is_equal(g2) || !ca1.is_equal(ca2) || !cb1.is_equal(cb2) || s.hits == 0) {
+		clog << "gcd(" << a << ", " << b << ") with cache returned " << g1 << ", "
+		     << g2 << " (" << s << ")" << endl;
+		++result;
+	}
+
+	ex q;
+	if (!divide(a, x - 2*z, q) || !divide(a, x - 2*z, q) || !q.is_equal(x + y)) {
+		clog << "divide(" << a << ", " << x - 2*z << ") with cache returned " << q << endl;
+		++result;
+	}
+	if (divide(a, x + z, q) || divide(a, x + z, q)) {
+		clog << "divide(" << a << ", " << x + z << ") with cache erroneously succeeded" << endl;
+		++result;
+	}
+	s = normal_cache::get_statistics(normal_cache::divide_results);
+	if (s.hits < 2) {
+		clog << "divide(): repeated divisions not found in cache: " << s << endl;
+		++result;
+	}
+
+	normal_cache::set_capacity(1);
+	s = normal_cache::get_statistics(normal_cache::divide_results);
+	if (s.size != 1 || s.evictions == 0) {
+		clog << "cache not shrunk to capacity 1: " << s << endl;
+		++result;
+	}
+
+	normal_cache::set_capacity(capacity);
+	return result;
+}
+
 unsigned exam_normalization()
 {
 	unsigned result = 0;
@@ -229,6 +332,8 @@ unsigned exam_normalization()
 	result += exam_normal3(); cout << '.' << flush;
 	result += exam_normal4(); cout << '.' << flush;
 	result += exam_content(); cout << '.' << flush;
+	result += exam_normal_large_sums(); cout << '.' << flush;
+	result += exam_normal_cache(); cout << '.' << flush;
 	
 	return result;
 }
@@ -381,6 +381,148 @@ static unsigned exam_numeric6()
 	return result;
 }
 
+/* Evaluates constants and functions at the precision of the thread, which
+ * is stored as a string so that no numbers are shared between threads.  All
+ * of them use CLN's global caches of Pi, log(2), zeta(3) and the other
+ * constants; sin(10^6) needs more digits of Pi than the precision. */
+struct eval_at_precision : public parallel_task {
+	vector<long> digits;
+	vector<string> values;
+	void run(size_t i, unsigned slot)
+	{
+		digits_guard guard(digits[i]);
+		std::ostringstream s;
+		s << Pi.evalf() << ' ' << exp(numeric(1)) << ' ' << zeta(numeric(3))
+		  << ' ' << Li2(numeric(1,3)) << ' ' << log(numeric(10))
+		  << ' ' << sin(numeric(1000000)) << ' ' << atan(numeric(-3))
+		  << ' ' << tgamma(numeric(1,3)) << ' ' << Catalan.evalf()
+		  << ' ' << Euler.evalf() << ' ' << Digits;
+		values[i] = s.str();
+	}
+};
+
+/* This test checks that digits_guard changes the precision of the calling
+ * thread only, and restores it. */
+static unsigned exam_numeric7()
+{
+	unsigned result = 0;
+	const long global_digits = Digits;
+	const numeric pi60("3.14159265358979323846264338327950288419716939937510582097494");
+	const numeric e60("2.71828182845904523536028747135266249775724709369995957496697");
+
+	{
+		digits_guard guard(60);
+		if (Digits != 60) {
+			clog << "Digits is " << Digits << " inside digits_guard(60)" << endl;
+			++result;
+		}
+		if (abs(ex_to<numeric>(Pi.evalf()) - pi60) > numeric(1, 10).power(55)) {
+			clog << "Pi.evalf() inside digits_guard(60) returned " << Pi.evalf() << endl;
+			++result;
+		}
+		if (abs(exp(numeric(1)) - e60) > numeric(1, 10).power(55)) {
+			clog << "exp(1) inside digits_guard(60) returned " << exp(numeric(1)) << endl;
+			++result;
+		}
+		{
+			digits_guard inner(20);
+			if (Digits != 20) {
+				clog << "Digits is " << Digits << " inside nested digits_guard(20)" << endl;
+				++result;
+			}
+		}
+		if (Digits != 60) {
+			clog << "Digits is " << Digits << " after nested digits_guard(20)" << endl;
+			++result;
+		}
+	}
+	if (Digits != global_digits) {
+		clog << "Digits is " << Digits << " after digits_guard, expected "
+		     << global_digits << endl;
+		++result;
+	}
+	if (abs(ex_to<numeric>(Pi.evalf()) - pi60) < numeric(1, 10).power(40)) {
+		clog << "Pi.evalf() after digits_guard still has 60 digits" << endl;
+		++result;
+	}
+
+	// Threads evaluating at different precisions at the same time must
+	// get the same results as a single thread.
+	eval_at_precision task;
+	for (int i = 0; i < 16; ++i)
+		task.digits.push_back(i % 2 ? 200 : 20);
+	task.values.resize(task.digits.size());
+	parallel_for(task.digits.size(), task);
+	const vector<string> values = task.values;
+	for (size_t i = 0; i < task.digits.size(); ++i)
+		task.run(i, 0);
+	for (size_t i = 0; i < values.size(); ++i) {
+		if (values[i] != task.values[i]) {
+			clog << "evaluation with " << task.digits[i] << " digits in parallel gave "
+			     << values[i] << " instead of " << task.values[i] << endl;
+			++result;
+		}
+	}
+
+	return result;
+}
+
+/* This test checks that values remembered at a higher precision give the
+ * same results at a lower one as computing them afresh. */
+static unsigned exam_numeric8()
+{
+	unsigned result = 0;
+	const std::size_t budget = precision_cache::get_memory_budget();
+	vector<ex> values;
+	values.push_back(Pi);
+	values.push_back(Catalan);
+	values.push_back(S(2, 2, numeric(1, 3)));
+	values.push_back(S(1, 3, numeric(-3, 10)));
+
+	// Nothing is remembered with a budget of zero.
+	precision_cache::set_memory_budget(0);
+	vector<ex> fresh;
+	{
+		digits_guard guard(16);
+		for (size_t i = 0; i < values.size(); ++i)
+			fresh.push_back(values[i].evalf());
+	}
+	if (precision_cache::get_statistics(precision_cache::constants).bytes != 0 ||
+	    precision_cache::get_statistics(precision_cache::polylog_tables).bytes != 0) {
+		clog << "values are remembered with a memory budget of zero" << endl;
+		++result;
+	}
+
+	precision_cache::set_memory_budget(budget);
+	precision_cache::reset_statistics();
+	{
+		digits_guard guard(500);
+		for (size_t i = 0; i < values.size(); ++i)
+			values[i].evalf();
+	}
+	{
+		digits_guard guard(16);
+		for (size_t i = 0; i < values.size(); ++i) {
+			const ex d = abs(values[i].evalf() - fresh[i]);
+			if (d > numeric(1, 10).power(14)) {
+				clog << values[i] << " evaluated with remembered values differs by "
+				     << d << " from its fresh evaluation" << endl;
+				++result;
+			}
+		}
+	}
+	const precision_cache::statistics constants = precision_cache::get_statistics(precision_cache::constants);
+	const precision_cache::statistics tables = precision_cache::get_statistics(precision_cache::polylog_tables);
+	if (constants.truncations == 0 || tables.truncations == 0) {
+		clog << "values computed with 500 digits were not reused with 16 digits:" << endl
+		     << "constants: " << constants << endl
+		     << "polylog tables: " << tables << endl;
+		++result;
+	}
+
+	return result;
+}
+
 unsigned exam_numeric()
 {
 	unsigned result = 0;
@@ -393,6 +535,8 @@ unsigned exam_numeric()
 	result += exam_numeric4();  cout << '.' << flush;
 	result += exam_numeric5();  cout << '.' << flush;
 	result += exam_numeric6();  cout << '.' << flush;
+	result += exam_numeric7();  cout << '.' << flush;
+	result += exam_numeric8();  cout << '.' << flush;
 	
 	return result;
 }
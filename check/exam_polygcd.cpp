@@ -230,6 +230,29 @@ static unsigned poly_gcd7()
 	return 0;
 }
 
+// Sparse inputs in seven variables, with cofactors
+static unsigned poly_gcd8()
+{
+	symbol a("a"), b("b"), c("c"), d("d"), e("e"), f("f");
+	ex h = pow(a, 3) * b * c + 2 * d * pow(e, 2) - f * x + 5;
+
+	for (int j=1; j<=MAX_VARIABLES; j++) {
+		ex p = pow(h, j) * (pow(x, 2) * a * f - 3 * pow(b, 3) * e + c * d + 1);
+		ex q = h * (x * pow(c, 2) * pow(e, j) + a * b * d - 7 * f - 2);
+		ex ca, cb;
+		ex r = gcd(p.expand(), q.expand(), &ca, &cb);
+		if (!(r - h).expand().is_zero() && !(r + h).expand().is_zero()) {
+			clog << "case 8, gcd(" << p << "," << q << ") = " << r << " (should be " << h << ")" << endl;
+			return 1;
+		}
+		if (!(r * ca - p).expand().is_zero() || !(r * cb - q).expand().is_zero()) {
+			clog << "case 8, wrong cofactors " << ca << ", " << cb << " of gcd(" << p << "," << q << ")" << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
 unsigned exam_polygcd()
 {
 	unsigned result = 0;
@@ -245,6 +268,7 @@ unsigned exam_polygcd()
 	result += poly_gcd5p();  cout << '.' << flush;
 	result += poly_gcd6();  cout << '.' << flush;
 	result += poly_gcd7();  cout << '.' << flush;
+	result += poly_gcd8();  cout << '.' << flush;
 	
 	return result;
 }
@@ -386,6 +386,99 @@ static unsigned exam_series14()
 	return result;
 }
 
+// Test the composition with exp() and long series with numeric coefficients,
+// where products and inverses switch to faster algorithms.
+static unsigned exam_series15()
+{
+	using GiNaC::exp;
+	unsigned result = 0;
+	ex e, d;
+
+	e = exp(sin(x));
+	d = 1 + x + pow(x, 2) / 2 - pow(x, 4) / 8 - pow(x, 5) / 15
+	    - pow(x, 6) / 240 + pow(x, 7) / 90 + Order(pow(x, 8));
+	result += check_series(e, 0, d);
+
+	e = tgamma(x + 1);
+	d = 1 - Euler * x + (pow(Euler, 2) / 2 + pow(Pi, 2) / 12) * pow(x, 2)
+	    + Order(pow(x, 3));
+	result += check_series(e, 0, d, 3);
+
+	// Fibonacci numbers
+	e = 1 / (1 - x - pow(x, 2));
+	d = Order(pow(x, 60));
+	numeric f0 = 1, f1 = 1;
+	for (int i = 0; i < 60; ++i) {
+		d += f0 * pow(x, i);
+		f1 += f0;
+		f0 = f1 - f0;
+	}
+	result += check_series(e, 0, d, 60);
+
+	e = 1 / ((1 - x) * (1 + x));
+	d = Order(pow(x, 80));
+	for (int i = 0; i < 80; i += 2)
+		d += pow(x, i);
+	result += check_series(e, 0, d, 80);
+
+	return result;
+}
+
+// Test series which compute their coefficients on demand.
+static unsigned check_lazy_series(const ex &e, int order)
+{
+	lazy_series ls(e, x);
+	ex el = ex_to<pseries>(ls.series(order)).convert_to_poly();
+	ex es = ex_to<pseries>(e.series(x, order)).convert_to_poly();
+	if (!(el - es).expand().is_zero()) {
+		clog << "lazy series expansion of " << e << " erroneously returned "
+		     << el << " (instead of " << es << ")" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+static unsigned exam_series16()
+{
+	using GiNaC::exp;
+	using GiNaC::log;
+	unsigned result = 0;
+
+	lazy_series s(sin(x) - x, x);
+	if (s.ldegree() != 3) {
+		clog << "lazy series of sin(x)-x erroneously has ldegree "
+		     << s.ldegree() << " (instead of 3)" << endl;
+		++result;
+	}
+	ex d = -pow(x, 3) / 6 + pow(x, 5) / 120 + Order(pow(x, 6));
+	if (!(ex_to<pseries>(s.series(6)).convert_to_poly() - d).expand().is_zero()) {
+		clog << "lazy series of sin(x)-x erroneously returned "
+		     << s.series(6) << endl;
+		++result;
+	}
+	// asking for more terms continues the computation
+	d = d.subs(Order(pow(x, 6)) == -pow(x, 7) / 5040 + Order(pow(x, 8)));
+	if (!(ex_to<pseries>(s.series(8)).convert_to_poly() - d).expand().is_zero()) {
+		clog << "lazy series of sin(x)-x erroneously returned "
+		     << s.series(8) << endl;
+		++result;
+	}
+
+	lazy_series f(1 / (1 - x - pow(x, 2)), x);
+	if (f.coeff(30) != fibonacci(31)) {
+		clog << "lazy series of 1/(1-x-x^2) erroneously has coefficient "
+		     << f.coeff(30) << " (instead of " << fibonacci(31) << ")" << endl;
+		++result;
+	}
+
+	result += check_lazy_series(1 / (sin(x) - x), 3);
+	result += check_lazy_series(exp(x) * log(1 + x) / pow(x, 2), 6);
+	result += check_lazy_series(sqrt(1 + x + pow(x, 2)) / (exp(x) - 1), 6);
+	result += check_lazy_series(pow(cos(x) - 1, 3) * tgamma(x), 10);
+
+	return result;
+}
+
 unsigned exam_pseries()
 {
 	unsigned result = 0;
@@ -406,6 +499,8 @@ unsigned exam_pseries()
 	result += exam_series12();  cout << '.' << flush;
 	result += exam_series13();  cout << '.' << flush;
 	result += exam_series14();  cout << '.' << flush;
+	result += exam_series15();  cout << '.' << flush;
+	result += exam_series16();  cout << '.' << flush;
 	
 	return result;
 }
@@ -0,0 +1,140 @@
+/** @file time_compile_ex.cpp
+ *
+ *  Time for compiling expressions with compile_ex and for evaluating the
+ *  resulting functions, using the built-in code generator and the external
+ *  compiler.
+ */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+static const unsigned num_exprs = 200;
+static const unsigned num_ext_exprs = 3;
+static const unsigned num_calls = 1000000;
+
+static ex test_expr(const symbol & x, unsigned k)
+{
+	return sin(k*x) * pow(x, k % 7) / (1 + pow(x, 2)) + exp(-x/(k+1)) - sqrt(x + k);
+}
+
+/* Compile n test expressions, check the functions at a few points and
+ * return the wall clock time per expression (the external compiler runs in
+ * a child process). */
+static double compile(const symbol & x, unsigned n, vector<FUNCP_1P> & fps, unsigned & result)
+{
+	walltimer tissot;
+	tissot.start();
+	for (unsigned k = 0; k < n; ++k) {
+		FUNCP_1P fp;
+		compile_ex(test_expr(x, k), x, fp);
+		fps.push_back(fp);
+	}
+	const double t = tissot.read() / n;
+
+	for (unsigned k = 0; k < n; ++k) {
+		for (double v = 0.25; v < 2; v += 0.5) {
+			const double ref = ex_to<numeric>(test_expr(x, k).subs(x==v).evalf()).to_double();
+			const double val = fps[k](v);
+			if (std::fabs(val - ref) > 1e-12 * (1 + std::fabs(ref))) {
+				clog << "compiled " << test_expr(x, k) << " at x==" << v
+				     << " erroneously returned " << val << " instead of " << ref << endl;
+				++result;
+			}
+		}
+	}
+	return t;
+}
+
+/* Return the time per call of fp. */
+static double evaluate(FUNCP_1P fp)
+{
+	timer tissot;
+	tissot.start();
+	volatile double sum = 0;
+	for (unsigned i = 0; i < num_calls; ++i)
+		sum += fp(i * (1.0 / num_calls));
+	return tissot.read() / num_calls;
+}
+
+unsigned time_compile_ex()
+{
+	unsigned result = 0;
+	const symbol x("x");
+
+	cout << "timing compile_ex" << flush;
+
+	// Without the built-in code generator, compile_ex needs the external
+	// compiler, which may not be installed.
+	vector<FUNCP_1P> jit_fps;
+	double jit_compile = 0, jit_eval = 0;
+	bool jit_ok = false;
+	try {
+		jit_compile = compile(x, num_exprs, jit_fps, result);
+		jit_eval = evaluate(jit_fps[num_ext_exprs-1]);
+		jit_ok = true;
+		cout << '.' << flush;
+	} catch (const std::runtime_error &) {
+	}
+
+	vector<FUNCP_1P> ext_fps;
+	double ext_compile = 0, ext_eval = 0;
+	bool ext_ok = false;
+	set_compile_ex_jit(false);
+	try {
+		ext_compile = compile(x, num_ext_exprs, ext_fps, result);
+		ext_eval = evaluate(ext_fps[num_ext_exprs-1]);
+		ext_ok = true;
+		cout << '.' << flush;
+	} catch (const std::runtime_error &) {
+	}
+	set_compile_ex_jit(true);
+
+	cout << endl;
+	if (jit_ok)
+		cout << "	built-in:          compile " << jit_compile * 1e6 << "us, evaluate "
+		     << jit_eval * 1e9 << "ns" << endl;
+	else
+		cout << "	built-in:          not available" << endl;
+	if (ext_ok)
+		cout << "	external compiler: compile " << ext_compile * 1e6 << "us, evaluate "
+		     << ext_eval * 1e9 << "ns" << endl;
+	else
+		cout << "	external compiler: not available" << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_compile_ex();
+}
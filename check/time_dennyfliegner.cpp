@@ -98,6 +98,7 @@ extern void randomify_symbol_serials();
 
 int main(int argc, char** argv)
 {
+	setup_benchmark();
 	randomify_symbol_serials();
 	cout << setprecision(2) << showpoint;
 	return time_dennyfliegner();
@@ -0,0 +1,148 @@
+/** @file time_factor_univariate.cpp
+ *
+ *  Time for factoring univariate polynomials of large degree with integer
+ *  coefficients, and Swinnerton-Dyer polynomials with many modular factors. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+/* Random monic polynomial of degree n with coefficients in [-10, 10]. */
+static ex random_poly(const symbol& x, unsigned n)
+{
+	ex p = pow(x, n);
+	for (unsigned i=0; i<n; ++i)
+		p += (rand()%21-10)*pow(x, i);
+	return p;
+}
+
+/* Factor the product of four random polynomials of degree n/4. */
+static unsigned factor_product(unsigned n)
+{
+	const symbol x("x");
+	ex p = 1;
+	for (unsigned i=0; i<4; ++i)
+		p *= random_poly(x, n/4);
+	p = p.expand();
+
+	const ex f = factor(p);
+	if (!is_a<mul>(f)) {
+		clog << "product of degree " << n << " was not factored" << endl;
+		return 1;
+	}
+	if (!(f.expand() - p).is_zero()) {
+		clog << "factorization of product of degree " << n
+		     << " is wrong" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+/* Swinnerton-Dyer polynomial of the first n primes, of degree 2^n. It is
+ * irreducible, but has 2^(n-1) or more factors modulo every prime, so the
+ * modular factors have to be recombined by lattice reduction. */
+static ex swinnerton_dyer(const symbol& x, unsigned n)
+{
+	static const int primes[] = { 2, 3, 5, 7, 11, 13 };
+	ex e = x;
+	for (unsigned i=0; i<n; ++i) {
+		const ex s = sqrt(numeric(primes[i]));
+		e = expand(e.subs(x == x + s).expand() * e.subs(x == x - s).expand());
+	}
+	return e;
+}
+
+static unsigned factor_swinnerton_dyer(unsigned n)
+{
+	const symbol x("x");
+	const ex p = swinnerton_dyer(x, n);
+	const ex f = factor(p);
+	if (!(f - p).is_zero()) {
+		clog << "Swinnerton-Dyer polynomial of " << n
+		     << " primes was factored: " << f << endl;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned time_factor_univariate()
+{
+	unsigned result = 0;
+
+	cout << "timing univariate factorization" << flush;
+
+	vector<unsigned> sizes, primes;
+	vector<double> times, sd_times;
+	timer rolex;
+
+	sizes.push_back(100);
+	sizes.push_back(200);
+	sizes.push_back(500);
+	sizes.push_back(1000);
+	primes.push_back(4);
+	primes.push_back(5);
+	primes.push_back(6);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		rolex.start();
+		result += factor_product(*i);
+		times.push_back(rolex.read());
+		cout << '.' << flush;
+	}
+	for (vector<unsigned>::iterator i=primes.begin(); i!=primes.end(); ++i) {
+		rolex.start();
+		result += factor_swinnerton_dyer(*i);
+		sd_times.push_back(rolex.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	degree:     ";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	time/s:     ";
+	for (vector<double>::iterator i=times.begin(); i!=times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	SD degree:  ";
+	for (vector<unsigned>::iterator i=primes.begin(); i!=primes.end(); ++i)
+		cout << '\t' << (1 << *i);
+	cout << endl << "	time/s:     ";
+	for (vector<double>::iterator i=sd_times.begin(); i!=sd_times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_factor_univariate();
+}
@@ -73,6 +73,7 @@ extern void randomify_symbol_serials();
 
 int main(int argc, char** argv)
 {
+	setup_benchmark();
 	randomify_symbol_serials();
 	cout << setprecision(2) << showpoint;
 	return time_fateman_expand();
@@ -63,6 +63,8 @@ unsigned time_gammaseries()
 	sizes.push_back(25);
 	sizes.push_back(30);
 	sizes.push_back(35);
+	sizes.push_back(40);
+	sizes.push_back(50);
 
 	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
 		omega.start();
@@ -87,6 +89,7 @@ extern void randomify_symbol_serials();
 
 int main(int argc, char** argv)
 {
+	setup_benchmark();
 	randomify_symbol_serials();
 	cout << setprecision(2) << showpoint;
 	return time_gammaseries();
@@ -0,0 +1,118 @@
+/** @file time_generic_determinant.cpp
+ *
+ *  Time for the determinant of generic symbolic matrices, with one symbol
+ *  per element, computed by the automatically chosen algorithm and by minor
+ *  expansion.  The automatic choice must not be much slower. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+static matrix generic_matrix(unsigned size)
+{
+	matrix M(size,size);
+	for (unsigned ro=0; ro<size; ++ro) {
+		for (unsigned co=0; co<size; ++co) {
+			ostringstream name;
+			name << "a" << ro << "_" << co;
+			M.set(ro,co,symbol(name.str()));
+		}
+	}
+	return M;
+}
+
+/* Time the determinant of M with the given algorithm, storing it in det. */
+static double time_det(const matrix & M, unsigned algo, ex & det)
+{
+	timer omega;
+	int count = 0;
+	omega.start();
+	// correct for very small times:
+	do {
+		det = M.determinant(algo);
+		++count;
+	} while (omega.read()<0.1);
+	return omega.read()/count;
+}
+
+unsigned time_generic_determinant()
+{
+	unsigned result = 0;
+
+	cout << "timing determinant of generic symbolic matrices" << flush;
+
+	vector<unsigned> sizes;
+	vector<double> auto_times, laplace_times;
+
+	sizes.push_back(4);
+	sizes.push_back(5);
+	sizes.push_back(6);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		const matrix M = generic_matrix(*i);
+		ex det_auto, det_laplace;
+		auto_times.push_back(time_det(M, determinant_algo::automatic, det_auto));
+		laplace_times.push_back(time_det(M, determinant_algo::laplace, det_laplace));
+		if (!(det_auto - det_laplace).expand().is_zero()) {
+			clog << "Determinant of generic " << *i << "x" << *i
+			     << " matrix was miscalculated:" << endl
+			     << "automatic:           " << det_auto << endl
+			     << "Minor elimination:   " << det_laplace << endl;
+			++result;
+		}
+		if (auto_times.back() > 10*laplace_times.back() + 0.1) {
+			clog << "automatic determinant of generic " << *i << "x" << *i
+			     << " matrix took " << auto_times.back() << "s instead of about "
+			     << laplace_times.back() << "s (minor expansion)" << endl;
+			++result;
+		}
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	dim:       ";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i << 'x' << *i;
+	cout << endl << "	automatic/s:";
+	for (vector<double>::iterator i=auto_times.begin(); i!=auto_times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	laplace/s:  ";
+	for (vector<double>::iterator i=laplace_times.begin(); i!=laplace_times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_generic_determinant();
+}
@@ -0,0 +1,102 @@
+/** @file time_large_sums.cpp
+ *
+ *  Time for building sums of 10^5 and 10^6 terms in one go, once with many
+ *  like terms to combine and once with all terms different.
+ */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+/* Sum n monomials in x and y, each of which occurs n/distinct times in
+ * scrambled order. */
+static unsigned large_sum(unsigned n, unsigned distinct)
+{
+	const symbol x("x"), y("y");
+	const unsigned k = 1000;
+
+	exvector v;
+	v.reserve(n);
+	for (unsigned i = 0; i < n; ++i) {
+		const unsigned j = (i * 7919UL) % distinct;
+		v.push_back(pow(x, j % k + 1) * pow(y, j / k));
+	}
+	const ex s = add(v);
+
+	if (s.nops() != distinct || !s.subs(lst(x==1, y==1)).is_equal(n)) {
+		clog << "sum of " << n << " terms with " << distinct
+		     << " different ones was miscomputed" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned time_large_sums()
+{
+	unsigned result = 0;
+
+	cout << "timing construction of large sums" << flush;
+
+	vector<unsigned> sizes;
+	vector<double> times;
+	timer longines;
+
+	sizes.push_back(100000);
+	sizes.push_back(1000000);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		longines.start();
+		result += large_sum(*i, *i / 10);
+		times.push_back(longines.read());
+		longines.start();
+		result += large_sum(*i, *i);
+		times.push_back(longines.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	number of terms:  ";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i << "  ";
+	cout << endl << "	10-fold repeated: ";
+	for (unsigned i=0; i<times.size(); i+=2)
+		cout << '\t' << times[i] << 's';
+	cout << endl << "	all different:    ";
+	for (unsigned i=1; i<times.size(); i+=2)
+		cout << '\t' << times[i] << 's';
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_large_sums();
+}
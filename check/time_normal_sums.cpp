@@ -0,0 +1,138 @@
+/** @file time_normal_sums.cpp
+ *
+ *  Time for normalizing sums of thousands of rational functions whose
+ *  denominators are products of a few recurring factors, and of hundreds of
+ *  rational functions with pairwise coprime denominators. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+/* Sum n fractions whose denominators are products of two of ten linear
+ * factors, one of them squared. */
+static unsigned normal_sum(unsigned n)
+{
+	const symbol x("x"), y("y"), z("z");
+
+	exvector factors;
+	for (int i = 1; i <= 10; ++i)
+		factors.push_back(x + i*y - z);
+
+	exvector terms;
+	terms.reserve(n);
+	for (unsigned i = 0; i < n; ++i) {
+		const ex &f1 = factors[(i * 7) % factors.size()];
+		const ex &f2 = factors[(i * 3 + 1) % factors.size()];
+		terms.push_back((x*i - y + z)/(pow(f1, 2) * f2));
+	}
+	const ex e = add(terms);
+	const ex d = e.normal();
+
+	// The common denominator is the product of the factors squared
+	if (d.denom().expand().degree(x) > 20) {
+		clog << "sum of " << n << " fractions was normalized to a fraction with denominator "
+		     << d.denom() << endl;
+		return 1;
+	}
+	return 0;
+}
+
+/* Sum n fractions whose denominators are n distinct irreducible quadratics,
+ * so that they are pairwise coprime. */
+static unsigned distinct_sum(unsigned n)
+{
+	const symbol x("x"), y("y");
+
+	exvector terms;
+	terms.reserve(n);
+	for (unsigned i = 0; i < n; ++i)
+		terms.push_back((x - i)/(pow(x, 2) + i*x + (i+1)*y));
+	const ex e = add(terms);
+	const ex d = e.normal();
+
+	// The common denominator is the product of all denominators
+	if (d.denom().degree(x) != int(2*n) || d.denom().degree(y) != int(n)) {
+		clog << "sum of " << n << " fractions with distinct denominators was normalized "
+		     << "to a fraction with denominator " << d.denom() << endl;
+		return 1;
+	}
+	return 0;
+}
+
+static unsigned time_sums(const char *name, unsigned (*sum)(unsigned), const vector<unsigned> &sizes)
+{
+	unsigned result = 0;
+	vector<double> times;
+	timer omega;
+
+	for (vector<unsigned>::const_iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		omega.start();
+		result += sum(*i);
+		times.push_back(omega.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	" << name << endl << "	number of terms:";
+	for (vector<unsigned>::const_iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	time/s:\t\t";
+	for (vector<double>::iterator i=times.begin(); i!=times.end(); ++i)
+		cout << '\t' << *i;
+
+	return result;
+}
+
+unsigned time_normal_sums()
+{
+	unsigned result = 0;
+
+	cout << "timing normalization of large sums of fractions" << flush;
+
+	vector<unsigned> sizes;
+	sizes.push_back(1000);
+	sizes.push_back(2000);
+	sizes.push_back(4000);
+	result += time_sums("recurring denominators", normal_sum, sizes);
+
+	sizes.clear();
+	sizes.push_back(50);
+	sizes.push_back(100);
+	sizes.push_back(200);
+	result += time_sums("distinct denominators", distinct_sum, sizes);
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_normal_sums();
+}
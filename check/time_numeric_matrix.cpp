@@ -0,0 +1,127 @@
+/** @file time_numeric_matrix.cpp
+ *
+ *  Time for solving dense linear systems and computing determinants of
+ *  matrices of rational and floating point numbers.
+ */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+static matrix random_matrix(unsigned rows, unsigned cols, bool floating)
+{
+	matrix A(rows, cols);
+	for (unsigned r=0; r<rows; ++r)
+		for (unsigned c=0; c<cols; ++c) {
+			ex elem = numeric(rand()%201-100);
+			if (floating)
+				elem = elem.evalf();
+			A.set(r, c, elem);
+		}
+	return A;
+}
+
+/* Solve a random system A*X == B of the given size and compute det(A).
+ * Exact solutions are checked by multiplying back, floating point ones
+ * by the size of the residual. */
+static unsigned numeric_solve(unsigned size, bool floating)
+{
+	const matrix A = random_matrix(size, size, floating);
+	const matrix B = random_matrix(size, 1, floating);
+	matrix X(size, 1);
+	for (unsigned r=0; r<size; ++r)
+		X.set(r, 0, symbol());
+
+	const matrix sol = A.solve(X, B);
+	const ex det = A.determinant();
+
+	const matrix res = A.mul(sol).sub(B);
+	for (unsigned r=0; r<size; ++r) {
+		if (!is_exactly_a<numeric>(res(r, 0)) ||
+		    (floating ? abs(ex_to<numeric>(res(r, 0))) > numeric(1, 1000000000)
+		              : !res(r, 0).is_zero())) {
+			clog << "solution of " << size << 'x' << size
+			     << " system was miscalculated" << endl;
+			return 1;
+		}
+	}
+	if (det.is_zero()) {
+		clog << "determinant of " << size << 'x' << size
+		     << " matrix was found to vanish" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned time_numeric_matrix()
+{
+	unsigned result = 0;
+
+	cout << "timing dense numeric linear systems" << flush;
+
+	vector<unsigned> sizes;
+	vector<double> times_exact, times_float;
+	timer rolex;
+
+	sizes.push_back(25);
+	sizes.push_back(50);
+	sizes.push_back(100);
+	sizes.push_back(200);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		rolex.start();
+		result += numeric_solve(*i, false);
+		times_exact.push_back(rolex.read());
+		rolex.start();
+		result += numeric_solve(*i, true);
+		times_float.push_back(rolex.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	dim:        ";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i << 'x' << *i;
+	cout << endl << "	rational/s: ";
+	for (vector<double>::iterator i=times_exact.begin(); i!=times_exact.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	float/s:    ";
+	for (vector<double>::iterator i=times_float.begin(); i!=times_float.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_numeric_matrix();
+}
@@ -0,0 +1,88 @@
+/** @file time_parallel_expand.cpp
+ *
+ *  Time for Fateman's polynomial expansion benchmark with the terms of the
+ *  product distributed over 1, 2, 4, ..., 32 threads (as far as there are
+ *  processors).  Only meaningful if the library was configured with
+ *  --enable-thread-safe, otherwise expansion is always sequential.
+ */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <iostream>
+using namespace std;
+
+static const unsigned max_threads = 32;
+
+static unsigned test(const ex & p, const ex & reference)
+{
+	const ex hugesum = expand(p * (p+1), expand_options::expand_parallel);
+
+	if (hugesum.nops()!=12341 || !hugesum.is_equal(reference)) {
+		clog << "(x+y+z+1)^20 * ((x+y+z+1)^20+1) was miscomputed with "
+		     << get_parallel_threads() << " threads!" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned time_parallel_expand()
+{
+	unsigned result = 0;
+	const symbol x("x"), y("y"), z("z");
+	const ex p = pow(x+y+z+1, 20);
+
+	cout << "timing Fateman's polynomial expand benchmark in parallel" << flush;
+
+	walltimer tissot;
+	tissot.start();
+	const ex reference = expand(p * (p+1));
+	const double t1 = tissot.read();
+	cout << '.' << flush;
+
+	const unsigned ncpu = get_parallel_threads();
+	double time1 = t1;
+	cout << ' ' << t1 << "s (sequential)";
+	for (unsigned nthreads = 1; nthreads <= max_threads && nthreads <= ncpu; nthreads *= 2) {
+		set_parallel_threads(nthreads);
+		tissot.start();
+		result += test(p, reference);
+		const double t = tissot.read();
+		if (nthreads == 1)
+			time1 = t;
+		cout << ", " << t << "s (" << nthreads << " threads, speedup " << time1/t << ')' << flush;
+	}
+	set_parallel_threads(0);
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_parallel_expand();
+}
@@ -58,6 +58,7 @@ static double benchmark_and_cmp(const string& srep)
 int main(int argc, char** argv)
 {
 	cout << "timing GiNaC parser..." << flush;
+	setup_benchmark();
 	randomify_symbol_serials();
 	unsigned n_min = 1024;
 	unsigned n_max = 32768;
@@ -0,0 +1,142 @@
+/** @file time_polylog_batch.cpp
+ *
+ *  Time for the numerical evaluation of weight four and five polylogarithms
+ *  at many points, one by one and batched over several threads, at the
+ *  default precision and at 50 digits. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+static const unsigned max_threads = 32;
+
+/* Points on a curve through the regions of the argument which need
+ * different transformations. */
+static exvector make_points(unsigned n)
+{
+	exvector points;
+	for (unsigned i = 0; i < n; ++i)
+		points.push_back(numeric(int(i) - int(n)/3, int(n)/4) + numeric(int(i % 7) - 3, 20)*I);
+	return points;
+}
+
+static exvector evalf_one_by_one(const exvector & exprs)
+{
+	exvector results;
+	for (size_t i = 0; i < exprs.size(); ++i)
+		results.push_back(exprs[i].evalf());
+	return results;
+}
+
+static unsigned compare(const char *name, const exvector & reference, const exvector & batch)
+{
+	const ex prec = pow(10, 2 - long(Digits));
+	for (size_t i = 0; i < reference.size(); ++i) {
+		if (abs(batch[i] - reference[i]) > prec) {
+			clog << "batched evaluation of " << name << " at point " << i << " gave "
+			     << batch[i] << " instead of " << reference[i] << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Time the evaluation at the precision of the calling thread. */
+static unsigned time_batch(unsigned npoints)
+{
+	unsigned result = 0;
+
+	const exvector points = make_points(npoints);
+	const ex Hm = lst(2, 1, 0, -1);
+	const ex Lim = lst(3, 1, 1);
+	exvector Hexprs, Sexprs, Lix, Liexprs, Ga, Gy, Gexprs;
+	for (unsigned i = 0; i < npoints; ++i) {
+		Hexprs.push_back(H(Hm, points[i]));
+		Sexprs.push_back(S(3, 2, points[i]));
+		Lix.push_back(lst(points[i], numeric(1, 2), numeric(-2, 3)));
+		Liexprs.push_back(Li(Lim, Lix.back()));
+		Ga.push_back(lst(points[i], 0, numeric(1, 2) + I, numeric(-3, 2)));
+		Gy.push_back(numeric(1));
+		Gexprs.push_back(G(Ga.back(), Gy.back()));
+	}
+
+	walltimer tissot;
+	tissot.start();
+	const exvector Href = evalf_one_by_one(Hexprs);
+	const exvector Sref = evalf_one_by_one(Sexprs);
+	const exvector Liref = evalf_one_by_one(Liexprs);
+	const exvector Gref = evalf_one_by_one(Gexprs);
+	const double t1 = tissot.read();
+	cout << '.' << flush;
+
+	const unsigned ncpu = get_parallel_threads();
+	double time1 = t1;
+	cout << ' ' << Digits << " digits: " << t1 << "s (one by one)";
+	for (unsigned nthreads = 1; nthreads <= max_threads && nthreads <= ncpu; nthreads *= 2) {
+		set_parallel_threads(nthreads);
+		tissot.start();
+		result += compare("H", Href, H_evalf_batch(Hm, points));
+		result += compare("S", Sref, S_evalf_batch(3, 2, points));
+		result += compare("Li", Liref, Li_evalf_batch(Lim, Lix));
+		result += compare("G", Gref, G_evalf_batch(Ga, Gy));
+		const double t = tissot.read();
+		if (nthreads == 1)
+			time1 = t;
+		cout << ", " << t << "s (" << nthreads << " threads, speedup " << time1/t
+		     << ", " << 4*npoints/t << " points/s)" << flush;
+	}
+	set_parallel_threads(0);
+
+	return result;
+}
+
+unsigned time_polylog_batch()
+{
+	unsigned result = 0;
+	const unsigned npoints = 200;
+
+	cout << "timing batched evaluation of polylogarithms at " << npoints << " points" << flush;
+
+	result += time_batch(npoints);
+	{
+		// long floats, where the threads share CLN's constants
+		digits_guard guard(50);
+		cout << ";";
+		result += time_batch(npoints);
+	}
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_polylog_batch();
+}
@@ -0,0 +1,122 @@
+/** @file time_precision_cache.cpp
+ *
+ *  Time for evaluating constants and Nielsen polylogarithms while switching
+ *  between precisions, with and without remembering values across them. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+/* Evaluate a few constants and polylogarithms rounds times, cycling through
+ * 16, 50 and 500 digits, and check the results against those of the first
+ * round. */
+static unsigned alternate_precisions(unsigned rounds)
+{
+	unsigned result = 0;
+	const long precisions[] = { 16, 50, 500 };
+	const unsigned num_precisions = sizeof(precisions) / sizeof(precisions[0]);
+	const long saved_digits = Digits;
+
+	exvector values;
+	values.push_back(Pi);
+	values.push_back(Euler);
+	values.push_back(Catalan);
+	values.push_back(S(2, 2, numeric(1, 3)));
+	values.push_back(S(1, 3, numeric(-3, 10)));
+
+	vector<exvector> first(num_precisions);
+	for (unsigned r = 0; r < rounds; ++r) {
+		for (unsigned i = 0; i < num_precisions; ++i) {
+			Digits = precisions[i];
+			for (size_t j = 0; j < values.size(); ++j) {
+				const ex v = values[j].evalf();
+				if (r == 0)
+					first[i].push_back(v);
+				else if (abs(v - first[i][j]) > pow(10, 2 - precisions[i])) {
+					clog << values[j] << " with " << precisions[i] << " digits evaluated to "
+					     << v << " instead of " << first[i][j] << endl;
+					++result;
+				}
+			}
+		}
+	}
+	Digits = saved_digits;
+	return result;
+}
+
+unsigned time_precision_cache()
+{
+	unsigned result = 0;
+
+	cout << "timing evaluation alternating between 16, 50 and 500 digits" << flush;
+
+	const std::size_t budget = precision_cache::get_memory_budget();
+	vector<unsigned> sizes;
+	vector<double> times_uncached, times_cached;
+	timer omega;
+
+	sizes.push_back(10);
+	sizes.push_back(40);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		precision_cache::set_memory_budget(0);
+		omega.start();
+		result += alternate_precisions(*i);
+		times_uncached.push_back(omega.read());
+		cout << '.' << flush;
+
+		precision_cache::set_memory_budget(budget);
+		omega.start();
+		result += alternate_precisions(*i);
+		times_cached.push_back(omega.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	rounds:\t\t";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	time/s, uncached:";
+	for (vector<double>::iterator i=times_uncached.begin(); i!=times_uncached.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	time/s, cached:\t";
+	for (vector<double>::iterator i=times_cached.begin(); i!=times_cached.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	constants:\t" << precision_cache::get_statistics(precision_cache::constants)
+	     << endl << "	polylog tables:\t" << precision_cache::get_statistics(precision_cache::polylog_tables)
+	     << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_precision_cache();
+}
@@ -0,0 +1,112 @@
+/** @file time_sparse_gcd.cpp
+ *
+ *  Time for computing GCDs of sparse polynomials in many variables. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+/* Random polynomial with the given number of terms in the variables, each
+ * of degree at most 4, with coefficients in [-50, 50]. */
+static ex random_poly(const exvector& vars, unsigned terms)
+{
+	ex p = rand()%50 + 1;
+	for (unsigned t=0; t<terms; ++t) {
+		ex m = rand()%101 - 50;
+		for (size_t i=0; i<vars.size(); ++i)
+			m *= pow(vars[i], rand()%5);
+		p += m;
+	}
+	return p;
+}
+
+/* GCD of the products of a random polynomial g with two other ones, all of
+ * them with the given number of terms in nvars variables. */
+static unsigned sparse_gcd(unsigned nvars, unsigned terms)
+{
+	exvector vars;
+	for (unsigned i=0; i<nvars; ++i) {
+		ostringstream buf;
+		buf << "x" << i;
+		vars.push_back(symbol(buf.str()));
+	}
+	const ex g = random_poly(vars, terms);
+	const ex a = (g*random_poly(vars, terms)).expand();
+	const ex b = (g*random_poly(vars, terms)).expand();
+
+	const ex r = gcd(a, b);
+	ex q;
+	if (!divide(r, g.expand(), q) || !divide(a, r, q) || !divide(b, r, q)) {
+		clog << "wrong gcd of sparse polynomials in " << nvars
+		     << " variables: " << r << endl;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned time_sparse_gcd()
+{
+	unsigned result = 0;
+
+	cout << "timing GCD of sparse polynomials" << flush;
+
+	vector<unsigned> sizes;
+	vector<double> times;
+	timer rolex;
+
+	sizes.push_back(6);
+	sizes.push_back(9);
+	sizes.push_back(12);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		rolex.start();
+		result += sparse_gcd(*i, 30);
+		times.push_back(rolex.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	variables:  ";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	time/s:     ";
+	for (vector<double>::iterator i=times.begin(); i!=times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_sparse_gcd();
+}
@@ -0,0 +1,133 @@
+/** @file time_sparse_lsolve.cpp
+ *
+ *  Time for solving large sparse linear systems with lsolve(), with
+ *  numeric coefficients and with coefficients depending on a symbol.
+ */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+/* Solve a random system of n equations, each with a dominant diagonal
+ * element and four further unknowns, like the recurrence relations of
+ * integration by parts.  In the symbolic case, every tenth equation has
+ * coefficients depending on d. */
+static unsigned sparse_lsolve(unsigned n, bool symbolic)
+{
+	const symbol d("d");
+	lst eqns, vars;
+	for (unsigned i=0; i<n; ++i) {
+		ostringstream buf;
+		buf << "x" << i;
+		vars.append(symbol(buf.str()));
+	}
+	for (unsigned i=0; i<n; ++i) {
+		ex lhs = (rand()%11+20)*vars.op(i);
+		for (unsigned k=0; k<4; ++k) {
+			ex c = numeric(rand()%7-3, rand()%3+1);
+			if (symbolic && i%10 == 0)
+				c *= d - k;
+			lhs += c*vars.op(rand()%n);
+		}
+		eqns.append(lhs == rand()%21-10);
+	}
+
+	const ex sol = lsolve(eqns, vars);
+	if (sol.nops() != n) {
+		clog << "solution of sparse system of size " << n
+		     << " was not found" << endl;
+		return 1;
+	}
+	if (!symbolic) {
+		for (size_t i=0; i<eqns.nops(); ++i) {
+			if (!(eqns.op(i).lhs().subs(sol) - eqns.op(i).rhs()).is_zero()) {
+				clog << "solution of sparse system of size " << n
+				     << " does not satisfy equation " << eqns.op(i) << endl;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+unsigned time_sparse_lsolve()
+{
+	unsigned result = 0;
+
+	cout << "timing sparse linear systems" << flush;
+
+	vector<unsigned> sizes, symbolic_sizes;
+	vector<double> times, symbolic_times;
+	timer rolex;
+
+	sizes.push_back(1000);
+	sizes.push_back(2000);
+	sizes.push_back(4000);
+	symbolic_sizes.push_back(100);
+	symbolic_sizes.push_back(200);
+	symbolic_sizes.push_back(400);
+
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i) {
+		rolex.start();
+		result += sparse_lsolve(*i, false);
+		times.push_back(rolex.read());
+		cout << '.' << flush;
+	}
+	for (vector<unsigned>::iterator i=symbolic_sizes.begin(); i!=symbolic_sizes.end(); ++i) {
+		rolex.start();
+		result += sparse_lsolve(*i, true);
+		symbolic_times.push_back(rolex.read());
+		cout << '.' << flush;
+	}
+
+	// print the report:
+	cout << endl << "	equations:  ";
+	for (vector<unsigned>::iterator i=sizes.begin(); i!=sizes.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	numeric/s:  ";
+	for (vector<double>::iterator i=times.begin(); i!=times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	equations:  ";
+	for (vector<unsigned>::iterator i=symbolic_sizes.begin(); i!=symbolic_sizes.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl << "	symbolic/s: ";
+	for (vector<double>::iterator i=symbolic_times.begin(); i!=symbolic_times.end(); ++i)
+		cout << '\t' << *i;
+	cout << endl;
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_sparse_lsolve();
+}
@@ -0,0 +1,156 @@
+/** @file time_threads.cpp
+ *
+ *  Time for expanding and normalizing shared subexpressions from several
+ *  threads at once.  Only meaningful if the library was configured with
+ *  --enable-thread-safe, otherwise only the single-threaded path is timed.
+ */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ginac.h"
+#include "timer.h"
+using namespace GiNaC;
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+static const unsigned ntasks = 16;
+
+static symbol x("x"), y("y"), z("z");
+
+// Subexpressions shared by all threads.  Their hash values are computed
+// lazily, so this also exercises concurrent hash caching.
+static ex p, q;
+
+static ex work(unsigned k)
+{
+	const ex e = expand(p * (q + k));
+	const ex r = normal(p / (q * (x + k)) + (x - y) / (q * (y + k)));
+	return e + numer(r) * denom(r);
+}
+
+struct task_range {
+	unsigned first, stride;
+	vector<ex> *results;
+};
+
+static void run_tasks(const task_range & t)
+{
+	for (unsigned k = t.first; k < ntasks; k += t.stride)
+		(*t.results)[k] = work(k);
+}
+
+#ifdef GINAC_THREAD_SAFE
+static void *thread_main(void *arg)
+{
+	run_tasks(*static_cast<task_range *>(arg));
+	return 0;
+}
+
+static void run_threaded(unsigned nthreads, vector<ex> & results)
+{
+	vector<pthread_t> threads(nthreads);
+	vector<task_range> ranges(nthreads);
+	for (unsigned i = 0; i < nthreads; ++i) {
+		ranges[i].first = i;
+		ranges[i].stride = nthreads;
+		ranges[i].results = &results;
+		if (pthread_create(&threads[i], 0, thread_main, &ranges[i]) != 0) {
+			clog << "pthread_create() failed" << endl;
+			exit(1);
+		}
+	}
+	for (unsigned i = 0; i < nthreads; ++i)
+		pthread_join(threads[i], 0);
+}
+#endif
+
+static unsigned check_results(const vector<ex> & reference, const vector<ex> & results, unsigned nthreads)
+{
+	unsigned result = 0;
+	for (unsigned k = 0; k < ntasks; ++k) {
+		if (!(reference[k] - results[k]).expand().is_zero()) {
+			clog << "task " << k << " was miscomputed with " << nthreads
+			     << " threads" << endl;
+			++result;
+		}
+	}
+	return result;
+}
+
+unsigned time_threads()
+{
+	unsigned result = 0;
+
+	cout << "timing expand/normal of shared expressions in threads" << flush;
+
+	p = pow(x + y + z + 1, 8);
+	q = pow(x - 2*y + 3*z, 6);
+
+	vector<ex> reference(ntasks);
+	task_range all = { 0, 1, &reference };
+	walltimer omega;
+	omega.start();
+	run_tasks(all);
+	const double t1 = omega.read();
+	cout << '.' << flush;
+
+#ifdef GINAC_THREAD_SAFE
+	unsigned maxthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (maxthreads > ntasks)
+		maxthreads = ntasks;
+	vector<double> times;
+	vector<unsigned> counts;
+	for (unsigned nthreads = 2; nthreads <= maxthreads; nthreads *= 2) {
+		vector<ex> results(ntasks);
+		omega.start();
+		run_threaded(nthreads, results);
+		times.push_back(omega.read());
+		counts.push_back(nthreads);
+		result += check_results(reference, results, nthreads);
+		cout << '.' << flush;
+	}
+	cout << t1 << "s (1 thread)";
+	for (size_t i = 0; i < times.size(); ++i)
+		cout << ", " << times[i] << "s (" << counts[i] << " threads, speedup "
+		     << t1/times[i] << ')';
+	cout << endl;
+#else
+	cout << t1 << "s (single-threaded, library not thread-safe)" << endl;
+#endif
+
+	return result;
+}
+
+extern void randomify_symbol_serials();
+
+int main(int argc, char** argv)
+{
+	setup_benchmark();
+	randomify_symbol_serials();
+	cout << setprecision(2) << showpoint;
+	return time_threads();
+}
@@ -1883,6 +1883,7 @@ run_with_random_intputs(const unsigned d1, const unsigned d2)
 
 int main(int argc, char** argv)
 {
+	setup_benchmark();
 	std::cout << "timing univarite GCD" << std::endl << std::flush;
 	run_with_random_intputs(100, 50);
 	// run PRS gcd tests, both with upoly and ex
@@ -32,6 +32,10 @@
 #include "config.h"
 #endif
 #include "timer.h"
+#include "ginac.h"
+
+#include <cstdlib>
+#include <iostream>
 
 timer::timer() : on(false)
 {
@@ -101,3 +105,81 @@ bool timer::running()
 {
 	return on;
 }
+
+#ifdef HAVE_UNISTD_H
+#include <sys/time.h>
+#else
+#include <ctime>
+#endif
+
+static double wallclock()
+{
+#ifdef HAVE_UNISTD_H
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+#else
+	return double(std::time(0));
+#endif
+}
+
+walltimer::walltimer() : on(false)
+{
+	start_time = stop_time = wallclock();
+}
+
+void walltimer::start()
+{
+	on = true;
+	start_time = stop_time = wallclock();
+}
+
+void walltimer::stop()
+{
+	on = false;
+	stop_time = wallclock();
+}
+
+double walltimer::read()
+{
+	if (running())
+		stop_time = wallclock();
+	return stop_time - start_time;
+}
+
+bool walltimer::running()
+{
+	return on;
+}
+
+/** Print the reports requested from setup_benchmark(). */
+static void print_benchmark_reports()
+{
+	using namespace GiNaC;
+	if (std::getenv("GINAC_ALLOCATION_REPORT")) {
+		// Since chunks are never returned, their number also tells the
+		// peak memory used for small objects.
+		const allocation_counters c = get_allocation_counters();
+		std::cerr << "allocations: " << c.pooled << " pooled in " << c.chunks
+		          << " chunks (" << c.pooled - c.chunks << " saved), "
+		          << c.large << " large, " << c.released << " released, "
+		          << c.chunks * 64 << " KiB in chunks" << std::endl;
+		if (get_hash_consing())
+			std::cerr << "hash-consing table: " << hash_consing_table_size()
+			          << " objects" << std::endl;
+	}
+	// with GiNaC and the timings compiled with GINAC_COUNT_REFERENCES
+	// defined, this includes the reference count operations
+	if (stats::is_enabled())
+		std::cerr << stats::snapshot();
+}
+
+void setup_benchmark()
+{
+	using namespace GiNaC;
+	if (std::getenv("GINAC_HASH_CONSING"))
+		set_hash_consing(true);
+	if (std::getenv("GINAC_STATS"))
+		stats::enable();
+	std::atexit(print_benchmark_reports);
+}
@@ -50,4 +50,27 @@ private:
 #endif
 };
 
+/** A stop watch measuring elapsed real time instead of CPU time.  Needed
+ *  for timing multi-threaded code, where CPU time adds up over all threads. */
+class walltimer {
+public:
+	walltimer();
+	void start();
+	void stop();
+	double read();
+	bool running();
+private:
+	bool on;
+	double start_time, stop_time;
+};
+
+/** Apply the switches for the timings given by environment variables.
+ *  GINAC_HASH_CONSING switches hash-consing on and GINAC_STATS counting
+ *  (see stats.h).  When the program exits, the counters are printed if
+ *  counting is on, and the allocation counters and the size of the
+ *  hash-consing table if GINAC_ALLOCATION_REPORT is set.  Every timing
+ *  program calls this first thing in main(), so that a run with and one
+ *  without a switch can be compared. */
+void setup_benchmark();
+
 #endif // ndef TIMER_H
@@ -8,4 +8,4 @@ Description: C++ library for symbolic calculations
 Version: @GINAC_VERSION@
 Requires: cln >= 1.2.2
 Libs: -L${libdir} -lginac @GINACLIB_RPATH@
-Cflags: -I${includedir}
+Cflags: -I${includedir} @GINACLIB_CPPFLAGS@
@@ -41,7 +41,8 @@ public:
 	add(const exvector & v);
 	add(const epvector & v);
 	add(const epvector & v, const ex & oc);
-	add(std::auto_ptr<epvector> vp, const ex & oc);
+	add(epvector && vp);
+	add(epvector && vp, const ex & oc);
 	
 	// functions overriding virtual functions from base classes
 public:
@@ -68,7 +69,7 @@ protected:
 	unsigned return_type() const;
 	return_type_t return_type_tinfo() const;
 	ex thisexpairseq(const epvector & v, const ex & oc, bool do_index_renaming = false) const;
-	ex thisexpairseq(std::auto_ptr<epvector> vp, const ex & oc, bool do_index_renaming = false) const;
+	ex thisexpairseq(epvector && vp, const ex & oc, bool do_index_renaming = false) const;
 	expair split_ex_to_pair(const ex & e) const;
 	expair combine_ex_with_coeff_to_pair(const ex & e,
 	                                     const ex & c) const;
@@ -56,14 +56,16 @@ GINAC_IMPLEMENT_REGISTERED_CLASS_OPT(basic, void,
 /** basic copy constructor: implicitly assumes that the other class is of
  *  the exact same type (as it's used by duplicate()), so it can copy the
  *  tinfo_key and the hash value. */
-basic::basic(const basic & other) : flags(other.flags & ~status_flags::dynallocated), hashvalue(other.hashvalue)
+basic::basic(const basic & other) : flags(other.flags & ~(status_flags::dynallocated | status_flags::unique)), hashvalue(other.hashvalue)
 {
 }
 
 /** basic assignment operator: the other object might be of a derived class. */
 const basic & basic::operator=(const basic & other)
 {
-	unsigned fl = other.flags & ~status_flags::dynallocated;
+	if (flags & status_flags::unique)
+		unregister_unique(*this);
+	unsigned fl = other.flags & ~(status_flags::dynallocated | status_flags::unique);
 	if (typeid(*this) != typeid(other)) {
 		// The other object is of a derived class, so clear the flags as they
 		// might no longer apply (especially hash_calculated). Oh, and don't
@@ -129,6 +131,12 @@ void basic::print_dispatch(const registered_class_info & ri, const print_context
 	const registered_class_info * reg_info = &ri;
 	const print_context_class_info * pc_info = &c.get_class_info();
 
+	// print_csrc_cse outputs statements for the whole expression
+	if (pc_info == &print_csrc_cse::get_class_info_static()) {
+		static_cast<const print_csrc_cse &>(c).print_statements(*this);
+		return;
+	}
+
 next_class:
 	const std::vector<print_functor> & pdt = reg_info->options.get_print_dispatch_table();
 
@@ -827,16 +835,12 @@ ex basic::expand(unsigned options) const
  *  1 greater. */
 int basic::compare(const basic & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_basic_compares++;
-#endif
+	stats::count(stats::basic_compares);
 	const unsigned hash_this = gethash();
 	const unsigned hash_other = other.gethash();
 	if (hash_this<hash_other) return -1;
 	if (hash_this>hash_other) return 1;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.compare_same_hashvalue++;
-#endif
+	stats::count(stats::compare_same_hashvalue);
 
 	const std::type_info& typeid_this = typeid(*this);
 	const std::type_info& typeid_other = typeid(other);
@@ -851,9 +855,7 @@ int basic::compare(const basic & other) const
 // 			std::cout << std::endl;
 // 		}
 // 		return cmpval;
-#ifdef GINAC_COMPARE_STATISTICS
-		compare_statistics.compare_same_type++;
-#endif
+		stats::count(stats::compare_same_type);
 		return compare_same_type(other);
 	} else {
 // 		std::cout << "hash collision, different types: " 
@@ -874,20 +876,14 @@ int basic::compare(const basic & other) const
  *  @see is_equal_same_type */
 bool basic::is_equal(const basic & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_basic_is_equals++;
-#endif
+	stats::count(stats::basic_is_equals);
 	if (this->gethash()!=other.gethash())
 		return false;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.is_equal_same_hashvalue++;
-#endif
+	stats::count(stats::is_equal_same_hashvalue);
 	if (typeid(*this) != typeid(other))
 		return false;
 	
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.is_equal_same_type++;
-#endif
+	stats::count(stats::is_equal_same_type);
 	return is_equal_same_type(other);
 }
 
@@ -907,6 +903,8 @@ void basic::ensure_if_modifiable() const
 {
 	if (get_refcount() > 1)
 		throw(std::runtime_error("cannot modify multiply referenced object"));
+	if (flags & status_flags::unique)
+		unregister_unique(*this);
 	clearflag(status_flags::hash_calculated | status_flags::evaluated);
 }
 
@@ -916,27 +914,4 @@ void basic::ensure_if_modifiable() const
 
 int max_recursion_level = 1024;
 
-
-#ifdef GINAC_COMPARE_STATISTICS
-compare_statistics_t::~compare_statistics_t()
-{
-	std::clog << "ex::compare() called " << total_compares << " times" << std::endl;
-	std::clog << "nontrivial compares: " << nontrivial_compares << " times" << std::endl;
-	std::clog << "basic::compare() called " << total_basic_compares << " times" << std::endl;
-	std::clog << "same hashvalue in compare(): " << compare_same_hashvalue << " times" << std::endl;
-	std::clog << "compare_same_type() called " << compare_same_type << " times" << std::endl;
-	std::clog << std::endl;
-	std::clog << "ex::is_equal() called " << total_is_equals << " times" << std::endl;
-	std::clog << "nontrivial is_equals: " << nontrivial_is_equals << " times" << std::endl;
-	std::clog << "basic::is_equal() called " << total_basic_is_equals << " times" << std::endl;
-	std::clog << "same hashvalue in is_equal(): " << is_equal_same_hashvalue << " times" << std::endl;
-	std::clog << "is_equal_same_type() called " << is_equal_same_type << " times" << std::endl;
-	std::clog << std::endl;
-	std::clog << "basic::gethash() called " << total_gethash << " times" << std::endl;
-	std::clog << "used cached hashvalue " << gethash_cached << " times" << std::endl;
-}
-
-compare_statistics_t compare_statistics;
-#endif
-
 } // namespace GiNaC
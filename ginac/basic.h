@@ -24,9 +24,12 @@
 #define GINAC_BASIC_H
 
 #include "flags.h"
+#include "pool_alloc.h"
 #include "ptr.h"
+#include "unique_table.h"
 #include "assertion.h"
 #include "registrar.h"
+#include "stats.h"
 
 // CINT needs <algorithm> to work properly with <vector>
 #include <algorithm>
@@ -50,36 +53,6 @@ typedef std::vector<ex> exvector;
 typedef std::set<ex, ex_is_less> exset;
 typedef std::map<ex, ex, ex_is_less> exmap;
 
-// Define this to enable some statistical output for comparisons and hashing
-#undef GINAC_COMPARE_STATISTICS
-
-#ifdef GINAC_COMPARE_STATISTICS
-class compare_statistics_t {
-public:
-	compare_statistics_t()
-	 : total_compares(0), nontrivial_compares(0), total_basic_compares(0), compare_same_hashvalue(0), compare_same_type(0),
-	   total_is_equals(0), nontrivial_is_equals(0), total_basic_is_equals(0), is_equal_same_hashvalue(0), is_equal_same_type(0),
-	   total_gethash(0), gethash_cached(0) {}
-	~compare_statistics_t();
-
-	unsigned long total_compares;
-	unsigned long nontrivial_compares;
-	unsigned long total_basic_compares;
-	unsigned long compare_same_hashvalue;
-	unsigned long compare_same_type;
-
-	unsigned long total_is_equals;
-	unsigned long nontrivial_is_equals;
-	unsigned long total_basic_is_equals;
-	unsigned long is_equal_same_hashvalue;
-	unsigned long is_equal_same_type;
-
-	unsigned long total_gethash;
-	unsigned long gethash_cached;
-};
-
-extern compare_statistics_t compare_statistics;
-#endif
 
 
 /** Function object for map(). */
@@ -106,6 +79,7 @@ class basic : public refcounted
 	GINAC_DECLARE_REGISTERED_CLASS_NO_CTORS(basic, void)
 	
 	friend class ex;
+	friend ptr<basic> unique_instance(const basic & obj);
 	
 	// default constructor, destructor, copy constructor and assignment operator
 protected:
@@ -117,10 +91,18 @@ public:
 	virtual ~basic()
 	{
 		GINAC_ASSERT((!(flags & status_flags::dynallocated)) || (get_refcount() == 0));
+		if (flags & status_flags::unique)
+			unregister_unique(*this);
 	}
 	basic(const basic & other);
 	const basic & operator=(const basic & other);
 
+	// All objects are allocated by the small object allocator.
+	static void *operator new(std::size_t size) { return pool_allocate(size); }
+	static void operator delete(void *p, std::size_t size) { pool_deallocate(p, size); }
+	static void *operator new(std::size_t, void *p) throw() { return p; }
+	static void operator delete(void *, void *) throw() {}
+
 protected:
 	// new virtual functions which can be overridden by derived classes
 public: // only const functions please (may break reference counting)
@@ -266,24 +248,47 @@ public:
 
 	unsigned gethash() const
 	{
-#ifdef GINAC_COMPARE_STATISTICS
-		compare_statistics.total_gethash++;
-#endif
+#ifdef GINAC_THREAD_SAFE
+		// The acquire pairs with the release in setflag(), so a set
+		// hash_calculated flag guarantees a visible hashvalue.  Concurrent
+		// calchash() calls are harmless because they store the same value.
+		if (__atomic_load_n(&flags, __ATOMIC_ACQUIRE) & status_flags::hash_calculated) {
+#else
 		if (flags & status_flags::hash_calculated) {
-#ifdef GINAC_COMPARE_STATISTICS
-			compare_statistics.gethash_cached++;
 #endif
+			stats::count(stats::gethash_cached);
 			return hashvalue;
 		} else {
+			stats::count(stats::gethash_computed);
 			return calchash();
 		}
 	}
 
+#ifdef GINAC_THREAD_SAFE
 	/** Set some status_flags. */
-	const basic & setflag(unsigned f) const {flags |= f; return *this;}
+	const basic & setflag(unsigned f) const
+	{
+		__atomic_fetch_or(&flags, f, __ATOMIC_ACQ_REL);
+		if (f & status_flags::dynallocated)
+			stats::count_allocation(*this);
+		return *this;
+	}
+
+	/** Clear some status_flags. */
+	const basic & clearflag(unsigned f) const {__atomic_fetch_and(&flags, ~f, __ATOMIC_ACQ_REL); return *this;}
+#else
+	/** Set some status_flags. */
+	const basic & setflag(unsigned f) const
+	{
+		flags |= f;
+		if (f & status_flags::dynallocated)
+			stats::count_allocation(*this);
+		return *this;
+	}
 
 	/** Clear some status_flags. */
 	const basic & clearflag(unsigned f) const {flags &= ~f; return *this;}
+#endif
 
 protected:
 	void ensure_if_modifiable() const;
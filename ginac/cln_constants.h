@@ -0,0 +1,114 @@
+/** @file cln_constants.h
+ *
+ *  Thread-safe access to CLN's global caches of mathematical constants. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_CLN_CONSTANTS_H
+#define GINAC_CLN_CONSTANTS_H
+
+#include <cln/complex.h>
+#include <cln/float.h>
+
+namespace GiNaC {
+
+/** CLN keeps Pi, log(2), e, zeta(3), Euler's and Catalan's constant at the
+ *  highest precision asked for so far in global caches.  Its transcendental
+ *  functions of long floats round these caches to the precision they need,
+ *  which only reads them.  But if they need the precision of a cache
+ *  exactly, they take a reference to it, and if they need more, they
+ *  replace it, both with non-atomic reference counts.  Machine precision
+ *  floats (at most 15 decimal digits) are worse: CLN keeps their constants
+ *  in static objects whose reference counts change on every use.
+ *
+ *  So CLN's transcendental functions may only be called while the calling
+ *  thread holds a cln_constants_lock for the constants they use and for the
+ *  precision and magnitude of their arguments.  For long floats, the lock
+ *  first makes sure, holding it exclusively, that the caches are longer
+ *  than anything the computation may ask for, growing them if needed, and
+ *  then is held shared, so that several threads compute at the same time,
+ *  also at different precisions.  For machine precision floats the lock is
+ *  held exclusively.  Results must be copied with unshared() before the
+ *  lock is released.  A thread may take the lock again while it holds it,
+ *  but this may release it in between.  The lock does nothing unless the
+ *  library was configured with --enable-thread-safe. */
+class cln_constants_lock {
+public:
+	/** The constants, for the first argument of the constructors. */
+	enum {
+		pi = 1,
+		ln2 = 2,
+		exp1 = 4,
+		zeta3 = 8,
+		eulerconst = 16,
+		catalanconst = 32,
+		elementary = pi | ln2 | exp1  ///< used by exp, log, non-integer powers, trigonometric and hyperbolic functions
+	};
+	/** Lock for a computation with arguments of the precision and magnitude of x. */
+	cln_constants_lock(unsigned constants, const cln::cl_N & x);
+	/** Lock for a computation with two arguments, such as x^y. */
+	cln_constants_lock(unsigned constants, const cln::cl_N & x, const cln::cl_N & y);
+	/** Lock for a computation at precision prec with arguments of magnitude about 1. */
+	cln_constants_lock(unsigned constants, const cln::float_format_t & prec);
+	~cln_constants_lock();
+private:
+	cln_constants_lock(const cln_constants_lock &);             // not copyable
+	cln_constants_lock & operator=(const cln_constants_lock &);
+};
+
+/** Copy of the number x which shares no storage with it. */
+template <class T>
+inline const T unshared(const T & x)
+{
+	return -(-x);
+}
+
+inline const cln::cl_N cln_exp(const cln::cl_N & x)
+{
+	cln_constants_lock lock(cln_constants_lock::elementary, x);
+	return unshared(cln::exp(x));
+}
+
+inline const cln::cl_N cln_log(const cln::cl_N & x)
+{
+	cln_constants_lock lock(cln_constants_lock::elementary, x);
+	return unshared(cln::log(x));
+}
+
+inline const cln::cl_N cln_sin(const cln::cl_N & x)
+{
+	cln_constants_lock lock(cln_constants_lock::elementary, x);
+	return unshared(cln::sin(x));
+}
+
+inline const cln::cl_N cln_expt(const cln::cl_N & x, const cln::cl_N & y)
+{
+	cln_constants_lock lock(cln_constants_lock::elementary, x, y);
+	return unshared(cln::expt(x, y));
+}
+
+inline const cln::cl_F cln_zeta(int s, const cln::float_format_t & prec)
+{
+	cln_constants_lock lock(cln_constants_lock::elementary | cln_constants_lock::zeta3, prec);
+	return unshared(cln::zeta(s, prec));
+}
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_CLN_CONSTANTS_H
@@ -148,14 +148,16 @@ public:
 
 		if (discardable)
 			this->seq.swap(const_cast<STLT &>(s));
-		else
+		else {
+			stats::count(stats::sequence_copies);
 			this->seq = s;
+		}
 	}
 
-	explicit container(std::auto_ptr<STLT> vp)
+	explicit container(STLT && v)
 	{
 		setflag(get_default_flags());
-		this->seq.swap(*vp);
+		this->seq.swap(v);
 	}
 
 	container(exvector::const_iterator b, exvector::const_iterator e)
@@ -412,7 +414,7 @@ protected:
 			newcont->push_back(x);
 		}
 		if (newcont) {
-			ex result = thiscontainer(*newcont);
+			ex result = thiscontainer(std::move(*newcont));
 			delete newcont;
 			return result;
 		}
@@ -427,7 +429,7 @@ protected:
 		const_iterator e = end();
 		for(const_iterator i=b; i!=e; ++i)
 			cont.push_back(i->real_part());
-		return thiscontainer(cont);
+		return thiscontainer(std::move(cont));
 	}
 
 	ex imag_part() const
@@ -438,7 +440,7 @@ protected:
 		const_iterator e = end();
 		for(const_iterator i=b; i!=e; ++i)
 			cont.push_back(i->imag_part());
-		return thiscontainer(cont);
+		return thiscontainer(std::move(cont));
 	}
 
 	bool is_equal_same_type(const basic & other) const;
@@ -447,11 +449,11 @@ protected:
 protected:
 	/** Similar to duplicate(), but with a preset sequence. Must be
 	 *  overridden by derived classes. */
-	virtual ex thiscontainer(const STLT & v) const { return container(v); }
+	virtual ex thiscontainer(const STLT & v) const { return (new container(v))->setflag(status_flags::dynallocated); }
 
 	/** Similar to duplicate(), but with a preset sequence (which gets
-	 *  deleted). Must be overridden by derived classes. */
-	virtual ex thiscontainer(std::auto_ptr<STLT> vp) const { return container(vp); }
+	 *  moved). Must be overridden by derived classes. */
+	virtual ex thiscontainer(STLT && v) const { return (new container(std::move(v)))->setflag(status_flags::dynallocated); }
 
 	virtual void printseq(const print_context & c, char openbracket, char delim,
 	                      char closebracket, unsigned this_precedence,
@@ -495,7 +497,7 @@ protected:
 	void do_print_python(const print_python & c, unsigned level) const;
 	void do_print_python_repr(const print_python_repr & c, unsigned level) const;
 	STLT evalchildren(int level) const;
-	std::auto_ptr<STLT> subschildren(const exmap & m, unsigned options = 0) const;
+	STLT subschildren(const exmap & m, unsigned options = 0) const;
 };
 
 /** Default constructor */
@@ -582,9 +584,9 @@ ex container<C>::subs(const exmap & m, unsigned options) const
 	// f(x).subs(x==f^-1(x))
 	//   -> f(f^-1(x))  [subschildren]
 	//   -> x           [eval]   /* must not subs(x==f^-1(x))! */
-	std::auto_ptr<STLT> vp = subschildren(m, options);
-	if (vp.get()) {
-		ex result(thiscontainer(vp));
+	STLT subsed = subschildren(m, options);
+	if (!subsed.empty()) {
+		ex result(thiscontainer(std::move(subsed)));
 		if (is_a<container<C> >(result))
 			return ex_to<basic>(result).subs_one_level(m, options);
 		else
@@ -751,11 +753,9 @@ typename container<C>::STLT container<C>::evalchildren(int level) const
 }
 
 template <template <class T, class = std::allocator<T> > class C>
-std::auto_ptr<typename container<C>::STLT> container<C>::subschildren(const exmap & m, unsigned options) const
+typename container<C>::STLT container<C>::subschildren(const exmap & m, unsigned options) const
 {
-	// returns a NULL pointer if nothing had to be substituted
-	// returns a pointer to a newly created STLT otherwise
-	// (and relinquishes responsibility for the STLT)
+	// returns an empty STLT if nothing had to be substituted
 
 	const_iterator cit = this->seq.begin(), end = this->seq.end();
 	while (cit != end) {
@@ -763,16 +763,16 @@ std::auto_ptr<typename container<C>::STLT> container<C>::subschildren(const exma
 		if (!are_ex_trivially_equal(*cit, subsed_ex)) {
 
 			// copy first part of seq which hasn't changed
-			std::auto_ptr<STLT> s(new STLT(this->seq.begin(), cit));
-			this->reserve(*s, this->seq.size());
+			STLT s(this->seq.begin(), cit);
+			this->reserve(s, this->seq.size());
 
 			// insert changed element
-			s->push_back(subsed_ex);
+			s.push_back(subsed_ex);
 			++cit;
 
 			// copy rest
 			while (cit != end) {
-				s->push_back(cit->subs(m, options));
+				s.push_back(cit->subs(m, options));
 				++cit;
 			}
 
@@ -782,7 +782,7 @@ std::auto_ptr<typename container<C>::STLT> container<C>::subschildren(const exma
 		++cit;
 	}
 	
-	return std::auto_ptr<STLT>(0); // nothing has changed
+	return STLT(); // nothing has changed
 }
 
 } // namespace GiNaC
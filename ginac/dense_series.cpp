@@ -0,0 +1,383 @@
+/** @file dense_series.cpp
+ *
+ *  Implementation of truncated Laurent series with densely stored
+ *  coefficients. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "dense_series.h"
+#include "add.h"
+#include "inifcns.h" // for Order function
+#include "operators.h"
+#include "power.h"
+#include "pseries.h"
+#include "relational.h"
+#include "utils.h"
+
+#include <algorithm>
+
+namespace GiNaC {
+
+/*
+ *  Arithmetic of vectors of numeric coefficients
+ */
+
+typedef std::vector<numeric> numvec;
+
+/** Coefficients of the product of the polynomials with coefficient vectors
+ *  a and b, by the schoolbook method. */
+static numvec mul_schoolbook(const numvec & a, const numvec & b)
+{
+	numvec r(a.size() + b.size() - 1);
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i].is_zero())
+			continue;
+		for (size_t j = 0; j < b.size(); ++j)
+			r[i + j] += a[i] * b[j];
+	}
+	return r;
+}
+
+static numvec mul_karatsuba(const numvec & a, const numvec & b);
+
+/** Coefficients of the product of the polynomials with coefficient vectors
+ *  a and b, a being at least twice as long as b.  a is cut into blocks of
+ *  the length of b, which are multiplied by b separately. */
+static numvec mul_blockwise(const numvec & a, const numvec & b)
+{
+	numvec r(a.size() + b.size() - 1);
+	for (size_t k = 0; k < a.size(); k += b.size()) {
+		const numvec block(a.begin() + k, a.begin() + std::min(k + b.size(), a.size()));
+		const numvec z = mul_karatsuba(block, b);
+		for (size_t i = 0; i < z.size(); ++i)
+			r[k + i] += z[i];
+	}
+	return r;
+}
+
+/** Coefficients of the product of the polynomials with coefficient vectors
+ *  a and b, by Karatsuba's algorithm. */
+static numvec mul_karatsuba(const numvec & a, const numvec & b)
+{
+	if (a.empty() || b.empty())
+		return numvec();
+	if (std::min(a.size(), b.size()) < karatsuba_series_threshold)
+		return mul_schoolbook(a, b);
+
+	// If one factor is at most half as long as the other, its upper half
+	// below would be empty and z0 computed twice.
+	if (a.size() >= 2*b.size())
+		return mul_blockwise(a, b);
+	if (b.size() >= 2*a.size())
+		return mul_blockwise(b, a);
+
+	// a = a0 + x^m*a1, b = b0 + x^m*b1, where a1 and b1 are not empty
+	const size_t m = std::max(a.size(), b.size()) / 2;
+	numvec a0(a.begin(), a.begin() + m);
+	numvec a1(a.begin() + m, a.end());
+	numvec b0(b.begin(), b.begin() + m);
+	numvec b1(b.begin() + m, b.end());
+
+	numvec z0 = mul_karatsuba(a0, b0);
+	numvec z2 = mul_karatsuba(a1, b1);
+	numvec sa = a0, sb = b0;
+	sa.resize(std::max(a0.size(), a1.size()));
+	sb.resize(std::max(b0.size(), b1.size()));
+	for (size_t i = 0; i < a1.size(); ++i)
+		sa[i] += a1[i];
+	for (size_t i = 0; i < b1.size(); ++i)
+		sb[i] += b1[i];
+	numvec z1 = mul_karatsuba(sa, sb);
+	for (size_t i = 0; i < z0.size(); ++i)
+		z1[i] -= z0[i];
+	for (size_t i = 0; i < z2.size(); ++i)
+		z1[i] -= z2[i];
+
+	numvec r(a.size() + b.size() - 1);
+	for (size_t i = 0; i < z0.size(); ++i)
+		r[i] += z0[i];
+	for (size_t i = 0; i < z1.size() && i + m < r.size(); ++i)
+		r[i + m] += z1[i];
+	for (size_t i = 0; i < z2.size(); ++i)
+		r[i + 2*m] += z2[i];
+	return r;
+}
+
+/** First n coefficients of the product of the polynomials with coefficient
+ *  vectors a and b. */
+static numvec mul_truncated(const numvec & a, const numvec & b, size_t n)
+{
+	numvec r = mul_karatsuba(numvec(a.begin(), a.begin() + std::min(n, a.size())),
+	                         numvec(b.begin(), b.begin() + std::min(n, b.size())));
+	r.resize(n);
+	return r;
+}
+
+/** First n coefficients of the reciprocal of the power series with
+ *  coefficient vector a, a[0] being nonzero, by Newton iteration
+ *    b <- b + b*(1 - a*b),
+ *  which doubles the number of correct coefficients in every step. */
+static numvec inverse_newton(const numvec & a, size_t n)
+{
+	numvec b(1, a[0].inverse());
+	size_t k = 1;
+	while (k < n) {
+		k = std::min(2*k, n);
+		numvec e = mul_truncated(a, b, k);
+		for (size_t i = 0; i < k; ++i)
+			e[i] = -e[i];
+		e[0] += *_num1_p;
+		numvec t = mul_truncated(b, e, k);
+		b.resize(k);
+		for (size_t i = 0; i < k; ++i)
+			b[i] += t[i];
+	}
+	return b;
+}
+
+
+/*
+ *  Class dense_series
+ */
+
+dense_series::dense_series(int ldeg_, const exvector & c_, bool truncated_)
+  : ldeg(ldeg_), c(c_), truncated(truncated_)
+{
+	normalize();
+}
+
+dense_series::dense_series(const pseries & s) : ldeg(0), truncated(false)
+{
+	if (s.nops() == 0)
+		return;
+
+	ldeg = ex_to<numeric>(s.exponop(0)).to_int();
+	for (size_t i = 0; i < s.nops(); ++i) {
+		const size_t e = ex_to<numeric>(s.exponop(i)).to_int() - ldeg;
+		c.resize(e, _ex0);
+		if (is_order_function(s.coeffop(i))) {
+			truncated = true;
+			break;
+		}
+		c.push_back(s.coeffop(i));
+	}
+	normalize();
+}
+
+pseries dense_series::to_pseries(const ex & r) const
+{
+	epvector seq;
+	for (size_t i = 0; i < c.size(); ++i) {
+		if (!c[i].is_zero())
+			seq.push_back(expair(c[i], numeric(ldeg + int(i))));
+	}
+	if (truncated)
+		seq.push_back(expair(Order(_ex1), numeric(ldeg + int(c.size()))));
+	return pseries(r, seq);
+}
+
+const ex & dense_series::coeff(int n) const
+{
+	if (n < ldeg || n >= ldeg + int(c.size()))
+		return _ex0;
+	return c[n - ldeg];
+}
+
+/** Remove zero coefficients at the beginning and, if the series terminates,
+ *  at the end. */
+void dense_series::normalize()
+{
+	size_t lead = 0;
+	while (lead < c.size() && c[lead].is_zero())
+		++lead;
+	if (lead == c.size() && !truncated) {
+		c.clear();
+		ldeg = 0;
+		return;
+	}
+	c.erase(c.begin(), c.begin() + lead);
+	ldeg += lead;
+	if (!truncated) {
+		while (c.back().is_zero())
+			c.pop_back();
+	}
+}
+
+bool dense_series::has_numeric_coeffs() const
+{
+	for (exvector::const_iterator i = c.begin(); i != c.end(); ++i) {
+		if (!is_exactly_a<numeric>(*i))
+			return false;
+	}
+	return true;
+}
+
+/** Product of two series.  Large series with numeric coefficients are
+ *  multiplied by Karatsuba's algorithm. */
+dense_series dense_series::mul(const dense_series & other) const
+{
+	if (is_zero() || other.is_zero())
+		return dense_series();
+
+	// Number of coefficients of the product
+	const int new_ldeg = ldeg + other.ldeg;
+	size_t n = c.empty() || other.c.empty() ? 0 : c.size() + other.c.size() - 1;
+	const bool new_truncated = truncated || other.truncated;
+	if (new_truncated) {
+		int new_order = std::numeric_limits<int>::max();
+		if (truncated)
+			new_order = order() + other.ldeg;
+		if (other.truncated)
+			new_order = std::min(new_order, other.order() + ldeg);
+		n = std::max(new_order - new_ldeg, 0);
+	}
+
+	exvector r(n, _ex0);
+	if (std::min(c.size(), other.c.size()) >= karatsuba_series_threshold &&
+	    has_numeric_coeffs() && other.has_numeric_coeffs()) {
+		numvec a(c.size()), b(other.c.size());
+		for (size_t i = 0; i < c.size(); ++i)
+			a[i] = ex_to<numeric>(c[i]);
+		for (size_t i = 0; i < other.c.size(); ++i)
+			b[i] = ex_to<numeric>(other.c[i]);
+		numvec p = mul_truncated(a, b, n);
+		for (size_t k = 0; k < n; ++k)
+			r[k] = p[k];
+	} else {
+		for (size_t k = 0; k < n; ++k) {
+			// r[k] = c[0]*other.c[k] + ... + c[k]*other.c[0]
+			exvector terms;
+			const size_t i_end = std::min(k + 1, c.size());
+			for (size_t i = k < other.c.size() ? 0 : k - other.c.size() + 1; i < i_end; ++i)
+				terms.push_back(c[i] * other.c[k - i]);
+			r[k] = (new add(terms))->setflag(status_flags::dynallocated);
+		}
+	}
+	return dense_series(new_ldeg, r, new_truncated);
+}
+
+/** Power of a series with nonzero leading coefficient, truncated at deg
+ *  or at the precision of the series, whichever comes first.
+ *  @see pseries::power_const */
+dense_series dense_series::power(const numeric & p, int deg) const
+{
+	GINAC_ASSERT(!c.empty() && (p * ldeg).is_integer());
+	const int new_ldeg = (p * ldeg).to_int();
+	size_t n = std::max(deg - new_ldeg, 0);
+	if (truncated)
+		n = std::min(n, c.size());
+	if (n == 0)
+		return dense_series(deg, exvector(), true);
+
+	exvector r;
+	r.reserve(n);
+	if (p.is_equal(*_num_1_p) && n >= karatsuba_series_threshold && has_numeric_coeffs()) {
+		numvec a(std::min(n, c.size()));
+		for (size_t i = 0; i < a.size(); ++i)
+			a[i] = ex_to<numeric>(c[i]);
+		numvec b = inverse_newton(a, n);
+		r.assign(b.begin(), b.end());
+		return dense_series(new_ldeg, r, true);
+	}
+
+	// Euler's recurrence
+	//   c_i = (i*p*a_i*c_0 + ((i-1)*p-1)*a_{i-1}*c_1 + ...
+	//                  ... + (p-(i-1))*a_1*c_{i-1})/(a_0*i)
+	r.push_back(GiNaC::power(c[0], p));
+	for (size_t i = 1; i < n; ++i) {
+		exvector terms;
+		const size_t j_end = std::min(i, c.size() - 1);
+		for (size_t j = 1; j <= j_end; ++j)
+			terms.push_back((p * j - (i - j)) * r[i - j] * c[j]);
+		ex sum = (new add(terms))->setflag(status_flags::dynallocated);
+		r.push_back(sum / c[0] / i);
+	}
+	return dense_series(new_ldeg, r, true);
+}
+
+/** Exponential of a series without negative powers, truncated at deg or at
+ *  the precision of the series, whichever comes first.  With a = a_0 + A,
+ *  E = exp(A) satisfies E' = A'*E, from which follows
+ *    e_n = (a_1*e_(n-1) + 2*a_2*e_(n-2) + ... + n*a_n*e_0)/n.
+ *  The coefficients are expanded, for they reappear in all later ones. */
+dense_series dense_series::exp(int deg) const
+{
+	GINAC_ASSERT(ldeg >= 0 || c.empty());
+	const ex a0 = GiNaC::exp(coeff(0));
+	size_t n = std::max(deg, 0);
+	if (truncated)
+		n = std::min(n, size_t(std::max(order(), 0)));
+	else if (ldeg + int(c.size()) <= 1) {
+		// constant
+		return dense_series(0, exvector(1, a0), false);
+	}
+
+	exvector r;
+	r.reserve(n);
+	if (n > 0)
+		r.push_back(_ex1);
+	for (size_t i = 1; i < n; ++i) {
+		exvector terms;
+		for (size_t k = 1; k <= i; ++k) {
+			const ex & ak = coeff(k);
+			if (!ak.is_zero())
+				terms.push_back(numeric(k) * ak * r[i - k]);
+		}
+		ex sum = (new add(terms))->setflag(status_flags::dynallocated);
+		r.push_back((sum / i).expand());
+	}
+	if (!a0.is_equal(_ex1)) {
+		for (size_t i = 0; i < n; ++i)
+			r[i] = (a0 * r[i]).expand();
+	}
+	return dense_series(0, r, true);
+}
+
+/** Logarithm of a series with constant term 1, truncated at deg or at the
+ *  precision of the series, whichever comes first.  L = log(a) satisfies
+ *  a*L' = a', from which follows
+ *    l_n = a_n - (a_(n-1)*l_1 + 2*a_(n-2)*l_2 + ... + (n-1)*a_1*l_(n-1))/n.
+ *  The coefficients are expanded, for they reappear in all later ones. */
+dense_series dense_series::log(int deg) const
+{
+	GINAC_ASSERT(ldeg == 0 && !c.empty() && c[0].is_equal(_ex1));
+	size_t n = std::max(deg, 0);
+	if (truncated)
+		n = std::min(n, c.size());
+	else if (c.size() == 1)
+		return dense_series();
+
+	exvector r;
+	r.reserve(n);
+	if (n > 0)
+		r.push_back(_ex0);
+	for (size_t i = 1; i < n; ++i) {
+		exvector terms;
+		for (size_t k = 1; k < i; ++k) {
+			const ex & ank = coeff(i - k);
+			if (!ank.is_zero())
+				terms.push_back(numeric(k) * ank * r[k]);
+		}
+		ex sum = (new add(terms))->setflag(status_flags::dynallocated);
+		r.push_back((coeff(i) - sum / i).expand());
+	}
+	return dense_series(0, r, true);
+}
+
+} // namespace GiNaC
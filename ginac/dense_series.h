@@ -0,0 +1,89 @@
+/** @file dense_series.h
+ *
+ *  Interface to truncated Laurent series with densely stored coefficients,
+ *  used internally for the arithmetic of pseries objects. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_DENSE_SERIES_H
+#define GINAC_DENSE_SERIES_H
+
+#include "ex.h"
+#include "numeric.h"
+
+#include <limits>
+
+namespace GiNaC {
+
+class pseries;
+class relational;
+
+/** Series multiplications in which both factors have at least this many
+ *  coefficients, all of them numbers, use Karatsuba's algorithm. */
+const size_t karatsuba_series_threshold = 32;
+
+/** Truncated Laurent series
+ *    c[0]*x^ldeg + c[1]*x^(ldeg+1) + ... + c[n-1]*x^(ldeg+n-1) + O(x^(ldeg+n))
+ *  in some expansion variable x, the order term only being present if the
+ *  series is truncated.  Unlike in a pseries, all coefficients up to the
+ *  order are stored, so that they are found by indexing.  Operations
+ *  compute each coefficient only once and use no coefficient beyond the
+ *  order of the operands. */
+class dense_series {
+public:
+	dense_series() : ldeg(0), truncated(false) {}
+	dense_series(int ldeg_, const exvector & c, bool truncated_);
+	explicit dense_series(const pseries & s);
+
+	/** Convert to a pseries in the expansion variable and point given by r. */
+	pseries to_pseries(const ex & r) const;
+
+	/** Exponent of the first stored coefficient.  If there are none, this
+	 *  is the exponent of the order term. */
+	int ldegree() const { return ldeg; }
+
+	/** Exponent of the last stored coefficient. */
+	int degree() const { return ldeg + int(c.size()) - 1; }
+
+	/** Exponent of the order term, or INT_MAX if the series terminates. */
+	int order() const { return truncated ? ldeg + int(c.size()) : std::numeric_limits<int>::max(); }
+
+	/** Check whether the series is the exact zero. */
+	bool is_zero() const { return c.empty() && !truncated; }
+
+	/** Coefficient of x^n, zero if n is outside the stored range. */
+	const ex & coeff(int n) const;
+
+	dense_series mul(const dense_series & other) const;
+	dense_series power(const numeric & p, int deg) const;
+	dense_series exp(int deg) const;
+	dense_series log(int deg) const;
+
+private:
+	void normalize();
+	bool has_numeric_coeffs() const;
+
+	int ldeg;       ///< exponent of c[0]
+	exvector c;     ///< coefficients
+	bool truncated; ///< whether the order term is present
+};
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_DENSE_SERIES_H
@@ -29,7 +29,9 @@
 #include "power.h"
 #include "lst.h"
 #include "relational.h"
+#include "unique_table.h"
 #include "utils.h"
+#include "polynomial/sparse_poly.h"
 
 #include <iostream>
 #include <stdexcept>
@@ -74,8 +76,14 @@ ex ex::expand(unsigned options) const
 {
 	if (options == 0 && (bp->flags & status_flags::expanded)) // The "expanded" flag only covers the standard options; someone might want to re-expand with different options
 		return *this;
-	else
-		return bp->expand(options);
+	stats::count(stats::expands);
+
+	// Products of polynomials over Q are multiplied out much faster in
+	// sparse distributed representation
+	ex result;
+	if (sparse_expand(*this, result, options))
+		return result;
+	return bp->expand(options);
 }
 
 /** Compute partial derivative of an expression.
@@ -307,6 +315,7 @@ ptr<basic> ex::construct_from_basic(const basic & other)
 		// apply eval() once more. The recursion stops when eval() calls
 		// hold() or returns an object that already has its "evaluated"
 		// flag set, such as a symbol or a numeric.
+		stats::count(stats::evals);
 		const ex & tmpex = other.eval(1);
 
 		// Eventually, the eval() recursion goes through the "else" branch
@@ -329,6 +338,18 @@ ptr<basic> ex::construct_from_basic(const basic & other)
 
 	} else {
 
+		// With hash-consing, use the registered object equal to this one.
+		// Like above, an unreferenced heap-allocated original is no longer
+		// needed if there is one.
+		if (get_hash_consing() &&
+		    !(other.flags & (status_flags::unique | status_flags::not_shareable)) &&
+		    is_hash_consable(other)) {
+			ptr<basic> u = unique_instance(other);
+			if (&*u != &other && (other.get_refcount() == 0) && (other.flags & status_flags::dynallocated))
+				delete &other;
+			return u;
+		}
+
 		// The easy case: making an "ex" out of an evaluated object.
 		if (other.flags & status_flags::dynallocated) {
 
@@ -29,7 +29,9 @@
 #include <functional>
 #include <iosfwd>
 #include <iterator>
+#include <memory>
 #include <stack>
+#include <utility>
 
 namespace GiNaC {
 #ifdef _MSC_VER
@@ -78,6 +80,16 @@ class ex {
 	// default constructor, copy constructor and assignment operator
 public:
 	ex() throw();
+	ex(const ex & other) = default;
+	ex & operator=(const ex & other) = default;
+
+	/** Take over the object of other, which is left holding zero, like a
+	 *  default constructed ex. */
+	ex(ex && other) throw();
+
+	/** Exchange the objects of this and other without any reference
+	 *  counting. */
+	ex & operator=(ex && other) = default;
 
 	// other constructors
 public:
@@ -261,6 +273,12 @@ ex::ex() throw() : bp(*const_cast<basic *>(_num0_bp))
 	GINAC_ASSERT(bp->flags & status_flags::dynallocated);
 }
 
+inline
+ex::ex(ex && other) throw() : ex()
+{
+	bp = std::move(other.bp);
+}
+
 inline
 ex::ex(const basic & other) : bp(construct_from_basic(other))
 {
@@ -306,16 +324,14 @@ ex::ex(const std::string &s, const ex &l) : bp(construct_from_string_and_lst(s,
 inline
 int ex::compare(const ex & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_compares++;
-#endif
+	stats::count(stats::compares);
 	if (bp == other.bp)  // trivial case: both expressions point to same basic
 		return 0;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.nontrivial_compares++;
-#endif
+	stats::count(stats::nontrivial_compares);
 	const int cmpval = bp->compare(*other.bp);
-#if 1
+#ifndef GINAC_THREAD_SAFE
+	// Sharing rebinds subexpressions of otherwise immutable trees, which
+	// would race with readers in other threads.
 	if (cmpval == 0) {
 		// Expressions point to different, but equal, trees: conserve
 		// memory and make subsequent compare() operations faster by
@@ -329,14 +345,10 @@ int ex::compare(const ex & other) const
 inline
 bool ex::is_equal(const ex & other) const
 {
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.total_is_equals++;
-#endif
+	stats::count(stats::is_equals);
 	if (bp == other.bp)  // trivial case: both expressions point to same basic
 		return true;
-#ifdef GINAC_COMPARE_STATISTICS
-	compare_statistics.nontrivial_is_equals++;
-#endif
+	stats::count(stats::nontrivial_is_equals);
 	const bool equal = bp->is_equal(*other.bp);
 #if 0
 	if (equal) {
@@ -373,9 +385,9 @@ public:
 
 	// This should return an ex*, but that would be a pointer to a
 	// temporary value
-	std::auto_ptr<ex> operator->() const
+	std::unique_ptr<ex> operator->() const
 	{
-		return std::auto_ptr<ex>(new ex(operator*()));
+		return std::unique_ptr<ex>(new ex(operator*()));
 	}
 
 	ex operator[](difference_type n) const
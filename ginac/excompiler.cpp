@@ -29,6 +29,7 @@
 #include "config.h"
 #endif
 
+#include "excompiler_jit.h"
 #include "ex.h"
 #include "lst.h"
 #include "operators.h"
@@ -47,6 +48,26 @@
 
 namespace GiNaC {
 
+static bool jit_on = true;
+
+void set_compile_ex_jit(bool on)
+{
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&jit_on, on, __ATOMIC_RELAXED);
+#else
+	jit_on = on;
+#endif
+}
+
+bool get_compile_ex_jit()
+{
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_load_n(&jit_on, __ATOMIC_RELAXED);
+#else
+	return jit_on;
+#endif
+}
+
 #ifdef HAVE_LIBDL
 	
 /**
@@ -66,6 +87,7 @@ class excompiler
 	struct filedesc
 	{
 		void* module;
+		void* function; /**< address of compiled_ex in the module */
 		std::string name; /**< filename with .so suffix */
 		bool clean_up; /**< if true, source and so-file will be deleted */
 	};
@@ -83,10 +105,11 @@ public:
 	/**
 	 * Adds a new module to the list.
 	 */
-	void add_opened_module(void* module, const std::string& name, bool clean_up)
+	void add_opened_module(void* module, void* function, const std::string& name, bool clean_up)
 	{
 		filedesc fd;
 		fd.module = module;
+		fd.function = function;
 		fd.name = name;
 		fd.clean_up = clean_up;
 		filelist.push_back(fd);
@@ -159,9 +182,10 @@ public:
 			throw std::runtime_error("excompiler::link_so_file: could not open compiled module!");
 		}
 
-		add_opened_module(module, filename, clean_up);
+		void* function = dlsym(module, "compiled_ex");
+		add_opened_module(module, function, filename, clean_up);
 
-		return dlsym(module, "compiled_ex");
+		return function;
 	}
 	/**
 	 * Removes a modules from the module list. Performs a clean-up before that.
@@ -178,6 +202,20 @@ public:
 			}
 		}
 	}
+	/**
+	 * Removes the module which provides the given function from the module
+	 * list. Performs a clean-up before that.
+	 */
+	void unlink(void* function)
+	{
+		for (std::vector<filedesc>::iterator it = filelist.begin(); it != filelist.end(); ++it) {
+			if (it->function == function) {
+				clean_up(it);
+				filelist.erase(it);
+				return;
+			}
+		}
+	}
 };
 
 /**
@@ -192,7 +230,7 @@ public:
  */
 static excompiler global_excompiler;
 
-void compile_ex(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::string filename)
+static void compile_ex_external(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::string filename)
 {
 	symbol x("x");
 	ex expr_with_x = expr.subs(lst(sym==x));
@@ -203,9 +241,8 @@ void compile_ex(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::stri
 
 	ofs << "double compiled_ex(double x)" << std::endl;
 	ofs << "{" << std::endl;
-	ofs << "double res = ";
-	expr_with_x.print(GiNaC::print_csrc_double(ofs));
-	ofs << ";" << std::endl;
+	ofs << "double res;" << std::endl;
+	expr_with_x.print(GiNaC::print_csrc_cse(ofs, "res"));
 	ofs << "return(res); " << std::endl;
 	ofs << "}" << std::endl;
 
@@ -217,7 +254,7 @@ void compile_ex(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::stri
 	fp = (FUNCP_1P) global_excompiler.link_so_file(unique_filename+".so", filename.empty());
 }
 
-void compile_ex(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P& fp, const std::string filename)
+static void compile_ex_external(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P& fp, const std::string filename)
 {
 	symbol x("x"), y("y");
 	ex expr_with_xy = expr.subs(lst(sym1==x, sym2==y));
@@ -228,9 +265,8 @@ void compile_ex(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P
 
 	ofs << "double compiled_ex(double x, double y)" << std::endl;
 	ofs << "{" << std::endl;
-	ofs << "double res = ";
-	expr_with_xy.print(GiNaC::print_csrc_double(ofs));
-	ofs << ";" << std::endl;
+	ofs << "double res;" << std::endl;
+	expr_with_xy.print(GiNaC::print_csrc_cse(ofs, "res"));
 	ofs << "return(res); " << std::endl;
 	ofs << "}" << std::endl;
 
@@ -242,7 +278,7 @@ void compile_ex(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P
 	fp = (FUNCP_2P) global_excompiler.link_so_file(unique_filename+".so", filename.empty());
 }
 
-void compile_ex(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::string filename)
+static void compile_ex_external(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::string filename)
 {
 	lst replacements;
 	for (std::size_t count=0; count<syms.nops(); ++count) {
@@ -251,9 +287,9 @@ void compile_ex(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::st
 		replacements.append(syms.op(count) == symbol(s.str()));
 	}
 
-	std::vector<ex> expr_with_cname;
+	lst expr_with_cname;
 	for (std::size_t count=0; count<exprs.nops(); ++count) {
-		expr_with_cname.push_back(exprs.op(count).subs(replacements));
+		expr_with_cname.append(exprs.op(count).subs(replacements));
 	}
 
 	std::ofstream ofs;
@@ -262,11 +298,7 @@ void compile_ex(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::st
 
 	ofs << "void compiled_ex(const int* an, const double a[], const int* fn, double f[])" << std::endl;
 	ofs << "{" << std::endl;
-	for (std::size_t count=0; count<exprs.nops(); ++count) {
-		ofs << "f[" << count << "] = ";
-		expr_with_cname[count].print(GiNaC::print_csrc_double(ofs));
-		ofs << ";" << std::endl;
-	}
+	ex(expr_with_cname).print(GiNaC::print_csrc_cse(ofs, "f"));
 	ofs << "}" << std::endl;
 
 	ofs.close();
@@ -310,17 +342,17 @@ void unlink_ex(const std::string filename)
  * stubs preserve the interface. Every function just raises an exception.
  */
 
-void compile_ex(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::string filename)
+static void compile_ex_external(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::string filename)
 {
 	throw std::runtime_error("compile_ex has been disabled because of missing libdl!");
 }
 
-void compile_ex(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P& fp, const std::string filename)
+static void compile_ex_external(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P& fp, const std::string filename)
 {
 	throw std::runtime_error("compile_ex has been disabled because of missing libdl!");
 }
 
-void compile_ex(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::string filename)
+static void compile_ex_external(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::string filename)
 {
 	throw std::runtime_error("compile_ex has been disabled because of missing libdl!");
 }
@@ -347,4 +379,83 @@ void unlink_ex(const std::string filename)
 
 #endif // def HAVE_LIBDL
 
+/*
+ * Functions produced by the built-in code generator are released directly,
+ * everything else must come from a module opened by compile_ex or link_ex.
+ */
+static void unlink_function(void* function)
+{
+	if (function == NULL || jit_release(function)) {
+		return;
+	}
+#ifdef HAVE_LIBDL
+	global_excompiler.unlink(function);
+#endif // def HAVE_LIBDL
+}
+
+void unlink_ex(FUNCP_1P fp)
+{
+	// This is not standard compliant! ... no conversion between
+	// pointer-to-functions and pointer-to-objects ...
+	unlink_function((void*) fp);
+}
+
+void unlink_ex(FUNCP_2P fp)
+{
+	// This is not standard compliant! ... no conversion between
+	// pointer-to-functions and pointer-to-objects ...
+	unlink_function((void*) fp);
+}
+
+void unlink_ex(FUNCP_CUBA fp)
+{
+	// This is not standard compliant! ... no conversion between
+	// pointer-to-functions and pointer-to-objects ...
+	unlink_function((void*) fp);
+}
+
+/*
+ * Unless intermediate files were requested, try the built-in code generator
+ * first and use the external compiler only if it fails.
+ */
+
+void compile_ex(const ex& expr, const symbol& sym, FUNCP_1P& fp, const std::string filename)
+{
+	if (filename.empty() && get_compile_ex_jit()) {
+		exvector params(1, sym);
+		if (void *code = jit_compile(exvector(1, expr), params, jit_1p)) {
+			fp = (FUNCP_1P) code;
+			return;
+		}
+	}
+	compile_ex_external(expr, sym, fp, filename);
+}
+
+void compile_ex(const ex& expr, const symbol& sym1, const symbol& sym2, FUNCP_2P& fp, const std::string filename)
+{
+	if (filename.empty() && get_compile_ex_jit()) {
+		exvector params;
+		params.push_back(sym1);
+		params.push_back(sym2);
+		if (void *code = jit_compile(exvector(1, expr), params, jit_2p)) {
+			fp = (FUNCP_2P) code;
+			return;
+		}
+	}
+	compile_ex_external(expr, sym1, sym2, fp, filename);
+}
+
+void compile_ex(const lst& exprs, const lst& syms, FUNCP_CUBA& fp, const std::string filename)
+{
+	if (filename.empty() && get_compile_ex_jit()) {
+		const exvector ev(exprs.begin(), exprs.end());
+		const exvector params(syms.begin(), syms.end());
+		if (void *code = jit_compile(ev, params, jit_cuba)) {
+			fp = (FUNCP_CUBA) code;
+			return;
+		}
+	}
+	compile_ex_external(exprs, syms, fp, filename);
+}
+
 } // namespace GiNaC
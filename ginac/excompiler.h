@@ -48,6 +48,22 @@ typedef double (*FUNCP_2P) (double, double);
  */
 typedef void (*FUNCP_CUBA) (const int*, const double[], const int*, double[]);
 
+/**
+ * Switches the built-in code generator of compile_ex on or off (it is on by
+ * default). The code generator translates expressions directly into machine
+ * code in memory, which is much faster than writing C source code and calling
+ * the external compiler. It is only available on x86-64 and only handles real
+ * numbers, constants, sums, products, powers and the elementary functions of
+ * the C library; for anything else, and when intermediate files are requested,
+ * compile_ex uses the external compiler.
+ */
+void set_compile_ex_jit(bool on);
+
+/**
+ * Returns whether the built-in code generator of compile_ex is switched on.
+ */
+bool get_compile_ex_jit();
+
 /**
  * Takes an expression and produces a function pointer to the compiled and linked
  * C code equivalent in double precision. The function pointer has type FUNCP_1P.
@@ -121,6 +137,18 @@ void link_ex(const std::string filename, FUNCP_CUBA& fp);
  */
 void unlink_ex(const std::string filename);
 
+/**
+ * Releases a function obtained from compile_ex or link_ex: the machine code
+ * produced by the built-in code generator is freed, a linked so-file is closed
+ * (and deleted if compile_ex created it without a filename). The function
+ * pointer must not be used afterwards.
+ *
+ * @param fp Function pointer to release
+ */
+void unlink_ex(FUNCP_1P fp);
+void unlink_ex(FUNCP_2P fp);
+void unlink_ex(FUNCP_CUBA fp);
+
 } // namespace GiNaC
 
 #endif // ndef GINAC_EXCOMPILER_H
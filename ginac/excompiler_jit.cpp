@@ -0,0 +1,486 @@
+/** @file excompiler_jit.cpp
+ *
+ *  In-process code generator used by compile_ex.
+ *
+ *  The expressions are first flattened into a list of three-address
+ *  instructions on double precision slots, where common subexpressions are
+ *  computed only once.  The instructions are then translated one by one
+ *  into x86-64 SSE2 machine code that keeps all slots in its stack frame
+ *  and calls the C library for elementary functions.  On other
+ *  architectures jit_compile() always fails and compile_ex falls back to
+ *  the external compiler. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "excompiler_jit.h"
+#include "add.h"
+#include "constant.h"
+#include "function.h"
+#include "mul.h"
+#include "numeric.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define GINAC_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+namespace GiNaC {
+
+namespace {
+
+typedef double (*unary_fcn)(double);
+typedef double (*binary_fcn)(double, double);
+
+struct unary_fcn_desc {
+	const char *name;
+	unary_fcn f;
+};
+
+/** GiNaC functions with a counterpart in the C library. */
+const unary_fcn_desc unary_fcns[] = {
+	{"abs", std::fabs},
+	{"sin", std::sin},
+	{"cos", std::cos},
+	{"tan", std::tan},
+	{"asin", std::asin},
+	{"acos", std::acos},
+	{"atan", std::atan},
+	{"sinh", std::sinh},
+	{"cosh", std::cosh},
+	{"tanh", std::tanh},
+	{"asinh", std::asinh},
+	{"acosh", std::acosh},
+	{"atanh", std::atanh},
+	{"exp", std::exp},
+	{"log", std::log},
+	{"lgamma", std::lgamma},
+	{"tgamma", std::tgamma}
+};
+
+enum opcode {
+	op_const,  ///< dst = value
+	op_param,  ///< dst = parameter number a
+	op_add,    ///< dst = a + b
+	op_mul,    ///< dst = a * b
+	op_div,    ///< dst = a / b
+	op_sqrt,   ///< dst = sqrt(a)
+	op_call1,  ///< dst = f1(a)
+	op_call2   ///< dst = f2(a, b)
+};
+
+/** One instruction.  Operands and results are slot numbers; every
+ *  instruction writes to a new slot. */
+struct instruction {
+	opcode op;
+	unsigned a, b;
+	double value;
+	unary_fcn f1;
+	binary_fcn f2;
+};
+
+/** Larger integer exponents are passed to pow(). */
+const int max_powering_exponent = 1024;
+
+/** Thrown when an expression cannot be translated. */
+struct unsupported {};
+
+/** Flattens expressions into a list of instructions. */
+class program {
+public:
+	explicit program(const exvector & params)
+	{
+		for (unsigned i = 0; i < params.size(); ++i) {
+			instruction in = make(op_param);
+			in.a = i;
+			slot_of[params[i]] = emit(in);
+		}
+	}
+
+	unsigned translate(const ex & e);
+
+	std::vector<instruction> code;  ///< the instruction writing to slot i is code[i]
+
+private:
+	static instruction make(opcode op)
+	{
+		instruction in;
+		in.op = op;
+		in.a = in.b = 0;
+		in.value = 0;
+		in.f1 = 0;
+		in.f2 = 0;
+		return in;
+	}
+
+	unsigned emit(const instruction & in)
+	{
+		code.push_back(in);
+		return code.size() - 1;
+	}
+
+	unsigned number(double value)
+	{
+		instruction in = make(op_const);
+		in.value = value;
+		return emit(in);
+	}
+
+	unsigned binary(opcode op, unsigned a, unsigned b)
+	{
+		instruction in = make(op);
+		in.a = a;
+		in.b = b;
+		return emit(in);
+	}
+
+	unsigned translate_power(const ex & basis, const ex & exponent);
+	unsigned square(const ex & basis, unsigned j, unsigned prev);
+	unsigned translate_function(const function & f);
+
+	std::map<ex, unsigned, ex_is_less> slot_of;  ///< translated subexpressions
+};
+
+unsigned program::translate(const ex & e)
+{
+	std::map<ex, unsigned, ex_is_less>::const_iterator found = slot_of.find(e);
+	if (found != slot_of.end())
+		return found->second;
+
+	unsigned result;
+	if (is_exactly_a<numeric>(e)) {
+		const numeric & num = ex_to<numeric>(e);
+		if (!num.is_real())
+			throw unsupported();
+		result = number(num.to_double());
+	} else if (is_exactly_a<constant>(e)) {
+		const ex value = e.evalf();
+		if (!is_exactly_a<numeric>(value) || !ex_to<numeric>(value).is_real())
+			throw unsupported();
+		result = number(ex_to<numeric>(value).to_double());
+	} else if (is_exactly_a<add>(e) || is_exactly_a<mul>(e)) {
+		const opcode op = is_exactly_a<add>(e) ? op_add : op_mul;
+		result = translate(e.op(0));
+		for (size_t i = 1; i < e.nops(); ++i)
+			result = binary(op, result, translate(e.op(i)));
+	} else if (is_exactly_a<power>(e)) {
+		result = translate_power(e.op(0), e.op(1));
+	} else if (is_exactly_a<function>(e)) {
+		result = translate_function(ex_to<function>(e));
+	} else {
+		// e.g. a symbol that is not a parameter
+		throw unsupported();
+	}
+	slot_of[e] = result;
+	return result;
+}
+
+unsigned program::translate_power(const ex & basis, const ex & exponent)
+{
+	const unsigned b = translate(basis);
+	if (is_exactly_a<numeric>(exponent) && ex_to<numeric>(exponent).is_integer() &&
+	    abs(ex_to<numeric>(exponent)) <= max_powering_exponent) {
+		// binary powering
+		const numeric & n = ex_to<numeric>(exponent);
+		unsigned k = abs(n).to_int();
+		unsigned result = 0;
+		bool have_result = false;
+		unsigned sq = b;
+		for (unsigned j = 0; k != 0; ++j) {
+			if (k & 1) {
+				result = have_result ? binary(op_mul, result, sq) : sq;
+				have_result = true;
+			}
+			k >>= 1;
+			if (k != 0)
+				sq = square(basis, j + 1, sq);
+		}
+		if (!have_result)
+			return number(1.0);
+		if (n.is_negative())
+			result = binary(op_div, number(1.0), result);
+		return result;
+	}
+	if (exponent.is_equal(_ex1_2)) {
+		instruction in = make(op_sqrt);
+		in.a = b;
+		return emit(in);
+	}
+	if (exponent.is_equal(_ex_1_2)) {
+		instruction in = make(op_sqrt);
+		in.a = b;
+		return binary(op_div, number(1.0), emit(in));
+	}
+	instruction in = make(op_call2);
+	in.a = b;
+	in.b = translate(exponent);
+	in.f2 = std::pow;
+	return emit(in);
+}
+
+/** Return the slot of basis^(2^j), given the slot prev of basis^(2^(j-1)).
+ *  The squares are shared by all powers of the same basis. */
+unsigned program::square(const ex & basis, unsigned j, unsigned prev)
+{
+	const ex key = pow(basis, numeric(1 << j));
+	std::map<ex, unsigned, ex_is_less>::const_iterator found = slot_of.find(key);
+	if (found != slot_of.end())
+		return found->second;
+	const unsigned result = binary(op_mul, prev, prev);
+	slot_of[key] = result;
+	return result;
+}
+
+unsigned program::translate_function(const function & f)
+{
+	const std::string name = f.get_name();
+	if (f.nops() == 1) {
+		for (size_t i = 0; i < sizeof(unary_fcns) / sizeof(unary_fcns[0]); ++i) {
+			if (name == unary_fcns[i].name) {
+				instruction in = make(op_call1);
+				in.a = translate(f.op(0));
+				in.f1 = unary_fcns[i].f;
+				return emit(in);
+			}
+		}
+	} else if (f.nops() == 2 && name == "atan2") {
+		instruction in = make(op_call2);
+		in.a = translate(f.op(0));
+		in.b = translate(f.op(1));
+		in.f2 = std::atan2;
+		return emit(in);
+	}
+	throw unsupported();
+}
+
+#ifdef GINAC_JIT_X86_64
+
+/** Machine code of one function, generated from a program. */
+class x86_64_code {
+public:
+	x86_64_code(const program & prog, const std::vector<unsigned> & results, jit_signature sig);
+
+	std::vector<unsigned char> bytes;
+
+private:
+	enum { rax = 0, rcx = 1, rsi = 6, rbp = 5 };
+
+	void byte(unsigned char c) { bytes.push_back(c); }
+	void int32(int x)
+	{
+		for (unsigned i = 0; i < 4; ++i)
+			byte((unsigned(x) >> (8 * i)) & 0xff);
+	}
+	void int64(unsigned long long x)
+	{
+		for (unsigned i = 0; i < 8; ++i)
+			byte((x >> (8 * i)) & 0xff);
+	}
+
+	/** Displacement of a slot relative to rbp. */
+	static int slot(unsigned s) { return -8 * int(s + 1); }
+
+	/** SSE2 instruction F2 0F op with operands xmm and [base + disp]. */
+	void sse(unsigned char op, unsigned xmm, unsigned base, int disp)
+	{
+		byte(0xf2);
+		byte(0x0f);
+		byte(op);
+		byte(0x80 | (xmm << 3) | base);
+		int32(disp);
+	}
+	void load(unsigned xmm, unsigned s) { sse(0x10, xmm, rbp, slot(s)); }  // movsd xmm, [slot]
+	void store(unsigned s) { sse(0x11, 0, rbp, slot(s)); }  // movsd [slot], xmm0
+
+	void mov_rax_imm(unsigned long long x)
+	{
+		byte(0x48);
+		byte(0xb8);
+		int64(x);
+	}
+
+	void call(const void *f)
+	{
+		mov_rax_imm(reinterpret_cast<unsigned long long>(f));
+		byte(0xff);  // call rax
+		byte(0xd0);
+	}
+};
+
+x86_64_code::x86_64_code(const program & prog, const std::vector<unsigned> & results, jit_signature sig)
+{
+	const std::vector<instruction> & code = prog.code;
+	const unsigned f_slot = code.size();  // saved pointer to f[]
+	const unsigned frame = ((8 * (code.size() + 1) + 15) / 16) * 16;
+
+	byte(0x55);  // push rbp
+	byte(0x48); byte(0x89); byte(0xe5);  // mov rbp, rsp
+	byte(0x48); byte(0x81); byte(0xec);  // sub rsp, frame
+	int32(frame);
+	if (sig == jit_cuba) {
+		byte(0x48); byte(0x89); byte(0x80 | (rcx << 3) | rbp);  // mov [f_slot], rcx
+		int32(slot(f_slot));
+	}
+
+	for (unsigned s = 0; s < code.size(); ++s) {
+		const instruction & in = code[s];
+		switch (in.op) {
+		case op_const: {
+			unsigned long long bits;
+			std::memcpy(&bits, &in.value, sizeof(bits));
+			mov_rax_imm(bits);
+			byte(0x66); byte(0x48); byte(0x0f); byte(0x6e); byte(0xc0);  // movq xmm0, rax
+			break;
+		}
+		case op_param:
+			// Parameters occupy the first slots, so the argument
+			// registers are still intact.
+			if (sig == jit_cuba)
+				sse(0x10, 0, rsi, 8 * in.a);  // movsd xmm0, [rsi + 8*a]
+			else if (in.a == 1) {
+				byte(0x66); byte(0x0f); byte(0x28); byte(0xc1);  // movapd xmm0, xmm1
+			}
+			break;
+		case op_add:
+		case op_mul:
+		case op_div:
+			load(0, in.a);
+			sse(in.op == op_add ? 0x58 : in.op == op_mul ? 0x59 : 0x5e, 0, rbp, slot(in.b));
+			break;
+		case op_sqrt:
+			sse(0x51, 0, rbp, slot(in.a));  // sqrtsd xmm0, [slot]
+			break;
+		case op_call1:
+			load(0, in.a);
+			call(reinterpret_cast<const void *>(in.f1));
+			break;
+		case op_call2:
+			load(0, in.a);
+			load(1, in.b);
+			call(reinterpret_cast<const void *>(in.f2));
+			break;
+		}
+		store(s);
+	}
+
+	if (sig == jit_cuba) {
+		byte(0x48); byte(0x8b); byte(0x80 | (rax << 3) | rbp);  // mov rax, [f_slot]
+		int32(slot(f_slot));
+		for (unsigned i = 0; i < results.size(); ++i) {
+			load(0, results[i]);
+			sse(0x11, 0, rax, 8 * i);  // movsd [rax + 8*i], xmm0
+		}
+	} else {
+		load(0, results[0]);
+	}
+	byte(0x48); byte(0x89); byte(0xec);  // mov rsp, rbp
+	byte(0x5d);  // pop rbp
+	byte(0xc3);  // ret
+}
+
+#ifdef GINAC_THREAD_SAFE
+pthread_mutex_t installed_mutex = PTHREAD_MUTEX_INITIALIZER;
+inline void lock_installed() { pthread_mutex_lock(&installed_mutex); }
+inline void unlock_installed() { pthread_mutex_unlock(&installed_mutex); }
+#else
+inline void lock_installed() {}
+inline void unlock_installed() {}
+#endif
+
+/** Sizes of the mappings holding generated code, by address.  Protected by
+ *  installed_mutex.  Deliberately never destroyed, so that functions can
+ *  still be released during static destruction. */
+std::map<void *, size_t> & installed()
+{
+	static std::map<void *, size_t> *m = new std::map<void *, size_t>;
+	return *m;
+}
+
+void *install(const std::vector<unsigned char> & bytes)
+{
+	const size_t page = sysconf(_SC_PAGESIZE);
+	const size_t size = ((bytes.size() + page - 1) / page) * page;
+	void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return 0;
+	std::memcpy(p, &bytes[0], bytes.size());
+	if (mprotect(p, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(p, size);
+		return 0;
+	}
+	lock_installed();
+	installed()[p] = size;
+	unlock_installed();
+	return p;
+}
+
+#endif // def GINAC_JIT_X86_64
+
+} // anonymous namespace
+
+void *jit_compile(const exvector & exprs, const exvector & params, jit_signature sig)
+{
+#ifdef GINAC_JIT_X86_64
+	program prog(params);
+	std::vector<unsigned> results;
+	try {
+		for (exvector::const_iterator i = exprs.begin(); i != exprs.end(); ++i)
+			results.push_back(prog.translate(*i));
+	} catch (const unsupported &) {
+		return 0;
+	}
+	return install(x86_64_code(prog, results, sig).bytes);
+#else
+	return 0;
+#endif
+}
+
+bool jit_release(void *code)
+{
+#ifdef GINAC_JIT_X86_64
+	lock_installed();
+	const std::map<void *, size_t>::iterator i = installed().find(code);
+	const bool found = i != installed().end();
+	if (found) {
+		munmap(i->first, i->second);
+		installed().erase(i);
+	}
+	unlock_installed();
+	return found;
+#else
+	return false;
+#endif
+}
+
+} // namespace GiNaC
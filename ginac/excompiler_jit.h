@@ -0,0 +1,52 @@
+/** @file excompiler_jit.h
+ *
+ *  Interface to the in-process code generator used by compile_ex. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_EXCOMPILER_JIT_H
+#define GINAC_EXCOMPILER_JIT_H
+
+#include "ex.h"
+
+namespace GiNaC {
+
+/** Calling conventions of the generated functions. */
+enum jit_signature {
+	jit_1p,    ///< FUNCP_1P: parameter and result in registers
+	jit_2p,    ///< FUNCP_2P: two parameters, result in a register
+	jit_cuba   ///< FUNCP_CUBA: parameters read from a[], results written to f[]
+};
+
+/** Translate exprs into a native function of the given signature whose
+ *  parameters are the symbols in params.  For jit_1p and jit_2p, exprs has
+ *  exactly one element.  Returns the address of the function, or 0 if the
+ *  code generator is not available on this platform or the expressions
+ *  contain something it cannot translate (e.g. complex numbers or
+ *  functions missing from the C library).  The code stays in memory until
+ *  it is released with jit_release() or the program ends. */
+void *jit_compile(const exvector & exprs, const exvector & params, jit_signature sig);
+
+/** Free the memory of a function returned by jit_compile().  Returns false,
+ *  doing nothing, if code is not such a function or was already released. */
+bool jit_release(void *code);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_EXCOMPILER_JIT_H
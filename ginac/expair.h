@@ -38,6 +38,12 @@ class expair
 {
 public:
 	expair() : rest(0), coeff(1) { }
+	expair(const expair & other) = default;
+	expair & operator=(const expair & other) = default;
+
+	/** Move the members of other, see ex::ex(ex &&). */
+	expair(expair && other) = default;
+	expair & operator=(expair && other) = default;
 
 	/** Construct an expair from two ex. */
 	expair(const ex & r, const ex & c) : rest(r), coeff(c)
@@ -112,7 +118,8 @@ inline void swap(expair & e1, expair & e2)
 { e1.swap(e2); }
 
 // This makes STL algorithms use the more efficient swap operation for ex objects
-inline void iter_swap(std::vector<expair>::iterator i1, std::vector<expair>::iterator i2)
+inline void iter_swap(std::vector<expair, pool_allocator<expair> >::iterator i1,
+                      std::vector<expair, pool_allocator<expair> >::iterator i2)
 { i1->swap(*i2); }
 
 } // namespace GiNaC
@@ -32,11 +32,9 @@
 #include "utils.h"
 #include "hash_seed.h"
 #include "indexed.h"
+#include "stats.h"
 
 #include <algorithm>
-#if EXPAIRSEQ_USE_HASHTAB
-#include <cmath>
-#endif // EXPAIRSEQ_USE_HASHTAB
 #include <iostream>
 #include <iterator>
 #include <stdexcept>
@@ -70,9 +68,6 @@ public:
 // public
 
 expairseq::expairseq() 
-#if EXPAIRSEQ_USE_HASHTAB
-	: hashtabsize(0)
-#endif // EXPAIRSEQ_USE_HASHTAB
 {}
 
 // protected
@@ -83,24 +78,6 @@ void expairseq::copy(const expairseq &other)
 {
 	seq = other.seq;
 	overall_coeff = other.overall_coeff;
-#if EXPAIRSEQ_USE_HASHTAB
-	// copy hashtab
-	hashtabsize = other.hashtabsize;
-	if (hashtabsize!=0) {
-		hashmask = other.hashmask;
-		hashtab.resize(hashtabsize);
-		epvector::const_iterator osb = other.seq.begin();
-		for (unsigned i=0; i<hashtabsize; ++i) {
-			hashtab[i].clear();
-			for (epplist::const_iterator cit=other.hashtab[i].begin();
-			     cit!=other.hashtab[i].end(); ++cit) {
-				hashtab[i].push_back(seq.begin()+((*cit)-osb));
-			}
-		}
-	} else {
-		hashtab.clear();
-	}
-#endif // EXPAIRSEQ_USE_HASHTAB
 }
 #endif
 
@@ -128,12 +105,11 @@ expairseq::expairseq(const epvector &v, const ex &oc, bool do_index_renaming)
 	GINAC_ASSERT(is_canonical());
 }
 
-expairseq::expairseq(std::auto_ptr<epvector> vp, const ex &oc, bool do_index_renaming)
+expairseq::expairseq(epvector && vp, const ex &oc, bool do_index_renaming)
   :  overall_coeff(oc)
 {
-	GINAC_ASSERT(vp.get()!=0);
 	GINAC_ASSERT(is_a<numeric>(oc));
-	construct_from_epvector(*vp, do_index_renaming);
+	construct_from_epvector(std::move(vp), do_index_renaming);
 	GINAC_ASSERT(is_canonical());
 }
 
@@ -208,59 +184,6 @@ void expairseq::do_print_tree(const print_tree & c, unsigned level) const
 		overall_coeff.print(c, level + c.delta_indent);
 	}
 	c.s << std::string(level + c.delta_indent,' ') << "=====" << std::endl;
-#if EXPAIRSEQ_USE_HASHTAB
-	c.s << std::string(level + c.delta_indent,' ')
-	    << "hashtab size " << hashtabsize << std::endl;
-	if (hashtabsize == 0) return;
-#define MAXCOUNT 5
-	unsigned count[MAXCOUNT+1];
-	for (int i=0; i<MAXCOUNT+1; ++i)
-		count[i] = 0;
-	unsigned this_bin_fill;
-	unsigned cum_fill_sq = 0;
-	unsigned cum_fill = 0;
-	for (unsigned i=0; i<hashtabsize; ++i) {
-		this_bin_fill = 0;
-		if (hashtab[i].size() > 0) {
-			c.s << std::string(level + c.delta_indent, ' ')
-			    << "bin " << i << " with entries ";
-			for (epplist::const_iterator it=hashtab[i].begin();
-			     it!=hashtab[i].end(); ++it) {
-				c.s << *it-seq.begin() << " ";
-				++this_bin_fill;
-			}
-			c.s << std::endl;
-			cum_fill += this_bin_fill;
-			cum_fill_sq += this_bin_fill*this_bin_fill;
-		}
-		if (this_bin_fill<MAXCOUNT)
-			++count[this_bin_fill];
-		else
-			++count[MAXCOUNT];
-	}
-	unsigned fact = 1;
-	double cum_prob = 0;
-	double lambda = (1.0*seq.size()) / hashtabsize;
-	for (int k=0; k<MAXCOUNT; ++k) {
-		if (k>0)
-			fact *= k;
-		double prob = std::pow(lambda,k)/fact * std::exp(-lambda);
-		cum_prob += prob;
-		c.s << std::string(level + c.delta_indent, ' ') << "bins with " << k << " entries: "
-		    << int(1000.0*count[k]/hashtabsize)/10.0 << "% (expected: "
-		    << int(prob*1000)/10.0 << ")" << std::endl;
-	}
-	c.s << std::string(level + c.delta_indent, ' ') << "bins with more entries: "
-	    << int(1000.0*count[MAXCOUNT]/hashtabsize)/10.0 << "% (expected: "
-	    << int((1-cum_prob)*1000)/10.0 << ")" << std::endl;
-
-	c.s << std::string(level + c.delta_indent, ' ') << "variance: "
-	    << 1.0/hashtabsize*cum_fill_sq-(1.0/hashtabsize*cum_fill)*(1.0/hashtabsize*cum_fill)
-	    << std::endl;
-	c.s << std::string(level + c.delta_indent, ' ') << "average fill: "
-	    << (1.0*cum_fill)/hashtabsize
-	    << " (should be equal to " << (1.0*seq.size())/hashtabsize << ")" << std::endl;
-#endif // EXPAIRSEQ_USE_HASHTAB
 }
 
 bool expairseq::info(unsigned inf) const
@@ -306,24 +229,24 @@ ex expairseq::op(size_t i) const
 
 ex expairseq::map(map_function &f) const
 {
-	std::auto_ptr<epvector> v(new epvector);
-	v->reserve(seq.size()+1);
+	epvector v;
+	v.reserve(seq.size()+1);
 
 	epvector::const_iterator cit = seq.begin(), last = seq.end();
 	while (cit != last) {
-		v->push_back(split_ex_to_pair(f(recombine_pair_to_ex(*cit))));
+		v.push_back(split_ex_to_pair(f(recombine_pair_to_ex(*cit))));
 		++cit;
 	}
 
 	if (overall_coeff.is_equal(default_overall_coeff()))
-		return thisexpairseq(v, default_overall_coeff(), true);
+		return thisexpairseq(std::move(v), default_overall_coeff(), true);
 	else {
 		ex newcoeff = f(overall_coeff);
 		if(is_a<numeric>(newcoeff))
-			return thisexpairseq(v, newcoeff, true);
+			return thisexpairseq(std::move(v), newcoeff, true);
 		else {
-			v->push_back(split_ex_to_pair(newcoeff));
-			return thisexpairseq(v, default_overall_coeff(), true);
+			v.push_back(split_ex_to_pair(newcoeff));
+			return thisexpairseq(std::move(v), default_overall_coeff(), true);
 		}
 	}
 }
@@ -334,11 +257,11 @@ ex expairseq::eval(int level) const
 	if ((level==1) && (flags &status_flags::evaluated))
 		return *this;
 	
-	std::auto_ptr<epvector> vp = evalchildren(level);
-	if (vp.get() == 0)
+	epvector evaled = evalchildren(level);
+	if (evaled.empty())
 		return this->hold();
 	
-	return (new expairseq(vp, overall_coeff))->setflag(status_flags::dynallocated | status_flags::evaluated);
+	return (new expairseq(std::move(evaled), overall_coeff))->setflag(status_flags::dynallocated | status_flags::evaluated);
 }
 
 epvector* conjugateepvector(const epvector&epv)
@@ -433,11 +356,11 @@ found:		;
 			// it has already been matched before, in which case the matches
 			// must be equal)
 			size_t num = ops.size();
-			std::auto_ptr<epvector> vp(new epvector);
-			vp->reserve(num);
+			epvector vp;
+			vp.reserve(num);
 			for (size_t i=0; i<num; i++)
-				vp->push_back(split_ex_to_pair(ops[i]));
-			ex rest = thisexpairseq(vp, default_overall_coeff());
+				vp.push_back(split_ex_to_pair(ops[i]));
+			ex rest = thisexpairseq(std::move(vp), default_overall_coeff());
 			for (exmap::const_iterator it = tmp_repl.begin(); it != tmp_repl.end(); ++it) {
 				if (it->first.is_equal(global_wildcard)) {
 					if (rest.is_equal(it->second)) {
@@ -467,9 +390,9 @@ found:		;
 
 ex expairseq::subs(const exmap & m, unsigned options) const
 {
-	std::auto_ptr<epvector> vp = subschildren(m, options);
-	if (vp.get())
-		return ex_to<basic>(thisexpairseq(vp, overall_coeff, (options & subs_options::no_index_renaming) == 0));
+	epvector subsed = subschildren(m, options);
+	if (!subsed.empty())
+		return ex_to<basic>(thisexpairseq(std::move(subsed), overall_coeff, (options & subs_options::no_index_renaming) == 0));
 	else if ((options & subs_options::algebraic) && is_exactly_a<mul>(*this))
 		return static_cast<const mul *>(this)->algebraic_subs_mul(m, options);
 	else
@@ -494,54 +417,20 @@ int expairseq::compare_same_type(const basic &other) const
 	if (cmpval!=0)
 		return cmpval;
 	
-#if EXPAIRSEQ_USE_HASHTAB
-	GINAC_ASSERT(hashtabsize==o.hashtabsize);
-	if (hashtabsize==0) {
-#endif // EXPAIRSEQ_USE_HASHTAB
-		epvector::const_iterator cit1 = seq.begin();
-		epvector::const_iterator cit2 = o.seq.begin();
-		epvector::const_iterator last1 = seq.end();
-		epvector::const_iterator last2 = o.seq.end();
-		
-		for (; (cit1!=last1)&&(cit2!=last2); ++cit1, ++cit2) {
-			cmpval = (*cit1).compare(*cit2);
-			if (cmpval!=0) return cmpval;
-		}
-		
-		GINAC_ASSERT(cit1==last1);
-		GINAC_ASSERT(cit2==last2);
-		
-		return 0;
-#if EXPAIRSEQ_USE_HASHTAB
-	}
+	epvector::const_iterator cit1 = seq.begin();
+	epvector::const_iterator cit2 = o.seq.begin();
+	epvector::const_iterator last1 = seq.end();
+	epvector::const_iterator last2 = o.seq.end();
 	
-	// compare number of elements in each hashtab entry
-	for (unsigned i=0; i<hashtabsize; ++i) {
-		unsigned cursize=hashtab[i].size();
-		if (cursize != o.hashtab[i].size())
-			return (cursize < o.hashtab[i].size()) ? -1 : 1;
+	for (; (cit1!=last1)&&(cit2!=last2); ++cit1, ++cit2) {
+		cmpval = (*cit1).compare(*cit2);
+		if (cmpval!=0) return cmpval;
 	}
 	
-	// compare individual (sorted) hashtab entries
-	for (unsigned i=0; i<hashtabsize; ++i) {
-		unsigned sz = hashtab[i].size();
-		if (sz>0) {
-			const epplist &eppl1 = hashtab[i];
-			const epplist &eppl2 = o.hashtab[i];
-			epplist::const_iterator it1 = eppl1.begin();
-			epplist::const_iterator it2 = eppl2.begin();
-			while (it1!=eppl1.end()) {
-				cmpval = (*(*it1)).compare(*(*it2));
-				if (cmpval!=0)
-					return cmpval;
-				++it1;
-				++it2;
-			}
-		}
-	}
+	GINAC_ASSERT(cit1==last1);
+	GINAC_ASSERT(cit2==last2);
 	
-	return 0; // equal
-#endif // EXPAIRSEQ_USE_HASHTAB
+	return 0;
 }
 
 bool expairseq::is_equal_same_type(const basic &other) const
@@ -556,56 +445,17 @@ bool expairseq::is_equal_same_type(const basic &other) const
 	if (!overall_coeff.is_equal(o.overall_coeff))
 		return false;
 	
-#if EXPAIRSEQ_USE_HASHTAB
-	// compare number of elements in each hashtab entry
-	if (hashtabsize!=o.hashtabsize) {
-		std::cout << "this:" << std::endl;
-		print(print_tree(std::cout));
-		std::cout << "other:" << std::endl;
-		other.print(print_tree(std::cout));
-	}
-		
-	GINAC_ASSERT(hashtabsize==o.hashtabsize);
+	epvector::const_iterator cit1 = seq.begin();
+	epvector::const_iterator cit2 = o.seq.begin();
+	epvector::const_iterator last1 = seq.end();
 	
-	if (hashtabsize==0) {
-#endif // EXPAIRSEQ_USE_HASHTAB
-		epvector::const_iterator cit1 = seq.begin();
-		epvector::const_iterator cit2 = o.seq.begin();
-		epvector::const_iterator last1 = seq.end();
-		
-		while (cit1!=last1) {
-			if (!(*cit1).is_equal(*cit2)) return false;
-			++cit1;
-			++cit2;
-		}
-		
-		return true;
-#if EXPAIRSEQ_USE_HASHTAB
-	}
-	
-	for (unsigned i=0; i<hashtabsize; ++i) {
-		if (hashtab[i].size() != o.hashtab[i].size())
-			return false;
-	}
-
-	// compare individual sorted hashtab entries
-	for (unsigned i=0; i<hashtabsize; ++i) {
-		unsigned sz = hashtab[i].size();
-		if (sz>0) {
-			const epplist &eppl1 = hashtab[i];
-			const epplist &eppl2 = o.hashtab[i];
-			epplist::const_iterator it1 = eppl1.begin();
-			epplist::const_iterator it2 = eppl2.begin();
-			while (it1!=eppl1.end()) {
-				if (!(*(*it1)).is_equal(*(*it2))) return false;
-				++it1;
-				++it2;
-			}
-		}
+	while (cit1!=last1) {
+		if (!(*cit1).is_equal(*cit2)) return false;
+		++cit1;
+		++cit2;
 	}
 	
 	return true;
-#endif // EXPAIRSEQ_USE_HASHTAB
 }
 
 unsigned expairseq::return_type() const
@@ -620,11 +470,9 @@ unsigned expairseq::calchash() const
 	const epvector::const_iterator end = seq.end();
 	while (i != end) {
 		v ^= i->rest.gethash();
-#if !EXPAIRSEQ_USE_HASHTAB
 		// rotation spoils commutativity!
 		v = rotate_left(v);
 		v ^= i->coeff.gethash();
-#endif // !EXPAIRSEQ_USE_HASHTAB
 		++i;
 	}
 
@@ -641,9 +489,9 @@ unsigned expairseq::calchash() const
 
 ex expairseq::expand(unsigned options) const
 {
-	std::auto_ptr<epvector> vp = expandchildren(options);
-	if (vp.get())
-		return thisexpairseq(vp, overall_coeff);
+	epvector expanded = expandchildren(options);
+	if (!expanded.empty())
+		return thisexpairseq(std::move(expanded), overall_coeff);
 	else {
 		// The terms have not changed, so it is safe to declare this expanded
 		return (options == 0) ? setflag(status_flags::expanded) : *this;
@@ -666,12 +514,12 @@ ex expairseq::expand(unsigned options) const
  *  definition. */
 ex expairseq::thisexpairseq(const epvector &v, const ex &oc, bool do_index_renaming) const
 {
-	return expairseq(v, oc, do_index_renaming);
+	return (new expairseq(v, oc, do_index_renaming))->setflag(status_flags::dynallocated);
 }
 
-ex expairseq::thisexpairseq(std::auto_ptr<epvector> vp, const ex &oc, bool do_index_renaming) const
+ex expairseq::thisexpairseq(epvector && vp, const ex &oc, bool do_index_renaming) const
 {
-	return expairseq(vp, oc, do_index_renaming);
+	return (new expairseq(std::move(vp), oc, do_index_renaming))->setflag(status_flags::dynallocated);
 }
 
 void expairseq::printpair(const print_context & c, const expair & p, unsigned upper_precedence) const
@@ -741,9 +589,6 @@ ex expairseq::recombine_pair_to_ex(const expair &p) const
 
 bool expairseq::expair_needs_further_processing(epp it)
 {
-#if EXPAIRSEQ_USE_HASHTAB
-	//#  error "FIXME: expair_needs_further_processing not yet implemented for hashtabs, sorry. A.F."
-#endif // EXPAIRSEQ_USE_HASHTAB
 	return false;
 }
 
@@ -785,70 +630,30 @@ void expairseq::construct_from_2_ex_via_exvector(const ex &lh, const ex &rh)
 	v.push_back(lh);
 	v.push_back(rh);
 	construct_from_exvector(v);
-#if EXPAIRSEQ_USE_HASHTAB
-	GINAC_ASSERT((hashtabsize==0)||(hashtabsize>=minhashtabsize));
-	GINAC_ASSERT(hashtabsize==calc_hashtabsize(seq.size()));
-#endif // EXPAIRSEQ_USE_HASHTAB
 }
 
 void expairseq::construct_from_2_ex(const ex &lh, const ex &rh)
 {
 	if (typeid(ex_to<basic>(lh)) == typeid(*this)) {
 		if (typeid(ex_to<basic>(rh)) == typeid(*this)) {
-#if EXPAIRSEQ_USE_HASHTAB
-			unsigned totalsize = ex_to<expairseq>(lh).seq.size() +
-			                     ex_to<expairseq>(rh).seq.size();
-			if (calc_hashtabsize(totalsize)!=0) {
-				construct_from_2_ex_via_exvector(lh,rh);
-			} else {
-#endif // EXPAIRSEQ_USE_HASHTAB
-				if (is_a<mul>(lh) && lh.info(info_flags::has_indices) && 
-					rh.info(info_flags::has_indices)) {
-					ex newrh=rename_dummy_indices_uniquely(lh, rh);
-					construct_from_2_expairseq(ex_to<expairseq>(lh),
-					                           ex_to<expairseq>(newrh));
-				}
-				else
-					construct_from_2_expairseq(ex_to<expairseq>(lh),
-					                           ex_to<expairseq>(rh));
-#if EXPAIRSEQ_USE_HASHTAB
+			if (is_a<mul>(lh) && lh.info(info_flags::has_indices) && 
+				rh.info(info_flags::has_indices)) {
+				ex newrh=rename_dummy_indices_uniquely(lh, rh);
+				construct_from_2_expairseq(ex_to<expairseq>(lh),
+				                           ex_to<expairseq>(newrh));
 			}
-#endif // EXPAIRSEQ_USE_HASHTAB
+			else
+				construct_from_2_expairseq(ex_to<expairseq>(lh),
+				                           ex_to<expairseq>(rh));
 			return;
 		} else {
-#if EXPAIRSEQ_USE_HASHTAB
-			unsigned totalsize = ex_to<expairseq>(lh).seq.size()+1;
-			if (calc_hashtabsize(totalsize)!=0) {
-				construct_from_2_ex_via_exvector(lh, rh);
-			} else {
-#endif // EXPAIRSEQ_USE_HASHTAB
-				construct_from_expairseq_ex(ex_to<expairseq>(lh), rh);
-#if EXPAIRSEQ_USE_HASHTAB
-			}
-#endif // EXPAIRSEQ_USE_HASHTAB
+			construct_from_expairseq_ex(ex_to<expairseq>(lh), rh);
 			return;
 		}
 	} else if (typeid(ex_to<basic>(rh)) == typeid(*this)) {
-#if EXPAIRSEQ_USE_HASHTAB
-		unsigned totalsize=ex_to<expairseq>(rh).seq.size()+1;
-		if (calc_hashtabsize(totalsize)!=0) {
-			construct_from_2_ex_via_exvector(lh,rh);
-		} else {
-#endif // EXPAIRSEQ_USE_HASHTAB
-			construct_from_expairseq_ex(ex_to<expairseq>(rh),lh);
-#if EXPAIRSEQ_USE_HASHTAB
-		}
-#endif // EXPAIRSEQ_USE_HASHTAB
-		return;
-	}
-	
-#if EXPAIRSEQ_USE_HASHTAB
-	if (calc_hashtabsize(2)!=0) {
-		construct_from_2_ex_via_exvector(lh,rh);
+		construct_from_expairseq_ex(ex_to<expairseq>(rh),lh);
 		return;
 	}
-	hashtabsize = 0;
-#endif // EXPAIRSEQ_USE_HASHTAB
 	
 	if (is_exactly_a<numeric>(lh)) {
 		if (is_exactly_a<numeric>(rh)) {
@@ -937,9 +742,9 @@ void expairseq::construct_from_2_expairseq(const expairseq &s1,
 	}
 	
 	if (needs_further_processing) {
-		epvector v = seq;
-		seq.clear();
-		construct_from_epvector(v);
+		epvector v;
+		v.swap(seq);
+		construct_from_epvector(std::move(v));
 	}
 }
 
@@ -949,6 +754,7 @@ void expairseq::construct_from_expairseq_ex(const expairseq &s,
 	combine_overall_coeff(s.overall_coeff);
 	if (is_exactly_a<numeric>(e)) {
 		combine_overall_coeff(e);
+		stats::count(stats::sequence_copies);
 		seq = s.seq;
 		return;
 	}
@@ -999,9 +805,9 @@ void expairseq::construct_from_expairseq_ex(const expairseq &s,
 	}
 
 	if (needs_further_processing) {
-		epvector v = seq;
-		seq.clear();
-		construct_from_epvector(v);
+		epvector v;
+		v.swap(seq);
+		construct_from_epvector(std::move(v));
 	}
 }
 
@@ -1013,12 +819,7 @@ void expairseq::construct_from_exvector(const exvector &v)
 	//                  (same for (+,*) -> (*,^)
 
 	make_flat(v);
-#if EXPAIRSEQ_USE_HASHTAB
 	combine_same_terms();
-#else
-	canonicalize();
-	combine_same_terms_sorted_seq();
-#endif // EXPAIRSEQ_USE_HASHTAB
 }
 
 void expairseq::construct_from_epvector(const epvector &v, bool do_index_renaming)
@@ -1028,13 +829,16 @@ void expairseq::construct_from_epvector(const epvector &v, bool do_index_renamin
 	//                  +(...,x,*(x,c1),*(x,c2)) -> +(...,*(x,1+c1+c2)) (c1, c2 numeric)
 	//                  same for (+,*) -> (*,^)
 
-	make_flat(v, do_index_renaming);
-#if EXPAIRSEQ_USE_HASHTAB
+	stats::count(stats::sequence_copies);
+	make_flat(epvector(v), do_index_renaming);
+	combine_same_terms();
+}
+
+void expairseq::construct_from_epvector(epvector &&v, bool do_index_renaming)
+{
+	// same as above, but v may be taken over as our sequence
+	make_flat(std::move(v), do_index_renaming);
 	combine_same_terms();
-#else
-	canonicalize();
-	combine_same_terms_sorted_seq();
-#endif // EXPAIRSEQ_USE_HASHTAB
 }
 
 /** Combine this expairseq with argument exvector.
@@ -1089,17 +893,19 @@ void expairseq::make_flat(const exvector &v)
 	}
 }
 
-/** Combine this expairseq with argument epvector.
+/** Combine this expairseq with argument epvector, whose elements are moved
+ *  (or, if no element needs to be touched, v itself is taken over).
  *  It cares for associativity as well as for special handling of numerics. */
-void expairseq::make_flat(const epvector &v, bool do_index_renaming)
+void expairseq::make_flat(epvector &&v, bool do_index_renaming)
 {
-	epvector::const_iterator cit;
+	epvector::iterator cit;
 	
 	// count number of operands which are of same expairseq derived type
 	// and their cumulative number of operands
 	int nexpairseqs = 0;
 	int noperands = 0;
 	bool really_need_rename_inds = false;
+	bool has_numerics = false;
 	
 	cit = v.begin();
 	while (cit!=v.end()) {
@@ -1110,15 +916,23 @@ void expairseq::make_flat(const epvector &v, bool do_index_renaming)
 		if ((!really_need_rename_inds) && is_a<mul>(*this) &&
 				cit->rest.info(info_flags::has_indices))
 			really_need_rename_inds = true;
+		if (cit->is_canonical_numeric())
+			has_numerics = true;
 		++cit;
 	}
 	do_index_renaming = do_index_renaming && really_need_rename_inds;
+
+	// nothing to flatten, rename or split off: v is our sequence
+	if (nexpairseqs == 0 && !do_index_renaming && !has_numerics) {
+		seq = std::move(v);
+		return;
+	}
 	
 	// reserve seq and coeffseq which will hold all operands
 	seq.reserve(v.size()+noperands-nexpairseqs);
 	make_flat_inserter mf(v, do_index_renaming);
 	
-	// copy elements and split off numerical part
+	// move elements and split off numerical part
 	cit = v.begin();
 	while (cit!=v.end()) {
 		if ((typeid(ex_to<basic>(cit->rest)) == typeid(*this)) &&
@@ -1139,10 +953,9 @@ void expairseq::make_flat(const epvector &v, bool do_index_renaming)
 			if (cit->is_canonical_numeric())
 				combine_overall_coeff(mf.handle_factor(cit->rest, _ex1));
 			else {
-				ex rest = cit->rest;
-				ex newrest = mf.handle_factor(rest, cit->coeff);
-				if (are_ex_trivially_equal(newrest, rest))
-					seq.push_back(*cit);
+				ex newrest = mf.handle_factor(cit->rest, cit->coeff);
+				if (are_ex_trivially_equal(newrest, cit->rest))
+					seq.push_back(std::move(*cit));
 				else
 					seq.push_back(expair(newrest, cit->coeff));
 			}
@@ -1151,6 +964,23 @@ void expairseq::make_flat(const epvector &v, bool do_index_renaming)
 	}
 }
 
+/** Sequences with at least this many terms are combined with a hash table
+ *  before they are sorted. */
+static const size_t hashed_combine_threshold = 256;
+
+/** Bring a freshly flattened sequence into canonical form: combine all
+ *  expairs with the same rest, drop the ones with zero coefficient and sort
+ *  the remaining ones. */
+void expairseq::combine_same_terms()
+{
+	if (seq.size() >= hashed_combine_threshold) {
+		combine_same_terms_hashed();
+	} else {
+		canonicalize();
+		combine_same_terms_sorted_seq();
+	}
+}
+
 /** Brings this expairseq into a sorted (canonical) form. */
 void expairseq::canonicalize()
 {
@@ -1201,321 +1031,85 @@ void expairseq::combine_same_terms_sorted_seq()
 		seq.erase(itout,last);
 
 	if (needs_further_processing) {
-		epvector v = seq;
-		seq.clear();
-		construct_from_epvector(v);
+		epvector v;
+		v.swap(seq);
+		construct_from_epvector(std::move(v));
 	}
 }
 
-#if EXPAIRSEQ_USE_HASHTAB
 
-unsigned expairseq::calc_hashtabsize(unsigned sz) const
+/** Same as canonicalize() followed by combine_same_terms_sorted_seq(), but
+ *  matching expairs are found with a transient open-addressing hash table
+ *  keyed on the hash values of their rests.  This takes O(n) steps instead
+ *  of O(n*log(n)) comparisons, and only the (often much shorter) result of
+ *  the combination has to be sorted.  Worthwhile for large unsorted
+ *  sequences, e.g. when a product of sums is expanded. */
+void expairseq::combine_same_terms_hashed()
 {
-	unsigned size;
-	unsigned nearest_power_of_2 = 1 << log2(sz);
-	// if (nearest_power_of_2 < maxhashtabsize/hashtabfactor) {
-	//  size = nearest_power_of_2*hashtabfactor;
-	size = nearest_power_of_2/hashtabfactor;
-	if (size<minhashtabsize)
-		return 0;
-
-	// hashtabsize must be a power of 2
-	GINAC_ASSERT((1U << log2(size))==size);
-	return size;
-}
+	const size_t n = seq.size();
+	size_t table_size = 1;
+	while (table_size < 2*n)
+		table_size <<= 1;
+	const size_t mask = table_size - 1;
+
+	// slots of the table hold indices into seq, n marks an empty slot
+	std::vector<size_t, pool_allocator<size_t> > table(table_size, n);
+	std::vector<unsigned, pool_allocator<unsigned> > hashes;
+	hashes.reserve(n);
+	std::vector<bool> combined;
 
-unsigned expairseq::calc_hashindex(const ex &e) const
-{
-	// calculate hashindex
-	unsigned hashindex;
-	if (is_a<numeric>(e)) {
-		hashindex = hashmask;
-	} else {
-		hashindex = e.gethash() & hashmask;
-		// last hashtab entry is reserved for numerics
-		if (hashindex==hashmask) hashindex = 0;
-	}
-	GINAC_ASSERT((hashindex<hashtabsize)||(hashtabsize==0));
-	return hashindex;
-}
-
-void expairseq::shrink_hashtab()
-{
-	unsigned new_hashtabsize;
-	while (hashtabsize!=(new_hashtabsize=calc_hashtabsize(seq.size()))) {
-		GINAC_ASSERT(new_hashtabsize<hashtabsize);
-		if (new_hashtabsize==0) {
-			hashtab.clear();
-			hashtabsize = 0;
-			canonicalize();
-			return;
-		}
-		
-		// shrink by a factor of 2
-		unsigned half_hashtabsize = hashtabsize/2;
-		for (unsigned i=0; i<half_hashtabsize-1; ++i)
-			hashtab[i].merge(hashtab[i+half_hashtabsize],epp_is_less());
-		// special treatment for numeric hashes
-		hashtab[0].merge(hashtab[half_hashtabsize-1],epp_is_less());
-		hashtab[half_hashtabsize-1] = hashtab[hashtabsize-1];
-		hashtab.resize(half_hashtabsize);
-		hashtabsize = half_hashtabsize;
-		hashmask = hashtabsize-1;
-	}
-}
+	bool needs_further_processing = false;
 
-void expairseq::remove_hashtab_entry(epvector::const_iterator element)
-{
-	if (hashtabsize==0)
-		return; // nothing to do
-	
-	// calculate hashindex of element to be deleted
-	unsigned hashindex = calc_hashindex((*element).rest);
-
-	// find it in hashtab and remove it
-	epplist &eppl = hashtab[hashindex];
-	epplist::iterator epplit = eppl.begin();
-	bool erased = false;
-	while (epplit!=eppl.end()) {
-		if (*epplit == element) {
-			eppl.erase(epplit);
-			erased = true;
-			break;
-		}
-		++epplit;
-	}
-	if (!erased) {
-		std::cout << "tried to erase " << element-seq.begin() << std::endl;
-		std::cout << "size " << seq.end()-seq.begin() << std::endl;
-
-		unsigned hashindex = calc_hashindex(element->rest);
-		epplist &eppl = hashtab[hashindex];
-		epplist::iterator epplit = eppl.begin();
-		bool erased = false;
-		while (epplit!=eppl.end()) {
-			if (*epplit == element) {
-				eppl.erase(epplit);
-				erased = true;
+	size_t out = 0;
+	for (size_t in = 0; in < n; ++in) {
+		const unsigned h = seq[in].rest.gethash();
+		size_t slot = h & mask;
+		while (table[slot] != n) {
+			const size_t j = table[slot];
+			if (hashes[j] == h && seq[j].rest.is_equal(seq[in].rest))
 				break;
-			}
-			++epplit;
-		}
-		GINAC_ASSERT(erased);
-	}
-	GINAC_ASSERT(erased);
-}
-
-void expairseq::move_hashtab_entry(epvector::const_iterator oldpos,
-                                   epvector::iterator newpos)
-{
-	GINAC_ASSERT(hashtabsize!=0);
-	
-	// calculate hashindex of element which was moved
-	unsigned hashindex=calc_hashindex((*newpos).rest);
-
-	// find it in hashtab and modify it
-	epplist &eppl = hashtab[hashindex];
-	epplist::iterator epplit = eppl.begin();
-	while (epplit!=eppl.end()) {
-		if (*epplit == oldpos) {
-			*epplit = newpos;
-			break;
+			slot = (slot + 1) & mask;
 		}
-		++epplit;
-	}
-	GINAC_ASSERT(epplit!=eppl.end());
-}
-
-void expairseq::sorted_insert(epplist &eppl, epvector::const_iterator elem)
-{
-	epplist::const_iterator current = eppl.begin();
-	while ((current!=eppl.end()) && ((*current)->is_less(*elem))) {
-		++current;
-	}
-	eppl.insert(current,elem);
-}    
-
-void expairseq::build_hashtab_and_combine(epvector::iterator &first_numeric,
-                                          epvector::iterator &last_non_zero,
-                                          std::vector<bool> &touched,
-                                          unsigned &number_of_zeroes)
-{
-	epp current = seq.begin();
-
-	while (current!=first_numeric) {
-		if (is_exactly_a<numeric>(current->rest)) {
-			--first_numeric;
-			iter_swap(current,first_numeric);
+		if (table[slot] == n) {
+			// first occurrence of this rest
+			table[slot] = out;
+			hashes.push_back(h);
+			if (in != out)
+				seq[out] = std::move(seq[in]);
+			++out;
 		} else {
-			// calculate hashindex
-			unsigned currenthashindex = calc_hashindex(current->rest);
-
-			// test if there is already a matching expair in the hashtab-list
-			epplist &eppl=hashtab[currenthashindex];
-			epplist::iterator epplit = eppl.begin();
-			while (epplit!=eppl.end()) {
-				if (current->rest.is_equal((*epplit)->rest))
-					break;
-				++epplit;
-			}
-			if (epplit==eppl.end()) {
-				// no matching expair found, append this to end of list
-				sorted_insert(eppl,current);
-				++current;
-			} else {
-				// epplit points to a matching expair, combine it with current
-				(*epplit)->coeff = ex_to<numeric>((*epplit)->coeff).
-				                   add_dyn(ex_to<numeric>(current->coeff));
-				
-				// move obsolete current expair to end by swapping with last_non_zero element
-				// if this was a numeric, it is swapped with the expair before first_numeric 
-				iter_swap(current,last_non_zero);
-				--first_numeric;
-				if (first_numeric!=last_non_zero) iter_swap(first_numeric,current);
-				--last_non_zero;
-				++number_of_zeroes;
-				// test if combined term has coeff 0 and can be removed is done later
-				touched[(*epplit)-seq.begin()] = true;
-			}
+			const size_t j = table[slot];
+			seq[j].coeff = ex_to<numeric>(seq[j].coeff).
+			               add_dyn(ex_to<numeric>(seq[in].coeff));
+			if (combined.empty())
+				combined.resize(n);
+			combined[j] = true;
 		}
 	}
-}
-
-void expairseq::drop_coeff_0_terms(epvector::iterator &first_numeric,
-                                   epvector::iterator &last_non_zero,
-                                   std::vector<bool> &touched,
-                                   unsigned &number_of_zeroes)
-{
-	// move terms with coeff 0 to end and remove them from hashtab
-	// check only those elements which have been touched
-	epp current = seq.begin();
-	size_t i = 0;
-	while (current!=first_numeric) {
-		if (!touched[i]) {
-			++current;
-			++i;
-		} else if (!ex_to<numeric>((*current).coeff).is_zero()) {
-			++current;
-			++i;
-		} else {
-			remove_hashtab_entry(current);
-			
-			// move element to the end, unless it is already at the end
-			if (current!=last_non_zero) {
-				iter_swap(current,last_non_zero);
-				--first_numeric;
-				bool numeric_swapped = first_numeric!=last_non_zero;
-				if (numeric_swapped)
-					iter_swap(first_numeric,current);
-				epvector::iterator changed_entry;
-
-				if (numeric_swapped)
-					changed_entry = first_numeric;
-				else
-					changed_entry = last_non_zero;
-				
-				--last_non_zero;
-				++number_of_zeroes;
-
-				if (first_numeric!=current) {
-
-					// change entry in hashtab which referred to first_numeric or last_non_zero to current
-					move_hashtab_entry(changed_entry,current);
-					touched[current-seq.begin()] = touched[changed_entry-seq.begin()];
-				}
-			} else {
-				--first_numeric;
-				--last_non_zero;
-				++number_of_zeroes;
-			}
-		}
-	}
-	GINAC_ASSERT(i==current-seq.begin());
-}
-
-/** True if one of the coeffs vanishes, otherwise false.
- *  This would be an invariant violation, so this should only be used for
- *  debugging purposes. */
-bool expairseq::has_coeff_0() const
-{
-	epvector::const_iterator i = seq.begin(), end = seq.end();
-	while (i != end) {
-		if (i->coeff.is_zero())
-			return true;
-		++i;
-	}
-	return false;
-}
 
-void expairseq::add_numerics_to_hashtab(epvector::iterator first_numeric,
-                                        epvector::const_iterator last_non_zero)
-{
-	if (first_numeric == seq.end()) return; // no numerics
-	
-	epvector::const_iterator current = first_numeric, last = last_non_zero + 1;
-	while (current != last) {
-		sorted_insert(hashtab[hashmask], current);
-		++current;
+	// post-process the combined terms and drop the ones that cancelled
+	size_t kept = 0;
+	for (size_t i = 0; i < out; ++i) {
+		if (!combined.empty() && combined[i] &&
+		    expair_needs_further_processing(seq.begin() + i))
+			needs_further_processing = true;
+		if (ex_to<numeric>(seq[i].coeff).is_zero())
+			continue;
+		if (kept != i)
+			seq[kept] = std::move(seq[i]);
+		++kept;
 	}
-}
+	seq.erase(seq.begin() + kept, seq.end());
 
-void expairseq::combine_same_terms()
-{
-	// combine same terms, drop term with coeff 0, move numerics to end
-	
-	// calculate size of hashtab
-	hashtabsize = calc_hashtabsize(seq.size());
-	
-	// hashtabsize is a power of 2
-	hashmask = hashtabsize-1;
-	
-	// allocate hashtab
-	hashtab.clear();
-	hashtab.resize(hashtabsize);
-	
-	if (hashtabsize==0) {
-		canonicalize();
-		combine_same_terms_sorted_seq();
-		GINAC_ASSERT(!has_coeff_0());
+	if (needs_further_processing) {
+		epvector v;
+		v.swap(seq);
+		construct_from_epvector(std::move(v));
 		return;
 	}
-	
-	// iterate through seq, move numerics to end,
-	// fill hashtab and combine same terms
-	epvector::iterator first_numeric = seq.end();
-	epvector::iterator last_non_zero = seq.end()-1;
-	
-	size_t num = seq.size();
-	std::vector<bool> touched(num);
-	
-	unsigned number_of_zeroes = 0;
-	
-	GINAC_ASSERT(!has_coeff_0());
-	build_hashtab_and_combine(first_numeric,last_non_zero,touched,number_of_zeroes);
-	
-	// there should not be any terms with coeff 0 from the beginning,
-	// so it should be safe to skip this step
-	if (number_of_zeroes!=0) {
-		drop_coeff_0_terms(first_numeric,last_non_zero,touched,number_of_zeroes);
-	}
-	
-	add_numerics_to_hashtab(first_numeric,last_non_zero);
-	
-	// pop zero elements
-	for (unsigned i=0; i<number_of_zeroes; ++i) {
-		seq.pop_back();
-	}
-	
-	// shrink hashtabsize to calculated value
-	GINAC_ASSERT(!has_coeff_0());
-	
-	shrink_hashtab();
-	
-	GINAC_ASSERT(!has_coeff_0());
+	canonicalize();
 }
 
-#endif // EXPAIRSEQ_USE_HASHTAB
-
 /** Check if this expairseq is in sorted (canonical) form.  Useful mainly for
  *  debugging or in assertions since being sorted is an invariance. */
 bool expairseq::is_canonical() const
@@ -1523,9 +1117,6 @@ bool expairseq::is_canonical() const
 	if (seq.size() <= 1)
 		return 1;
 	
-#if EXPAIRSEQ_USE_HASHTAB
-	if (hashtabsize > 0) return 1; // not canoncalized
-#endif // EXPAIRSEQ_USE_HASHTAB
 	
 	epvector::const_iterator it = seq.begin(), itend = seq.end();
 	epvector::const_iterator it_last = it;
@@ -1558,9 +1149,9 @@ bool expairseq::is_canonical() const
 /** Member-wise expand the expairs in this sequence.
  *
  *  @see expairseq::expand()
- *  @return pointer to epvector containing expanded pairs or zero pointer,
- *  if no members were changed. */
-std::auto_ptr<epvector> expairseq::expandchildren(unsigned options) const
+ *  @return epvector containing expanded pairs, empty if no members were
+ *    changed. */
+epvector expairseq::expandchildren(unsigned options) const
 {
 	const epvector::const_iterator last = seq.end();
 	epvector::const_iterator cit = seq.begin();
@@ -1569,24 +1160,24 @@ std::auto_ptr<epvector> expairseq::expandchildren(unsigned options) const
 		if (!are_ex_trivially_equal(cit->rest,expanded_ex)) {
 			
 			// something changed, copy seq, eval and return it
-			std::auto_ptr<epvector> s(new epvector);
-			s->reserve(seq.size());
+			epvector s;
+			s.reserve(seq.size());
 			
 			// copy parts of seq which are known not to have changed
 			epvector::const_iterator cit2 = seq.begin();
 			while (cit2!=cit) {
-				s->push_back(*cit2);
+				s.push_back(*cit2);
 				++cit2;
 			}
 
 			// copy first changed element
-			s->push_back(combine_ex_with_coeff_to_pair(expanded_ex,
+			s.push_back(combine_ex_with_coeff_to_pair(expanded_ex,
 			                                           cit2->coeff));
 			++cit2;
 
 			// copy rest
 			while (cit2!=last) {
-				s->push_back(combine_ex_with_coeff_to_pair(cit2->rest.expand(options),
+				s.push_back(combine_ex_with_coeff_to_pair(cit2->rest.expand(options),
 				                                           cit2->coeff));
 				++cit2;
 			}
@@ -1595,23 +1186,21 @@ std::auto_ptr<epvector> expairseq::expandchildren(unsigned options) const
 		++cit;
 	}
 	
-	return std::auto_ptr<epvector>(0); // signalling nothing has changed
+	return epvector(); // signalling nothing has changed
 }
 
 
 /** Member-wise evaluate the expairs in this sequence.
  *
  *  @see expairseq::eval()
- *  @return pointer to epvector containing evaluated pairs or zero pointer,
- *  if no members were changed. */
-std::auto_ptr<epvector> expairseq::evalchildren(int level) const
+ *  @return epvector containing evaluated pairs, empty if no members were
+ *    changed. */
+epvector expairseq::evalchildren(int level) const
 {
-	// returns a NULL pointer if nothing had to be evaluated
-	// returns a pointer to a newly created epvector otherwise
-	// (which has to be deleted somewhere else)
+	// returns an empty epvector if nothing had to be evaluated
 
 	if (level==1)
-		return std::auto_ptr<epvector>(0);
+		return epvector();
 	
 	if (level == -max_recursion_level)
 		throw(std::runtime_error("max recursion level reached"));
@@ -1624,24 +1213,24 @@ std::auto_ptr<epvector> expairseq::evalchildren(int level) const
 		if (!are_ex_trivially_equal(cit->rest,evaled_ex)) {
 			
 			// something changed, copy seq, eval and return it
-			std::auto_ptr<epvector> s(new epvector);
-			s->reserve(seq.size());
+			epvector s;
+			s.reserve(seq.size());
 			
 			// copy parts of seq which are known not to have changed
 			epvector::const_iterator cit2=seq.begin();
 			while (cit2!=cit) {
-				s->push_back(*cit2);
+				s.push_back(*cit2);
 				++cit2;
 			}
 
 			// copy first changed element
-			s->push_back(combine_ex_with_coeff_to_pair(evaled_ex,
+			s.push_back(combine_ex_with_coeff_to_pair(evaled_ex,
 			                                           cit2->coeff));
 			++cit2;
 
 			// copy rest
 			while (cit2!=last) {
-				s->push_back(combine_ex_with_coeff_to_pair(cit2->rest.eval(level),
+				s.push_back(combine_ex_with_coeff_to_pair(cit2->rest.eval(level),
 				                                           cit2->coeff));
 				++cit2;
 			}
@@ -1650,15 +1239,15 @@ std::auto_ptr<epvector> expairseq::evalchildren(int level) const
 		++cit;
 	}
 	
-	return std::auto_ptr<epvector>(0); // signalling nothing has changed
+	return epvector(); // signalling nothing has changed
 }
 
 /** Member-wise substitute in this sequence.
  *
  *  @see expairseq::subs()
- *  @return pointer to epvector containing pairs after application of subs,
- *    or NULL pointer if no members were changed. */
-std::auto_ptr<epvector> expairseq::subschildren(const exmap & m, unsigned options) const
+ *  @return epvector containing pairs after application of subs, empty if
+ *    no members were changed. */
+epvector expairseq::subschildren(const exmap & m, unsigned options) const
 {
 	// When any of the objects to be substituted is a product or power
 	// we have to recombine the pairs because the numeric coefficients may
@@ -1687,19 +1276,19 @@ std::auto_ptr<epvector> expairseq::subschildren(const exmap & m, unsigned option
 			if (!are_ex_trivially_equal(orig_ex, subsed_ex)) {
 
 				// Something changed, copy seq, subs and return it
-				std::auto_ptr<epvector> s(new epvector);
-				s->reserve(seq.size());
+				epvector s;
+				s.reserve(seq.size());
 
 				// Copy parts of seq which are known not to have changed
-				s->insert(s->begin(), seq.begin(), cit);
+				s.insert(s.begin(), seq.begin(), cit);
 
 				// Copy first changed element
-				s->push_back(split_ex_to_pair(subsed_ex));
+				s.push_back(split_ex_to_pair(subsed_ex));
 				++cit;
 
 				// Copy rest
 				while (cit != last) {
-					s->push_back(split_ex_to_pair(recombine_pair_to_ex(*cit).subs(m, options)));
+					s.push_back(split_ex_to_pair(recombine_pair_to_ex(*cit).subs(m, options)));
 					++cit;
 				}
 				return s;
@@ -1718,19 +1307,19 @@ std::auto_ptr<epvector> expairseq::subschildren(const exmap & m, unsigned option
 			if (!are_ex_trivially_equal(cit->rest, subsed_ex)) {
 			
 				// Something changed, copy seq, subs and return it
-				std::auto_ptr<epvector> s(new epvector);
-				s->reserve(seq.size());
+				epvector s;
+				s.reserve(seq.size());
 
 				// Copy parts of seq which are known not to have changed
-				s->insert(s->begin(), seq.begin(), cit);
+				s.insert(s.begin(), seq.begin(), cit);
 			
 				// Copy first changed element
-				s->push_back(combine_ex_with_coeff_to_pair(subsed_ex, cit->coeff));
+				s.push_back(combine_ex_with_coeff_to_pair(subsed_ex, cit->coeff));
 				++cit;
 
 				// Copy rest
 				while (cit != last) {
-					s->push_back(combine_ex_with_coeff_to_pair(cit->rest.subs(m, options), cit->coeff));
+					s.push_back(combine_ex_with_coeff_to_pair(cit->rest.subs(m, options), cit->coeff));
 					++cit;
 				}
 				return s;
@@ -1741,17 +1330,12 @@ std::auto_ptr<epvector> expairseq::subschildren(const exmap & m, unsigned option
 	}
 	
 	// Nothing has changed
-	return std::auto_ptr<epvector>(0);
+	return epvector();
 }
 
 //////////
 // static member variables
 //////////
 
-#if EXPAIRSEQ_USE_HASHTAB
-unsigned expairseq::maxhashtabsize = 0x4000000U;
-unsigned expairseq::minhashtabsize = 0x1000U;
-unsigned expairseq::hashtabfactor = 1;
-#endif // EXPAIRSEQ_USE_HASHTAB
 
 } // namespace GiNaC
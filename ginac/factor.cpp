@@ -12,7 +12,8 @@
  *
  *  Univariate factorization does a modular factorization via Berlekamp's
  *  algorithm and distinct degree factorization. Hensel lifting is used at the
- *  end.
+ *  end. If there are many modular factors, they are recombined by lattice
+ *  reduction [Hoe].
  *  
  *  Multivariate factorization uses the univariate factorization (applying a
  *  evaluation homomorphism first) and Hensel lifting raises the answer to the
@@ -26,6 +27,12 @@
  *    [GCL] Algorithms for Computer Algebra,
  *          K.O.Geddes, S.R.Czapor, G.Labahn,
  *          Springer Verlag, 1992.
+ *    [Hoe] Factoring polynomials and the knapsack problem,
+ *          M.van Hoeij,
+ *          Journal of Number Theory, Vol. 95 (2002) 167--189.
+ *    [Coh] A Course in Computational Algebraic Number Theory,
+ *          H.Cohen,
+ *          Springer Verlag, 1993.
  *    [Mig] Some Useful Bounds,
  *          M.Mignotte, 
  *          In "Computer Algebra, Symbolic and Algebraic Computation" (B.Buchberger et al., eds.),
@@ -64,6 +71,8 @@
 #include "mul.h"
 #include "normal.h"
 #include "add.h"
+#include "parallel.h"
+#include "polynomial/modp_poly.h"
 
 #include <algorithm>
 #include <cmath>
@@ -206,18 +215,6 @@ canonicalize(T& p, const typename T::size_type hint = std::numeric_limits<typena
 
 // END COPY FROM UPOLY.HPP
 
-static void expt_pos(umodpoly& a, unsigned int q)
-{
-	if ( a.empty() ) return;
-	cl_MI zero = a[0].ring()->zero(); 
-	int deg = degree(a);
-	a.resize(degree(a)*q+1, zero);
-	for ( int i=deg; i>0; --i ) {
-		a[i*q] = a[i];
-		a[i] = zero;
-	}
-}
-
 template<bool COND, typename T = void> struct enable_if
 {
 	typedef T type;
@@ -623,266 +620,175 @@ static void gcd(const umodpoly& a, const umodpoly& b, umodpoly& c)
 	normalize_in_field(c);
 }
 
-/** Calculates the derivative of the polynomial a.
- *  
- *  @param[in]  a  polynomial of which to take the derivative
- *  @param[out] d  result/derivative
- */
-static void deriv(const umodpoly& a, umodpoly& d)
-{
-	d.clear();
-	if ( a.size() <= 1 ) return;
+// END modular univariate polynomial code
+////////////////////////////////////////////////////////////////////////////////
 
-	d.insert(d.begin(), a.begin()+1, a.end());
-	int max = d.size();
-	for ( int i=1; i<max; ++i ) {
-		d[i] = d[i] * (i+1);
-	}
-	canonicalize(d);
-}
+////////////////////////////////////////////////////////////////////////////////
+// modular factorization with word-size coefficients
+
+// The small primes used for the modular factorization fit into a word, so
+// that the finite field arithmetic is done with modp_field instead of cl_MI.
+// Only the factors that are Hensel lifted are converted to umodpoly.
 
-static bool unequal_one(const umodpoly& a)
+typedef modp_field<uint32_t> wfield;
+typedef std::vector<uint32_t> wpoly;
+typedef vector<wpoly> wpvec;
+
+static void wpoly_from_upoly(wpoly& wp, const upoly& a, const wfield& F)
 {
-	if ( a.empty() ) return true;
-	return ( a.size() != 1 || a[0] != a[0].ring()->one() );
+	const cl_I p = F.modulus();
+	wp.resize(a.size());
+	for ( size_t i=0; i<a.size(); ++i ) {
+		wp[i] = F.from_uint(cl_I_to_uint(mod(a[i], p)));
+	}
+	modp_canonicalize(wp);
 }
 
-static bool equal_one(const umodpoly& a)
+static void umodpoly_from_wpoly(umodpoly& ump, const wpoly& a, const wfield& F, const cl_modint_ring& R)
 {
-	return ( a.size() == 1 && a[0] == a[0].ring()->one() );
+	ump.resize(a.size());
+	for ( size_t i=0; i<a.size(); ++i ) {
+		ump[i] = R->canonhom(cl_I(F.to_uint(a[i])));
+	}
 }
 
 /** Returns true if polynomial a is square free.
  *
+ *  @param[in] F  modular field
  *  @param[in] a  polynomial to check
  *  @return       true if polynomial is square free, false otherwise
  */
-static bool squarefree(const umodpoly& a)
+static bool squarefree(const wfield& F, const wpoly& a)
 {
-	umodpoly b;
-	deriv(a, b);
+	wpoly b;
+	modp_deriv(F, b, a);
 	if ( b.empty() ) {
 		return false;
 	}
-	umodpoly c;
-	gcd(a, b, c);
-	return equal_one(c);
-}
-
-// END modular univariate polynomial code
-////////////////////////////////////////////////////////////////////////////////
-
-////////////////////////////////////////////////////////////////////////////////
-// modular matrix
-
-typedef vector<cl_MI> mvec;
-
-class modular_matrix
-{
-	friend ostream& operator<<(ostream& o, const modular_matrix& m);
-public:
-	modular_matrix(size_t r_, size_t c_, const cl_MI& init) : r(r_), c(c_)
-	{
-		m.resize(c*r, init);
-	}
-	size_t rowsize() const { return r; }
-	size_t colsize() const { return c; }
-	cl_MI& operator()(size_t row, size_t col) { return m[row*c + col]; }
-	cl_MI operator()(size_t row, size_t col) const { return m[row*c + col]; }
-	void mul_col(size_t col, const cl_MI x)
-	{
-		for ( size_t rc=0; rc<r; ++rc ) {
-			std::size_t i = c*rc + col;
-			m[i] = m[i] * x;
-		}
-	}
-	void sub_col(size_t col1, size_t col2, const cl_MI fac)
-	{
-		for ( size_t rc=0; rc<r; ++rc ) {
-			std::size_t i1 = col1 + c*rc;
-			std::size_t i2 = col2 + c*rc;
-			m[i1] = m[i1] - m[i2]*fac;
-		}
-	}
-	void switch_col(size_t col1, size_t col2)
-	{
-		for ( size_t rc=0; rc<r; ++rc ) {
-			std::size_t i1 = col1 + rc*c;
-			std::size_t i2 = col2 + rc*c;
-			std::swap(m[i1], m[i2]);
-		}
-	}
-	void mul_row(size_t row, const cl_MI x)
-	{
-		for ( size_t cc=0; cc<c; ++cc ) {
-			std::size_t i = row*c + cc; 
-			m[i] = m[i] * x;
-		}
-	}
-	void sub_row(size_t row1, size_t row2, const cl_MI fac)
-	{
-		for ( size_t cc=0; cc<c; ++cc ) {
-			std::size_t i1 = row1*c + cc;
-			std::size_t i2 = row2*c + cc;
-			m[i1] = m[i1] - m[i2]*fac;
-		}
-	}
-	void switch_row(size_t row1, size_t row2)
-	{
-		for ( size_t cc=0; cc<c; ++cc ) {
-			std::size_t i1 = row1*c + cc;
-			std::size_t i2 = row2*c + cc;
-			std::swap(m[i1], m[i2]);
-		}
-	}
-	bool is_col_zero(size_t col) const
-	{
-		for ( size_t rr=0; rr<r; ++rr ) {
-			std::size_t i = col + rr*c;
-			if ( !zerop(m[i]) ) {
-				return false;
-			}
-		}
-		return true;
-	}
-	bool is_row_zero(size_t row) const
-	{
-		for ( size_t cc=0; cc<c; ++cc ) {
-			std::size_t i = row*c + cc;
-			if ( !zerop(m[i]) ) {
-				return false;
-			}
-		}
-		return true;
-	}
-	void set_row(size_t row, const vector<cl_MI>& newrow)
-	{
-		for (std::size_t i2 = 0; i2 < newrow.size(); ++i2) {
-			std::size_t i1 = row*c + i2;
-			m[i1] = newrow[i2];
-		}
-	}
-	mvec::const_iterator row_begin(size_t row) const { return m.begin()+row*c; }
-	mvec::const_iterator row_end(size_t row) const { return m.begin()+row*c+r; }
-private:
-	size_t r, c;
-	mvec m;
-};
-
-#ifdef DEBUGFACTOR
-modular_matrix operator*(const modular_matrix& m1, const modular_matrix& m2)
-{
-	const unsigned int r = m1.rowsize();
-	const unsigned int c = m2.colsize();
-	modular_matrix o(r,c,m1(0,0));
-
-	for ( size_t i=0; i<r; ++i ) {
-		for ( size_t j=0; j<c; ++j ) {
-			cl_MI buf;
-			buf = m1(i,0) * m2(0,j);
-			for ( size_t k=1; k<c; ++k ) {
-				buf = buf + m1(i,k)*m2(k,j);
-			}
-			o(i,j) = buf;
-		}
-	}
-	return o;
+	wpoly c;
+	modp_gcd(F, c, a, b);
+	return c.size() == 1;
 }
 
-ostream& operator<<(ostream& o, const modular_matrix& m)
-{
-	cl_modint_ring R = m(0,0).ring();
-	o << "{";
-	for ( size_t i=0; i<m.rowsize(); ++i ) {
-		o << "{";
-		for ( size_t j=0; j<m.colsize()-1; ++j ) {
-			o << R->retract(m(i,j)) << ",";
+/** Calculates the Q matrix for a polynomial, i.e. the matrix of the map
+ *  w -> w^p modulo the polynomial. Row i holds x^(i*p) mod a. Used by
+ *  Berlekamp's algorithm and by distinct degree factorization.
+ *
+ *  @param[in]  F  modular field
+ *  @param[in]  a  monic modular polynomial of degree n > 0
+ *  @param[out] Q  n x n Q matrix in row-major order
+ */
+static void q_matrix(const wfield& F, const wpoly& a, vector<uint32_t>& Q)
+{
+	const size_t n = degree(a);
+	const unsigned int q = F.modulus();
+	Q.assign(n*n, 0);
+	wpoly r(n, 0);
+	r[0] = F.one();
+	copy(r.begin(), r.end(), Q.begin());
+	const size_t max = (n-1) * q;
+	for ( size_t m=1; m<=max; ++m ) {
+		const uint32_t rn_1 = r[n-1];
+		for ( size_t i=n-1; i>0; --i ) {
+			r[i] = F.sub(r[i-1], F.mul(rn_1, a[i]));
 		}
-		o << R->retract(m(i,m.colsize()-1)) << "}";
-		if ( i != m.rowsize()-1 ) {
-			o << ",";
+		r[0] = F.neg(F.mul(rn_1, a[0]));
+		if ( (m % q) == 0 ) {
+			copy(r.begin(), r.end(), Q.begin() + (m/q)*n);
 		}
 	}
-	o << "}";
-	return o;
 }
-#endif // def DEBUGFACTOR
-
-// END modular matrix
-////////////////////////////////////////////////////////////////////////////////
 
-/** Calculates the Q matrix for a polynomial. Used by Berlekamp's algorithm.
+/** Calculates w^p mod a with the Q matrix of a.
  *
- *  @param[in]  a_  modular polynomial
- *  @param[out] Q   Q matrix
+ *  @param[in]  F  modular field
+ *  @param[in]  Q  Q matrix of a as computed by q_matrix()
+ *  @param[in]  n  degree of a
+ *  @param[in]  w  polynomial of degree less than n
+ *  @param[out] r  w^p mod a
  */
-static void q_matrix(const umodpoly& a_, modular_matrix& Q)
+static void frobenius(const wfield& F, const vector<uint32_t>& Q, size_t n, const wpoly& w, wpoly& r)
 {
-	umodpoly a = a_;
-	normalize_in_field(a);
-
-	int n = degree(a);
-	unsigned int q = cl_I_to_uint(a[0].ring()->modulus);
-	umodpoly r(n, a[0].ring()->zero());
-	r[0] = a[0].ring()->one();
-	Q.set_row(0, r);
-	unsigned int max = (n-1) * q;
-	for ( size_t m=1; m<=max; ++m ) {
-		cl_MI rn_1 = r.back();
-		for ( size_t i=n-1; i>0; --i ) {
-			r[i] = r[i-1] - (rn_1 * a[i]);
-		}
-		r[0] = -rn_1 * a[0];
-		if ( (m % q) == 0 ) {
-			Q.set_row(m/q, r);
+	vector<wfield::wide_type> s(n, 0);
+	for ( size_t j=0; j<w.size(); ++j ) {
+		const uint32_t wj = w[j];
+		if ( wj == 0 ) continue;
+		const uint32_t* row = &Q[j*n];
+		for ( size_t k=0; k<n; ++k ) {
+			F.lazy_add(s[k], wj, row[k]);
 		}
 	}
+	r.resize(n);
+	for ( size_t k=0; k<n; ++k ) {
+		r[k] = F.reduce(s[k]);
+	}
+	modp_canonicalize(r);
 }
 
 /** Determine the nullspace of a matrix M-1.
  *
- *  @param[in,out] M      matrix, will be modified
- *  @param[out]    basis  calculated nullspace of M-1
+ *  @param[in]  F      modular field
+ *  @param[in]  M      n x n matrix in row-major order
+ *  @param[in]  n      size of the matrix
+ *  @param[out] basis  calculated nullspace of M-1
  */
-static void nullspace(modular_matrix& M, vector<mvec>& basis)
+static void nullspace(const wfield& F, const vector<uint32_t>& M, size_t n, wpvec& basis)
 {
-	const size_t n = M.rowsize();
-	const cl_MI one = M(0,0).ring()->one();
+	// The elimination works on columns, so store them contiguously.
+	wpvec col(n, wpoly(n));
+	for ( size_t r=0; r<n; ++r ) {
+		for ( size_t c=0; c<n; ++c ) {
+			col[c][r] = M[r*n + c];
+		}
+	}
+	const uint32_t one = F.one();
 	for ( size_t i=0; i<n; ++i ) {
-		M(i,i) = M(i,i) - one;
+		col[i][i] = F.sub(col[i][i], one);
 	}
 	for ( size_t r=0; r<n; ++r ) {
 		size_t cc = 0;
 		for ( ; cc<n; ++cc ) {
-			if ( !zerop(M(r,cc)) ) {
+			if ( col[cc][r] != 0 ) {
 				if ( cc < r ) {
-					if ( !zerop(M(cc,cc)) ) {
+					if ( col[cc][cc] != 0 ) {
 						continue;
 					}
-					M.switch_col(cc, r);
+					col[cc].swap(col[r]);
 				}
 				else if ( cc > r ) {
-					M.switch_col(cc, r);
+					col[cc].swap(col[r]);
 				}
 				break;
 			}
 		}
 		if ( cc < n ) {
-			M.mul_col(r, recip(M(r,r)));
+			wpoly& cr = col[r];
+			const uint32_t x = F.inv(cr[r]);
+			for ( size_t k=0; k<n; ++k ) {
+				cr[k] = F.mul(cr[k], x);
+			}
 			for ( cc=0; cc<n; ++cc ) {
-				if ( cc != r ) {
-					M.sub_col(cc, r, M(r,cc));
+				const uint32_t fac = F.neg(col[cc][r]);
+				if ( cc == r || fac == 0 ) continue;
+				wpoly& c = col[cc];
+				for ( size_t k=0; k<n; ++k ) {
+					c[k] = F.add(c[k], F.mul(cr[k], fac));
 				}
 			}
 		}
 	}
 
 	for ( size_t i=0; i<n; ++i ) {
-		M(i,i) = M(i,i) - one;
+		col[i][i] = F.sub(col[i][i], one);
 	}
 	for ( size_t i=0; i<n; ++i ) {
-		if ( !M.is_row_zero(i) ) {
-			mvec nu(M.row_begin(i), M.row_end(i));
+		wpoly nu(n);
+		bool zero = true;
+		for ( size_t k=0; k<n; ++k ) {
+			nu[k] = col[k][i];
+			zero = zero && nu[k] == 0;
+		}
+		if ( !zero ) {
 			basis.push_back(nu);
 		}
 	}
@@ -892,20 +798,21 @@ static void nullspace(modular_matrix& M, vector<mvec>& basis)
  *  
  *  The implementation follows the algorithm in chapter 8 of [GCL].
  *
- *  @param[in]  a    modular polynomial
- *  @param[out] upv  vector containing modular factors. if upv was not empty the
- *                   new elements are added at the end
+ *  @param[in]  F    modular field
+ *  @param[in]  a_   modular polynomial
+ *  @param[out] upv  vector containing monic modular factors. if upv was not
+ *                   empty the new elements are added at the end
  */
-static void berlekamp(const umodpoly& a, upvec& upv)
+static void berlekamp(const wfield& F, const wpoly& a_, wpvec& upv)
 {
-	cl_modint_ring R = a[0].ring();
-	umodpoly one(1, R->one());
+	wpoly a = a_;
+	modp_make_monic(F, a);
 
 	// find nullspace of Q matrix
-	modular_matrix Q(degree(a), degree(a), R->zero());
-	q_matrix(a, Q);
-	vector<mvec> nu;
-	nullspace(Q, nu);
+	vector<uint32_t> Q;
+	q_matrix(F, a, Q);
+	wpvec nu;
+	nullspace(F, Q, degree(a), nu);
 
 	const unsigned int k = nu.size();
 	if ( k == 1 ) {
@@ -913,26 +820,26 @@ static void berlekamp(const umodpoly& a, upvec& upv)
 		return;
 	}
 
-	list<umodpoly> factors;
+	list<wpoly> factors;
 	factors.push_back(a);
 	unsigned int size = 1;
 	unsigned int r = 1;
-	unsigned int q = cl_I_to_uint(R->modulus);
+	const unsigned int q = F.modulus();
 
-	list<umodpoly>::iterator u = factors.begin();
+	list<wpoly>::iterator u = factors.begin();
 
 	// calculate all gcd's
 	while ( true ) {
 		for ( unsigned int s=0; s<q; ++s ) {
-			umodpoly nur = nu[r];
-			nur[0] = nur[0] - cl_MI(R, s);
-			canonicalize(nur);
-			umodpoly g;
-			gcd(nur, *u, g);
-			if ( unequal_one(g) && g != *u ) {
-				umodpoly uo;
-				div(*u, g, uo);
-				if ( equal_one(uo) ) {
+			wpoly nur = nu[r];
+			nur[0] = F.sub(nur[0], F.from_uint(s));
+			modp_canonicalize(nur);
+			wpoly g;
+			modp_gcd(F, g, nur, *u);
+			if ( g.size() > 1 && g != *u ) {
+				wpoly ur, uo;
+				modp_remdiv(F, ur, *u, g, &uo);
+				if ( uo.size() == 1 ) {
 					throw logic_error("berlekamp: unexpected divisor.");
 				}
 				else {
@@ -940,13 +847,13 @@ static void berlekamp(const umodpoly& a, upvec& upv)
 				}
 				factors.push_back(g);
 				size = 0;
-				list<umodpoly>::const_iterator i = factors.begin(), end = factors.end();
+				list<wpoly>::const_iterator i = factors.begin(), end = factors.end();
 				while ( i != end ) {
 					if ( degree(*i) ) ++size; 
 					++i;
 				}
 				if ( size == k ) {
-					list<umodpoly>::const_iterator i = factors.begin(), end = factors.end();
+					list<wpoly>::const_iterator i = factors.begin(), end = factors.end();
 					while ( i != end ) {
 						upv.push_back(*i++);
 					}
@@ -961,154 +868,162 @@ static void berlekamp(const umodpoly& a, upvec& upv)
 	}
 }
 
-// modular square free factorization is not used at the moment so we deactivate
-// the code
-#if 0
-
-/** Calculates a^(1/prime).
- *  
- *  @param[in] a      polynomial
- *  @param[in] prime  prime number -> exponent 1/prime
- *  @param[in] ap     resulting polynomial
- */
-static void expt_1_over_p(const umodpoly& a, unsigned int prime, umodpoly& ap)
-{
-	size_t newdeg = degree(a)/prime;
-	ap.resize(newdeg+1);
-	ap[0] = a[0];
-	for ( size_t i=1; i<=newdeg; ++i ) {
-		ap[i] = a[i*prime];
-	}
-}
-
-/** Modular square free factorization.
- *
- *  @param[in]  a        polynomial
- *  @param[out] factors  modular factors
- *  @param[out] mult     corresponding multiplicities (exponents)
- */
-static void modsqrfree(const umodpoly& a, upvec& factors, vector<int>& mult)
-{
-	const unsigned int prime = cl_I_to_uint(a[0].ring()->modulus);
-	int i = 1;
-	umodpoly b;
-	deriv(a, b);
-	if ( b.size() ) {
-		umodpoly c;
-		gcd(a, b, c);
-		umodpoly w;
-		div(a, c, w);
-		while ( unequal_one(w) ) {
-			umodpoly y;
-			gcd(w, c, y);
-			umodpoly z;
-			div(w, y, z);
-			factors.push_back(z);
-			mult.push_back(i);
-			++i;
-			w = y;
-			umodpoly buf;
-			div(c, y, buf);
-			c = buf;
-		}
-		if ( unequal_one(c) ) {
-			umodpoly cp;
-			expt_1_over_p(c, prime, cp);
-			size_t previ = mult.size();
-			modsqrfree(cp, factors, mult);
-			for ( size_t i=previ; i<mult.size(); ++i ) {
-				mult[i] *= prime;
-			}
-		}
-	}
-	else {
-		umodpoly ap;
-		expt_1_over_p(a, prime, ap);
-		size_t previ = mult.size();
-		modsqrfree(ap, factors, mult);
-		for ( size_t i=previ; i<mult.size(); ++i ) {
-			mult[i] *= prime;
-		}
-	}
-}
-
-#endif // deactivation of square free factorization
-
 /** Distinct degree factorization (DDF).
  *  
- *  The implementation follows the algorithm in chapter 8 of [GCL].
+ *  The implementation follows the algorithm in chapter 8 of [GCL]. The
+ *  powers w^p are computed with the Q matrix, which is only recomputed when
+ *  a factor is split off.
  *
+ *  @param[in]  F          modular field
  *  @param[in]  a_         modular polynomial
  *  @param[out] degrees    vector containing the degrees of the factors of the
  *                         corresponding polynomials in ddfactors.
- *  @param[out] ddfactors  vector containing polynomials which factors have the
- *                         degree given in degrees.
+ *  @param[out] ddfactors  vector containing monic polynomials which factors
+ *                         have the degree given in degrees.
  */
-static void distinct_degree_factor(const umodpoly& a_, vector<int>& degrees, upvec& ddfactors)
+static void distinct_degree_factor(const wfield& F, const wpoly& a_, vector<int>& degrees, wpvec& ddfactors)
 {
-	umodpoly a = a_;
+	wpoly a = a_;
+	modp_make_monic(F, a);
 
-	cl_modint_ring R = a[0].ring();
-	int q = cl_I_to_int(R->modulus);
 	int nhalf = degree(a)/2;
 
 	int i = 1;
-	umodpoly w(2);
-	w[0] = R->zero();
-	w[1] = R->one();
-	umodpoly x = w;
+	wpoly x(2, 0);
+	x[1] = F.one();
+	wpoly w = x;
+	vector<uint32_t> Q;
+	if ( nhalf ) {
+		q_matrix(F, a, Q);
+	}
 
 	while ( i <= nhalf ) {
-		expt_pos(w, q);
-		umodpoly buf;
-		rem(w, a, buf);
-		w = buf;
-		umodpoly wx = w - x;
-		gcd(a, wx, buf);
-		if ( unequal_one(buf) ) {
+		frobenius(F, Q, degree(a), w, w);
+		wpoly wx, buf;
+		modp_sub(F, wx, w, x);
+		modp_gcd(F, buf, a, wx);
+		if ( buf.size() > 1 ) {
 			degrees.push_back(i);
 			ddfactors.push_back(buf);
-		}
-		if ( unequal_one(buf) ) {
-			umodpoly buf2;
-			div(a, buf, buf2);
-			a = buf2;
+			wpoly r, q;
+			modp_remdiv(F, r, a, buf, &q);
+			a.swap(q);
 			nhalf = degree(a)/2;
-			rem(w, a, buf);
-			w = buf;
+			modp_remdiv(F, w, w, a);
+			if ( i < nhalf ) {
+				q_matrix(F, a, Q);
+			}
 		}
 		++i;
 	}
-	if ( unequal_one(a) ) {
+	if ( a.size() > 1 ) {
 		degrees.push_back(degree(a));
 		ddfactors.push_back(a);
 	}
 }
 
+/** Equal degree factorization by the Cantor-Zassenhaus algorithm.
+ *
+ *  For a random polynomial r, the power r^((p^d-1)/2) is 0, 1 or -1 modulo
+ *  every factor of a, so that its GCD with a splits a with probability of
+ *  about one half. The power is computed as N^((p-1)/2) with the norm
+ *  N = r*r^p*...*r^(p^(d-1)), whose factors are obtained with the Q matrix.
+ *  The random numbers come from a fixed seed, so the result is reproducible.
+ *
+ *  @param[in]  F    modular field, the prime must be odd
+ *  @param[in]  a_   modular polynomial, product of distinct irreducible
+ *                   polynomials of degree d
+ *  @param[in]  d    degree of the irreducible factors
+ *  @param[out] upv  vector containing monic modular factors. if upv was not
+ *                   empty the new elements are added at the end
+ */
+static void equal_degree_factor(const wfield& F, const wpoly& a_, int d, wpvec& upv)
+{
+	wpoly a = a_;
+	modp_make_monic(F, a);
+	const size_t n = degree(a);
+	const unsigned int p = F.modulus();
+
+	// The Q matrix of a gives w^p mod a, and w^p mod b for every factor b
+	// of a after another division.
+	vector<uint32_t> Q;
+	q_matrix(F, a, Q);
+
+	uint64_t seed = 1;
+	wpvec tosplit(1, a);
+	while ( !tosplit.empty() ) {
+		wpoly b;
+		b.swap(tosplit.back());
+		tosplit.pop_back();
+		const size_t m = degree(b);
+		if ( m == (size_t)d ) {
+			upv.push_back(b);
+			continue;
+		}
+
+		while ( true ) {
+			wpoly r(m);
+			for ( size_t i=0; i<m; ++i ) {
+				seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+				r[i] = F.from_uint(uint32_t(seed >> 33) % p);
+			}
+			modp_canonicalize(r);
+			if ( r.size() < 2 ) continue;
+
+			wpoly t = r, norm = r;
+			for ( int i=1; i<d; ++i ) {
+				frobenius(F, Q, n, t, t);
+				modp_remdiv(F, t, t, b);
+				modp_mulmod(F, norm, norm, t, b);
+			}
+			wpoly h;
+			modp_powmod(F, h, norm, (p-1)/2, b);
+			modp_sub(F, h, h, wpoly(1, F.one()));
+			wpoly g;
+			modp_gcd(F, g, h, b);
+			if ( g.size() > 1 && g.size() <= m ) {
+				wpoly r0, q;
+				modp_remdiv(F, r0, b, g, &q);
+				tosplit.push_back(g);
+				tosplit.push_back(q);
+				break;
+			}
+		}
+	}
+}
+
+/** Factors of at most this degree found by the distinct degree factorization
+ *  are split with Berlekamp's algorithm, larger ones with the equal degree
+ *  factorization, since the nullspace computation of the former costs
+ *  O(n^3) operations. */
+static const int berlekamp_max_degree = 16;
+
 /** Modular same degree factorization.
  *  Same degree factorization is a kind of misnomer. It performs distinct degree
- *  factorization, but instead of using the Cantor-Zassenhaus algorithm it
- *  (sub-optimally) uses Berlekamp's algorithm for the factors of the same
- *  degree.
+ *  factorization, and then splits the products of factors of the same degree
+ *  with Berlekamp's algorithm or by equal degree factorization, depending on
+ *  their degree.
  *
+ *  @param[in]  F    modular field
  *  @param[in]  a    modular polynomial
  *  @param[out] upv  vector containing modular factors. if upv was not empty the
  *                   new elements are added at the end
  */
-static void same_degree_factor(const umodpoly& a, upvec& upv)
+static void same_degree_factor(const wfield& F, const wpoly& a, wpvec& upv)
 {
-	cl_modint_ring R = a[0].ring();
-
 	vector<int> degrees;
-	upvec ddfactors;
-	distinct_degree_factor(a, degrees, ddfactors);
+	wpvec ddfactors;
+	distinct_degree_factor(F, a, degrees, ddfactors);
 
 	for ( size_t i=0; i<degrees.size(); ++i ) {
 		if ( degrees[i] == degree(ddfactors[i]) ) {
 			upv.push_back(ddfactors[i]);
 		}
+		else if ( degree(ddfactors[i]) <= berlekamp_max_degree ) {
+			berlekamp(F, ddfactors[i], upv);
+		}
 		else {
-			berlekamp(ddfactors[i], upv);
+			equal_degree_factor(F, ddfactors[i], degrees[i], upv);
 		}
 	}
 }
@@ -1122,19 +1037,23 @@ static void same_degree_factor(const umodpoly& a, upvec& upv)
  *  and same degree factorization (SDF). SDF seems to be slightly faster in
  *  almost all cases so it is activated as default.
  *
+ *  @param[in]  F    modular field
  *  @param[in]  p    modular polynomial
- *  @param[out] upv  vector containing modular factors. if upv was not empty the
- *                   new elements are added at the end
+ *  @param[out] upv  vector containing monic modular factors. if upv was not
+ *                   empty the new elements are added at the end
  */
-static void factor_modular(const umodpoly& p, upvec& upv)
+static void factor_modular(const wfield& F, const wpoly& p, wpvec& upv)
 {
 #ifdef USE_SAME_DEGREE_FACTOR
-	same_degree_factor(p, upv);
+	same_degree_factor(F, p, upv);
 #else
-	berlekamp(p, upv);
+	berlekamp(F, p, upv);
 #endif
 }
 
+// END modular factorization with word-size coefficients
+////////////////////////////////////////////////////////////////////////////////
+
 /** Calculates modular polynomials s and t such that a*s+b*t==1.
  *  Assertion: a and b are relatively prime and not zero.
  *
@@ -1362,13 +1281,13 @@ class factor_partition
 {
 public:
 	/** Takes the vector of modular factors and initializes the first partition */
-	factor_partition(const upvec& factors_) : factors(factors_)
+	factor_partition(const wfield& F_, const cl_modint_ring& R_, const wpvec& factors_) : F(F_), R(R_), factors(factors_)
 	{
 		n = factors.size();
 		k.resize(n, 0);
 		k[0] = 1;
 		cache.resize(n-1);
-		one.resize(1, factors.front()[0].ring()->one());
+		one.resize(1, F.one());
 		len = 1;
 		last = 0;
 		split();
@@ -1417,10 +1336,16 @@ public:
 		return true;
 	}
 	/** Get first partition */
-	umodpoly& left() { return lr[0]; }
+	umodpoly left() const { umodpoly r; umodpoly_from_wpoly(r, lr[0], F, R); return r; }
 	/** Get second partition */
-	umodpoly& right() { return lr[1]; }
+	umodpoly right() const { umodpoly r; umodpoly_from_wpoly(r, lr[1], F, R); return r; }
 private:
+	wpoly mul(const wpoly& a, const wpoly& b) const
+	{
+		wpoly c;
+		modp_mul(F, c, a, b);
+		return c;
+	}
 	void split_cached()
 	{
 		size_t i = 0;
@@ -1431,25 +1356,25 @@ private:
 			while ( i < n && k[i] == group ) { ++d; ++i; }
 			if ( d ) {
 				if ( cache[pos].size() >= d ) {
-					lr[group] = lr[group] * cache[pos][d-1];
+					lr[group] = mul(lr[group], cache[pos][d-1]);
 				}
 				else {
 					if ( cache[pos].size() == 0 ) {
-						cache[pos].push_back(factors[pos] * factors[pos+1]);
+						cache[pos].push_back(mul(factors[pos], factors[pos+1]));
 					}
 					size_t j = pos + cache[pos].size() + 1;
 					d -= cache[pos].size();
 					while ( d ) {
-						umodpoly buf = cache[pos].back() * factors[j];
+						wpoly buf = mul(cache[pos].back(), factors[j]);
 						cache[pos].push_back(buf);
 						--d;
 						++j;
 					}
-					lr[group] = lr[group] * cache[pos].back();
+					lr[group] = mul(lr[group], cache[pos].back());
 				}
 			}
 			else {
-				lr[group] = lr[group] * factors[pos];
+				lr[group] = mul(lr[group], factors[pos]);
 			}
 		} while ( i < n );
 	}
@@ -1462,15 +1387,17 @@ private:
 		}
 		else {
 			for ( size_t i=0; i<n; ++i ) {
-				lr[k[i]] = lr[k[i]] * factors[i];
+				lr[k[i]] = mul(lr[k[i]], factors[i]);
 			}
 		}
 	}
 private:
-	umodpoly lr[2];
-	vector< vector<umodpoly> > cache;
-	upvec factors;
-	umodpoly one;
+	const wfield F;
+	const cl_modint_ring R;
+	wpoly lr[2];
+	vector< vector<wpoly> > cache;
+	wpvec factors;
+	wpoly one;
 	size_t n;
 	size_t len;
 	size_t last;
@@ -1483,13 +1410,446 @@ private:
 struct ModFactors
 {
 	upoly poly;
-	upvec factors;
+	wpvec factors;
 };
 
+/** Modular factorizations of a polynomial for several primes, computed in
+ *  parallel. Used by factor_univariate().
+ */
+struct modular_trials : public parallel_task
+{
+	vector<unsigned int> primes;
+	wpvec images;           ///< polynomial modulo primes[i]
+	vector<char> usable;    ///< images[i] is square free
+	vector<wpvec> factors;  ///< modular factors of images[i]
+	void run(size_t i, unsigned slot)
+	{
+		const wfield F(primes[i]);
+		usable[i] = squarefree(F, images[i]);
+		if ( usable[i] ) {
+			factor_modular(F, images[i], factors[i]);
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// recombination of modular factors by lattice reduction
+
+static cl_I dot(const vector<cl_I>& a, const vector<cl_I>& b)
+{
+	cl_I s = 0;
+	for ( size_t i=0; i<a.size(); ++i ) {
+		s = s + a[i]*b[i];
+	}
+	return s;
+}
+
+/** Size reduction step of lll_reduce(), makes |lambda[k][l]| <= d[l]/2.
+ */
+static void lll_size_reduce(vector< vector<cl_I> >& b, const vector<cl_I>& d, vector< vector<cl_I> >& lambda, size_t k, size_t l)
+{
+	if ( 2*abs(lambda[k][l]) > d[l] ) {
+		const cl_I q = floor1(2*lambda[k][l] + d[l], 2*d[l]);
+		vector<cl_I>& bk = b[k-1];
+		const vector<cl_I>& bl = b[l-1];
+		for ( size_t i=0; i<bk.size(); ++i ) {
+			bk[i] = bk[i] - q*bl[i];
+		}
+		lambda[k][l] = lambda[k][l] - q*d[l];
+		for ( size_t i=1; i<l; ++i ) {
+			lambda[k][i] = lambda[k][i] - q*lambda[l][i];
+		}
+	}
+}
+
+/** Reduces a lattice basis with the integral LLL algorithm for the parameter
+ *  3/4, see algorithm 2.6.7 in [Coh]. All computations are done with
+ *  integers.
+ *
+ *  @param[in,out] b  linearly independent basis vectors, reduced on return
+ *  @param[out]    d  d[i] is the Gram determinant of the first i vectors, so
+ *                    that d[i]/d[i-1] is the squared length of the i-th
+ *                    Gram-Schmidt vector
+ */
+static void lll_reduce(vector< vector<cl_I> >& b, vector<cl_I>& d)
+{
+	const size_t n = b.size();
+	d.assign(n+1, 0);
+	if ( n == 0 ) return;
+	vector< vector<cl_I> > lambda(n+1, vector<cl_I>(n+1, 0));
+	d[0] = 1;
+	d[1] = dot(b[0], b[0]);
+	size_t k = 2, kmax = 1;
+	while ( k <= n ) {
+		if ( k > kmax ) {
+			kmax = k;
+			for ( size_t j=1; j<=k; ++j ) {
+				cl_I u = dot(b[k-1], b[j-1]);
+				for ( size_t i=1; i<j; ++i ) {
+					u = exquo(d[i]*u - lambda[k][i]*lambda[j][i], d[i-1]);
+				}
+				if ( j < k ) {
+					lambda[k][j] = u;
+				}
+				else {
+					d[k] = u;
+				}
+			}
+			if ( zerop(d[k]) ) {
+				throw logic_error("lll_reduce: basis vectors are linearly dependent");
+			}
+		}
+		lll_size_reduce(b, d, lambda, k, k-1);
+		if ( 4*d[k]*d[k-2] < 3*square(d[k-1]) - 4*square(lambda[k][k-1]) ) {
+			swap(b[k-1], b[k-2]);
+			for ( size_t j=1; j+2<=k; ++j ) {
+				std::swap(lambda[k][j], lambda[k-1][j]);
+			}
+			const cl_I l = lambda[k][k-1];
+			const cl_I B = exquo(d[k-2]*d[k] + square(l), d[k-1]);
+			for ( size_t i=k+1; i<=kmax; ++i ) {
+				const cl_I t = lambda[i][k];
+				lambda[i][k] = exquo(d[k]*lambda[i][k-1] - l*t, d[k-1]);
+				lambda[i][k-1] = exquo(B*t + l*lambda[i][k], d[k]);
+			}
+			d[k-1] = B;
+			if ( k > 2 ) --k;
+		}
+		else {
+			for ( size_t l=k-1; l-- > 1; ) {
+				lll_size_reduce(b, d, lambda, k, l);
+			}
+			++k;
+		}
+	}
+}
+
+/** Checks whether the first r coordinates of the vectors b[0], ..., b[s-1]
+ *  span a space with a basis of 0/1 vectors whose supports partition
+ *  {0, ..., r-1}, and determines these supports. The basis is the reduced
+ *  row echelon form.
+ *
+ *  @param[in]  b       vectors
+ *  @param[in]  s       number of vectors
+ *  @param[in]  r       number of coordinates
+ *  @param[out] groups  supports of the basis vectors
+ *  @return             true if there is such a basis
+ */
+static bool zero_one_basis(const vector< vector<cl_I> >& b, size_t s, size_t r, vector< vector<size_t> >& groups)
+{
+	vector< vector<cl_RA> > M(s, vector<cl_RA>(r));
+	for ( size_t i=0; i<s; ++i ) {
+		for ( size_t j=0; j<r; ++j ) {
+			M[i][j] = b[i][j];
+		}
+	}
+	size_t row = 0;
+	for ( size_t c=0; c<r && row<s; ++c ) {
+		size_t piv = row;
+		while ( piv < s && zerop(M[piv][c]) ) ++piv;
+		if ( piv == s ) continue;
+		swap(M[row], M[piv]);
+		const cl_RA inv = recip(M[row][c]);
+		for ( size_t j=0; j<r; ++j ) {
+			M[row][j] = M[row][j] * inv;
+		}
+		for ( size_t i=0; i<s; ++i ) {
+			if ( i == row || zerop(M[i][c]) ) continue;
+			const cl_RA f = M[i][c];
+			for ( size_t j=0; j<r; ++j ) {
+				M[i][j] = M[i][j] - f*M[row][j];
+			}
+		}
+		++row;
+	}
+	if ( row < s ) {
+		return false;
+	}
+
+	groups.assign(s, vector<size_t>());
+	for ( size_t c=0; c<r; ++c ) {
+		size_t ones = 0;
+		for ( size_t i=0; i<s; ++i ) {
+			if ( M[i][c] == 1 ) {
+				++ones;
+				groups[i].push_back(c);
+			}
+			else if ( !zerop(M[i][c]) ) {
+				return false;
+			}
+		}
+		if ( ones != 1 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Lifts the factorization g = u1*w1 mod p of the monic polynomial g to a
+ *  factorization g = u*w mod p^a with monic u and w by linear Hensel lifting.
+ *
+ *  @param[in]  g   monic polynomial
+ *  @param[in]  p   prime
+ *  @param[in]  a   exponent of the modulus to lift to
+ *  @param[in]  u1  monic modular factor, coprime to w1
+ *  @param[in]  w1  monic modular factor
+ *  @param[out] u   lifted factor, coefficients are not reduced mod p^a
+ *  @param[out] w   lifted factor, coefficients are not reduced mod p^a
+ */
+static void hensel_lift_pair(const upoly& g, unsigned int p, unsigned int a, const umodpoly& u1, const umodpoly& w1, upoly& u, upoly& w)
+{
+	const cl_modint_ring& R = u1[0].ring();
+	umodpoly s, t;
+	exteuclid(u1, w1, s, t);
+	u = umodpoly_to_upoly(u1);
+	w = umodpoly_to_upoly(w1);
+	cl_I modulus = p;
+	for ( unsigned int k=1; k<a; ++k ) {
+		const upoly e = g - u * w;
+		if ( e.empty() ) break;
+		// find du, dw with du*w1 + dw*u1 = e/p^k mod p
+		umodpoly c;
+		umodpoly_from_upoly(c, e / modulus, R);
+		umodpoly du, dw;
+		rem(c * t, u1, du);
+		div(c - du * w1, u1, dw);
+		u = u + umodpoly_to_upoly(du) * modulus;
+		w = w + umodpoly_to_upoly(dw) * modulus;
+		modulus = modulus * p;
+	}
+}
+
+/** Lifts the factorization of the monic polynomial g into the modular factors
+ *  factors[lo], ..., factors[hi-1] to a factorization mod p^a. The factors
+ *  are split into two halves recursively.
+ */
+static void hensel_lift_all(const upoly& g, unsigned int p, unsigned int a, const cl_I& pa, const wpvec& factors, size_t lo, size_t hi, vector<upoly>& lifted)
+{
+	if ( hi - lo == 1 ) {
+		lifted[lo] = g;
+		return;
+	}
+	const size_t mid = (lo + hi) / 2;
+	const wfield F(p);
+	const cl_modint_ring R = find_modint_ring(p);
+	wpoly wu(1, F.one()), ww(1, F.one());
+	for ( size_t i=lo; i<mid; ++i ) {
+		modp_mul(F, wu, wu, factors[i]);
+	}
+	for ( size_t i=mid; i<hi; ++i ) {
+		modp_mul(F, ww, ww, factors[i]);
+	}
+	umodpoly u1, w1;
+	umodpoly_from_wpoly(u1, wu, F, R);
+	umodpoly_from_wpoly(w1, ww, F, R);
+	upoly u, w;
+	hensel_lift_pair(g, p, a, u1, w1, u, w);
+	for ( size_t i=0; i<u.size(); ++i ) {
+		u[i] = mod(u[i], pa);
+	}
+	for ( size_t i=0; i<w.size(); ++i ) {
+		w[i] = mod(w[i], pa);
+	}
+	hensel_lift_all(u, p, a, pa, factors, lo, mid, lifted);
+	hensel_lift_all(w, p, a, pa, factors, mid, hi, lifted);
+}
+
+/** Calculates the power sums S[1], ..., S[N] of the roots of the monic
+ *  polynomial a modulo m with Newton's identities.
+ */
+static void power_sums(const upoly& a, unsigned int N, const cl_I& m, vector<cl_I>& S)
+{
+	const unsigned int d = degree(a);
+	S.assign(N+1, 0);
+	for ( unsigned int j=1; j<=N; ++j ) {
+		cl_I s = 0;
+		for ( unsigned int i=1; i<j && i<=d; ++i ) {
+			s = s + a[d-i]*S[j-i];
+		}
+		if ( j <= d ) {
+			s = s + cl_I(j)*a[d-j];
+		}
+		S[j] = mod(-s, m);
+	}
+}
+
+/** Returns the smallest integer y with y^i >= x, for x >= 0.
+ */
+static cl_I ceil_root(const cl_I& x, unsigned int i)
+{
+	cl_I lo = 0, hi = 1;
+	while ( expt_pos(hi, i) < x ) {
+		hi = ash(hi, 1);
+	}
+	while ( lo < hi ) {
+		const cl_I m = ash(lo + hi, -1);
+		if ( expt_pos(m, i) >= x ) {
+			hi = m;
+		}
+		else {
+			lo = m + 1;
+		}
+	}
+	return lo;
+}
+
+/** Univariate polynomials with at least this number of modular factors are
+ *  factored with factor_vanhoeij() instead of trying all combinations of
+ *  the modular factors.
+ */
+static const size_t vanhoeij_min_factors = 8;
+
+/** Univariate factorization by van Hoeij's algorithm.
+ *
+ *  The modular factors are lifted to factors F_i mod p^a. For a true factor g
+ *  of f the vector of 0/1 coefficients v with g = lc(g)*prod F_i^v_i mod p^a
+ *  together with the power sums l^j*S_j of the roots of g, l = lcoeff(f),
+ *  forms a short vector of the lattice spanned by the rows of
+ *      ( I  l^j*S_j(F_i) )
+ *      ( 0  p^a          )
+ *  The power sum columns are scaled down to about the size of their bound.
+ *  After LLL reduction, all short vectors lie in the span of the basis vectors
+ *  whose Gram-Schmidt vectors are short. If this span has a basis of 0/1
+ *  vectors, these give the candidate factors, which are checked by division.
+ *  If not, more power sums are used. See [Hoe].
+ *
+ *  @param[in]  f        primitive square free polynomial
+ *  @param[in]  p        prime, not dividing the leading coefficient of f
+ *  @param[in]  factors  monic modular factors of f mod p
+ *  @param[in]  x        symbol
+ *  @param[out] result   factorization of f
+ *  @return              true if successful, false if the factors have to be
+ *                       recombined otherwise
+ */
+static bool factor_vanhoeij(const upoly& f, unsigned int p, const wpvec& factors, const ex& x, ex& result)
+{
+	const unsigned int n = degree(f);
+	const size_t r = factors.size();
+	const cl_I l = lcoeff(f);
+	const cl_I al = abs(l);
+
+	// Fujiwara's bound for the absolute values of the roots
+	cl_I rootbound = 0;
+	for ( unsigned int i=1; i<=n; ++i ) {
+		const cl_I b = ceil_root(ceiling1(abs(f[n-i]), al), i);
+		if ( b > rootbound ) rootbound = b;
+	}
+	rootbound = 2*rootbound;
+
+	// |l^j*S_j| of a factor is at most n*(|l|*rootbound)^j, cbits[j] is the
+	// length of this bound
+	const unsigned int Nmax = min<size_t>(n, max<size_t>(8, r/2));
+	vector<size_t> cbits(Nmax+1);
+	for ( unsigned int j=1; j<=Nmax; ++j ) {
+		cbits[j] = integer_length(cl_I(n) * expt_pos(al*rootbound, j));
+	}
+
+	// p^a must exceed twice the coefficients of l times a factor, and leave
+	// enough room for the lattice reduction
+	const cl_I cbound = 2*al*calc_bound(f, n);
+	size_t need = cbits[Nmax] + 2*(r+Nmax) + 30;
+	if ( integer_length(cbound) > need ) need = integer_length(cbound);
+	unsigned int a = 1;
+	cl_I pa = p;
+	while ( integer_length(pa) <= need ) {
+		pa = pa * p;
+		++a;
+	}
+	const cl_I halfpa = ash(pa, -1);
+
+	// lift the factorization of f/l mod p^a
+	const cl_modint_ring Rpa = find_modint_ring(pa);
+	const cl_I linv = Rpa->retract(recip(Rpa->canonhom(l)));
+	upoly g(f.size());
+	for ( size_t i=0; i<f.size(); ++i ) {
+		g[i] = mod(f[i]*linv, pa);
+	}
+	vector<upoly> lifted(r);
+	hensel_lift_all(g, p, a, pa, factors, 0, r, lifted);
+
+	// l^j times the power sums of the roots of the lifted factors
+	vector< vector<cl_I> > traces(r);
+	for ( size_t i=0; i<r; ++i ) {
+		power_sums(lifted[i], Nmax, pa, traces[i]);
+		cl_I lj = 1;
+		for ( unsigned int j=1; j<=Nmax; ++j ) {
+			lj = lj * l;
+			cl_I t = mod(lj * traces[i][j], pa);
+			if ( t > halfpa ) t = t - pa;
+			traces[i][j] = t;
+		}
+	}
+
+	for ( unsigned int N=1; N<=Nmax; N*=2 ) {
+		// lattice basis, the power sum column j is divided by 2^cbits[j]
+		const size_t dim = r + N;
+		vector< vector<cl_I> > B(dim, vector<cl_I>(dim, 0));
+		for ( size_t i=0; i<r; ++i ) {
+			B[i][i] = 1;
+			for ( unsigned int j=1; j<=N; ++j ) {
+				B[i][r+j-1] = floor1(2*traces[i][j] + ash(1, cbits[j]), ash(1, cbits[j]+1));
+			}
+		}
+		for ( unsigned int j=1; j<=N; ++j ) {
+			B[r+j-1][r+j-1] = floor1(2*pa + ash(1, cbits[j]), ash(1, cbits[j]+1));
+		}
+		vector<cl_I> d;
+		lll_reduce(B, d);
+
+		// The vectors of the true factors have squared length at most
+		// r + N*(r+1)^2, so they lie in the span of the first s vectors.
+		const cl_I bound = cl_I(r) + cl_I(N)*square(cl_I(r+1));
+		size_t s = dim;
+		while ( s > 0 && d[s] > bound*d[s-1] ) --s;
+		if ( s <= 1 ) {
+			// irreducible
+			result = upoly_to_ex(f, x);
+			return true;
+		}
+
+		vector< vector<size_t> > groups;
+		if ( !zero_one_basis(B, s, r, groups) ) continue;
+
+		ex rest = upoly_to_ex(f, x);
+		exvector candidates;
+		for ( size_t k=0; k<groups.size(); ++k ) {
+			upoly G(1, l);
+			for ( size_t i=0; i<groups[k].size(); ++i ) {
+				G = G * lifted[groups[k][i]];
+				for ( size_t c=0; c<G.size(); ++c ) {
+					G[c] = mod(G[c], pa);
+				}
+			}
+			cl_I cont = 0;
+			for ( size_t c=0; c<G.size(); ++c ) {
+				if ( G[c] > halfpa ) G[c] = G[c] - pa;
+				cont = gcd(cont, G[c]);
+			}
+			if ( minusp(lcoeff(G)) ) cont = -cont;
+			G = G / cont;
+			const ex cand = upoly_to_ex(G, x);
+			ex q;
+			if ( !divide(rest, cand, q) ) break;
+			rest = q;
+			candidates.push_back(cand);
+		}
+		if ( candidates.size() == groups.size() ) {
+			candidates.push_back(rest);
+			result = (new mul(candidates))->setflag(status_flags::dynallocated);
+			return true;
+		}
+	}
+	return false;
+}
+
+// END recombination of modular factors by lattice reduction
+////////////////////////////////////////////////////////////////////////////////
+
 /** Univariate polynomial factorization.
  *
  *  Modular factorization is tried for several primes to minimize the number of
- *  modular factors. Then, Hensel lifting is performed.
+ *  modular factors. Then, Hensel lifting is performed. Many modular factors
+ *  are recombined by factor_vanhoeij(), otherwise all combinations are tried.
  *
  *  @param[in]     poly   expanded square free univariate polynomial
  *  @param[in]     x      symbol
@@ -1506,7 +1866,6 @@ static ex factor_univariate(const ex& poly, const ex& x, unsigned int& prime)
 	// determine proper prime and minimize number of modular factors
 	prime = 3;
 	unsigned int lastp = prime;
-	cl_modint_ring R;
 	unsigned int trials = 0;
 	unsigned int minfactors = 0;
 
@@ -1520,38 +1879,55 @@ static ex factor_univariate(const ex& poly, const ex& x, unsigned int& prime)
 		i_cont = cl_I(1);
 	}
 	cl_I lc = lcoeff(prim)*i_cont;
-	upvec factors;
+	wpvec factors;
+	// The modular factorizations are done for batches of primes in
+	// parallel, and then examined in order until two primes in a row have
+	// not reduced the number of factors.  Without threads the batches have
+	// one prime, so the same primes are tried as one after the other.
+	const size_t batch = get_parallel_threads();
 	while ( trials < 2 ) {
-		umodpoly modpoly;
-		while ( true ) {
+		modular_trials mt;
+		while ( mt.primes.size() < batch ) {
 			prime = next_prime(prime);
 			if ( !zerop(rem(lc, prime)) ) {
-				R = find_modint_ring(prime);
-				umodpoly_from_upoly(modpoly, prim, R);
-				if ( squarefree(modpoly) ) break;
+				mt.primes.push_back(prime);
+				mt.images.push_back(wpoly());
+				wpoly_from_upoly(mt.images.back(), prim, wfield(prime));
 			}
 		}
+		mt.usable.resize(batch);
+		mt.factors.resize(batch);
+		parallel_for(batch, mt);
 
-		// do modular factorization
-		upvec trialfactors;
-		factor_modular(modpoly, trialfactors);
-		if ( trialfactors.size() <= 1 ) {
-			// irreducible for sure
-			return poly;
-		}
+		for ( size_t i=0; i<batch && trials<2; ++i ) {
+			if ( !mt.usable[i] ) continue;
+			const wpvec& trialfactors = mt.factors[i];
+			if ( trialfactors.size() <= 1 ) {
+				// irreducible for sure
+				return poly;
+			}
 
-		if ( minfactors == 0 || trialfactors.size() < minfactors ) {
-			factors = trialfactors;
-			minfactors = trialfactors.size();
-			lastp = prime;
-			trials = 1;
-		}
-		else {
-			++trials;
+			if ( minfactors == 0 || trialfactors.size() < minfactors ) {
+				factors = trialfactors;
+				minfactors = trialfactors.size();
+				lastp = mt.primes[i];
+				trials = 1;
+			}
+			else {
+				++trials;
+			}
 		}
 	}
 	prime = lastp;
-	R = find_modint_ring(prime);
+	const wfield F(prime);
+	const cl_modint_ring R = find_modint_ring(prime);
+
+	if ( factors.size() >= vanhoeij_min_factors ) {
+		ex res;
+		if ( factor_vanhoeij(prim, prime, factors, x, res) ) {
+			return unit * cont * res;
+		}
+	}
 
 	// lift all factor combinations
 	stack<ModFactors> tocheck;
@@ -1563,7 +1939,7 @@ static ex factor_univariate(const ex& poly, const ex& x, unsigned int& prime)
 	ex result = 1;
 	while ( tocheck.size() ) {
 		const size_t n = tocheck.top().factors.size();
-		factor_partition part(tocheck.top().factors);
+		factor_partition part(F, R, tocheck.top().factors);
 		while ( true ) {
 			// call Hensel lifting
 			hensel_univar(tocheck.top().poly, prime, part.left(), part.right(), f1, f2);
@@ -1602,8 +1978,8 @@ static ex factor_univariate(const ex& poly, const ex& x, unsigned int& prime)
 					break;
 				}
 				else {
-					upvec newfactors1(part.size_left()), newfactors2(part.size_right());
-					upvec::iterator i1 = newfactors1.begin(), i2 = newfactors2.begin();
+					wpvec newfactors1(part.size_left()), newfactors2(part.size_right());
+					wpvec::iterator i1 = newfactors1.begin(), i2 = newfactors2.begin();
 					for ( size_t i=0; i<n; ++i ) {
 						if ( part[i] ) {
 							*i2++ = tocheck.top().factors[i];
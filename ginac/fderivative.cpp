@@ -55,7 +55,7 @@ fderivative::fderivative(unsigned ser, const paramset & params, const exvector &
 {
 }
 
-fderivative::fderivative(unsigned ser, const paramset & params, std::auto_ptr<exvector> vp) : function(ser, vp), parameter_set(params)
+fderivative::fderivative(unsigned ser, const paramset & params, exvector && v) : function(ser, std::move(v)), parameter_set(params)
 {
 }
 
@@ -143,7 +143,7 @@ ex fderivative::eval(int level) const
 {
 	if (level > 1) {
 		// first evaluate children, then we will end up here again
-		return fderivative(serial, parameter_set, evalchildren(level));
+		return (new fderivative(serial, parameter_set, evalchildren(level)))->setflag(status_flags::dynallocated);
 	}
 
 	// No parameters specified? Then return the function itself
@@ -173,12 +173,12 @@ ex fderivative::series(const relational & r, int order, unsigned options) const
 
 ex fderivative::thiscontainer(const exvector & v) const
 {
-	return fderivative(serial, parameter_set, v);
+	return (new fderivative(serial, parameter_set, v))->setflag(status_flags::dynallocated);
 }
 
-ex fderivative::thiscontainer(std::auto_ptr<exvector> vp) const
+ex fderivative::thiscontainer(exvector && v) const
 {
-	return fderivative(serial, parameter_set, vp);
+	return (new fderivative(serial, parameter_set, std::move(v)))->setflag(status_flags::dynallocated);
 }
 
 /** Implementation of ex::diff() for derivatives. It applies the chain rule.
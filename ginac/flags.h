@@ -32,7 +32,8 @@ public:
 		expand_indexed = 0x0001,      ///< expands (a+b).i to a.i+b.i
 		expand_function_args = 0x0002, ///< expands the arguments of functions
 		expand_rename_idx = 0x0004, ///< used internally by mul::expand()
-		expand_transcendental = 0x0008 ///< expands trancendental functions like log and exp
+		expand_transcendental = 0x0008, ///< expands trancendental functions like log and exp
+		expand_parallel = 0x0010 ///< multiplies large sums using several threads (see parallel.h)
 	};
 };
 
@@ -133,7 +134,16 @@ public:
 		 *  division.  The determinant can then be read of from the lower
 		 *  right entry.  This algorithm is rarely fast for computing
 		 *  determinants. */
-		bareiss
+		bareiss,
+		/** Evaluation and interpolation.  If all the entries are
+		 *  polynomials with rational coefficients, the determinant is
+		 *  computed modulo several primes at the integer points of a grid
+		 *  large enough for its degree bounds, interpolated by Newton's
+		 *  method and reconstructed by Chinese remaindering.  This avoids
+		 *  any intermediate expression swell and is by far the fastest
+		 *  algorithm for matrices of polynomials in few variables.  Other
+		 *  matrices are treated as with automatic. */
+		interpolation
 	};
 };
 
@@ -200,7 +210,8 @@ public:
 		has_no_indices	= 0x0040, // ! (has_indices || has_no_indices) means "don't know"
 		is_positive	= 0x0080,
 		is_negative	= 0x0100,
-		purely_indefinite = 0x0200  // If set in a mul, then it does not contains any terms with determined signs, used in power::expand()
+		purely_indefinite = 0x0200, // If set in a mul, then it does not contains any terms with determined signs, used in power::expand()
+		unique          = 0x0400  ///< registered in the hash-consing table (see unique_table.h)
 	};
 };
 
@@ -29,6 +29,7 @@
 
 #include "ex.h"
 #include "normal.h"
+#include "normal_cache.h"
 #include "archive.h"
 #include "print.h"
 
@@ -38,11 +39,13 @@
 #include "lst.h"
 #include "matrix.h"
 #include "numeric.h"
+#include "precision_cache.h"
 #include "power.h"
 #include "relational.h"
 #include "structure.h"
 #include "symbol.h"
 #include "pseries.h"
+#include "lazy_series.h"
 #include "wildcard.h"
 #include "symmetry.h"
 
@@ -69,6 +72,10 @@
 #include "factor.h"
 
 #include "excompiler.h"
+#include "parallel.h"
+#include "pool_alloc.h"
+#include "unique_table.h"
+#include "stats.h"
 
 #ifndef IN_GINAC
 #include "parser.h"
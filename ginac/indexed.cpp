@@ -121,7 +121,7 @@ indexed::indexed(const symmetry & symm, const exvector & v, bool discardable) :
 {
 }
 
-indexed::indexed(const symmetry & symm, std::auto_ptr<exvector> vp) : inherited(vp), symtree(symm)
+indexed::indexed(const symmetry & symm, exvector && v) : inherited(std::move(v)), symtree(symm)
 {
 }
 
@@ -269,7 +269,7 @@ ex indexed::eval(int level) const
 {
 	// First evaluate children, then we will end up here again
 	if (level > 1)
-		return indexed(ex_to<symmetry>(symtree), evalchildren(level));
+		return (new indexed(ex_to<symmetry>(symtree), evalchildren(level)))->setflag(status_flags::dynallocated);
 
 	const ex &base = seq[0];
 
@@ -282,7 +282,7 @@ ex indexed::eval(int level) const
 		exvector v(seq);
 		ex f = ex_to<numeric>(base.op(base.nops() - 1));
 		v[0] = seq[0] / f;
-		return f * thiscontainer(v);
+		return f * thiscontainer(std::move(v));
 	}
 
 	if((typeid(*this) == typeid(indexed)) && seq.size()==1)
@@ -297,7 +297,7 @@ ex indexed::eval(int level) const
 			// Something has changed while sorting indices, more evaluations later
 			if (sig == 0)
 				return _ex0;
-			return ex(sig) * thiscontainer(v);
+			return ex(sig) * thiscontainer(std::move(v));
 		}
 	}
 
@@ -321,12 +321,12 @@ ex indexed::imag_part() const
 
 ex indexed::thiscontainer(const exvector & v) const
 {
-	return indexed(ex_to<symmetry>(symtree), v);
+	return (new indexed(ex_to<symmetry>(symtree), v))->setflag(status_flags::dynallocated);
 }
 
-ex indexed::thiscontainer(std::auto_ptr<exvector> vp) const
+ex indexed::thiscontainer(exvector && v) const
 {
-	return indexed(ex_to<symmetry>(symtree), vp);
+	return (new indexed(ex_to<symmetry>(symtree), std::move(v)))->setflag(status_flags::dynallocated);
 }
 
 unsigned indexed::return_type() const
@@ -348,14 +348,14 @@ ex indexed::expand(unsigned options) const
 			for (size_t i=0; i<newbase.nops(); i++) {
 				exvector s = seq;
 				s[0] = newbase.op(i);
-				sum += thiscontainer(s).expand(options);
+				sum += thiscontainer(std::move(s)).expand(options);
 			}
 			return sum;
 		}
 		if (!are_ex_trivially_equal(newbase, seq[0])) {
 			exvector s = seq;
 			s[0] = newbase;
-			return ex_to<indexed>(thiscontainer(s)).inherited::expand(options);
+			return ex_to<indexed>(thiscontainer(std::move(s))).inherited::expand(options);
 		}
 	}
 	return inherited::expand(options);
@@ -33,7 +33,11 @@
 #include "symbol.h"
 #include "symmetry.h"
 #include "utils.h"
+#include "add.h"
+#include "hash_map.h"
+#include "sparse_matrix.h"
 
+#include <map>
 #include <stdexcept>
 #include <vector>
 
@@ -988,6 +992,102 @@ REGISTER_FUNCTION(Order, eval_func(Order_eval).
 // Solve linear system
 //////////
 
+/** Systems with at least this many unknowns and at most this percentage of
+ *  non-zero coefficients are eliminated as a sparse_matrix by lsolve(). */
+static const unsigned sparse_lsolve_min_unknowns = 32;
+static const unsigned sparse_lsolve_max_density = 10;
+
+/** Check whether e contains one of the unknowns. */
+static bool has_unknown(const ex & e, const exhashmap<unsigned> & columns)
+{
+	if (is_a<symbol>(e))
+		return columns.find(e) != columns.end();
+	for (size_t i=0; i<e.nops(); ++i)
+		if (has_unknown(e.op(i), columns))
+			return true;
+	return false;
+}
+
+/** Add the term t of an expanded linear equation to the coefficient of its
+ *  unknown in coeffs or, negated, to the right hand side in column n. */
+static void linear_term(const ex & t, const exhashmap<unsigned> & columns, unsigned n, std::map<unsigned, ex> & coeffs)
+{
+	if (is_exactly_a<mul>(t)) {
+		for (size_t i=0; i<t.nops(); ++i) {
+			exhashmap<unsigned>::const_iterator c = columns.find(t.op(i));
+			if (c == columns.end())
+				continue;
+			exvector rest;
+			rest.reserve(t.nops()-1);
+			for (size_t j=0; j<t.nops(); ++j)
+				if (j != i)
+					rest.push_back(t.op(j));
+			const ex co = (new mul(rest))->setflag(status_flags::dynallocated);
+			if (has_unknown(co, columns))
+				throw(std::logic_error("lsolve: system is not linear"));
+			coeffs[c->second] += co;
+			return;
+		}
+	} else {
+		exhashmap<unsigned>::const_iterator c = columns.find(t);
+		if (c != columns.end()) {
+			coeffs[c->second] += _ex1;
+			return;
+		}
+	}
+	if (has_unknown(t, columns))
+		throw(std::logic_error("lsolve: system is not linear"));
+	coeffs[n] -= t;
+}
+
+/** Solve the linear system with the sparse_matrix code and store the list
+ *  of solutions in sol.  The coefficients are extracted term by term from
+ *  the expanded equations.  Returns false if the system is not sparse
+ *  enough or its coefficients are not rational functions. */
+static bool sparse_lsolve(const ex & eqns, const ex & symbols, ex & sol)
+{
+	const unsigned n = symbols.nops();
+	exhashmap<unsigned> columns;
+	for (unsigned c=0; c<n; ++c)
+		columns[symbols.op(c)] = c;
+	if (columns.size() != n)
+		return false;  // some symbol occurs twice
+
+	std::vector<sparse_matrix::row_type> rows(eqns.nops());
+	std::map<unsigned, ex> coeffs;
+	size_t nonzero = 0;
+	for (size_t r=0; r<eqns.nops(); ++r) {
+		const ex eq = (eqns.op(r).op(0)-eqns.op(r).op(1)).expand();
+		coeffs.clear();
+		if (is_exactly_a<add>(eq)) {
+			for (size_t i=0; i<eq.nops(); ++i)
+				linear_term(eq.op(i), columns, n, coeffs);
+		} else
+			linear_term(eq, columns, n, coeffs);
+		rows[r].assign(coeffs.begin(), coeffs.end());
+		nonzero += rows[r].size();
+	}
+	if (nonzero * 100 > size_t(sparse_lsolve_max_density) * rows.size() * (n+1))
+		return false;
+
+	sparse_matrix sys(n+1);
+	for (size_t r=0; r<rows.size(); ++r)
+		if (!sys.add_row(rows[r]))
+			return false;
+
+	const exvector vars(symbols.begin(), symbols.end());
+	exvector x;
+	if (!sys.solve(n, vars, x)) {
+		sol = lst();
+		return true;
+	}
+	lst sollist;
+	for (unsigned c=0; c<n; ++c)
+		sollist.append(symbols.op(c)==x[c]);
+	sol = sollist;
+	return true;
+}
+
 ex lsolve(const ex &eqns, const ex &symbols, unsigned options)
 {
 	// solve a system of linear equations
@@ -1020,6 +1120,13 @@ ex lsolve(const ex &eqns, const ex &symbols, unsigned options)
 		}
 	}
 	
+	// large sparse systems
+	if (options == solve_algo::automatic && symbols.nops() >= sparse_lsolve_min_unknowns) {
+		ex sol;
+		if (sparse_lsolve(eqns, symbols, sol))
+			return sol;
+	}
+	
 	// build matrix from equation system
 	matrix sys(eqns.nops(),symbols.nops());
 	matrix rhs(eqns.nops(),1);
@@ -210,6 +210,34 @@ inline bool is_order_function(const ex & e)
  */
 ex convert_H_to_Li(const ex& parameterlst, const ex& arg);
 
+/** Numerical evaluation of G(a[i],y[i]) for all i.  The result is the same
+ *  as that of evaluating the functions one by one with evalf(), but the
+ *  points are distributed over get_parallel_threads() threads, which reuse
+ *  the transformations and lookup tables computed for previous points.  A
+ *  precision set with digits_guard in the calling thread is used.
+ *
+ *  @exception invalid_argument (if the sizes of a and y differ) */
+exvector G_evalf_batch(const exvector& a, const exvector& y);
+
+/** Numerical evaluation of G(a[i],s,y[i]) for all i, see G_evalf_batch().
+ *
+ *  @exception invalid_argument (if the sizes of a and y differ) */
+exvector G_evalf_batch(const exvector& a, const ex& s, const exvector& y);
+
+/** Numerical evaluation of Li(m,x[i]) for all i, see G_evalf_batch(). */
+exvector Li_evalf_batch(const ex& m, const exvector& x);
+
+/** Numerical evaluation of H(m,x[i]) for all i, see G_evalf_batch(). */
+exvector H_evalf_batch(const ex& m, const exvector& x);
+
+/** Numerical evaluation of S(n,p,x[i]) for all i, see G_evalf_batch(). */
+exvector S_evalf_batch(const ex& n, const ex& p, const exvector& x);
+
+/** Forget the transformations of G and H functions into convergent
+ *  representations which the calling thread remembers for later numerical
+ *  evaluations.  This frees their memory and does not change any results. */
+void clear_polylog_transformations();
+
 } // namespace GiNaC
 
 #endif // ndef GINAC_INIFCNS_H
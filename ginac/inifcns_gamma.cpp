@@ -24,6 +24,7 @@
 #include "inifcns.h"
 #include "constant.h"
 #include "pseries.h"
+#include "dense_series.h"
 #include "numeric.h"
 #include "power.h"
 #include "relational.h"
@@ -204,16 +205,31 @@ static ex tgamma_series(const ex & arg,
                         unsigned options)
 {
 	// method:
-	// Taylor series where there is no pole falls back to psi function
-	// evaluation.
+	// Where there is no pole and the argument is linear, a+b*x, use
+	//   log(tgamma(a+t)) == log(tgamma(a)) + sum(psi(k-1,a)*t^k/k!, k>=1)
+	// and exponentiate the series, which avoids the repeated
+	// differentiation of Taylor expansion.  Other arguments fall back to
+	// Taylor series, i.e. to psi function evaluation.
 	// On a pole at -m use the recurrence relation
 	//   tgamma(x) == tgamma(x+1) / x
 	// from which follows
 	//   series(tgamma(x),x==-m,order) ==
 	//   series(tgamma(x+m+1)/(x*(x+1)*...*(x+m)),x==-m,order);
 	const ex arg_pt = arg.subs(rel, subs_options::no_pattern);
-	if (!arg_pt.info(info_flags::integer) || arg_pt.info(info_flags::positive))
-		throw do_taylor();  // caught by function::series()
+	if (!arg_pt.info(info_flags::integer) || arg_pt.info(info_flags::positive)) {
+		const ex slope = arg.diff(ex_to<symbol>(rel.lhs()));
+		if (order <= 0 || slope.is_zero() || slope.has(rel.lhs()))
+			throw do_taylor();  // caught by function::series()
+		exvector c(order);
+		numeric fact(1);
+		for (int k = 1; k < order; ++k) {
+			fact *= k;
+			c[k] = psi(k-1, arg_pt) * pow(slope, k) / fact;
+		}
+		const dense_series lgser(0, c, true);
+		const dense_series lead(0, exvector(1, tgamma(arg_pt)), false);
+		return lead.mul(lgser.exp(order)).to_pseries(rel);
+	}
 	// if we got here we have to care for a simple pole at -m:
 	const numeric m = -ex_to<numeric>(arg_pt);
 	ex ser_denom = _ex1;
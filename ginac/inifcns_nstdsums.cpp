@@ -67,12 +67,15 @@
 #include "inifcns.h"
 
 #include "add.h"
+#include "cln_constants.h"
 #include "constant.h"
 #include "lst.h"
 #include "mul.h"
 #include "numeric.h"
 #include "operators.h"
+#include "parallel.h"
 #include "power.h"
+#include "precision_cache.h"
 #include "pseries.h"
 #include "relational.h"
 #include "symbol.h"
@@ -80,6 +83,7 @@
 #include "wildcard.h"
 
 #include <cln/cln.h>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
@@ -102,11 +106,13 @@ namespace {
 
 // lookup table for factors built from Bernoulli numbers
 // see fill_Xn()
-std::vector<std::vector<cln::cl_N> > Xn;
+// Each thread has its own table, so that evaluations in several threads
+// need no locking.
+thread_local std::vector<std::vector<cln::cl_N> > Xn;
 // initial size of Xn that should suffice for 32bit machines (must be even)
 const int xninitsizestep = 26;
-int xninitsize = xninitsizestep;
-int xnsize = 0;
+thread_local int xninitsize = xninitsizestep;
+thread_local int xnsize = 0;
 
 
 // This function calculates the X_n. The X_n are needed for speed up of classical polylogarithms.
@@ -255,7 +261,7 @@ cln::cl_N Li2_do_sum_Xn(const cln::cl_N& x)
 {
 	std::vector<cln::cl_N>::const_iterator it = Xn[0].begin();
 	std::vector<cln::cl_N>::const_iterator xend = Xn[0].end();
-	cln::cl_N u = -cln::log(1-x);
+	cln::cl_N u = -cln_log(1-x);
 	cln::cl_N factor = u * cln::cl_float(1, cln::float_format(Digits));
 	cln::cl_N uu = cln::square(u);
 	cln::cl_N res = u - uu/4;
@@ -298,7 +304,7 @@ cln::cl_N Lin_do_sum_Xn(int n, const cln::cl_N& x)
 {
 	std::vector<cln::cl_N>::const_iterator it = Xn[n-2].begin();
 	std::vector<cln::cl_N>::const_iterator xend = Xn[n-2].end();
-	cln::cl_N u = -cln::log(1-x);
+	cln::cl_N u = -cln_log(1-x);
 	cln::cl_N factor = u * cln::cl_float(1, cln::float_format(Digits));
 	cln::cl_N res = u;
 	cln::cl_N resbuf;
@@ -347,12 +353,12 @@ cln::cl_N Li_projection(int n, const cln::cl_N& x, const cln::float_format_t& pr
 			// choose the faster algorithm
 			if (cln::abs(cln::realpart(x)) > 0.75) {
 				if ( x == 1 ) {
-					return cln::zeta(2);
+					return cln_zeta(2, cln::float_format(Digits));
 				} else {
-					return -Li2_do_sum(1-x) - cln::log(x) * cln::log(1-x) + cln::zeta(2);
+					return -Li2_do_sum(1-x) - cln_log(x) * cln_log(1-x) + cln_zeta(2, cln::float_format(Digits));
 				}
 			} else {
-				return -Li2_do_sum_Xn(1-x) - cln::log(x) * cln::log(1-x) + cln::zeta(2);
+				return -Li2_do_sum_Xn(1-x) - cln_log(x) * cln_log(1-x) + cln_zeta(2, cln::float_format(Digits));
 			}
 		}
 	} else {
@@ -373,10 +379,10 @@ cln::cl_N Li_projection(int n, const cln::cl_N& x, const cln::float_format_t& pr
 			}
 		} else {
 			cln::cl_N result = 0;
-			if ( x != 1 ) result = -cln::expt(cln::log(x), n-1) * cln::log(1-x) / cln::factorial(n-1);
+			if ( x != 1 ) result = -cln::expt(cln_log(x), n-1) * cln_log(1-x) / cln::factorial(n-1);
 			for (int j=0; j<n-1; j++) {
 				result = result + (S_num(n-j-1, 1, 1) - S_num(1, n-j-1, 1-x))
-				                  * cln::expt(cln::log(x), j) / cln::factorial(j);
+				                  * cln::expt(cln_log(x), j) / cln::factorial(j);
 			}
 			return result;
 		}
@@ -388,31 +394,31 @@ const cln::cl_N Lin_numeric(const int n, const cln::cl_N& x)
 {
 	if (n == 1) {
 		// just a log
-		return -cln::log(1-x);
+		return -cln_log(1-x);
 	}
 	if (zerop(x)) {
 		return 0;
 	}
 	if (x == 1) {
 		// [Kol] (2.22)
-		return cln::zeta(n);
+		return cln_zeta(n, cln::float_format(Digits));
 	}
 	else if (x == -1) {
 		// [Kol] (2.22)
-		return -(1-cln::expt(cln::cl_I(2),1-n)) * cln::zeta(n);
+		return -(1-cln::expt(cln::cl_I(2),1-n)) * cln_zeta(n, cln::float_format(Digits));
 	}
 	if (cln::abs(realpart(x)) < 0.4 && cln::abs(cln::abs(x)-1) < 0.01) {
-		cln::cl_N result = -cln::expt(cln::log(x), n-1) * cln::log(1-x) / cln::factorial(n-1);
+		cln::cl_N result = -cln::expt(cln_log(x), n-1) * cln_log(1-x) / cln::factorial(n-1);
 		for (int j=0; j<n-1; j++) {
 			result = result + (S_num(n-j-1, 1, 1) - S_num(1, n-j-1, 1-x))
-				* cln::expt(cln::log(x), j) / cln::factorial(j);
+				* cln::expt(cln_log(x), j) / cln::factorial(j);
 		}
 		return result;
 	}
 
 	// what is the desired float format?
-	// first guess: default format
-	cln::float_format_t prec = cln::default_float_format;
+	// first guess: the precision of the calling thread
+	cln::float_format_t prec = cln::float_format(Digits);
 	const cln::cl_N value = x;
 	// second guess: the argument's format
 	if (!instanceof(realpart(x), cln::cl_RA_ring))
@@ -422,7 +428,7 @@ const cln::cl_N Lin_numeric(const int n, const cln::cl_N& x)
 	
 	// [Kol] (5.15)
 	if (cln::abs(value) > 1) {
-		cln::cl_N result = -cln::expt(cln::log(-value),n) / cln::factorial(n);
+		cln::cl_N result = -cln::expt(cln_log(-value),n) / cln::factorial(n);
 		// check if argument is complex. if it is real, the new polylog has to be conjugated.
 		if (cln::zerop(cln::imagpart(value))) {
 			if (n & 1) {
@@ -443,7 +449,7 @@ const cln::cl_N Lin_numeric(const int n, const cln::cl_N& x)
 		cln::cl_N add;
 		for (int j=0; j<n-1; j++) {
 			add = add + (1+cln::expt(cln::cl_I(-1),n-j)) * (1-cln::expt(cln::cl_I(2),1-n+j))
-			            * Lin_numeric(n-j,1) * cln::expt(cln::log(-value),j) / cln::factorial(j);
+			            * Lin_numeric(n-j,1) * cln::expt(cln_log(-value),j) / cln::factorial(j);
 		}
 		result = result - add;
 		return result;
@@ -1062,6 +1068,21 @@ public:
 };
 
 
+// The result of G_transform() only depends on the order of the absolute values
+// of the arguments, on which of them are equal and on the flag, not on the
+// values themselves.  Each thread remembers the transformed expressions in
+// terms of the dummy symbols, so that evaluating G at many points with
+// arguments in the same order transforms only once (see G_evalf_batch()).
+struct G_trafo_plan {
+	exvector gsyms; // dummy symbols, gsyms[pos] stands for the argument at position pos
+	ex result;      // transformed and expanded expression in gsyms
+};
+typedef std::map<std::vector<int>, G_trafo_plan> G_trafo_plan_map;
+thread_local G_trafo_plan_map G_trafo_plans;
+// remembered plans per thread, the map is cleared when it is full
+const std::size_t max_G_trafo_plans = 256;
+
+
 // convergence transformation, used for numerical evaluation of G function.
 // the parameter x, s and y must only contain numerics
 static cln::cl_N
@@ -1081,29 +1102,25 @@ G_do_trafo(const std::vector<cln::cl_N>& x, const std::vector<int>& s,
 	// include upper limit (scale)
 	sortmap.insert(std::make_pair(y, x.size()));
 
-	// generate missing dummy-symbols
+	// number the dummy-symbols, equal arguments share one
 	int i = 1;
-	// holding dummy-symbols for the G/Li transformations
-	exvector gsyms;
-	gsyms.push_back(symbol("GSYMS_ERROR"));
+	std::vector<int> symbol_number;
 	cln::cl_N lastentry(0);
 	for (sortmap_t::const_iterator it = sortmap.begin(); it != sortmap.end(); ++it) {
 		if (it != sortmap.begin()) {
 			if (it->second < x.size()) {
 				if (x[it->second] == lastentry) {
-					gsyms.push_back(gsyms.back());
+					symbol_number.push_back(symbol_number.back());
 					continue;
 				}
 			} else {
 				if (y == lastentry) {
-					gsyms.push_back(gsyms.back());
+					symbol_number.push_back(symbol_number.back());
 					continue;
 				}
 			}
 		}
-		std::ostringstream os;
-		os << "a" << i;
-		gsyms.push_back(symbol(os.str()));
+		symbol_number.push_back(i);
 		++i;
 		if (it->second < x.size()) {
 			lastentry = x[it->second];
@@ -1112,9 +1129,8 @@ G_do_trafo(const std::vector<cln::cl_N>& x, const std::vector<int>& s,
 		}
 	}
 
-	// fill position data according to sorted indices and prepare substitution list
+	// fill position data according to sorted indices
 	Gparameter a(x.size());
-	exmap subslst;
 	std::size_t pos = 1;
 	int scale = pos;
 	for (sortmap_t::const_iterator it = sortmap.begin(); it != sortmap.end(); ++it) {
@@ -1124,20 +1140,56 @@ G_do_trafo(const std::vector<cln::cl_N>& x, const std::vector<int>& s,
 			} else {
 				a[it->second] = -int(pos);
 			}
-			subslst[gsyms[pos]] = numeric(x[it->second]);
 		} else {
 			scale = pos;
-			subslst[gsyms[pos]] = numeric(y);
 		}
 		++pos;
 	}
 
-	// do transformation
-	Gparameter pendint;
-	ex result = G_transform(pendint, a, scale, gsyms, flag_trailing_zeros_only);
+	// look up the transformation or do it
+	std::vector<int> key(a.begin(), a.end());
+	key.push_back(scale);
+	key.push_back(flag_trailing_zeros_only);
+	key.insert(key.end(), symbol_number.begin(), symbol_number.end());
+	G_trafo_plan_map::const_iterator found = G_trafo_plans.find(key);
+	G_trafo_plan plan;
+	if (found != G_trafo_plans.end()) {
+		plan = found->second;
+	} else {
+		// holding dummy-symbols for the G/Li transformations
+		plan.gsyms.push_back(symbol("GSYMS_ERROR"));
+		for (std::size_t j = 0; j < symbol_number.size(); ++j) {
+			if (j > 0 && symbol_number[j] == symbol_number[j-1]) {
+				plan.gsyms.push_back(plan.gsyms.back());
+			} else {
+				std::ostringstream os;
+				os << "a" << symbol_number[j];
+				plan.gsyms.push_back(symbol(os.str()));
+			}
+		}
+		Gparameter pendint;
+		plan.result = G_transform(pendint, a, scale, plan.gsyms, flag_trailing_zeros_only);
+		plan.result = plan.result.eval().expand();
+		if (G_trafo_plans.size() >= max_G_trafo_plans) {
+			G_trafo_plans.clear();
+		}
+		G_trafo_plans[key] = plan;
+	}
+
+	// prepare substitution list
+	exmap subslst;
+	pos = 1;
+	for (sortmap_t::const_iterator it = sortmap.begin(); it != sortmap.end(); ++it) {
+		if (it->second < x.size()) {
+			subslst[plan.gsyms[pos]] = numeric(x[it->second]);
+		} else {
+			subslst[plan.gsyms[pos]] = numeric(y);
+		}
+		++pos;
+	}
+
 	// replace dummy symbols with their values
-	result = result.eval().expand();
-	result = result.subs(subslst).evalf();
+	ex result = plan.result.subs(subslst).evalf();
 	if (!is_a<numeric>(result))
 		throw std::logic_error("G_do_trafo: G_transform returned non-numeric result");
 	
@@ -1779,9 +1831,86 @@ namespace {
 
 // lookup table for special Euler-Zagier-Sums (used for S_n,p(x))
 // see fill_Yn()
-std::vector<std::vector<cln::cl_N> > Yn;
-int ynsize = 0; // number of Yn[]
-int ynlength = 100; // initial length of all Yn[i]
+// Like Xn, the table is per thread, and so is the precision it was computed
+// with, since threads may evaluate at different precisions (see digits_guard).
+thread_local std::vector<std::vector<cln::cl_N> > Yn;
+thread_local int ynsize = 0; // number of Yn[]
+thread_local int ynlength = 100; // initial length of all Yn[i]
+thread_local cln::float_format_t ynprec = cln::float_format(Digits);
+
+
+// The most precise Yn table of this thread, kept when the precision changes
+// so that tables for lower precisions can be obtained by rounding its
+// entries (see precision_cache.h).
+struct remembered_Yn {
+	remembered_Yn() : prec(0), bytes(0) {}
+	~remembered_Yn() { precision_cache::release(precision_cache::polylog_tables, bytes); }
+	std::vector<std::vector<cln::cl_N> > table;
+	long prec;         // precision in bits, 0 if nothing is remembered
+	std::size_t bytes; // memory accounted for the table
+	void forget()
+	{
+		table.clear();
+		prec = 0;
+		precision_cache::release(precision_cache::polylog_tables, bytes);
+		bytes = 0;
+	}
+};
+thread_local remembered_Yn Yn_best;
+
+
+// Switches the lookup table Yn to the precision prec.  The current table is
+// remembered if it is at least as precise as the remembered one, and the new
+// table is derived from the remembered one if that is precise enough.
+void select_Yn(const cln::float_format_t& prec)
+{
+	using namespace precision_cache;
+	if (ynprec == prec) {
+		record(polylog_tables, ynsize > 0 ? hit : computation);
+		return;
+	}
+
+	if (ynsize > 0 && (long(ynprec) > Yn_best.prec
+	                   || (long(ynprec) == Yn_best.prec && ynlength > int(Yn_best.table[0].size())))) {
+		Yn_best.forget();
+		const std::size_t bytes = std::size_t(ynsize) * ynlength * float_bytes(long(ynprec));
+		if (reserve(polylog_tables, bytes)) {
+			Yn_best.table.swap(Yn);
+			Yn_best.prec = long(ynprec);
+			Yn_best.bytes = bytes;
+		} else
+			record(polylog_tables, eviction);
+	}
+
+	Yn.clear();
+	ynsize = 0;
+	ynlength = 100;
+	ynprec = prec;
+
+	if (Yn_best.prec && !within_budget()) {
+		record(polylog_tables, eviction);
+		Yn_best.forget();
+	}
+	if (Yn_best.prec == long(prec)) {
+		record(polylog_tables, hit);
+		Yn.swap(Yn_best.table);
+		Yn_best.forget();
+	} else if (Yn_best.prec > long(prec)) {
+		record(polylog_tables, truncation);
+		Yn.resize(Yn_best.table.size());
+		for (std::size_t n = 0; n < Yn.size(); ++n) {
+			const std::vector<cln::cl_N> &row = Yn_best.table[n];
+			Yn[n].reserve(row.size());
+			for (std::vector<cln::cl_N>::const_iterator it = row.begin(); it != row.end(); ++it)
+				Yn[n].push_back(cln::cl_float(cln::the<cln::cl_R>(*it), prec));
+		}
+	} else {
+		record(polylog_tables, computation);
+		return;
+	}
+	ynsize = Yn.size();
+	ynlength = Yn.empty() ? 100 : Yn[0].size();
+}
 
 
 // This function calculates the Y_n. The Y_n are needed for the evaluation of S_{n,p}(x).
@@ -1864,16 +1993,17 @@ void make_Yn_longer(int newsize, const cln::float_format_t& prec)
 cln::cl_N C(int n, int p)
 {
 	cln::cl_N result;
+	const cln::cl_N pi_val = ex_to<numeric>(PiEvalf()).to_cl_N();
 
 	for (int k=0; k<p; k++) {
 		for (int j=0; j<=(n+k-1)/2; j++) {
 			if (k == 0) {
 				if (n & 1) {
 					if (j & 1) {
-						result = result - 2 * cln::expt(cln::pi(),2*j) * S_num(n-2*j,p,1) / cln::factorial(2*j);
+						result = result - 2 * cln::expt(pi_val,2*j) * S_num(n-2*j,p,1) / cln::factorial(2*j);
 					}
 					else {
-						result = result + 2 * cln::expt(cln::pi(),2*j) * S_num(n-2*j,p,1) / cln::factorial(2*j);
+						result = result + 2 * cln::expt(pi_val,2*j) * S_num(n-2*j,p,1) / cln::factorial(2*j);
 					}
 				}
 			}
@@ -1881,23 +2011,23 @@ cln::cl_N C(int n, int p)
 				if (k & 1) {
 					if (j & 1) {
 						result = result + cln::factorial(n+k-1)
-						                  * cln::expt(cln::pi(),2*j) * S_num(n+k-2*j,p-k,1)
+						                  * cln::expt(pi_val,2*j) * S_num(n+k-2*j,p-k,1)
 						                  / (cln::factorial(k) * cln::factorial(n-1) * cln::factorial(2*j));
 					}
 					else {
 						result = result - cln::factorial(n+k-1)
-						                  * cln::expt(cln::pi(),2*j) * S_num(n+k-2*j,p-k,1)
+						                  * cln::expt(pi_val,2*j) * S_num(n+k-2*j,p-k,1)
 						                  / (cln::factorial(k) * cln::factorial(n-1) * cln::factorial(2*j));
 					}
 				}
 				else {
 					if (j & 1) {
-						result = result - cln::factorial(n+k-1) * cln::expt(cln::pi(),2*j) * S_num(n+k-2*j,p-k,1)
+						result = result - cln::factorial(n+k-1) * cln::expt(pi_val,2*j) * S_num(n+k-2*j,p-k,1)
 						                  / (cln::factorial(k) * cln::factorial(n-1) * cln::factorial(2*j));
 					}
 					else {
 						result = result + cln::factorial(n+k-1)
-						                  * cln::expt(cln::pi(),2*j) * S_num(n+k-2*j,p-k,1)
+						                  * cln::expt(pi_val,2*j) * S_num(n+k-2*j,p-k,1)
 						                  / (cln::factorial(k) * cln::factorial(n-1) * cln::factorial(2*j));
 					}
 				}
@@ -1907,10 +2037,10 @@ cln::cl_N C(int n, int p)
 	int np = n+p;
 	if ((np-1) & 1) {
 		if (((np)/2+n) & 1) {
-			result = -result - cln::expt(cln::pi(),np) / (np * cln::factorial(n-1) * cln::factorial(p));
+			result = -result - cln::expt(pi_val,np) / (np * cln::factorial(n-1) * cln::factorial(p));
 		}
 		else {
-			result = -result + cln::expt(cln::pi(),np) / (np * cln::factorial(n-1) * cln::factorial(p));
+			result = -result + cln::expt(pi_val,np) / (np * cln::factorial(n-1) * cln::factorial(p));
 		}
 	}
 
@@ -1930,7 +2060,7 @@ cln::cl_N a_k(int k)
 
 	result = result;
 	for (int m=2; m<=k; m++) {
-		result = result + cln::expt(cln::cl_N(-1),m) * cln::zeta(m) * a_k(k-m);
+		result = result + cln::expt(cln::cl_N(-1),m) * cln_zeta(m, cln::float_format(Digits)) * a_k(k-m);
 	}
 
 	return -result / k;
@@ -1949,7 +2079,7 @@ cln::cl_N b_k(int k)
 
 	result = result;
 	for (int m=2; m<=k; m++) {
-		result = result + cln::expt(cln::cl_N(-1),m) * cln::zeta(m) * b_k(k-m);
+		result = result + cln::expt(cln::cl_N(-1),m) * cln_zeta(m, cln::float_format(Digits)) * b_k(k-m);
 	}
 
 	return result / k;
@@ -1959,19 +2089,12 @@ cln::cl_N b_k(int k)
 // helper function for S(n,p,x)
 cln::cl_N S_do_sum(int n, int p, const cln::cl_N& x, const cln::float_format_t& prec)
 {
-	static cln::float_format_t oldprec = cln::default_float_format;
-
 	if (p==1) {
 		return Li_projection(n+1, x, prec);
 	}
 
-	// precision has changed, we need to clear lookup table Yn
-	if ( oldprec != prec ) {
-		Yn.clear();
-		ynsize = 0;
-		ynlength = 100;
-		oldprec = prec;
-	}
+	// the lookup table Yn must have the precision prec
+	select_Yn(prec);
 		
 	// check if precalculated values are sufficient
 	if (p > ynsize+1) {
@@ -2011,16 +2134,16 @@ cln::cl_N S_projection(int n, int p, const cln::cl_N& x, const cln::float_format
 	// [Kol] (5.3)
 	if (cln::abs(cln::realpart(x)) > cln::cl_F("0.5")) {
 
-		cln::cl_N result = cln::expt(cln::cl_I(-1),p) * cln::expt(cln::log(x),n)
-		                   * cln::expt(cln::log(1-x),p) / cln::factorial(n) / cln::factorial(p);
+		cln::cl_N result = cln::expt(cln::cl_I(-1),p) * cln::expt(cln_log(x),n)
+		                   * cln::expt(cln_log(1-x),p) / cln::factorial(n) / cln::factorial(p);
 
 		for (int s=0; s<n; s++) {
 			cln::cl_N res2;
 			for (int r=0; r<p; r++) {
-				res2 = res2 + cln::expt(cln::cl_I(-1),r) * cln::expt(cln::log(1-x),r)
+				res2 = res2 + cln::expt(cln::cl_I(-1),r) * cln::expt(cln_log(1-x),r)
 				              * S_do_sum(p-r,n-s,1-x,prec) / cln::factorial(r);
 			}
-			result = result + cln::expt(cln::log(x),s) * (S_num(n-s,p,1) - res2) / cln::factorial(s);
+			result = result + cln::expt(cln_log(x),s) * (S_num(n-s,p,1) - res2) / cln::factorial(s);
 		}
 
 		return result;
@@ -2036,12 +2159,12 @@ const cln::cl_N S_num(int n, int p, const cln::cl_N& x)
 	if (x == 1) {
 		if (n == 1) {
 		    // [Kol] (2.22) with (2.21)
-			return cln::zeta(p+1);
+			return cln_zeta(p+1, cln::float_format(Digits));
 		}
 
 		if (p == 1) {
 		    // [Kol] (2.22)
-			return cln::zeta(n+1);
+			return cln_zeta(n+1, cln::float_format(Digits));
 		}
 
 		// [Kol] (9.1)
@@ -2059,14 +2182,14 @@ const cln::cl_N S_num(int n, int p, const cln::cl_N& x)
 	else if (x == -1) {
 		// [Kol] (2.22)
 		if (p == 1) {
-			return -(1-cln::expt(cln::cl_I(2),-n)) * cln::zeta(n+1);
+			return -(1-cln::expt(cln::cl_I(2),-n)) * cln_zeta(n+1, cln::float_format(Digits));
 		}
 //		throw std::runtime_error("don't know how to evaluate this function!");
 	}
 
 	// what is the desired float format?
-	// first guess: default format
-	cln::float_format_t prec = cln::default_float_format;
+	// first guess: the precision of the calling thread
+	cln::float_format_t prec = cln::float_format(Digits);
 	const cln::cl_N value = x;
 	// second guess: the argument's format
 	if (!instanceof(realpart(value), cln::cl_RA_ring))
@@ -2079,16 +2202,16 @@ const cln::cl_N S_num(int n, int p, const cln::cl_N& x)
 	// we don't care here about abs(value)<1 && real(value)>0.5, this will be taken care of in S_projection
 	if ((cln::realpart(value) < -0.5) || (n == 0) || ((cln::abs(value) <= 1) && (cln::abs(value) > 0.95) && (cln::abs(1-value) > 1) )) {
 
-		cln::cl_N result = cln::expt(cln::cl_I(-1),p) * cln::expt(cln::log(value),n)
-		                   * cln::expt(cln::log(1-value),p) / cln::factorial(n) / cln::factorial(p);
+		cln::cl_N result = cln::expt(cln::cl_I(-1),p) * cln::expt(cln_log(value),n)
+		                   * cln::expt(cln_log(1-value),p) / cln::factorial(n) / cln::factorial(p);
 
 		for (int s=0; s<n; s++) {
 			cln::cl_N res2;
 			for (int r=0; r<p; r++) {
-				res2 = res2 + cln::expt(cln::cl_I(-1),r) * cln::expt(cln::log(1-value),r)
+				res2 = res2 + cln::expt(cln::cl_I(-1),r) * cln::expt(cln_log(1-value),r)
 				              * S_num(p-r,n-s,1-value) / cln::factorial(r);
 			}
-			result = result + cln::expt(cln::log(value),s) * (S_num(n-s,p,1) - res2) / cln::factorial(s);
+			result = result + cln::expt(cln_log(value),s) * (S_num(n-s,p,1) - res2) / cln::factorial(s);
 		}
 
 		return result;
@@ -2101,7 +2224,7 @@ const cln::cl_N S_num(int n, int p, const cln::cl_N& x)
 
 		for (int s=0; s<p; s++) {
 			for (int r=0; r<=s; r++) {
-				result = result + cln::expt(cln::cl_I(-1),s) * cln::expt(cln::log(-value),r) * cln::factorial(n+s-r-1)
+				result = result + cln::expt(cln::cl_I(-1),s) * cln::expt(cln_log(-value),r) * cln::factorial(n+s-r-1)
 				                  / cln::factorial(r) / cln::factorial(s-r) / cln::factorial(n-1)
 				                  * S_num(n+s-r,p-s,cln::recip(value));
 			}
@@ -2110,9 +2233,9 @@ const cln::cl_N S_num(int n, int p, const cln::cl_N& x)
 
 		cln::cl_N res2;
 		for (int r=0; r<n; r++) {
-			res2 = res2 + cln::expt(cln::log(-value),r) * C(n-r,p) / cln::factorial(r);
+			res2 = res2 + cln::expt(cln_log(-value),r) * C(n-r,p) / cln::factorial(r);
 		}
-		res2 = res2 + cln::expt(cln::log(-value),n+p) / cln::factorial(n+p);
+		res2 = res2 + cln::expt(cln_log(-value),n+p) / cln::factorial(n+p);
 
 		result = result + cln::expt(cln::cl_I(-1),p) * res2;
 
@@ -3181,6 +3304,81 @@ cln::cl_N H_do_sum(const std::vector<int>& m, const cln::cl_N& x)
 //////////////////////////////////////////////////////////////////////
 
 
+// anonymous namespace for helper functions
+namespace {
+
+
+// Regions of the argument of H outside the unit circle and the transformations
+// used there, see H_evalf().
+enum H_trafo_kind {
+	H_trafo_1overx_lower,  // x -> 1/x, imag(x) <= 0
+	H_trafo_1overx_upper,  // x -> 1/x, imag(x) > 0
+	H_trafo_1mxt1px,       // x -> (1-x)/(1+x)
+	H_trafo_1mx            // x -> 1-x
+};
+
+// H(m,x) transformed for a region of x, as an expression in the symbol xtemp.
+// Like the transformations of G, these are remembered per thread.
+struct H_trafo_plan {
+	ex xtemp;
+	ex result;
+};
+typedef std::map<std::vector<int>, H_trafo_plan> H_trafo_plan_map;
+thread_local H_trafo_plan_map H_trafo_plans;
+const std::size_t max_H_trafo_plans = 256;
+
+// Returns the transformation of H(m,x) of the given kind.  The parameters m
+// must be in expanded notation (only 0, 1 and -1).
+H_trafo_plan H_trafo(const lst& m, H_trafo_kind kind)
+{
+	std::vector<int> key;
+	key.reserve(m.nops() + 1);
+	for (lst::const_iterator it = m.begin(); it != m.end(); ++it) {
+		key.push_back(ex_to<numeric>(*it).to_int());
+	}
+	key.push_back(kind);
+	H_trafo_plan_map::const_iterator found = H_trafo_plans.find(key);
+	if (found != H_trafo_plans.end()) {
+		return found->second;
+	}
+
+	H_trafo_plan plan;
+	symbol xtemp("xtemp");
+	plan.xtemp = xtemp;
+	switch (kind) {
+		case H_trafo_1overx_lower:
+		case H_trafo_1overx_upper: {
+			map_trafo_H_1overx trafo;
+			plan.result = trafo(H(m, xtemp).hold());
+			if (kind == H_trafo_1overx_lower) {
+				plan.result = plan.result.subs(H_polesign == -I*Pi);
+			} else {
+				plan.result = plan.result.subs(H_polesign == I*Pi);
+			}
+			break;
+		}
+		case H_trafo_1mxt1px: {
+			map_trafo_H_1mxt1px trafo;
+			plan.result = trafo(H(m, xtemp).hold());
+			break;
+		}
+		case H_trafo_1mx: {
+			map_trafo_H_1mx trafo;
+			plan.result = trafo(H(m, xtemp).hold());
+			break;
+		}
+	}
+	if (H_trafo_plans.size() >= max_H_trafo_plans) {
+		H_trafo_plans.clear();
+	}
+	H_trafo_plans[key] = plan;
+	return plan;
+}
+
+
+} // end of anonymous namespace
+
+
 static ex H_evalf(const ex& x1, const ex& x2)
 {
 	if (is_a<lst>(x1)) {
@@ -3261,7 +3459,6 @@ static ex H_evalf(const ex& x1, const ex& x2)
 			}
 		}
 
-		symbol xtemp("xtemp");
 		ex res = 1;	
 		
 		// ensure that the realpart of the argument is positive
@@ -3275,36 +3472,30 @@ static ex H_evalf(const ex& x1, const ex& x2)
 			}
 		}
 
-		// x -> 1/x
+		H_trafo_kind kind;
 		if (cln::abs(x) >= 2.0) {
-			map_trafo_H_1overx trafo;
-			res *= trafo(H(m, xtemp).hold());
-			if (cln::imagpart(x) <= 0) {
-				res = res.subs(H_polesign == -I*Pi);
-			} else {
-				res = res.subs(H_polesign == I*Pi);
-			}
-			return res.subs(xtemp == numeric(x)).evalf();
-		}
-		
-		// check transformations for 0.95 <= |x| < 2.0
-		
-		// |(1-x)/(1+x)| < 0.9 -> circular area with center=9.53+0i and radius=9.47
-		if (cln::abs(x-9.53) <= 9.47) {
-			// x -> (1-x)/(1+x)
-			map_trafo_H_1mxt1px trafo;
-			res *= trafo(H(m, xtemp).hold());
+			// x -> 1/x
+			kind = cln::imagpart(x) <= 0 ? H_trafo_1overx_lower : H_trafo_1overx_upper;
 		} else {
-			// x -> 1-x
-			if (has_minus_one) {
-				map_trafo_H_convert_to_Li filter;
-				return filter(H(m, numeric(x)).hold()).evalf();
+			// check transformations for 0.95 <= |x| < 2.0
+
+			// |(1-x)/(1+x)| < 0.9 -> circular area with center=9.53+0i and radius=9.47
+			if (cln::abs(x-9.53) <= 9.47) {
+				// x -> (1-x)/(1+x)
+				kind = H_trafo_1mxt1px;
+			} else {
+				// x -> 1-x
+				if (has_minus_one) {
+					map_trafo_H_convert_to_Li filter;
+					return filter(H(m, numeric(x)).hold()).evalf();
+				}
+				kind = H_trafo_1mx;
 			}
-			map_trafo_H_1mx trafo;
-			res *= trafo(H(m, xtemp).hold());
 		}
 
-		return res.subs(xtemp == numeric(x)).evalf();
+		const H_trafo_plan plan = H_trafo(m, kind);
+		res *= plan.result;
+		return res.subs(plan.xtemp == numeric(x)).evalf();
 	}
 
 	return H(x1,x2).hold();
@@ -3597,7 +3788,7 @@ static void calc_f(std::vector<std::vector<cln::cl_N> >& f_kj,
 	std::vector<std::vector<cln::cl_N> >::iterator it = f_kj.begin();
 	cln::cl_F one = cln::cl_float(1, cln::float_format(Digits));
 	
-	t0 = cln::exp(-lambda);
+	t0 = cln_exp(-lambda);
 	t2 = 1;
 	for (k=1; k<=L1; k++) {
 		t1 = k * lambda;
@@ -4127,5 +4318,152 @@ unsigned zeta2_SERIAL::serial = function::register_new(function_options("zeta",
                                 overloaded(2));
 
 
+//////////////////////////////////////////////////////////////////////
+//
+// Numerical evaluation at many points
+//
+//////////////////////////////////////////////////////////////////////
+
+
+// anonymous namespace for helper functions
+namespace {
+
+
+// Replaces all numbers in an expression by copies that share no storage
+// with the originals, since CLN's reference counts are not atomic.
+struct unshare_numbers : public map_function {
+	ex operator()(const ex& e)
+	{
+		if (is_a<numeric>(e)) {
+			const cln::cl_N z = ex_to<numeric>(e).to_cl_N();
+			return numeric(-cln::cl_N(-z));
+		}
+		return e.map(*this);
+	}
+};
+
+
+enum batch_function { batch_G2, batch_G3, batch_Li, batch_H, batch_S };
+
+
+// Evaluates a function at many points.  The parameters common to all points
+// are copied for every thread slot and the arguments of every point are
+// copied once, so that no numbers are shared between threads.  The
+// transformations and lookup tables computed for one point are remembered
+// by the thread and used for the following points.
+class batch_evalf_task : public parallel_task {
+public:
+	batch_evalf_task(batch_function f, const exvector& common, const exvector& args1,
+	                 const exvector& args2, unsigned nthreads)
+	  : fn(f), results(args1.size())
+	{
+		unshare_numbers unshare;
+		params.resize(nthreads);
+		for (unsigned t = 0; t < nthreads; ++t) {
+			for (std::size_t k = 0; k < common.size(); ++k) {
+				params[t].push_back(unshare(common[k]));
+			}
+		}
+		first.reserve(args1.size());
+		for (std::size_t i = 0; i < args1.size(); ++i) {
+			first.push_back(unshare(args1[i]));
+		}
+		second.reserve(args2.size());
+		for (std::size_t i = 0; i < args2.size(); ++i) {
+			second.push_back(unshare(args2[i]));
+		}
+	}
+
+	void run(size_t i, unsigned slot)
+	{
+		const exvector& p = params[slot];
+		ex f;
+		switch (fn) {
+			case batch_G2:
+				f = G(first[i], second[i]);
+				break;
+			case batch_G3:
+				f = G(first[i], p[0], second[i]);
+				break;
+			case batch_Li:
+				f = Li(p[0], first[i]);
+				break;
+			case batch_H:
+				f = H(p[0], first[i]);
+				break;
+			case batch_S:
+				f = S(p[0], p[1], first[i]);
+				break;
+		}
+		results[i] = f.evalf();
+	}
+
+	batch_function fn;
+	std::vector<exvector> params; // common parameters, one copy per thread slot
+	exvector first;               // first varying argument of each point
+	exvector second;              // second varying argument of each point (G only)
+	exvector results;
+};
+
+
+exvector evalf_batch(batch_function fn, const exvector& common, const exvector& args1,
+                     const exvector& args2 = exvector())
+{
+	const unsigned nthreads = get_parallel_threads();
+	batch_evalf_task task(fn, common, args1, args2, nthreads);
+	parallel_for(args1.size(), task, nthreads);
+	return task.results;
+}
+
+
+} // end of anonymous namespace
+
+
+exvector G_evalf_batch(const exvector& a, const exvector& y)
+{
+	if (a.size() != y.size()) {
+		throw std::invalid_argument("G_evalf_batch(): numbers of parameters and arguments differ");
+	}
+	return evalf_batch(batch_G2, exvector(), a, y);
+}
+
+
+exvector G_evalf_batch(const exvector& a, const ex& s, const exvector& y)
+{
+	if (a.size() != y.size()) {
+		throw std::invalid_argument("G_evalf_batch(): numbers of parameters and arguments differ");
+	}
+	return evalf_batch(batch_G3, exvector(1, s), a, y);
+}
+
+
+exvector Li_evalf_batch(const ex& m, const exvector& x)
+{
+	return evalf_batch(batch_Li, exvector(1, m), x);
+}
+
+
+exvector H_evalf_batch(const ex& m, const exvector& x)
+{
+	return evalf_batch(batch_H, exvector(1, m), x);
+}
+
+
+exvector S_evalf_batch(const ex& n, const ex& p, const exvector& x)
+{
+	exvector np;
+	np.push_back(n);
+	np.push_back(p);
+	return evalf_batch(batch_S, np, x);
+}
+
+
+void clear_polylog_transformations()
+{
+	G_trafo_plans.clear();
+	H_trafo_plans.clear();
+}
+
+
 } // namespace GiNaC
 
@@ -32,8 +32,11 @@
 #include "relational.h"
 #include "symbol.h"
 #include "pseries.h"
+#include "dense_series.h"
+#include "lazy_series.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 
@@ -112,6 +115,25 @@ static ex exp_deriv(const ex & x, unsigned deriv_param)
 	return exp(x);
 }
 
+static ex exp_series(const ex & arg,
+                     const relational & rel,
+                     int order,
+                     unsigned options)
+{
+	// method:
+	// Series expand the argument and compose it with the exponential
+	// series coefficient by coefficient, which is much cheaper than Taylor
+	// expansion by repeated differentiation of nested functions.
+	GINAC_ASSERT(is_a<symbol>(rel.lhs()));
+	if (arg.diff(ex_to<symbol>(rel.lhs())).is_zero() || order <= 0)
+		throw do_taylor();
+
+	const dense_series argser(ex_to<pseries>(arg.series(rel, order, options)));
+	if (argser.ldegree() < 0)
+		throw do_taylor();  // essential singularity, let Taylor expansion fail
+	return argser.exp(order).to_pseries(rel);
+}
+
 static ex exp_real_part(const ex & x)
 {
 	return exp(GiNaC::real_part(x))*cos(GiNaC::imag_part(x));
@@ -132,6 +154,7 @@ REGISTER_FUNCTION(exp, eval_func(exp_eval).
                        evalf_func(exp_evalf).
                        expand_func(exp_expand).
                        derivative_func(exp_deriv).
+                       series_func(exp_series).
                        real_part_func(exp_real_part).
                        imag_part_func(exp_imag_part).
                        conjugate_func(exp_conjugate).
@@ -217,13 +240,10 @@ static ex log_series(const ex &arg,
 		// Return a plain n*log(x) for the x^n part and series expand the
 		// other part.  Add them together and reexpand again in order to have
 		// one unnested pseries object.  All this also works for negative n.
-		pseries argser;          // series expansion of log's argument
-		unsigned extra_ord = 0;  // extra expansion order
-		do {
-			// oops, the argument expanded to a pure Order(x^something)...
-			argser = ex_to<pseries>(arg.series(rel, order+extra_ord, options));
-			++extra_ord;
-		} while (!argser.is_terminating() && argser.nops()==1);
+		// series expansion of log's argument, with at least one term
+		// besides the Order term
+		const lazy_series arglazy(arg, rel, options);
+		const pseries argser = ex_to<pseries>(arglazy.series(std::max(order, arglazy.ldegree() + 1)));
 
 		const symbol &s = ex_to<symbol>(rel.lhs());
 		const ex &point = rel.rhs();
@@ -241,22 +261,8 @@ static ex log_series(const ex &arg,
 		if (!argser.is_terminating() || argser.nops()!=1) {
 			// in this case n more (or less) terms are needed
 			// (sadly, to generate them, we have to start from the beginning)
-			if (n == 0 && coeff == 1) {
-				epvector epv;
-				ex acc = (new pseries(rel, epv))->setflag(status_flags::dynallocated);
-				epv.reserve(2);
-				epv.push_back(expair(-1, _ex0));
-				epv.push_back(expair(Order(_ex1), order));
-				ex rest = pseries(rel, epv).add_series(argser);
-				for (int i = order-1; i>0; --i) {
-					epvector cterm;
-					cterm.reserve(1);
-					cterm.push_back(expair(i%2 ? _ex1/i : _ex_1/i, _ex0));
-					acc = pseries(rel, cterm).add_series(ex_to<pseries>(acc));
-					acc = (ex_to<pseries>(rest)).mul_series(ex_to<pseries>(acc));
-				}
-				return acc;
-			}
+			if (n == 0 && coeff == 1)
+				return dense_series(argser).log(order).to_pseries(rel);
 			const ex newarg = ex_to<pseries>((arg/coeff).series(rel, order+n, options)).shift_exponents(-n).convert_to_poly(true);
 			return pseries(rel, seq).add_series(ex_to<pseries>(log(newarg).series(rel, order, options)));
 		} else  // it was a monomial
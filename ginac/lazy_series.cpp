@@ -0,0 +1,598 @@
+/** @file lazy_series.cpp
+ *
+ *  Implementation of series expansions whose coefficients are computed on
+ *  demand.
+ *
+ *  A lazy_series is a tree of nodes mirroring the expression.  Each node
+ *  computes the coefficients of its series one after the other, from the
+ *  lowest exponent upwards, and keeps them, so that every coefficient is
+ *  computed exactly once no matter how often more terms are asked for. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "lazy_series.h"
+#include "dense_series.h"
+#include "add.h"
+#include "mul.h"
+#include "power.h"
+#include "pseries.h"
+#include "inifcns.h"
+#include "operators.h"
+#include "relational.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace GiNaC {
+
+/** Upper bound of the exponents of a series which does not terminate. */
+static const int no_upper_bound = std::numeric_limits<int>::max();
+
+/** Node of a lazy_series, standing for the series of one subexpression. */
+class lazy_series_node : public refcounted {
+public:
+	lazy_series_node() : first_known(false), first(0) {}
+	virtual ~lazy_series_node() {}
+
+	/** Lower bound of the exponents of the nonzero coefficients. */
+	virtual int lower() = 0;
+
+	/** Upper bound of the exponents of the nonzero coefficients, or
+	 *  no_upper_bound if the series is not known to terminate. */
+	virtual int upper() = 0;
+
+	/** Announce that the coefficients up to x^n will be needed, so that
+	 *  series obtained by ex::series() can be computed to that order at
+	 *  once. */
+	virtual void prepare(int n) {}
+
+	/** Return the coefficient of x^n, computing it if necessary. */
+	const ex & coeff(int n);
+
+protected:
+	/** Compute the coefficient of x^n.  This is called for
+	 *  n = lower(), lower()+1, ... in turn. */
+	virtual ex compute(int n) = 0;
+
+	/** Return the coefficient of x^n, which must already be computed. */
+	const ex & cached(int n) const { return c[n - first]; }
+
+private:
+	exvector c;        ///< coefficients computed so far, starting with x^first
+	bool first_known;  ///< whether first has been set
+	int first;         ///< exponent of c[0]
+};
+
+const ex & lazy_series_node::coeff(int n)
+{
+	if (!first_known) {
+		first = lower();
+		first_known = true;
+	}
+	if (n >= first && size_t(n - first) < c.size())
+		return c[n - first];
+	if (n < first || n > upper())
+		return _ex0;
+	while (c.size() <= size_t(n - first)) {
+		const ex cn = compute(first + int(c.size()));
+		c.push_back(cn);
+	}
+	return c[n - first];
+}
+
+namespace {
+
+typedef ptr<lazy_series_node> node_ptr;
+
+/** Expression not depending on the expansion variable. */
+class constant_node : public lazy_series_node {
+public:
+	constant_node(const ex & e_) : e(e_) {}
+	int lower() { return 0; }
+	int upper() { return e.is_zero() ? -1 : 0; }
+protected:
+	ex compute(int n) { return e; }
+private:
+	ex e;
+};
+
+/** The expansion variable x itself, i.e. point + (x-point). */
+class variable_node : public lazy_series_node {
+public:
+	variable_node(const ex & point_) : point(point_) {}
+	int lower() { return point.is_zero() ? 1 : 0; }
+	int upper() { return 1; }
+protected:
+	ex compute(int n) { return n == 0 ? point : _ex1; }
+private:
+	ex point;
+};
+
+/** Sum of series. */
+class add_node : public lazy_series_node {
+public:
+	add_node(const std::vector<node_ptr> & terms_) : terms(terms_) {}
+	int lower();
+	int upper();
+	void prepare(int n);
+protected:
+	ex compute(int n);
+private:
+	std::vector<node_ptr> terms;
+};
+
+int add_node::lower()
+{
+	int lo = no_upper_bound;
+	for (std::vector<node_ptr>::iterator i = terms.begin(); i != terms.end(); ++i)
+		lo = std::min(lo, (*i)->lower());
+	return lo;
+}
+
+int add_node::upper()
+{
+	int hi = -1;
+	for (std::vector<node_ptr>::iterator i = terms.begin(); i != terms.end(); ++i)
+		hi = std::max(hi, (*i)->upper());
+	return hi;
+}
+
+void add_node::prepare(int n)
+{
+	for (std::vector<node_ptr>::iterator i = terms.begin(); i != terms.end(); ++i)
+		(*i)->prepare(n);
+}
+
+ex add_node::compute(int n)
+{
+	exvector cn;
+	cn.reserve(terms.size());
+	for (std::vector<node_ptr>::iterator i = terms.begin(); i != terms.end(); ++i)
+		cn.push_back((*i)->coeff(n));
+	return (new add(cn))->setflag(status_flags::dynallocated);
+}
+
+/** Product of two series. */
+class mul_node : public lazy_series_node {
+public:
+	mul_node(const node_ptr & a_, const node_ptr & b_) : a(a_), b(b_) {}
+	int lower() { return a->lower() + b->lower(); }
+	int upper();
+	void prepare(int n);
+protected:
+	ex compute(int n);
+private:
+	node_ptr a, b;
+};
+
+int mul_node::upper()
+{
+	const int ahi = a->upper(), bhi = b->upper();
+	if (ahi == no_upper_bound || bhi == no_upper_bound)
+		return no_upper_bound;
+	return ahi + bhi;
+}
+
+void mul_node::prepare(int n)
+{
+	a->prepare(n - b->lower());
+	b->prepare(n - a->lower());
+}
+
+ex mul_node::compute(int n)
+{
+	// sum of a_i*b_(n-i) over all i where neither factor is known to vanish
+	int i_begin = a->lower(), i_end = n - b->lower();
+	const int ahi = a->upper(), bhi = b->upper();
+	if (ahi != no_upper_bound)
+		i_end = std::min(i_end, ahi);
+	if (bhi != no_upper_bound)
+		i_begin = std::max(i_begin, n - bhi);
+
+	exvector terms;
+	for (int i = i_begin; i <= i_end; ++i) {
+		const ex & ai = a->coeff(i);
+		if (ai.is_zero())
+			continue;
+		const ex & bj = b->coeff(n - i);
+		if (!bj.is_zero())
+			terms.push_back(ai * bj);
+	}
+	return (new add(terms))->setflag(status_flags::dynallocated);
+}
+
+/** Rational power of a series, by Euler's recurrence.
+ *  @see pseries::power_const */
+class power_node : public lazy_series_node {
+public:
+	power_node(const node_ptr & basis_, const numeric & p_)
+	  : basis(basis_), p(p_), search_started(false), found(false), vanishes(false), next(0), v(0), pv(0) {}
+	int lower();
+	int upper();
+	void prepare(int n);
+protected:
+	ex compute(int n);
+private:
+	void search(int n);
+
+	node_ptr basis;
+	numeric p;            ///< exponent
+	bool search_started;  ///< whether next has been set
+	bool found;           ///< whether the leading term of the basis is known
+	bool vanishes;        ///< whether the basis is the zero series
+	int next;             ///< next exponent of the basis to look at
+	int v;                ///< exponent of the leading term of the basis
+	int pv;               ///< p*v, exponent of the leading term
+};
+
+/** Look for the leading term of the basis, but only as far as it could
+ *  contribute to the coefficient of x^n (further if n is no_upper_bound). */
+void power_node::search(int n)
+{
+	if (found || vanishes)
+		return;
+	if (!search_started) {
+		next = basis->lower();
+		search_started = true;
+	}
+	while (next <= basis->upper()) {
+		if (n != no_upper_bound && p * next > n)
+			return;
+		if (!basis->coeff(next).is_zero()) {
+			if (!(p * next).is_integer())
+				throw std::runtime_error("lazy_series: trying to assemble a Puiseux series");
+			found = true;
+			v = next;
+			pv = (p * v).to_int();
+			return;
+		}
+		++next;
+	}
+	if (p.is_negative())
+		throw pole_error("lazy_series: division by zero", 1);
+	vanishes = true;
+}
+
+int power_node::lower()
+{
+	if (p.is_negative())
+		search(no_upper_bound);
+	if (found)
+		return pv;
+	if (vanishes)
+		return 0;
+	return int(std::floor((p * basis->lower()).to_double()));
+}
+
+int power_node::upper()
+{
+	if (p.is_negative())
+		search(no_upper_bound);
+	if (vanishes)
+		return -1;
+	if (p.is_pos_integer()) {
+		const int hi = basis->upper();
+		return hi == no_upper_bound ? no_upper_bound : p.to_int() * hi;
+	}
+	if (found && basis->upper() == v)
+		return pv;  // power of a monomial
+	return no_upper_bound;
+}
+
+void power_node::prepare(int n)
+{
+	if (p.is_negative())
+		search(no_upper_bound);
+	if (found)
+		basis->prepare(v + n - pv);
+}
+
+ex power_node::compute(int n)
+{
+	search(n);
+	if (!found || n < pv)
+		return _ex0;
+
+	// c_i = (i*p*a_i*c_0 + ((i-1)*p-1)*a_{i-1}*c_1 + ...
+	//                ... + (p-(i-1))*a_1*c_{i-1})/(a_0*i)
+	// where the indices count from the leading terms
+	const int i = n - pv;
+	const ex & a0 = basis->coeff(v);
+	if (i == 0)
+		return GiNaC::power(a0, p);
+	exvector terms;
+	for (int j = 1; j <= i; ++j) {
+		const ex & aj = basis->coeff(v + j);
+		if (!aj.is_zero())
+			terms.push_back((p * j - (i - j)) * aj * cached(n - j));
+	}
+	ex sum = (new add(terms))->setflag(status_flags::dynallocated);
+	return sum / a0 / i;
+}
+
+/** Exponential of a series without negative powers.
+ *  @see dense_series::exp */
+class exp_node : public lazy_series_node {
+public:
+	exp_node(const node_ptr & arg_) : arg(arg_) {}
+	int lower() { return 0; }
+	int upper() { return arg->upper() <= 0 ? 0 : no_upper_bound; }
+	void prepare(int n) { arg->prepare(n); }
+protected:
+	ex compute(int n);
+private:
+	node_ptr arg;
+	ex exp_a0;     ///< exponential of the constant term
+	exvector e;    ///< coefficients of exp(arg - constant term)
+};
+
+ex exp_node::compute(int n)
+{
+	if (n == 0) {
+		exp_a0 = exp(arg->coeff(0));
+		e.push_back(_ex1);
+		return exp_a0;
+	}
+	exvector terms;
+	for (int k = 1; k <= n; ++k) {
+		const ex & ak = arg->coeff(k);
+		if (!ak.is_zero())
+			terms.push_back(numeric(k) * ak * e[n - k]);
+	}
+	ex sum = (new add(terms))->setflag(status_flags::dynallocated);
+	e.push_back((sum / n).expand());
+	return exp_a0.is_equal(_ex1) ? e.back() : (exp_a0 * e.back()).expand();
+}
+
+/** Logarithm of a series with nonzero constant term.
+ *  @see dense_series::log */
+class log_node : public lazy_series_node {
+public:
+	log_node(const node_ptr & arg_) : arg(arg_) {}
+	int lower() { return 0; }
+	int upper() { return arg->upper() == 0 ? 0 : no_upper_bound; }
+	void prepare(int n) { arg->prepare(n); }
+protected:
+	ex compute(int n);
+private:
+	node_ptr arg;
+};
+
+ex log_node::compute(int n)
+{
+	const ex & a0 = arg->coeff(0);
+	if (n == 0)
+		return log(a0);
+	// a*L' = a' gives n*a_n = a_0*n*l_n + (n-1)*a_1*l_(n-1) + ... + a_(n-1)*l_1
+	exvector terms;
+	terms.push_back(numeric(n) * arg->coeff(n));
+	for (int k = 1; k < n; ++k) {
+		const ex & ank = arg->coeff(n - k);
+		if (!ank.is_zero())
+			terms.push_back(numeric(-k) * ank * cached(k));
+	}
+	ex sum = (new add(terms))->setflag(status_flags::dynallocated);
+	return (sum / a0 / n).expand();
+}
+
+/** Any other expression, expanded by ex::series() to an order which is
+ *  raised as more coefficients are needed. */
+class series_node : public lazy_series_node {
+public:
+	series_node(const ex & e_, const ex & rel_, unsigned options_)
+	  : e(e_), rel(rel_), options(options_), requested(0) {}
+	int lower();
+	int upper();
+	void prepare(int n);
+protected:
+	ex compute(int n);
+private:
+	void expand_to(int order);
+
+	ex e, rel;
+	unsigned options;
+	int requested;    ///< order of the last expansion, 0 if there was none
+	dense_series s;   ///< result of the last expansion
+};
+
+void series_node::expand_to(int order)
+{
+	s = dense_series(ex_to<pseries>(e.series(rel, order, options)));
+	requested = order;
+}
+
+int series_node::lower()
+{
+	if (requested == 0)
+		expand_to(1);
+	return s.ldegree();
+}
+
+int series_node::upper()
+{
+	if (requested == 0)
+		expand_to(1);
+	if (s.is_zero())
+		return -1;
+	return s.order() == no_upper_bound ? s.degree() : no_upper_bound;
+}
+
+void series_node::prepare(int n)
+{
+	if (requested == 0 || s.order() <= n)
+		expand_to(std::max(n + 1 + std::max(requested - s.order(), 0), requested + 1));
+}
+
+ex series_node::compute(int n)
+{
+	if (requested == 0)
+		expand_to(1);
+	while (s.order() <= n) {
+		// Double the order, but at least make up for the orders lost in
+		// the last expansion, e.g. by division by a series with a zero.
+		expand_to(std::max(std::max(2 * requested, requested + 1),
+		                   n + 1 + requested - s.order()));
+	}
+	return s.coeff(n);
+}
+
+/** Check whether the series of a node has no negative powers of x. */
+bool is_regular(const node_ptr & n)
+{
+	for (int k = n->lower(); k < 0; ++k) {
+		if (!n->coeff(k).is_zero())
+			return false;
+	}
+	return true;
+}
+
+node_ptr make_node(const ex & e, const relational & rel, unsigned options)
+{
+	const ex & x = rel.lhs();
+	if (!e.has(x))
+		return node_ptr(new constant_node(e));
+	if (e.is_equal(x))
+		return node_ptr(new variable_node(rel.rhs()));
+
+	if (is_exactly_a<add>(e)) {
+		std::vector<node_ptr> terms;
+		terms.reserve(e.nops());
+		for (size_t i = 0; i < e.nops(); ++i)
+			terms.push_back(make_node(e.op(i), rel, options));
+		return node_ptr(new add_node(terms));
+	}
+
+	if (is_exactly_a<mul>(e)) {
+		node_ptr acc = make_node(e.op(0), rel, options);
+		for (size_t i = 1; i < e.nops(); ++i)
+			acc = node_ptr(new mul_node(acc, make_node(e.op(i), rel, options)));
+		return acc;
+	}
+
+	if (is_exactly_a<power>(e) && is_exactly_a<numeric>(e.op(1))
+	 && ex_to<numeric>(e.op(1)).is_rational())
+		return node_ptr(new power_node(make_node(e.op(0), rel, options), ex_to<numeric>(e.op(1))));
+
+	if (is_ex_the_function(e, exp)) {
+		node_ptr arg = make_node(e.op(0), rel, options);
+		if (is_regular(arg))
+			return node_ptr(new exp_node(arg));
+	}
+
+	if (is_ex_the_function(e, log)) {
+		// Only away from the branch point and, unless suppressed, the
+		// branch cut, which log_series() knows how to handle.
+		node_ptr arg = make_node(e.op(0), rel, options);
+		if (is_regular(arg)) {
+			const ex & a0 = arg->coeff(0);
+			if (!a0.is_zero() && ((options & series_options::suppress_branchcut)
+			                      || !a0.info(info_flags::negative)))
+				return node_ptr(new log_node(arg));
+		}
+	}
+
+	return node_ptr(new series_node(e, rel, options));
+}
+
+relational make_rel(const ex & r)
+{
+	if (is_a<relational>(r))
+		return ex_to<relational>(r);
+	if (is_a<symbol>(r))
+		return relational(r, _ex0);
+	throw std::logic_error("lazy_series: expansion point has unknown type");
+}
+
+} // anonymous namespace
+
+/*
+ *  Class lazy_series
+ */
+
+lazy_series::lazy_series(const ex & e, const ex & r, unsigned options)
+  : rel(make_rel(r)), root(make_node(e, ex_to<relational>(rel), options))
+{
+	GINAC_ASSERT(is_a<symbol>(rel.lhs()));
+}
+
+lazy_series::lazy_series(const ex & r, const ptr<lazy_series_node> & n)
+  : rel(r), root(n)
+{
+}
+
+lazy_series::lazy_series(const lazy_series & other)
+  : rel(other.rel), root(other.root)
+{
+}
+
+lazy_series & lazy_series::operator=(const lazy_series & other)
+{
+	rel = other.rel;
+	root = other.root;
+	return *this;
+}
+
+lazy_series::~lazy_series()
+{
+}
+
+ex lazy_series::coeff(int n) const
+{
+	return root->coeff(n);
+}
+
+int lazy_series::ldegree(int limit) const
+{
+	for (int n = root->lower(); n < limit; ++n) {
+		if (n > root->upper())
+			return 0;  // zero series
+		if (!root->coeff(n).is_zero())
+			return n;
+	}
+	return limit;
+}
+
+ex lazy_series::series(int order) const
+{
+	root->prepare(order - 1);
+	epvector seq;
+	for (int n = root->lower(); n < order && n <= root->upper(); ++n) {
+		const ex & cn = root->coeff(n);
+		if (!cn.is_zero())
+			seq.push_back(expair(cn, numeric(n)));
+	}
+	if (root->upper() >= order)
+		seq.push_back(expair(Order(_ex1), numeric(order)));
+	return (new pseries(rel, seq))->setflag(status_flags::dynallocated);
+}
+
+lazy_series lazy_series::power(const numeric & p) const
+{
+	if (!p.is_rational())
+		throw std::invalid_argument("lazy_series::power(): exponent must be rational");
+	if (p.is_equal(*_num1_p))
+		return *this;
+	return lazy_series(rel, node_ptr(new power_node(root, p)));
+}
+
+} // namespace GiNaC
@@ -0,0 +1,91 @@
+/** @file lazy_series.h
+ *
+ *  Interface to series expansions whose coefficients are computed on
+ *  demand. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_LAZY_SERIES_H
+#define GINAC_LAZY_SERIES_H
+
+#include "ex.h"
+#include "numeric.h"
+#include "ptr.h"
+
+#include <limits>
+
+namespace GiNaC {
+
+class lazy_series_node;
+
+/** Series expansion of an expression which computes its coefficients only
+ *  when they are asked for and remembers them, so that asking for more
+ *  terms later continues where the previous computation stopped instead of
+ *  expanding everything again.  This is useful when the number of terms
+ *  needed is not known in advance, e.g. because the leading terms may
+ *  cancel.
+ *
+ *  Sums, products, powers with numeric exponents, exp() and log() are
+ *  expanded coefficient by coefficient.  The series of any other
+ *  subexpression is obtained by ex::series(), to an order which grows
+ *  geometrically as more coefficients are needed.
+ *
+ *  Copies share the computed coefficients.  A lazy_series must not be used
+ *  by several threads at a time. */
+class lazy_series {
+public:
+	/** Prepare the expansion of e in the variable and around the point
+	 *  given by r (a relational or, for the point 0, a symbol).  No
+	 *  coefficients are computed yet, except where needed to decide how
+	 *  to expand the arguments of exp() and log().
+	 *  @param options  see series_options */
+	lazy_series(const ex & e, const ex & r, unsigned options = 0);
+	lazy_series(const lazy_series & other);
+	lazy_series & operator=(const lazy_series & other);
+	~lazy_series();
+
+	/** Return the coefficient of (x-point)^n. */
+	ex coeff(int n) const;
+
+	/** Return the exponent of the first nonzero coefficient.  The search
+	 *  stops at limit, which is returned if all coefficients below it
+	 *  vanish.  Like pseries::ldegree(), this is 0 for the zero series. */
+	int ldegree(int limit = std::numeric_limits<int>::max()) const;
+
+	/** Return the series up to, but not including, (x-point)^order as a
+	 *  pseries object. */
+	ex series(int order) const;
+
+	/** Return the series of the expression raised to the rational power p,
+	 *  which reuses the coefficients of this series. */
+	lazy_series power(const numeric & p) const;
+
+	/** Return the relational defining expansion variable and point. */
+	const ex & get_rel() const { return rel; }
+
+private:
+	lazy_series(const ex & r, const ptr<lazy_series_node> & n);
+
+	ex rel;  ///< expansion variable == point
+	ptr<lazy_series_node> root;
+};
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_LAZY_SERIES_H
@@ -32,6 +32,7 @@
 #include "normal.h"
 #include "archive.h"
 #include "utils.h"
+#include "matrix_modular.h"
 
 #include <algorithm>
 #include <iostream>
@@ -40,6 +41,10 @@
 #include <stdexcept>
 #include <string>
 
+#include <cln/integer.h>
+#include <cln/rational.h>
+#include <cln/real.h>
+
 namespace GiNaC {
 
 GINAC_IMPLEMENT_REGISTERED_CLASS_OPT(matrix, basic,
@@ -545,6 +550,328 @@ bool matrix::contract_with(exvector::iterator self, exvector::iterator other, ex
 }
 
 
+//////////
+// dense numeric matrices
+//////////
+
+namespace {
+
+/** Matrix all of whose elements are numbers, stored as CLN numbers in
+ *  row-major order.  Matrices of numbers are multiplied and eliminated on
+ *  this representation, which saves constructing and evaluating an ex for
+ *  every intermediate result.  Matrices of real rational numbers are
+ *  eliminated with Bareiss' fraction free scheme on integers, avoiding the
+ *  GCD computations of rational arithmetic, and floating point matrices use
+ *  partial pivoting.  Large rational matrices are handled by the
+ *  multi-modular algorithms of matrix_modular.cpp if the caller allows. */
+class numeric_matrix {
+public:
+	numeric_matrix() : rows(0), cols(0), rational(true), exact(true) {}
+
+	bool assign(unsigned r, unsigned c, const exvector & m);
+
+	cln::cl_N & operator()(unsigned r, unsigned c) { return v[r*cols+c]; }
+	const cln::cl_N & operator()(unsigned r, unsigned c) const { return v[r*cols+c]; }
+
+	void mul(const numeric_matrix & other, exvector & prod) const;
+	ex determinant(bool modular = false);
+	unsigned rank();
+	bool solve(unsigned n, exvector & sol, bool modular = false);
+
+private:
+	int eliminate(bool det);
+	int gauss_elimination(bool det);
+	int fraction_free_elimination(bool det);
+	void to_integers(std::vector<cln::cl_I> & a);
+	unsigned pivot(unsigned r0, unsigned c0) const;
+	void swap_rows(unsigned r1, unsigned r2);
+
+	static ex to_ex(const cln::cl_N & x)
+	{
+		return (new numeric(x))->setflag(status_flags::dynallocated);
+	}
+
+	unsigned rows, cols;
+	std::vector<cln::cl_N> v;
+	bool rational;       ///< all elements are real rational numbers
+	bool exact;          ///< no element is a floating point number
+	cln::cl_I scale;     ///< product of the row factors in to_integers()
+};
+
+/** Set this to the r x c matrix with elements m.  Returns false if some
+ *  element is not a number. */
+bool numeric_matrix::assign(unsigned r, unsigned c, const exvector & m)
+{
+	rows = r;
+	cols = c;
+	rational = exact = true;
+	v.clear();
+	v.reserve(m.size());
+	for (exvector::const_iterator i = m.begin(); i != m.end(); ++i) {
+		if (!is_exactly_a<numeric>(*i))
+			return false;
+		const numeric & x = ex_to<numeric>(*i);
+		if (!x.is_rational()) {
+			rational = false;
+			if (!x.is_crational())
+				exact = false;
+		}
+		v.push_back(x.to_cl_N());
+	}
+	return true;
+}
+
+/** Store the elements of the product of this matrix and other in prod. */
+void numeric_matrix::mul(const numeric_matrix & other, exvector & prod) const
+{
+	GINAC_ASSERT(cols == other.rows);
+	const unsigned n = other.cols;
+	if (rows == 0 || n == 0) {
+		prod.clear();
+		return;
+	}
+	std::vector<cln::cl_N> p(rows * n);
+
+	// Traverse all matrices row by row, skipping zero elements of this.
+	for (unsigned r = 0; r < rows; ++r) {
+		cln::cl_N * const prow = &p[r*n];
+		for (unsigned k = 0; k < cols; ++k) {
+			const cln::cl_N & a = v[r*cols+k];
+			if (cln::zerop(a))
+				continue;
+			const cln::cl_N * const brow = &other.v[k*n];
+			for (unsigned c = 0; c < n; ++c)
+				prow[c] = prow[c] + a * brow[c];
+		}
+	}
+
+	prod.resize(p.size());
+	for (size_t i = 0; i < p.size(); ++i)
+		prod[i] = to_ex(p[i]);
+}
+
+/** Determinant of this square matrix.  If modular is true, large rational
+ *  matrices use modular_determinant().  The elements are destroyed. */
+ex numeric_matrix::determinant(bool modular)
+{
+	GINAC_ASSERT(rows == cols);
+	if (rows == 0)
+		return _ex1;
+	if (modular && rational && rows >= modular_matrix_threshold) {
+		std::vector<cln::cl_I> a;
+		to_integers(a);
+		return to_ex(modular_determinant(a, rows) / scale);
+	}
+	const int sign = eliminate(true);
+	if (sign == 0)
+		return _ex0;
+	if (rational) {
+		// the last element of the fraction free echelon form is the
+		// determinant of the matrix with rescaled rows
+		return to_ex(cln::cl_I(sign) * v[rows*cols-1] / scale);
+	}
+	cln::cl_N det = sign;
+	for (unsigned d = 0; d < rows; ++d)
+		det = det * v[d*cols+d];
+	return to_ex(det);
+}
+
+/** Rank of this matrix.  The elements are destroyed. */
+unsigned numeric_matrix::rank()
+{
+	eliminate(false);
+	unsigned r = rows;
+	while (r > 0) {
+		for (unsigned c = 0; c < cols; ++c)
+			if (!cln::zerop(v[(r-1)*cols+c]))
+				return r;
+		--r;
+	}
+	return 0;
+}
+
+/** Solve the linear system whose augmented matrix is this, i.e. the first n
+ *  columns form a square matrix and the remaining ones the right hand
+ *  sides.  Stores the n x (cols-n) solution matrix in sol and returns true
+ *  if the system has a unique solution.  If not, returns false and leaves
+ *  the system to the general code, which can introduce free parameters.
+ *  If modular is true, large rational systems are first tried with
+ *  modular_solve().  The elements are destroyed. */
+bool numeric_matrix::solve(unsigned n, exvector & sol, bool modular)
+{
+	GINAC_ASSERT(rows == n && cols >= n);
+	if (modular && rational && n >= modular_matrix_threshold) {
+		// Rescaling the rows does not change the solution.
+		std::vector<cln::cl_I> a;
+		to_integers(a);
+		std::vector<cln::cl_RA> x;
+		if (modular_solve(a, n, cols - n, x)) {
+			sol.resize(x.size());
+			for (size_t i = 0; i < x.size(); ++i)
+				sol[i] = to_ex(x[i]);
+			return true;
+		}
+		// singular, or singular modulo an unlucky prime
+	}
+
+	eliminate(false);
+	for (unsigned d = 0; d < n; ++d)
+		if (cln::zerop(v[d*cols+d]))
+			return false;
+
+	// back substitution
+	const unsigned p = cols - n;
+	std::vector<cln::cl_N> x(n * p);
+	for (unsigned co = 0; co < p; ++co) {
+		for (int r = n - 1; r >= 0; --r) {
+			cln::cl_N e = v[r*cols+n+co];
+			for (unsigned c = r + 1; c < n; ++c)
+				if (!cln::zerop(v[r*cols+c]))
+					e = e - v[r*cols+c] * x[c*p+co];
+			x[r*p+co] = e / v[r*cols+r];
+		}
+	}
+
+	sol.resize(x.size());
+	for (size_t i = 0; i < x.size(); ++i)
+		sol[i] = to_ex(x[i]);
+	return true;
+}
+
+/** Bring this matrix into an upper echelon form.  The return value is the
+ *  sign as for matrix::gauss_elimination(). */
+int numeric_matrix::eliminate(bool det)
+{
+	if (rational)
+		return fraction_free_elimination(det);
+	return gauss_elimination(det);
+}
+
+/** Gauss elimination, for matrices of complex or floating point numbers. */
+int numeric_matrix::gauss_elimination(bool det)
+{
+	int sign = 1;
+	unsigned r0 = 0;
+	for (unsigned c0 = 0; c0 < cols && r0 < rows; ++c0) {
+		const unsigned k = pivot(r0, c0);
+		if (k == rows) {
+			// all elements in column c0 below row r0 vanish
+			sign = 0;
+			if (det)
+				return 0;
+			continue;
+		}
+		if (k != r0) {
+			swap_rows(k, r0);
+			sign = -sign;
+		}
+		const cln::cl_N piv = v[r0*cols+c0];
+		for (unsigned r2 = r0 + 1; r2 < rows; ++r2) {
+			if (cln::zerop(v[r2*cols+c0]))
+				continue;
+			const cln::cl_N f = v[r2*cols+c0] / piv;
+			for (unsigned c = c0 + 1; c < cols; ++c)
+				if (!cln::zerop(v[r0*cols+c]))
+					v[r2*cols+c] = v[r2*cols+c] - f * v[r0*cols+c];
+			v[r2*cols+c0] = 0;
+		}
+		++r0;
+	}
+	return sign;
+}
+
+/** Store the elements of this matrix of real rational numbers in a, with
+ *  every row multiplied by the least common multiple of the denominators of
+ *  its elements.  The product of the multipliers is stored in scale. */
+void numeric_matrix::to_integers(std::vector<cln::cl_I> & a)
+{
+	a.resize(v.size());
+	scale = 1;
+	for (unsigned r = 0; r < rows; ++r) {
+		cln::cl_I l = 1;
+		for (unsigned c = 0; c < cols; ++c)
+			l = cln::lcm(l, cln::denominator(cln::the<cln::cl_RA>(v[r*cols+c])));
+		for (unsigned c = 0; c < cols; ++c)
+			a[r*cols+c] = cln::the<cln::cl_I>(v[r*cols+c] * l);
+		scale = scale * l;
+	}
+}
+
+/** Bareiss' fraction free elimination, for matrices of real rational
+ *  numbers.  The rows are first made integral by to_integers(), so the
+ *  elimination works on integers where every division is exact. */
+int numeric_matrix::fraction_free_elimination(bool det)
+{
+	std::vector<cln::cl_I> a;
+	to_integers(a);
+
+	int sign = 1;
+	cln::cl_I divisor = 1;
+	unsigned r0 = 0;
+	for (unsigned c0 = 0; c0 < cols && r0 < rows; ++c0) {
+		unsigned k = r0;
+		while (k < rows && cln::zerop(a[k*cols+c0]))
+			++k;
+		if (k == rows) {
+			sign = 0;
+			if (det)
+				return 0;
+			continue;
+		}
+		if (k != r0) {
+			for (unsigned c = c0; c < cols; ++c)
+				std::swap(a[k*cols+c], a[r0*cols+c]);
+			sign = -sign;
+		}
+		const cln::cl_I piv = a[r0*cols+c0];
+		for (unsigned r2 = r0 + 1; r2 < rows; ++r2) {
+			const cln::cl_I f = a[r2*cols+c0];
+			for (unsigned c = c0 + 1; c < cols; ++c)
+				a[r2*cols+c] = cln::exquo(piv * a[r2*cols+c] - f * a[r0*cols+c], divisor);
+			a[r2*cols+c0] = 0;
+		}
+		divisor = piv;
+		++r0;
+	}
+
+	for (size_t i = 0; i < a.size(); ++i)
+		v[i] = a[i];
+	return sign;
+}
+
+/** Return the row of the pivot element in column c0 at or below row r0, or
+ *  rows if all these elements vanish.  For floating point matrices this is
+ *  the element with the largest absolute value, otherwise the first
+ *  non-zero element. */
+unsigned numeric_matrix::pivot(unsigned r0, unsigned c0) const
+{
+	if (exact) {
+		for (unsigned k = r0; k < rows; ++k)
+			if (!cln::zerop(v[k*cols+c0]))
+				return k;
+		return rows;
+	}
+	unsigned kmax = rows;
+	cln::cl_R max = 0;
+	for (unsigned k = r0; k < rows; ++k) {
+		const cln::cl_R a = cln::abs(v[k*cols+c0]);
+		if (a > max) {
+			max = a;
+			kmax = k;
+		}
+	}
+	return kmax;
+}
+
+void numeric_matrix::swap_rows(unsigned r1, unsigned r2)
+{
+	for (unsigned c = 0; c < cols; ++c)
+		std::swap(v[r1*cols+c], v[r2*cols+c]);
+}
+
+} // anonymous namespace
+
+
 //////////
 // non-virtual functions in this class
 //////////
@@ -595,6 +922,13 @@ matrix matrix::mul(const matrix & other) const
 	if (this->cols() != other.rows())
 		throw std::logic_error("matrix::mul(): incompatible matrices");
 	
+	numeric_matrix a, b;
+	if (a.assign(row, col, m) && b.assign(other.row, other.col, other.m)) {
+		exvector prod;
+		a.mul(b, prod);
+		return matrix(row, other.col, prod);
+	}
+
 	exvector prod(this->rows()*other.cols());
 	
 	for (unsigned r1=0; r1<this->rows(); ++r1) {
@@ -744,6 +1078,37 @@ ex matrix::determinant(unsigned algo) const
 		throw (std::logic_error("matrix::determinant(): matrix not square"));
 	GINAC_ASSERT(row*col==m.capacity());
 	
+	// Matrices of numbers are eliminated directly on their CLN
+	// representation, using Bareiss' scheme for rational numbers.
+	if (algo == determinant_algo::automatic ||
+	    algo == determinant_algo::gauss ||
+	    algo == determinant_algo::bareiss) {
+		numeric_matrix tmp;
+		if (tmp.assign(row, col, m))
+			return tmp.determinant(algo == determinant_algo::automatic);
+	}
+
+	// Matrices of polynomials are interpolated from their values at
+	// integer points, automatically if not too many points are needed
+	// compared with the row! terms of minor expansion and the matrix is
+	// not sparse in many variables.
+	if (algo == determinant_algo::interpolation ||
+	    (algo == determinant_algo::automatic && row > 3)) {
+		ex det;
+		const bool automatic = algo == determinant_algo::automatic;
+		unsigned long max_points = 1UL << 24;
+		if (automatic) {
+			max_points = interpolation_points_per_term;
+			for (unsigned i = 2; i <= row && max_points < interpolation_max_points; ++i)
+				max_points *= i;
+			max_points = std::min(max_points, interpolation_max_points);
+		}
+		if (interpolation_determinant(m, row, max_points,
+		                              automatic ? interpolation_max_sparse_vars : ~0U, det))
+			return det;
+		algo = determinant_algo::automatic;
+	}
+
 	// Gather some statistical information about this matrix:
 	bool numeric_flag = true;
 	bool normal_flag = false;
@@ -955,6 +1320,23 @@ matrix matrix::inverse() const
 	// This routine actually doesn't do anything fancy at all.  We compute the
 	// inverse of the matrix A by solving the system A * A^{-1} == Id.
 	
+	// For a matrix of numbers, the augmented matrix [A|Id] is eliminated
+	// directly.
+	exvector aug(row*2*col);
+	for (unsigned r=0; r<row; ++r) {
+		for (unsigned c=0; c<col; ++c) {
+			aug[r*2*col+c] = m[r*col+c];
+			aug[r*2*col+col+c] = r==c ? _ex1 : _ex0;
+		}
+	}
+	numeric_matrix tmp;
+	if (tmp.assign(row, 2*col, aug)) {
+		exvector sol;
+		if (!tmp.solve(row, sol, true))
+			throw (std::runtime_error("matrix::inverse(): singular matrix"));
+		return matrix(row, col, sol);
+	}
+
 	// First populate the identity matrix supposed to become the right hand side.
 	matrix identity(row,col);
 	for (unsigned i=0; i<row; ++i)
@@ -1026,6 +1408,21 @@ matrix matrix::solve(const matrix & vars,
 		++r;
 	}
 	
+	// A system of numbers with a square matrix is eliminated directly on
+	// the CLN representation.  If some element cannot be represented that
+	// way or the system turns out not to have a unique solution, the
+	// general code below takes care of it.
+	numeric_matrix tmp;
+	if (numeric_flag && m == n &&
+	    (algo == solve_algo::automatic ||
+	     algo == solve_algo::gauss ||
+	     algo == solve_algo::bareiss) &&
+	    tmp.assign(m, n+p, aug.m)) {
+		exvector sol;
+		if (tmp.solve(n, sol, algo == solve_algo::automatic))
+			return matrix(n, p, sol);
+	}
+
 	// Here is the heuristics in case this routine has to decide:
 	if (algo == solve_algo::automatic) {
 		// Bareiss (fraction-free) elimination is generally a good guess:
@@ -1096,6 +1493,10 @@ unsigned matrix::rank() const
 
 	GINAC_ASSERT(row*col==m.capacity());
 
+	numeric_matrix tmp;
+	if (tmp.assign(row, col, m))
+		return tmp.rank();
+
 	// Actually, any elimination scheme will do since we are only
 	// interested in the echelon matrix' zeros.
 	matrix to_eliminate = *this;
@@ -0,0 +1,701 @@
+/** @file matrix_modular.cpp
+ *
+ *  Multi-modular computation of determinants and solutions of linear
+ *  systems of integer matrices.
+ *
+ *  The matrix is reduced modulo word-size primes and eliminated with
+ *  machine arithmetic, independently for every prime and, in thread-safe
+ *  builds, in parallel.  The results are reconstructed by Chinese
+ *  remaindering.  Hadamard's bound limits the number of primes needed;
+ *  solutions of systems with few right hand sides are also checked after
+ *  every doubling of the number of primes, which usually allows stopping
+ *  much earlier.
+ *
+ *  Determinants of matrices of polynomials are interpolated from their
+ *  values at integer points, which are again computed modulo primes. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "matrix_modular.h"
+#include "add.h"
+#include "mul.h"
+#include "numeric.h"
+#include "operators.h"
+#include "parallel.h"
+#include "polynomial/cra_garner.h"
+#include "polynomial/modp_poly.h"
+#include "polynomial/primes_factory.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+namespace GiNaC {
+
+namespace {
+
+/** Solutions of systems with at most this many right hand sides are
+ *  checked for early termination. */
+const unsigned max_checked_rhs = 8;
+
+/** Number of bits of the primes used first for solving systems. */
+const unsigned long initial_solve_bits = 128;
+
+/** A system is taken for singular once the coefficient matrix has been
+ *  singular modulo this many primes. */
+const unsigned max_unlucky_primes = 3;
+
+/** Upper bound for the logarithm to base 2 of the Euclidean norm of the
+ *  len elements a[first], a[first+stride], ... */
+unsigned long norm_bits(const std::vector<cln::cl_I> & a, size_t first, size_t stride, unsigned len)
+{
+	cln::cl_I s = 0;
+	for (unsigned i = 0; i < len; ++i)
+		s = s + cln::square(a[first + i*stride]);
+	return (cln::integer_length(s) + 1) / 2;
+}
+
+/** Hadamard's bound for the absolute value of the determinant of the
+ *  n x n matrix in the first columns of the n x cols matrix a, as a power
+ *  of two. */
+unsigned long determinant_bits(const std::vector<cln::cl_I> & a, unsigned n, unsigned cols)
+{
+	unsigned long row_bits = 0, col_bits = 0;
+	for (unsigned i = 0; i < n; ++i) {
+		row_bits += norm_bits(a, i*cols, 1, n);
+		col_bits += norm_bits(a, i, cols, n);
+	}
+	return std::min(row_bits, col_bits);
+}
+
+/** Return floor(log2(p)). */
+unsigned long log2_floor(uint64_t p)
+{
+	unsigned long l = 0;
+	while (p >>= 1)
+		++l;
+	return l;
+}
+
+/** Gauss elimination modulo p of the n x cols matrix r, whose elements are
+ *  reduced.  Returns the determinant of the first n columns modulo p.  If
+ *  it does not vanish, the remaining columns are replaced by det times the
+ *  solutions of the system. */
+uint64_t eliminate_mod(std::vector<uint64_t> & r, unsigned n, unsigned cols, uint64_t p)
+{
+	// Elements are only reduced every max_lazy steps of the elimination,
+	// in between they grow by less than p^2 per step.
+	const uint64_t max_lazy = (~uint64_t(0) - p) / (p * p);
+	uint64_t lazy = 0;
+	uint64_t det = 1;
+
+	for (unsigned c0 = 0; c0 < n; ++c0) {
+		unsigned k = c0;
+		while (k < n && (r[k*cols+c0] %= p) == 0)
+			++k;
+		if (k == n)
+			return 0;
+		if (k != c0) {
+			std::swap_ranges(r.begin() + k*cols + c0, r.begin() + (k+1)*cols, r.begin() + c0*cols + c0);
+			det = p - det;
+		}
+
+		// normalize the pivot row
+		uint64_t * const row0 = &r[c0*cols];
+		const uint64_t piv = row0[c0];
+		det = det * piv % p;
+		const uint64_t inv = recip_mod(piv, p);
+		for (unsigned c = c0; c < cols; ++c)
+			row0[c] = row0[c] % p * inv % p;
+
+		for (unsigned r2 = c0 + 1; r2 < n; ++r2) {
+			uint64_t * const row = &r[r2*cols];
+			const uint64_t f = row[c0] % p;
+			row[c0] = 0;
+			if (f == 0)
+				continue;
+			const uint64_t g = p - f;
+			for (unsigned c = c0 + 1; c < cols; ++c)
+				row[c] += g * row0[c];
+		}
+
+		if (++lazy == max_lazy) {
+			for (unsigned r2 = c0 + 1; r2 < n; ++r2)
+				for (unsigned c = c0 + 1; c < cols; ++c)
+					r[r2*cols+c] %= p;
+			lazy = 0;
+		}
+	}
+
+	// back substitution, the pivot rows have a unit diagonal
+	for (unsigned i = n; i-- != 0; ) {
+		uint64_t * const rowi = &r[i*cols];
+		lazy = 0;
+		for (unsigned j = i + 1; j < n; ++j) {
+			if (rowi[j] == 0)
+				continue;
+			const uint64_t g = p - rowi[j];
+			const uint64_t * const rowj = &r[j*cols];
+			for (unsigned c = n; c < cols; ++c)
+				rowi[c] += g * rowj[c];
+			if (++lazy == max_lazy) {
+				for (unsigned c = n; c < cols; ++c)
+					rowi[c] %= p;
+				lazy = 0;
+			}
+		}
+		for (unsigned c = n; c < cols; ++c)
+			rowi[c] %= p;
+	}
+	for (unsigned i = 0; i < n; ++i)
+		for (unsigned c = n; c < cols; ++c)
+			r[i*cols+c] = r[i*cols+c] * det % p;
+	return det;
+}
+
+/** The elements of an integer matrix split into 32 bit digits, from which
+ *  the residues modulo a prime can be computed without touching CLN
+ *  objects, whose reference counts are not thread-safe. */
+class digit_matrix {
+public:
+	explicit digit_matrix(const std::vector<cln::cl_I> & a);
+	void reduce(uint64_t p, std::vector<uint64_t> & r) const;
+private:
+	std::vector<uint32_t> digits;  ///< most significant digit first
+	std::vector<size_t> start;     ///< digits of element i start at start[i]
+	std::vector<bool> negative;
+};
+
+digit_matrix::digit_matrix(const std::vector<cln::cl_I> & a)
+{
+	static const cln::cl_I mask(0xffffffffUL);
+	start.reserve(a.size() + 1);
+	negative.reserve(a.size());
+	std::vector<uint32_t> d;
+	for (std::vector<cln::cl_I>::const_iterator i = a.begin(); i != a.end(); ++i) {
+		negative.push_back(cln::minusp(*i));
+		d.clear();
+		for (cln::cl_I x = cln::abs(*i); !cln::zerop(x); x = cln::ash(x, -32))
+			d.push_back(cln::cl_I_to_uint(cln::logand(x, mask)));
+		start.push_back(digits.size());
+		digits.insert(digits.end(), d.rbegin(), d.rend());
+	}
+	start.push_back(digits.size());
+}
+
+void digit_matrix::reduce(uint64_t p, std::vector<uint64_t> & r) const
+{
+	r.resize(negative.size());
+	for (size_t i = 0; i < negative.size(); ++i) {
+		uint64_t x = 0;
+		for (size_t k = start[i]; k < start[i+1]; ++k)
+			x = ((x << 32) | digits[k]) % p;
+		r[i] = negative[i] && x != 0 ? p - x : x;
+	}
+}
+
+/** Images of the determinant and of det times the solutions of a linear
+ *  system modulo a growing list of primes. */
+class modular_images : public parallel_task {
+public:
+	modular_images(const std::vector<cln::cl_I> & a, unsigned n_, unsigned cols_, bool drop_singular_)
+	  : digits(a), n(n_), cols(cols_), drop_singular(drop_singular_), bits(0), unlucky(0), first(0) {}
+
+	bool extend(unsigned long min_bits);
+	void reconstruct(std::vector<cln::cl_I> & values) const;
+	unsigned long modulus_bits() const { return bits; }
+
+	void run(size_t i, unsigned slot);
+
+private:
+	const digit_matrix digits;
+	const unsigned n, cols;
+	const bool drop_singular;                   ///< drop primes modulo which the determinant vanishes
+	primes_factory next_prime;
+	std::vector<long> primes;
+	unsigned long bits;                         ///< lower bound of log2 of the product of the primes
+	unsigned unlucky;                           ///< number of primes dropped so far
+	std::vector<std::vector<long> > images;     ///< images[k][0] is the determinant modulo primes[k]
+	std::vector<std::vector<uint64_t> > scratch;  ///< matrix for each thread
+	size_t first;                               ///< first prime of the current parallel_for()
+};
+
+/** Add primes until their product has at least min_bits bits.  If
+ *  drop_singular is set, primes modulo which the determinant vanishes are
+ *  dropped and replaced by further ones.  Returns false if this happened
+ *  for max_unlucky_primes primes. */
+bool modular_images::extend(unsigned long min_bits)
+{
+	const unsigned nthreads = get_parallel_threads();
+	scratch.resize(nthreads);
+
+	while (bits < min_bits) {
+		first = primes.size();
+		while (bits < min_bits) {
+			long p;
+			if (!next_prime(p, cln::cl_I(1)))
+				throw std::runtime_error("modular_images: out of primes");
+			primes.push_back(p);
+			bits += log2_floor(p);
+		}
+		images.resize(primes.size());
+		parallel_for(primes.size() - first, *this, nthreads);
+		if (!drop_singular)
+			break;
+
+		size_t kept = first;
+		for (size_t k = first; k < primes.size(); ++k) {
+			if (images[k][0] == 0) {
+				bits -= log2_floor(primes[k]);
+				if (++unlucky == max_unlucky_primes)
+					return false;
+				continue;
+			}
+			primes[kept] = primes[k];
+			images[kept].swap(images[k]);
+			++kept;
+		}
+		primes.resize(kept);
+		images.resize(kept);
+	}
+	return true;
+}
+
+void modular_images::run(size_t i, unsigned slot)
+{
+	const uint64_t p = primes[first + i];
+	std::vector<uint64_t> & r = scratch[slot];
+	digits.reduce(p, r);
+	const uint64_t det = eliminate_mod(r, n, cols, p);
+
+	std::vector<long> & im = images[first + i];
+	im.resize(1 + n*(cols - n));
+	im[0] = det;
+	for (unsigned row = 0; row < n; ++row)
+		for (unsigned c = n; c < cols; ++c)
+			im[1 + row*(cols - n) + c - n] = r[row*cols+c];
+}
+
+/** Reconstruct the determinant (values[0]) and det times the solutions
+ *  (values[1], ...) from their images. */
+void modular_images::reconstruct(std::vector<cln::cl_I> & values) const
+{
+	const cln::word_cra cra(primes);
+	const size_t nvalues = images.front().size();
+	values.resize(nvalues);
+	std::vector<long> residues(primes.size());
+	for (size_t i = 0; i < nvalues; ++i) {
+		for (size_t k = 0; k < primes.size(); ++k)
+			residues[k] = images[k][i];
+		values[i] = cra(residues);
+	}
+}
+
+/** Check whether a * y == det * b, where values holds det and y as
+ *  returned by modular_images::reconstruct(). */
+bool solves(const std::vector<cln::cl_I> & aug, unsigned n, unsigned q, const std::vector<cln::cl_I> & values)
+{
+	const unsigned cols = n + q;
+	for (unsigned k = 0; k < q; ++k) {
+		for (unsigned i = 0; i < n; ++i) {
+			cln::cl_I s = -values[0] * aug[i*cols+n+k];
+			for (unsigned j = 0; j < n; ++j)
+				s = s + aug[i*cols+j] * values[1 + j*q + k];
+			if (!cln::zerop(s))
+				return false;
+		}
+	}
+	return true;
+}
+
+/** Dense interpolation of the determinant of a matrix of polynomials
+ *  modulo a list of primes.  The elements are given as lists of terms with
+ *  integer coefficients and exponent vectors. */
+class determinant_interpolation : public parallel_task {
+public:
+	determinant_interpolation(unsigned n_, const std::vector<unsigned> & deg_,
+	                          const std::vector<cln::cl_I> & coeffs,
+	                          const std::vector<unsigned> & exps_,
+	                          const std::vector<size_t> & start_);
+
+	void compute(const std::vector<long> & p);
+	const std::vector<long> & image(size_t k) const { return images[k]; }
+
+	/** Offset of the coefficient of the monomial with exponents e. */
+	size_t index(const std::vector<unsigned> & e) const;
+	size_t size() const { return stride[0]; }
+
+	void run(size_t i, unsigned slot);
+
+private:
+	struct workspace {
+		std::vector<uint64_t> coeffs;                  ///< coefficients modulo the prime
+		std::vector<std::vector<uint64_t> > powers;    ///< powers of the values of the variables
+		std::vector<std::vector<uint64_t> > newton;    ///< interpolation buffer for each variable
+		std::vector<uint64_t> mat;
+		std::vector<uint64_t> result;
+	};
+
+	void interpolate(unsigned level, uint64_t * out, workspace & w, uint64_t p) const;
+
+	const unsigned n, nvars;
+	const std::vector<unsigned> deg;      ///< degree bound for each variable
+	std::vector<size_t> stride;           ///< offset between successive exponents of each variable
+	const digit_matrix digits;
+	const std::vector<unsigned> exps;     ///< exponents of term t at exps[t*nvars]
+	const std::vector<size_t> start;      ///< terms of element e start at start[e]
+	std::vector<unsigned> max_exp;
+	std::vector<long> primes;
+	std::vector<std::vector<long> > images;
+	std::vector<workspace> scratch;
+};
+
+determinant_interpolation::determinant_interpolation(unsigned n_, const std::vector<unsigned> & deg_,
+                                                     const std::vector<cln::cl_I> & coeffs,
+                                                     const std::vector<unsigned> & exps_,
+                                                     const std::vector<size_t> & start_)
+  : n(n_), nvars(deg_.size()), deg(deg_), stride(deg_.size() + 1),
+    digits(coeffs), exps(exps_), start(start_), max_exp(deg_.size(), 0)
+{
+	stride[nvars] = 1;
+	for (unsigned v = nvars; v-- != 0; )
+		stride[v] = (deg[v] + 1) * stride[v+1];
+	for (size_t t = 0; t < coeffs.size(); ++t)
+		for (unsigned v = 0; v < nvars; ++v)
+			max_exp[v] = std::max(max_exp[v], exps[t*nvars+v]);
+}
+
+size_t determinant_interpolation::index(const std::vector<unsigned> & e) const
+{
+	size_t i = 0;
+	for (unsigned v = 0; v < nvars; ++v)
+		i += e[v] * stride[v+1];
+	return i;
+}
+
+/** Interpolate the determinant modulo each of the primes p. */
+void determinant_interpolation::compute(const std::vector<long> & p)
+{
+	primes = p;
+	images.resize(primes.size());
+	const unsigned nthreads = get_parallel_threads();
+	scratch.resize(nthreads);
+	for (std::vector<workspace>::iterator w = scratch.begin(); w != scratch.end(); ++w) {
+		w->powers.resize(nvars);
+		w->newton.resize(nvars);
+		for (unsigned v = 0; v < nvars; ++v) {
+			w->powers[v].resize(max_exp[v] + 1);
+			w->newton[v].resize(stride[v]);
+		}
+		w->mat.resize(n * n);
+		w->result.resize(stride[0]);
+	}
+	parallel_for(primes.size(), *this, nthreads);
+}
+
+void determinant_interpolation::run(size_t i, unsigned slot)
+{
+	const uint64_t p = primes[i];
+	workspace & w = scratch[slot];
+	digits.reduce(p, w.coeffs);
+	interpolate(0, &w.result[0], w, p);
+	images[i].assign(w.result.begin(), w.result.end());
+}
+
+/** Store the coefficients of the determinant as a polynomial in the
+ *  variables from level on in out, with the values of the previous
+ *  variables given by w.powers. */
+void determinant_interpolation::interpolate(unsigned level, uint64_t * out, workspace & w, uint64_t p) const
+{
+	if (level == nvars) {
+		for (size_t e = 0; e < size_t(n) * n; ++e) {
+			uint64_t s = 0;
+			for (size_t t = start[e]; t < start[e+1]; ++t) {
+				uint64_t x = w.coeffs[t];
+				const unsigned * const et = &exps[t*nvars];
+				for (unsigned v = 0; v < nvars; ++v)
+					x = x * w.powers[v][et[v]] % p;
+				s = (s + x) % p;
+			}
+			w.mat[e] = s;
+		}
+		*out = eliminate_mod(w.mat, n, n, p);
+		return;
+	}
+
+	// values at the points 0, 1, ..., d
+	const unsigned d = deg[level];
+	const size_t s = stride[level+1];
+	std::vector<uint64_t> & pw = w.powers[level];
+	for (unsigned j = 0; j <= d; ++j) {
+		pw[0] = 1;
+		for (size_t e = 1; e < pw.size(); ++e)
+			pw[e] = pw[e-1] * j % p;
+		interpolate(level + 1, out + j*s, w, p);
+	}
+
+	// divided differences, the points j and j-k differ by k
+	for (unsigned k = 1; k <= d; ++k) {
+		const uint64_t inv = recip_mod(k, p);
+		for (unsigned j = d; j >= k; --j)
+			for (size_t i = 0; i < s; ++i)
+				out[j*s+i] = (out[j*s+i] + p - out[(j-1)*s+i]) * inv % p;
+	}
+
+	// convert the Newton form to monomials by Horner's scheme
+	std::vector<uint64_t> & poly = w.newton[level];
+	std::fill(poly.begin(), poly.end(), 0);
+	std::copy(out + d*s, out + (d+1)*s, poly.begin());
+	for (unsigned j = d; j-- != 0; ) {
+		// poly = poly * (x - j) + c_j
+		for (unsigned e = d - j; e > 0; --e)
+			for (size_t i = 0; i < s; ++i)
+				poly[e*s+i] = (poly[(e-1)*s+i] + (p - j) * poly[e*s+i]) % p;
+		for (size_t i = 0; i < s; ++i)
+			poly[i] = ((p - j) * poly[i] + out[j*s+i]) % p;
+	}
+	std::copy(poly.begin(), poly.end(), out);
+}
+
+/** Insert the symbols of the polynomial e into syms.  Returns false if e
+ *  contains any other atom, such as a constant or a function like
+ *  conjugate(x), which would otherwise be taken for a number. */
+bool collect_symbols(const ex & e, exset & syms)
+{
+	if (is_a<symbol>(e)) {
+		syms.insert(e);
+		return true;
+	}
+	if (is_exactly_a<numeric>(e))
+		return true;
+	if (!is_exactly_a<add>(e) && !is_exactly_a<mul>(e) && !is_exactly_a<power>(e))
+		return false;
+	for (size_t i = 0; i < e.nops(); ++i)
+		if (!collect_symbols(e.op(i), syms))
+			return false;
+	return true;
+}
+
+/** Append the terms of the expanded polynomial e to t. */
+void collect_terms(const ex & e, exvector & t)
+{
+	if (is_exactly_a<add>(e)) {
+		for (size_t i = 0; i < e.nops(); ++i)
+			t.push_back(e.op(i));
+	} else if (!e.is_zero())
+		t.push_back(e);
+}
+
+/** Numeric coefficient of a term of an expanded polynomial. */
+numeric term_coeff(const ex & t)
+{
+	if (is_exactly_a<numeric>(t))
+		return ex_to<numeric>(t);
+	if (is_exactly_a<mul>(t) && is_exactly_a<numeric>(t.op(t.nops() - 1)))
+		return ex_to<numeric>(t.op(t.nops() - 1));
+	return *_num1_p;
+}
+
+} // anonymous namespace
+
+cln::cl_I modular_determinant(const std::vector<cln::cl_I> & a, unsigned n)
+{
+	modular_images images(a, n, n, false);
+	images.extend(determinant_bits(a, n, n) + 2);
+	std::vector<cln::cl_I> values;
+	images.reconstruct(values);
+	return values[0];
+}
+
+bool modular_solve(const std::vector<cln::cl_I> & aug, unsigned n, unsigned q,
+                   std::vector<cln::cl_RA> & x)
+{
+	const unsigned cols = n + q;
+
+	// By Cramer's rule, det times the solutions are determinants of the
+	// coefficient matrix with one column replaced by a right hand side.
+	std::vector<unsigned long> col_bits(n);
+	for (unsigned j = 0; j < n; ++j)
+		col_bits[j] = norm_bits(aug, j, cols, n);
+	unsigned long rhs_bits = 0;
+	for (unsigned k = 0; k < q; ++k)
+		rhs_bits = std::max(rhs_bits, norm_bits(aug, n + k, cols, n));
+	unsigned long sum_bits = 0;
+	for (unsigned j = 0; j < n; ++j)
+		sum_bits += col_bits[j];
+	const unsigned long bound = std::max(determinant_bits(aug, n, cols),
+	                                     sum_bits - *std::min_element(col_bits.begin(), col_bits.end()) + rhs_bits) + 2;
+
+	modular_images images(aug, n, cols, true);
+	std::vector<cln::cl_I> values;
+	unsigned long target = std::min(bound, initial_solve_bits);
+	for (;;) {
+		if (!images.extend(target))
+			return false;
+		images.reconstruct(values);
+		if (images.modulus_bits() >= bound)
+			break;
+		if (q <= max_checked_rhs && solves(aug, n, q, values))
+			break;
+		target = std::min(bound, 2 * images.modulus_bits());
+	}
+
+	x.resize(n * q);
+	for (size_t i = 0; i < x.size(); ++i)
+		x[i] = values[1 + i] / values[0];
+	return true;
+}
+
+bool interpolation_determinant(const exvector & m, unsigned n, unsigned long max_points,
+                               unsigned max_sparse_vars, ex & det)
+{
+	// variables and degree bounds from the unexpanded elements
+	exset syms;
+	unsigned nonzero = 0;
+	for (exvector::const_iterator i = m.begin(); i != m.end(); ++i) {
+		if (!i->info(info_flags::rational_polynomial) || !collect_symbols(*i, syms))
+			return false;
+		if (!i->is_zero())
+			++nonzero;
+	}
+	const exvector vars(syms.begin(), syms.end());
+	const unsigned nvars = vars.size();
+	if (5 * nonzero <= n * n && nvars > max_sparse_vars)
+		return false;
+	std::vector<unsigned> deg(nvars);
+	unsigned long points = 1;
+	for (unsigned v = 0; v < nvars; ++v) {
+		std::vector<unsigned> row_deg(n, 0), col_deg(n, 0);
+		for (unsigned r = 0; r < n; ++r)
+			for (unsigned c = 0; c < n; ++c) {
+				const unsigned d = m[r*n+c].degree(vars[v]);
+				row_deg[r] = std::max(row_deg[r], d);
+				col_deg[c] = std::max(col_deg[c], d);
+			}
+		unsigned long row_sum = 0, col_sum = 0;
+		for (unsigned i = 0; i < n; ++i) {
+			row_sum += row_deg[i];
+			col_sum += col_deg[i];
+		}
+		deg[v] = std::min(row_sum, col_sum);
+		points *= deg[v] + 1;
+		if (points > max_points)
+			return false;
+	}
+
+	// Make the rows integral and store the terms of the elements.
+	std::vector<cln::cl_I> coeffs;
+	std::vector<unsigned> exps;
+	std::vector<size_t> start;
+	std::vector<cln::cl_I> norms(m.size(), 0);  // sums of the absolute values of the coefficients
+	cln::cl_I scale = 1;
+	exvector terms;
+	std::vector<size_t> row_terms(n + 1);
+	for (unsigned r = 0; r < n; ++r) {
+		terms.clear();
+		for (unsigned c = 0; c < n; ++c) {
+			row_terms[c] = terms.size();
+			collect_terms(m[r*n+c].expand(), terms);
+		}
+		row_terms[n] = terms.size();
+		numeric l = *_num1_p;
+		for (exvector::const_iterator t = terms.begin(); t != terms.end(); ++t)
+			l = lcm(l, term_coeff(*t).denom());
+		scale = scale * cln::the<cln::cl_I>(l.to_cl_N());
+
+		for (unsigned c = 0; c < n; ++c) {
+			start.push_back(coeffs.size());
+			for (size_t t = row_terms[c]; t < row_terms[c+1]; ++t) {
+				const cln::cl_I co = cln::the<cln::cl_I>((term_coeff(terms[t]) * l).to_cl_N());
+				coeffs.push_back(co);
+				norms[r*n+c] = norms[r*n+c] + cln::abs(co);
+				for (unsigned v = 0; v < nvars; ++v)
+					exps.push_back(terms[t].degree(vars[v]));
+			}
+		}
+	}
+	start.push_back(coeffs.size());
+
+	// The coefficients of the determinant are bounded by the products of
+	// the row (column) sums of the norms.
+	cln::cl_I row_bound = 1, col_bound = 1;
+	for (unsigned i = 0; i < n; ++i) {
+		cln::cl_I row_sum = 0, col_sum = 0;
+		for (unsigned j = 0; j < n; ++j) {
+			row_sum = row_sum + norms[i*n+j];
+			col_sum = col_sum + norms[j*n+i];
+		}
+		row_bound = row_bound * row_sum;
+		col_bound = col_bound * col_sum;
+	}
+	const cln::cl_I bound = row_bound < col_bound ? row_bound : col_bound;
+	if (cln::zerop(bound)) {
+		det = _ex0;
+		return true;
+	}
+
+	std::vector<long> primes;
+	primes_factory next_prime;
+	const unsigned long bits = cln::integer_length(bound) + 2;
+	for (unsigned long b = 0; b < bits; ) {
+		long p;
+		if (!next_prime(p, cln::cl_I(1)))
+			throw std::runtime_error("interpolation_determinant(): out of primes");
+		primes.push_back(p);
+		b += log2_floor(p);
+	}
+
+	determinant_interpolation interp(n, deg, coeffs, exps, start);
+	interp.compute(primes);
+
+	// reconstruct the coefficients
+	const cln::word_cra cra(primes);
+	const numeric nscale(scale);
+	std::vector<long> residues(primes.size());
+	std::vector<unsigned> e(nvars, 0);
+	exvector result;
+	for (;;) {
+		const size_t i = interp.index(e);
+		for (size_t k = 0; k < primes.size(); ++k)
+			residues[k] = interp.image(k)[i];
+		const cln::cl_I co = cra(residues);
+		if (!cln::zerop(co)) {
+			ex term = numeric(co) / nscale;
+			for (unsigned v = 0; v < nvars; ++v)
+				if (e[v] != 0)
+					term *= pow(vars[v], e[v]);
+			result.push_back(term);
+		}
+		// next exponent vector
+		unsigned v = nvars;
+		while (v != 0 && e[v-1] == deg[v-1])
+			e[--v] = 0;
+		if (v == 0)
+			break;
+		++e[v-1];
+	}
+	det = (new add(result))->setflag(status_flags::dynallocated);
+	return true;
+}
+
+} // namespace GiNaC
@@ -0,0 +1,90 @@
+/** @file matrix_modular.h
+ *
+ *  Interface to the multi-modular computation of determinants and
+ *  solutions of linear systems of integer matrices. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_MATRIX_MODULAR_H
+#define GINAC_MATRIX_MODULAR_H
+
+#include "ex.h"
+
+#include <cln/integer.h>
+#include <cln/rational.h>
+#include <vector>
+
+namespace GiNaC {
+
+/** Exact matrices of numbers with at least this many rows are handled by
+ *  the modular algorithms when the algorithm is chosen automatically. */
+const unsigned modular_matrix_threshold = 20;
+
+/** Determinant of the n x n integer matrix a, stored in row-major order.
+ *  It is computed modulo as many word-size primes as Hadamard's bound
+ *  requires and reconstructed by Chinese remaindering. */
+cln::cl_I modular_determinant(const std::vector<cln::cl_I> & a, unsigned n);
+
+/** Solve the linear system with the n x (n+q) augmented integer matrix aug,
+ *  stored in row-major order: the first n columns form the coefficient
+ *  matrix, the remaining q ones the right hand sides.  The n x q solution
+ *  is stored in x in row-major order.  Returns false if the coefficient
+ *  matrix is singular.  Primes modulo which it is singular are replaced by
+ *  others; after a few of them the matrix is taken for singular.
+ *
+ *  Images modulo further primes are added until the reconstructed
+ *  solution satisfies the system or the number of primes is sufficient
+ *  according to Hadamard's bound. */
+bool modular_solve(const std::vector<cln::cl_I> & aug, unsigned n, unsigned q,
+                   std::vector<cln::cl_RA> & x);
+
+/** Determinants of matrices of polynomials which need at most this many
+ *  evaluation points are computed by interpolation when the algorithm is
+ *  chosen automatically. */
+const unsigned long interpolation_max_points = 100000;
+
+/** When the algorithm is chosen automatically, the grid for an n x n matrix
+ *  of polynomials may also have at most this many points per term of the
+ *  full expansion of the determinant, n!, which bounds the work of minor
+ *  expansion.  This leaves matrices in many independent variables, such as
+ *  the generic 4 x 4 matrix with a grid of 2^16 points, to the other
+ *  algorithms. */
+const unsigned long interpolation_points_per_term = 64;
+
+/** Sparse matrices of polynomials in more variables than this are left to
+ *  minor expansion or fraction-free elimination when the algorithm is
+ *  chosen automatically, since they are much cheaper there than on the
+ *  dense grid. */
+const unsigned interpolation_max_sparse_vars = 2;
+
+/** Determinant of the n x n matrix m, stored in row-major order, whose
+ *  elements are polynomials with rational coefficients.  It is evaluated
+ *  modulo word-size primes at integer points of a grid large enough for
+ *  the degree bounds derived from the elements, interpolated by Newton's
+ *  method one variable after the other and reconstructed by Chinese
+ *  remaindering.  Returns false if some element is not a polynomial in
+ *  symbols, if the grid would have more than max_points points, or if at
+ *  most a fifth of the elements are nonzero and there are more than
+ *  max_sparse_vars variables. */
+bool interpolation_determinant(const exvector & m, unsigned n, unsigned long max_points,
+                               unsigned max_sparse_vars, ex & det);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_MATRIX_MODULAR_H
@@ -31,6 +31,7 @@
 #include "utils.h"
 #include "symbol.h"
 #include "compiler.h"
+#include "parallel.h"
 
 #include <iostream>
 #include <limits>
@@ -89,11 +90,17 @@ mul::mul(const epvector & v, const ex & oc, bool do_index_renaming)
 	GINAC_ASSERT(is_canonical());
 }
 
-mul::mul(std::auto_ptr<epvector> vp, const ex & oc, bool do_index_renaming)
+mul::mul(epvector && vp)
+{
+	overall_coeff = _ex1;
+	construct_from_epvector(std::move(vp));
+	GINAC_ASSERT(is_canonical());
+}
+
+mul::mul(epvector && vp, const ex & oc, bool do_index_renaming)
 {
-	GINAC_ASSERT(vp.get()!=0);
 	overall_coeff = oc;
-	construct_from_epvector(*vp, do_index_renaming);
+	construct_from_epvector(std::move(vp), do_index_renaming);
 	GINAC_ASSERT(is_canonical());
 }
 
@@ -496,10 +503,10 @@ ex mul::coeff(const ex & s, int n) const
  *  @param level cut-off in recursive evaluation */
 ex mul::eval(int level) const
 {
-	std::auto_ptr<epvector> evaled_seqp = evalchildren(level);
-	if (evaled_seqp.get()) {
+	epvector evaled_seqp = evalchildren(level);
+	if (!evaled_seqp.empty()) {
 		// do more evaluation later
-		return (new mul(evaled_seqp, overall_coeff))->
+		return (new mul(std::move(evaled_seqp), overall_coeff))->
 		           setflag(status_flags::dynallocated);
 	}
 	
@@ -524,14 +531,14 @@ ex mul::eval(int level) const
 	           ex_to<numeric>((*seq.begin()).coeff).is_equal(*_num1_p)) {
 		// *(+(x,y,...);c) -> +(*(x,c),*(y,c),...) (c numeric(), no powers of +())
 		const add & addref = ex_to<add>((*seq.begin()).rest);
-		std::auto_ptr<epvector> distrseq(new epvector);
-		distrseq->reserve(addref.seq.size());
+		epvector distrseq;
+		distrseq.reserve(addref.seq.size());
 		epvector::const_iterator i = addref.seq.begin(), end = addref.seq.end();
 		while (i != end) {
-			distrseq->push_back(addref.combine_pair_with_coeff_to_pair(*i, overall_coeff));
+			distrseq.push_back(addref.combine_pair_with_coeff_to_pair(*i, overall_coeff));
 			++i;
 		}
-		return (new add(distrseq,
+		return (new add(std::move(distrseq),
 		                ex_to<numeric>(addref.overall_coeff).
 		                mul_dyn(ex_to<numeric>(overall_coeff)))
 		       )->setflag(status_flags::dynallocated | status_flags::evaluated);
@@ -542,7 +549,7 @@ ex mul::eval(int level) const
 		epvector::const_iterator last = seq.end();
 		epvector::const_iterator i = seq.begin();
 		epvector::const_iterator j = seq.begin();
-		std::auto_ptr<epvector> s(new epvector);
+		epvector s;
 		numeric oc = *_num1_p;
 		bool something_changed = false;
 		while (i!=last) {
@@ -569,12 +576,12 @@ ex mul::eval(int level) const
 			}
 
 			if (! something_changed) {
-				s->reserve(seq_size);
+				s.reserve(seq_size);
 				something_changed = true;
 			}
 
 			while ((j!=i) && (j!=last)) {
-				s->push_back(*j);
+				s.push_back(*j);
 				++j;
 			}
 
@@ -592,17 +599,17 @@ ex mul::eval(int level) const
 			for (epvector::iterator ai = primitive->seq.begin(); ai != primitive->seq.end(); ++ai)
 				ai->coeff = ex_to<numeric>(ai->coeff).div_dyn(c);
 			
-			s->push_back(expair(*primitive, _ex1));
+			s.push_back(expair(*primitive, _ex1));
 
 			++i;
 			++j;
 		}
 		if (something_changed) {
 			while (j!=last) {
-				s->push_back(*j);
+				s.push_back(*j);
 				++j;
 			}
-			return (new mul(s, ex_to<numeric>(overall_coeff).mul_dyn(oc))
+			return (new mul(std::move(s), ex_to<numeric>(overall_coeff).mul_dyn(oc))
 			       )->setflag(status_flags::dynallocated);
 		}
 	}
@@ -618,13 +625,13 @@ ex mul::evalf(int level) const
 	if (level==-max_recursion_level)
 		throw(std::runtime_error("max recursion level reached"));
 	
-	std::auto_ptr<epvector> s(new epvector);
-	s->reserve(seq.size());
+	epvector s;
+	s.reserve(seq.size());
 
 	--level;
 	epvector::const_iterator i = seq.begin(), end = seq.end();
 	while (i != end) {
-		s->push_back(combine_ex_with_coeff_to_pair(i->rest.evalf(level),
+		s.push_back(combine_ex_with_coeff_to_pair(i->rest.evalf(level),
 		                                           i->coeff));
 		++i;
 	}
@@ -676,8 +683,8 @@ ex mul::evalm() const
 	// Evaluate children first, look whether there are any matrices at all
 	// (there can be either no matrices or one matrix; if there were more
 	// than one matrix, it would be a non-commutative product)
-	std::auto_ptr<epvector> s(new epvector);
-	s->reserve(seq.size());
+	epvector s;
+	s.reserve(seq.size());
 
 	bool have_matrix = false;
 	epvector::iterator the_matrix;
@@ -685,10 +692,10 @@ ex mul::evalm() const
 	epvector::const_iterator i = seq.begin(), end = seq.end();
 	while (i != end) {
 		const ex &m = recombine_pair_to_ex(*i).evalm();
-		s->push_back(split_ex_to_pair(m));
+		s.push_back(split_ex_to_pair(m));
 		if (is_a<matrix>(m)) {
 			have_matrix = true;
-			the_matrix = s->end() - 1;
+			the_matrix = s.end() - 1;
 		}
 		++i;
 	}
@@ -698,12 +705,12 @@ ex mul::evalm() const
 		// The product contained a matrix. We will multiply all other factors
 		// into that matrix.
 		matrix m = ex_to<matrix>(the_matrix->rest);
-		s->erase(the_matrix);
-		ex scalar = (new mul(s, overall_coeff))->setflag(status_flags::dynallocated);
+		s.erase(the_matrix);
+		ex scalar = (new mul(std::move(s), overall_coeff))->setflag(status_flags::dynallocated);
 		return m.mul_scalar(scalar);
 
 	} else
-		return (new mul(s, overall_coeff))->setflag(status_flags::dynallocated);
+		return (new mul(std::move(s), overall_coeff))->setflag(status_flags::dynallocated);
 }
 
 ex mul::eval_ncmul(const exvector & v) const
@@ -994,9 +1001,9 @@ ex mul::thisexpairseq(const epvector & v, const ex & oc, bool do_index_renaming)
 	return (new mul(v, oc, do_index_renaming))->setflag(status_flags::dynallocated);
 }
 
-ex mul::thisexpairseq(std::auto_ptr<epvector> vp, const ex & oc, bool do_index_renaming) const
+ex mul::thisexpairseq(epvector && vp, const ex & oc, bool do_index_renaming) const
 {
-	return (new mul(vp, oc, do_index_renaming))->setflag(status_flags::dynallocated);
+	return (new mul(std::move(vp), oc, do_index_renaming))->setflag(status_flags::dynallocated);
 }
 
 expair mul::split_ex_to_pair(const ex & e) const
@@ -1109,6 +1116,130 @@ bool mul::can_be_further_expanded(const ex & e)
 	return false;
 }
 
+namespace {
+
+#ifdef GINAC_THREAD_SAFE
+
+/** Products of sums with fewer pairs of terms are always multiplied out by
+ *  the calling thread. */
+const size_t parallel_expand_threshold = 40000;
+
+/** Check whether all numbers in e are integers which CLN stores as immediate
+ *  values.  Only those can be shared between threads, because CLN's own
+ *  reference counting is not atomic. */
+bool has_only_immediate_numbers(const ex & e)
+{
+	if (is_exactly_a<numeric>(e)) {
+		const numeric & n = ex_to<numeric>(e);
+		return n.is_integer() && n.int_length() < cl_value_len;
+	}
+	for (size_t i=0; i<e.nops(); ++i)
+		if (!has_only_immediate_numbers(e.op(i)))
+			return false;
+	return true;
+}
+
+/** Return a copy of the rational number c that shares no CLN storage with c. */
+ex unshared_copy(const ex & c)
+{
+	const numeric & n = ex_to<numeric>(c);
+	const numeric num = n.numer().add(*_num1_p).sub(*_num1_p);
+	if (n.is_integer())
+		return num;
+	const numeric den = n.denom().add(*_num1_p).sub(*_num1_p);
+	return num.div(den);
+}
+
+/** Multiplies one chunk of the terms of the second sum with all terms of the
+ *  first sum and combines like terms, yielding one partial sum per chunk.
+ *  Each thread slot uses its own copy of the first sum. */
+class multiply_sums_task : public parallel_task {
+public:
+	multiply_sums_task(const std::vector<epvector> & s1, const epvector & s2, size_t nchunks)
+	 : seq1(s1), seq2(s2), chunk_size((s2.size() + nchunks - 1) / nchunks), partial(nchunks) {}
+
+	void run(size_t i, unsigned slot)
+	{
+		const epvector & terms1 = seq1[slot];
+		const size_t end = std::min((i + 1) * chunk_size, seq2.size());
+		const size_t begin = std::min(i * chunk_size, end);
+		numeric oc(*_num0_p);
+		epvector distrseq;
+		distrseq.reserve((end - begin) * terms1.size());
+		for (size_t j=begin; j<end; ++j) {
+			const expair & t2 = seq2[j];
+			for (epvector::const_iterator i1=terms1.begin(); i1!=terms1.end(); ++i1) {
+				// Don't push_back expairs which might have a rest that evaluates to a numeric,
+				// since that would violate an invariant of expairseq:
+				const ex rest = (new mul(i1->rest, t2.rest))->setflag(status_flags::dynallocated);
+				if (is_exactly_a<numeric>(rest))
+					oc += ex_to<numeric>(rest).mul(ex_to<numeric>(i1->coeff).mul(ex_to<numeric>(t2.coeff)));
+				else
+					distrseq.push_back(expair(rest, ex_to<numeric>(i1->coeff).mul_dyn(ex_to<numeric>(t2.coeff))));
+			}
+		}
+		partial[i] = (new add(std::move(distrseq), oc))->setflag(status_flags::dynallocated);
+	}
+
+	const std::vector<epvector> & seq1;
+	const epvector & seq2;
+	const size_t chunk_size;
+	exvector partial;    ///< one partial sum per chunk
+};
+
+#endif // def GINAC_THREAD_SAFE
+
+/** Multiply out all terms of two sums (given by their sequences, without
+ *  overall coefficients) using several threads and add the result to accu.
+ *
+ *  @return false if the product is too small or cannot safely be computed
+ *  by several threads, in which case accu is left unchanged */
+bool multiply_sums_parallel(const epvector & seq1, const epvector & seq2, ex & accu)
+{
+#ifdef GINAC_THREAD_SAFE
+	const unsigned nthreads = get_parallel_threads();
+	if (nthreads < 2 || seq1.size() * seq2.size() < parallel_expand_threshold)
+		return false;
+
+	for (epvector::const_iterator i=seq1.begin(); i!=seq1.end(); ++i)
+		if (!i->coeff.info(info_flags::rational) || !has_only_immediate_numbers(i->rest))
+			return false;
+	for (epvector::const_iterator i=seq2.begin(); i!=seq2.end(); ++i)
+		if (!i->coeff.info(info_flags::rational) || !has_only_immediate_numbers(i->rest))
+			return false;
+
+	// The coefficients may be bignums, so every thread slot gets its own
+	// copy of the first sum and every term of the second sum is copied once.
+	std::vector<epvector> seq1_copies(nthreads);
+	for (unsigned t=0; t<nthreads; ++t) {
+		seq1_copies[t].reserve(seq1.size());
+		for (epvector::const_iterator i=seq1.begin(); i!=seq1.end(); ++i)
+			seq1_copies[t].push_back(expair(i->rest, unshared_copy(i->coeff)));
+	}
+	epvector seq2_copy;
+	seq2_copy.reserve(seq2.size());
+	for (epvector::const_iterator i=seq2.begin(); i!=seq2.end(); ++i)
+		seq2_copy.push_back(expair(i->rest, unshared_copy(i->coeff)));
+
+	// Use more chunks than threads, so that threads finishing early can
+	// pick up the remaining ones.
+	const size_t nchunks = std::min(seq2.size(), size_t(4) * nthreads);
+	multiply_sums_task task(seq1_copies, seq2_copy, nchunks);
+	parallel_for(nchunks, task, nthreads);
+
+	exvector terms;
+	terms.reserve(nchunks + 1);
+	terms.push_back(accu);
+	terms.insert(terms.end(), task.partial.begin(), task.partial.end());
+	accu = (new add(terms))->setflag(status_flags::dynallocated);
+	return true;
+#else
+	return false;
+#endif
+}
+
+} // anonymous namespace
+
 ex mul::expand(unsigned options) const
 {
 	{
@@ -1130,8 +1261,8 @@ ex mul::expand(unsigned options) const
 	const bool skip_idx_rename = !(options & expand_options::expand_rename_idx);
 
 	// First, expand the children
-	std::auto_ptr<epvector> expanded_seqp = expandchildren(options);
-	const epvector & expanded_seq = (expanded_seqp.get() ? *expanded_seqp : seq);
+	epvector expanded_seqp = expandchildren(options);
+	const epvector & expanded_seq = (expanded_seqp.empty() ? seq : expanded_seqp);
 
 	// Now, look for all the factors that are sums and multiply each one out
 	// with the next one that is found while collecting the factors which are
@@ -1181,7 +1312,13 @@ ex mul::expand(unsigned options) const
 				}
 
 				// Compute the new overall coefficient and put it together:
-				ex tmp_accu = (new add(distrseq, add1.overall_coeff*add2.overall_coeff))->setflag(status_flags::dynallocated);
+				ex tmp_accu = (new add(std::move(distrseq), add1.overall_coeff*add2.overall_coeff))->setflag(status_flags::dynallocated);
+
+				if (skip_idx_rename && (options & expand_options::expand_parallel) &&
+				    multiply_sums_parallel(add1.seq, add2.seq, tmp_accu)) {
+					last_expanded = tmp_accu;
+					continue;
+				}
 
 				exvector add1_dummy_indices, add2_dummy_indices, add_indices;
 				lst dummy_subs;
@@ -1222,7 +1359,7 @@ ex mul::expand(unsigned options) const
 							distrseq2.push_back(expair(rest, ex_to<numeric>(i1->coeff).mul_dyn(ex_to<numeric>(i2->coeff))));
 						}
 					}
-					tmp_accu += (new add(distrseq2, oc))->setflag(status_flags::dynallocated);
+					tmp_accu += (new add(std::move(distrseq2), oc))->setflag(status_flags::dynallocated);
 				} 
 				last_expanded = tmp_accu;
 			} else {
@@ -1254,7 +1391,7 @@ ex mul::expand(unsigned options) const
 				factors.push_back(split_ex_to_pair(last_expanded.op(i)));
 			else
 				factors.push_back(split_ex_to_pair(rename_dummy_indices_uniquely(va, last_expanded.op(i))));
-			ex term = (new mul(factors, overall_coeff))->setflag(status_flags::dynallocated);
+			ex term = (new mul(std::move(factors), overall_coeff))->setflag(status_flags::dynallocated);
 			if (can_be_further_expanded(term)) {
 				distrseq.push_back(term.expand());
 			} else {
@@ -1269,7 +1406,7 @@ ex mul::expand(unsigned options) const
 	}
 
 	non_adds.push_back(split_ex_to_pair(last_expanded));
-	ex result = (new mul(non_adds, overall_coeff))->setflag(status_flags::dynallocated);
+	ex result = (new mul(std::move(non_adds), overall_coeff))->setflag(status_flags::dynallocated);
 	if (can_be_further_expanded(result)) {
 		return result.expand();
 	} else {
@@ -1296,9 +1433,9 @@ ex mul::expand(unsigned options) const
  *  to allow for early cancallations and thus safe memory.
  *
  *  @see mul::expand()
- *  @return pointer to epvector containing expanded representation or zero
- *  pointer, if sequence is unchanged. */
-std::auto_ptr<epvector> mul::expandchildren(unsigned options) const
+ *  @return epvector containing expanded representation, empty if sequence
+ *    is unchanged. */
+epvector mul::expandchildren(unsigned options) const
 {
 	const epvector::const_iterator last = seq.end();
 	epvector::const_iterator cit = seq.begin();
@@ -1308,23 +1445,23 @@ std::auto_ptr<epvector> mul::expandchildren(unsigned options) const
 		if (!are_ex_trivially_equal(factor,expanded_factor)) {
 			
 			// something changed, copy seq, eval and return it
-			std::auto_ptr<epvector> s(new epvector);
-			s->reserve(seq.size());
+			epvector s;
+			s.reserve(seq.size());
 			
 			// copy parts of seq which are known not to have changed
 			epvector::const_iterator cit2 = seq.begin();
 			while (cit2!=cit) {
-				s->push_back(*cit2);
+				s.push_back(*cit2);
 				++cit2;
 			}
 
 			// copy first changed element
-			s->push_back(split_ex_to_pair(expanded_factor));
+			s.push_back(split_ex_to_pair(expanded_factor));
 			++cit2;
 
 			// copy rest
 			while (cit2!=last) {
-				s->push_back(split_ex_to_pair(recombine_pair_to_ex(*cit2).expand(options)));
+				s.push_back(split_ex_to_pair(recombine_pair_to_ex(*cit2).expand(options)));
 				++cit2;
 			}
 			return s;
@@ -1332,7 +1469,7 @@ std::auto_ptr<epvector> mul::expandchildren(unsigned options) const
 		++cit;
 	}
 	
-	return std::auto_ptr<epvector>(0); // nothing has changed
+	return epvector(); // nothing has changed
 }
 
 GINAC_BIND_UNARCHIVER(mul);
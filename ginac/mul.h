@@ -42,7 +42,8 @@ public:
 	mul(const exvector & v);
 	mul(const epvector & v);
 	mul(const epvector & v, const ex & oc, bool do_index_renaming = false);
-	mul(std::auto_ptr<epvector> vp, const ex & oc, bool do_index_renaming = false);
+	mul(epvector && vp);
+	mul(epvector && vp, const ex & oc, bool do_index_renaming = false);
 	mul(const ex & lh, const ex & mh, const ex & rh);
 	
 	// functions overriding virtual functions from base classes
@@ -72,7 +73,7 @@ protected:
 	unsigned return_type() const;
 	return_type_t return_type_tinfo() const;
 	ex thisexpairseq(const epvector & v, const ex & oc, bool do_index_renaming = false) const;
-	ex thisexpairseq(std::auto_ptr<epvector> vp, const ex & oc, bool do_index_renaming = false) const;
+	ex thisexpairseq(epvector && vp, const ex & oc, bool do_index_renaming = false) const;
 	expair split_ex_to_pair(const ex & e) const;
 	expair combine_ex_with_coeff_to_pair(const ex & e, const ex & c) const;
 	expair combine_pair_with_coeff_to_pair(const expair & p, const ex & c) const;
@@ -98,7 +99,7 @@ protected:
 	void do_print_csrc(const print_csrc & c, unsigned level) const;
 	void do_print_python_repr(const print_python_repr & c, unsigned level) const;
 	static bool can_be_further_expanded(const ex & e);
-	std::auto_ptr<epvector> expandchildren(unsigned options) const;
+	epvector expandchildren(unsigned options) const;
 };
 GINAC_DECLARE_UNARCHIVER(mul);
 
@@ -41,7 +41,11 @@
 #include "pseries.h"
 #include "symbol.h"
 #include "utils.h"
+#include "normal_cache.h"
 #include "polynomial/chinrem_gcd.h"
+#include "polynomial/modp_poly.h"
+#include "polynomial/sparse_poly.h"
+#include "polynomial/sparse_gcd.h"
 
 #include <algorithm>
 #include <map>
@@ -68,6 +72,7 @@ namespace GiNaC {
 #if STATISTICS
 // Statistics variables
 static int gcd_called = 0;
+static int gcd_cache_hits = 0;
 static int sr_gcd_called = 0;
 static int heur_gcd_called = 0;
 static int heur_gcd_failed = 0;
@@ -77,6 +82,7 @@ static struct _stat_print {
 	_stat_print() {}
 	~_stat_print() {
 		std::cout << "gcd() called " << gcd_called << " times\n";
+		std::cout << "gcd() found " << gcd_cache_hits << " results in the cache\n";
 		std::cout << "sr_gcd() called " << sr_gcd_called << " times\n";
 		std::cout << "heur_gcd() called " << heur_gcd_called << " times\n";
 		std::cout << "heur_gcd() failed " << heur_gcd_failed << " times\n";
@@ -578,16 +584,10 @@ ex sprem(const ex &a, const ex &b, const ex &x, bool check_args)
 }
 
 
-/** Exact polynomial division of a(X) by b(X) in Q[X].
- *  
- *  @param a  first multivariate polynomial (dividend)
- *  @param b  second multivariate polynomial (divisor)
- *  @param q  quotient (returned)
- *  @param check_args  check whether a and b are polynomials with rational
- *         coefficients (defaults to "true")
- *  @return "true" when exact division succeeds (quotient returned in q),
- *          "false" otherwise (q left untouched) */
-bool divide(const ex &a, const ex &b, ex &q, bool check_args)
+/** Exact polynomial division of a(X) by b(X) in Q[X], bypassing the cache
+ *  of results.
+ *  @see divide */
+static bool divide_nocache(const ex &a, const ex &b, ex &q, bool check_args)
 {
 	if (b.is_zero())
 		throw(std::overflow_error("divide: division by zero"));
@@ -682,6 +682,11 @@ bool divide(const ex &a, const ex &b, ex &q, bool check_args)
 //		} // ... so we *really* need to expand expression.
 	}
 	
+	// Heap division in sparse distributed representation
+	bool divisible;
+	if (sparse_divide(a, b, q, divisible))
+		return divisible;
+
 	// Polynomial long division (recursive)
 	ex r = a.expand();
 	if (r.is_zero()) {
@@ -713,6 +718,39 @@ bool divide(const ex &a, const ex &b, ex &q, bool check_args)
 }
 
 
+/** Exact polynomial division of a(X) by b(X) in Q[X].
+ *  
+ *  @param a  first multivariate polynomial (dividend)
+ *  @param b  second multivariate polynomial (divisor)
+ *  @param q  quotient (returned)
+ *  @param check_args  check whether a and b are polynomials with rational
+ *         coefficients (defaults to "true")
+ *  @return "true" when exact division succeeds (quotient returned in q),
+ *          "false" otherwise (q left untouched) */
+bool divide(const ex &a, const ex &b, ex &q, bool check_args)
+{
+	if (!normal_cache::is_enabled() || is_exactly_a<numeric>(a) || is_exactly_a<numeric>(b))
+		return divide_nocache(a, b, q, check_args);
+
+	if (check_args && (!a.info(info_flags::rational_polynomial) ||
+	                   !b.info(info_flags::rational_polynomial)))
+		throw(std::invalid_argument("divide: arguments must be polynomials over the rationals"));
+
+	// The cached result is empty if a is not divisible by b
+	exvector result;
+	if (!normal_cache::lookup(normal_cache::divide_results, a, b, 0, result)) {
+		ex quo;
+		if (divide_nocache(a, b, quo, false))
+			result.push_back(quo);
+		normal_cache::insert(normal_cache::divide_results, a, b, 0, result);
+	}
+	if (result.empty())
+		return false;
+	q = result[0];
+	return true;
+}
+
+
 #if USE_REMEMBER
 /*
  *  Remembering
@@ -807,6 +845,14 @@ static bool divide_in_z(const ex &a, const ex &b, ex &q, sym_desc_vec::const_ite
 		return true;
 	}
 
+	bool divisible;
+	if (sparse_divide(a, b, q, divisible, true)) {
+#if USE_REMEMBER
+		dr_remember[ex2(a, b)] = exbool(q, divisible);
+#endif
+		return divisible;
+	}
+
 	// Main symbol
 	const ex &x = var->sym;
 
@@ -1226,7 +1272,7 @@ ex add::smod(const numeric &xi) const
 	}
 	GINAC_ASSERT(is_exactly_a<numeric>(overall_coeff));
 	numeric coeff = GiNaC::smod(ex_to<numeric>(overall_coeff), xi);
-	return (new add(newseq,coeff))->setflag(status_flags::dynallocated);
+	return (new add(std::move(newseq), coeff))->setflag(status_flags::dynallocated);
 }
 
 ex mul::smod(const numeric &xi) const
@@ -1425,23 +1471,34 @@ static ex gcd_pf_pow(const ex& a, const ex& b, ex* ca, ex* cb);
 // large expressions). At least one of the arguments should be a product.
 static ex gcd_pf_mul(const ex& a, const ex& b, ex* ca, ex* cb);
 
-/** Compute GCD (Greatest Common Divisor) of multivariate polynomials a(X)
- *  and b(X) in Z[X]. Optionally also compute the cofactors of a and b,
- *  defined by a = ca * gcd(a, b) and b = cb * gcd(a, b).
- *
- *  @param a  first multivariate polynomial
- *  @param b  second multivariate polynomial
- *  @param ca pointer to expression that will receive the cofactor of a, or NULL
- *  @param cb pointer to expression that will receive the cofactor of b, or NULL
- *  @param check_args  check whether a and b are polynomials with rational
- *         coefficients (defaults to "true")
- *  @return the GCD as a new expression */
-ex gcd(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned options)
+/** GCDs of polynomials in at least this number of variables are computed
+ *  by sparse_gcd() if the polynomials are sparse. */
+static const size_t sparse_gcd_min_vars = 3;
+
+/** Polynomials are considered sparse if they have at most one term in this
+ *  many terms of the dense polynomials with the same degrees. */
+static const double sparse_gcd_density = 8;
+
+/** Decide whether the GCD of the expanded polynomials a and b should be
+ *  computed by sparse_gcd(). */
+static bool is_sparse_gcd_problem(const ex &a, const ex &b, const sym_desc_vec &sym_stats)
 {
-#if STATISTICS
-	gcd_called++;
-#endif
+	if (sym_stats.size() < sparse_gcd_min_vars)
+		return false;
+	double dense_a = 1, dense_b = 1;
+	for (sym_desc_vec::const_iterator it = sym_stats.begin(); it != sym_stats.end(); ++it) {
+		dense_a *= it->deg_a + 1;
+		dense_b *= it->deg_b + 1;
+	}
+	const double terms_a = is_exactly_a<add>(a) ? a.nops() : 1;
+	const double terms_b = is_exactly_a<add>(b) ? b.nops() : 1;
+	return terms_a*sparse_gcd_density <= dense_a && terms_b*sparse_gcd_density <= dense_b;
+}
 
+/** Compute GCD of multivariate polynomials, bypassing the cache of results.
+ *  @see gcd */
+static ex gcd_nocache(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned options)
+{
 	// GCD of numerics -> CLN
 	if (is_exactly_a<numeric>(a) && is_exactly_a<numeric>(b)) {
 		numeric g = gcd(ex_to<numeric>(a), ex_to<numeric>(b));
@@ -1603,8 +1660,25 @@ ex gcd(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned optio
 		return g;
 	}
 
-	// Try heuristic algorithm first, fall back to PRS if that failed
+	// Sparse multivariate polynomials are best handled by Zippel's algorithm
 	ex g;
+	if (!(options & (gcd_options::no_sparse_gcd | gcd_options::use_sr_gcd)) &&
+	    is_sparse_gcd_problem(aex, bex, sym_stats)) {
+		exvector vars;
+		for (std::size_t n = sym_stats.size(); n-- != 0; )
+			vars.push_back(sym_stats[n].sym);
+		if (sparse_gcd(aex, bex, vars, g, ca, cb)) {
+			if (g.is_equal(_ex1)) {
+				if (ca)
+					*ca = a;
+				if (cb)
+					*cb = b;
+			}
+			return g;
+		}
+	}
+
+	// Try heuristic algorithm first, fall back to PRS if that failed
 	if (!(options & gcd_options::no_heur_gcd)) {
 		bool found = heur_gcd(g, aex, bex, ca, cb, var);
 		if (found) {
@@ -1648,6 +1722,55 @@ ex gcd(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned optio
 	return g;
 }
 
+/** Compute GCD (Greatest Common Divisor) of multivariate polynomials a(X)
+ *  and b(X) in Z[X]. Optionally also compute the cofactors of a and b,
+ *  defined by a = ca * gcd(a, b) and b = cb * gcd(a, b).
+ *
+ *  @param a  first multivariate polynomial
+ *  @param b  second multivariate polynomial
+ *  @param ca pointer to expression that will receive the cofactor of a, or NULL
+ *  @param cb pointer to expression that will receive the cofactor of b, or NULL
+ *  @param check_args  check whether a and b are polynomials with rational
+ *         coefficients (defaults to "true")
+ *  @return the GCD as a new expression */
+ex gcd(const ex &a, const ex &b, ex *ca, ex *cb, bool check_args, unsigned options)
+{
+#if STATISTICS
+	gcd_called++;
+#endif
+
+	if (!normal_cache::is_enabled() || (is_exactly_a<numeric>(a) && is_exactly_a<numeric>(b)))
+		return gcd_nocache(a, b, ca, cb, check_args, options);
+
+	if (check_args && (!a.info(info_flags::rational_polynomial) || !b.info(info_flags::rational_polynomial))) {
+		throw(std::invalid_argument("gcd: arguments must be polynomials over the rationals"));
+	}
+
+	// Results with and without cofactors are cached separately
+	const bool cofactors = ca || cb;
+	const unsigned flags = (options << 1) | cofactors;
+	exvector result;
+	if (!normal_cache::lookup(normal_cache::gcd_results, a, b, flags, result)) {
+		ex cofactor_a, cofactor_b;
+		if (cofactors) {
+			result.push_back(gcd_nocache(a, b, &cofactor_a, &cofactor_b, false, options));
+			result.push_back(cofactor_a);
+			result.push_back(cofactor_b);
+		} else
+			result.push_back(gcd_nocache(a, b, 0, 0, false, options));
+		normal_cache::insert(normal_cache::gcd_results, a, b, flags, result);
+	}
+#if STATISTICS
+	else
+		gcd_cache_hits++;
+#endif
+	if (ca)
+		*ca = result[1];
+	if (cb)
+		*cb = result[2];
+	return result[0];
+}
+
 // gcd helper to handle partially factored polynomials (to avoid expanding
 // large expressions). Both arguments should be powers.
 static ex gcd_pf_pow_pow(const ex& a, const ex& b, ex* ca, ex* cb)
@@ -2163,6 +2286,421 @@ static ex frac_cancel(const ex &n, const ex &d)
 }
 
 
+/** Look up the normal form of a sum or product in the cache of results.
+ *  Only normal forms not involving temporary symbols are cached, so
+ *  nothing is found once a subexpression has been replaced by a symbol.
+ *  @param e  sum or product
+ *  @param repl  replacements of subexpressions by temporary symbols
+ *  @param level  maximum depth of recursion
+ *  @param nd  normal form of e as a list {numerator, denominator} (returned)
+ *  @return "true" if the normal form was found */
+static bool lookup_normal(const basic &e, const exmap &repl, int level, ex &nd)
+{
+	if (!repl.empty() || !normal_cache::is_enabled())
+		return false;
+	exvector result;
+	if (!normal_cache::lookup(normal_cache::normal_results, e, _ex0, level > 0 ? level : 0, result))
+		return false;
+	nd = result[0];
+	return true;
+}
+
+/** Store the normal form of a sum or product in the cache of results,
+ *  unless it involves temporary symbols.
+ *  @see lookup_normal
+ *  @return nd */
+static ex remember_normal(const basic &e, const exmap &repl, int level, const ex &nd)
+{
+	if (repl.empty() && normal_cache::is_enabled())
+		normal_cache::insert(normal_cache::normal_results, e, _ex0, level > 0 ? level : 0, exvector(1, nd));
+	return nd;
+}
+
+
+/** Sums with at least this many terms with polynomial denominators are
+ *  brought to a common denominator by way of a coprime basis of the
+ *  denominators instead of by adding one fraction after the other. */
+static const size_t coprime_basis_min_terms = 16;
+
+/** Powers of elements of a coprime_basis: pairs of index and exponent. */
+typedef std::vector<std::pair<size_t, unsigned> > basis_powers;
+
+/** Exponents of the irreducible elements of a coprime_basis. */
+typedef std::map<size_t, unsigned> basis_exponents;
+
+/** Image of a polynomial in Z/pZ[x] for one of its variables x, obtained
+ *  by substituting fixed values for all other variables. */
+struct modular_image {
+	std::vector<uint32_t> poly;  ///< coefficients, see modp_poly.h
+	bool full_degree;            ///< the leading coefficient did not vanish
+};
+
+/** Images of a polynomial for all its variables. */
+typedef std::map<ex, modular_image, ex_is_less> modular_images;
+
+/** Coprime ("gcd-free") basis of a set of polynomials, built up one
+ *  polynomial at a time.  Every polynomial added is written as a rational
+ *  number times a product of powers of pairwise coprime elements.  An
+ *  element found to have a nontrivial gcd with a new polynomial is split;
+ *  it stays in the basis as the product of its parts, so that products
+ *  computed before remain valid.
+ *
+ *  Most elements are coprime to a new polynomial, so instead of computing
+ *  a GCD with every element, common factors are first ruled out by means
+ *  of modular images (see certainly_coprime()). */
+class coprime_basis {
+public:
+	coprime_basis() : F(2147483629u), seed(1) { }
+	numeric factor(const ex &p, basis_powers &f);
+	numeric resolve(const basis_powers &f, basis_exponents &e) const;
+	const ex &element(size_t i) const { return elements[i].poly; }
+
+private:
+	size_t add_element(const ex &p);
+	bool images(const ex &p, modular_images &im);
+	bool certainly_coprime(const modular_images &a, const modular_images &b) const;
+
+	struct element_desc {
+		ex poly;              ///< the polynomial
+		bool split;           ///< poly = coeff * product of parts
+		numeric coeff;
+		basis_powers parts;
+		bool have_images;     ///< images could be computed
+		modular_images img;
+	};
+	std::vector<element_desc> elements;
+	std::map<ex, size_t, ex_is_less> index;  ///< positions of the elements
+
+	modp_field<uint32_t> F;  ///< field of the modular images
+	std::map<ex, uint32_t, ex_is_less> points;  ///< values of the variables
+	uint32_t seed;  ///< for choosing new values
+};
+
+/** Compute the modular images of a polynomial with integer coefficients.
+ *  Returns false if p has another form. */
+bool coprime_basis::images(const ex &p, modular_images &im)
+{
+	// Terms as coefficients and exponents of the variables in vars
+	exvector vars;
+	std::map<ex, size_t, ex_is_less> var_index;
+	std::vector<uint32_t> coeffs;
+	std::vector<std::vector<std::pair<size_t, unsigned> > > exponents;
+	const size_t nterms = is_exactly_a<add>(p) ? p.nops() : 1;
+	coeffs.reserve(nterms);
+	exponents.reserve(nterms);
+	const numeric modulus(long(F.modulus()));
+	for (size_t i = 0; i < nterms; ++i) {
+		const ex &t = is_exactly_a<add>(p) ? p.op(i) : p;
+		const size_t nfactors = is_exactly_a<mul>(t) ? t.nops() : 1;
+		numeric c = *_num1_p;
+		std::vector<std::pair<size_t, unsigned> > e;
+		for (size_t k = 0; k < nfactors; ++k) {
+			const ex &f = is_exactly_a<mul>(t) ? t.op(k) : t;
+			if (is_exactly_a<numeric>(f)) {
+				c *= ex_to<numeric>(f);
+				continue;
+			}
+			const ex &x = is_exactly_a<power>(f) ? f.op(0) : f;
+			if (!is_a<symbol>(x))
+				return false;
+			unsigned n = 1;
+			if (is_exactly_a<power>(f)) {
+				if (!f.op(1).info(info_flags::posint))
+					return false;
+				n = ex_to<numeric>(f.op(1)).to_int();
+			}
+			std::map<ex, size_t, ex_is_less>::const_iterator found = var_index.find(x);
+			if (found == var_index.end()) {
+				found = var_index.insert(std::make_pair(x, vars.size())).first;
+				vars.push_back(x);
+			}
+			e.push_back(std::make_pair(found->second, n));
+		}
+		if (!c.is_integer())
+			return false;
+		coeffs.push_back(F.from_uint(uint32_t(mod(c, modulus).to_long())));
+		exponents.push_back(e);
+	}
+
+	// Values of the variables
+	std::vector<uint32_t> values(vars.size());
+	std::vector<unsigned> degrees(vars.size(), 0);
+	for (size_t v = 0; v < vars.size(); ++v) {
+		std::map<ex, uint32_t, ex_is_less>::const_iterator found = points.find(vars[v]);
+		if (found == points.end()) {
+			seed = seed * 1103515245u + 12345u;
+			const uint32_t x = F.from_uint(1 + (seed >> 1) % (F.modulus() - 1));
+			found = points.insert(std::make_pair(vars[v], x)).first;
+		}
+		values[v] = found->second;
+	}
+	for (size_t i = 0; i < exponents.size(); ++i)
+		for (size_t k = 0; k < exponents[i].size(); ++k)
+			degrees[exponents[i][k].first] = std::max(degrees[exponents[i][k].first], exponents[i][k].second);
+
+	im.clear();
+	for (size_t v = 0; v < vars.size(); ++v) {
+		modular_image &img = im[vars[v]];
+		img.poly.assign(degrees[v] + 1, F.zero());
+		for (size_t i = 0; i < exponents.size(); ++i) {
+			uint32_t c = coeffs[i];
+			unsigned n = 0;
+			for (size_t k = 0; k < exponents[i].size(); ++k) {
+				if (exponents[i][k].first == v)
+					n = exponents[i][k].second;
+				else
+					c = F.mul(c, F.pow(values[exponents[i][k].first], exponents[i][k].second));
+			}
+			img.poly[n] = F.add(img.poly[n], c);
+		}
+		modp_canonicalize(img.poly);
+		img.full_degree = img.poly.size() == degrees[v] + 1;
+	}
+	return true;
+}
+
+/** Test with modular images whether two polynomials are coprime.  A common
+ *  factor g has a positive degree in some variable x occurring in both.  If
+ *  the leading coefficient in x of one of the polynomials does not vanish
+ *  in its image, neither does the one of g, so the image of g has positive
+ *  degree and divides the images of both.  Returns false if the images do
+ *  not rule out a common factor. */
+bool coprime_basis::certainly_coprime(const modular_images &a, const modular_images &b) const
+{
+	for (modular_images::const_iterator i = a.begin(); i != a.end(); ++i) {
+		modular_images::const_iterator k = b.find(i->first);
+		if (k == b.end())
+			continue;
+		if (!i->second.full_degree && !k->second.full_degree)
+			return false;
+		std::vector<uint32_t> g;
+		modp_gcd(F, g, i->second.poly, k->second.poly);
+		if (g.size() > 1)
+			return false;
+	}
+	return true;
+}
+
+/** Write the polynomial p as c * product of powers of basis elements,
+ *  splitting elements as needed.
+ *  @param p  polynomial with integer coefficients and integer content 1
+ *  @param f  the powers of basis elements are appended to this
+ *  @return c */
+numeric coprime_basis::factor(const ex &p, basis_powers &f)
+{
+	// Most denominators recur unchanged
+	std::map<ex, size_t, ex_is_less>::const_iterator found = index.find(p);
+	if (found != index.end() && !elements[found->second].split) {
+		f.push_back(std::make_pair(found->second, 1u));
+		return *_num1_p;
+	}
+
+	numeric c = *_num1_p;
+	ex a = p;
+	modular_images a_img;
+	bool a_img_current = false, a_have_images = false;
+	for (size_t j = 0; j < elements.size() && !is_exactly_a<numeric>(a); ++j) {
+		if (elements[j].split)
+			continue;
+
+		// elements[] may be reallocated below
+		const ex b = elements[j].poly;
+		if (a.is_equal(b)) {
+			f.push_back(std::make_pair(j, 1u));
+			a = _ex1;
+			break;
+		}
+
+		if (elements[j].have_images) {
+			if (!a_img_current) {
+				a_have_images = images(a, a_img);
+				a_img_current = true;
+			}
+			if (a_have_images && certainly_coprime(a_img, elements[j].img))
+				continue;
+		}
+
+		// Divide out b as often as possible
+		ex g, ca, cb;
+		while (true) {
+			g = gcd(a, b, &ca, &cb, false);
+			if (is_exactly_a<numeric>(g) || !is_exactly_a<numeric>(cb))
+				break;
+			c /= ex_to<numeric>(cb);
+			f.push_back(std::make_pair(j, 1u));
+			a = ca;
+			a_img_current = false;
+		}
+		if (is_exactly_a<numeric>(g))
+			continue;
+
+		// Split b = g * cb.  The parts are coprime to all elements
+		// other than b, but not necessarily to each other.
+		elements[j].split = true;
+		basis_powers g_parts, b_parts;
+		numeric g_coeff = factor(g, g_parts);
+		b_parts = g_parts;
+		numeric b_coeff = g_coeff * factor(cb, b_parts);
+		elements[j].coeff = b_coeff;
+		elements[j].parts.swap(b_parts);
+
+		// a = g * ca, where ca is still to be factored
+		c *= g_coeff;
+		f.insert(f.end(), g_parts.begin(), g_parts.end());
+		a = ca;
+		a_img_current = false;
+	}
+
+	if (is_exactly_a<numeric>(a))
+		c *= ex_to<numeric>(a);
+	else
+		f.push_back(std::make_pair(add_element(a), 1u));
+	return c;
+}
+
+/** Add a polynomial coprime to all elements to the basis.
+ *  @return its index */
+size_t coprime_basis::add_element(const ex &p)
+{
+	element_desc d;
+	d.poly = p;
+	d.split = false;
+	d.have_images = images(p, d.img);
+	elements.push_back(d);
+	index[p] = elements.size() - 1;
+	return elements.size() - 1;
+}
+
+/** Write a product of powers of basis elements as c * product of powers of
+ *  elements which have not been split.
+ *  @param f  the product
+ *  @param e  the exponents of the elements are added to this
+ *  @return c */
+numeric coprime_basis::resolve(const basis_powers &f, basis_exponents &e) const
+{
+	numeric c = *_num1_p;
+	for (basis_powers::const_iterator i = f.begin(); i != f.end(); ++i) {
+		const element_desc &d = elements[i->first];
+		if (!d.split) {
+			e[i->first] += i->second;
+			continue;
+		}
+		basis_exponents parts;
+		c *= (d.coeff * resolve(d.parts, parts)).power(i->second);
+		for (basis_exponents::const_iterator k = parts.begin(); k != parts.end(); ++k)
+			e[k->first] += k->second * i->second;
+	}
+	return c;
+}
+
+/** Sum of fractions num[i]/prod(basis^exps[i]) for lo <= i < hi, computed
+ *  by divide and conquer.
+ *  @param e  exponents of the basis elements in the common denominator (returned)
+ *  @return expanded numerator over the common denominator */
+static ex sum_over_basis(const coprime_basis &basis, const exvector &num,
+                         const std::vector<basis_exponents> &exps,
+                         size_t lo, size_t hi, basis_exponents &e)
+{
+	if (hi - lo == 1) {
+		e = exps[lo];
+		return num[lo];
+	}
+
+	size_t mid = lo + (hi - lo) / 2;
+	basis_exponents e1, e2;
+	ex n1 = sum_over_basis(basis, num, exps, lo, mid, e1);
+	ex n2 = sum_over_basis(basis, num, exps, mid, hi, e2);
+
+	// Common denominator and the cofactors of both denominators
+	e = e1;
+	for (basis_exponents::const_iterator i = e2.begin(); i != e2.end(); ++i)
+		e[i->first] = std::max(e[i->first], i->second);
+	exvector co1, co2;
+	for (basis_exponents::const_iterator i = e.begin(); i != e.end(); ++i) {
+		basis_exponents::const_iterator k = e1.find(i->first);
+		unsigned d = i->second - (k == e1.end() ? 0 : k->second);
+		if (d)
+			co1.push_back(power(basis.element(i->first), d));
+		k = e2.find(i->first);
+		d = i->second - (k == e2.end() ? 0 : k->second);
+		if (d)
+			co2.push_back(power(basis.element(i->first), d));
+	}
+	co1.push_back(n1);
+	co2.push_back(n2);
+	return (ex((new mul(co1))->setflag(status_flags::dynallocated)) +
+	        ex((new mul(co2))->setflag(status_flags::dynallocated))).expand();
+}
+
+/** Add fractions by bringing them to a common denominator, which is built
+ *  from a coprime basis of the denominators.  This avoids computing a GCD
+ *  of the growing common denominator with every further denominator.
+ *  @param nums  numerators
+ *  @param dens  denominators (polynomials)
+ *  @param num  numerator of the sum, not yet cancelled (returned)
+ *  @param den  denominator of the sum, not yet cancelled (returned) */
+static void add_over_coprime_basis(const exvector &nums, const exvector &dens, ex &num, ex &den)
+{
+	coprime_basis basis;
+	std::vector<basis_powers> factorizations(nums.size());
+	std::vector<numeric> coeffs(nums.size());
+
+	for (size_t i = 0; i < nums.size(); ++i) {
+		// Take the denominator apart into powers of its factors
+		exvector factors;
+		std::vector<unsigned> multiplicities;
+		const ex &d = dens[i];
+		size_t nfactors = is_exactly_a<mul>(d) ? d.nops() : 1;
+		for (size_t k = 0; k < nfactors; ++k) {
+			const ex &f = is_exactly_a<mul>(d) ? d.op(k) : d;
+			if (is_exactly_a<power>(f) && f.op(1).info(info_flags::posint)) {
+				factors.push_back(f.op(0));
+				multiplicities.push_back(ex_to<numeric>(f.op(1)).to_int());
+			} else {
+				factors.push_back(f);
+				multiplicities.push_back(1);
+			}
+		}
+
+		numeric c = *_num1_p;
+		basis_powers &f = factorizations[i];
+		for (size_t k = 0; k < factors.size(); ++k) {
+			ex p = factors[k].expand();
+			if (is_exactly_a<numeric>(p)) {
+				c *= ex_to<numeric>(p).power(multiplicities[k]);
+				continue;
+			}
+			numeric content = p.integer_content();
+			basis_powers pf;
+			numeric pc = content * basis.factor((p * content.inverse()).expand(), pf);
+			c *= pc.power(multiplicities[k]);
+			for (basis_powers::const_iterator j = pf.begin(); j != pf.end(); ++j)
+				f.push_back(std::make_pair(j->first, j->second * multiplicities[k]));
+		}
+
+		coeffs[i] = c;
+	}
+
+	// Elements may have been split after a denominator was factored, so
+	// only now express the denominators by elements which are coprime
+	exvector scaled_nums;
+	scaled_nums.reserve(nums.size());
+	std::vector<basis_exponents> exps(nums.size());
+	for (size_t i = 0; i < nums.size(); ++i) {
+		numeric c = coeffs[i] * basis.resolve(factorizations[i], exps[i]);
+		scaled_nums.push_back((nums[i] * c.inverse()).expand());
+	}
+
+	basis_exponents e;
+	num = sum_over_basis(basis, scaled_nums, exps, 0, nums.size(), e);
+	exvector den_factors;
+	den_factors.reserve(e.size());
+	for (basis_exponents::const_iterator i = e.begin(); i != e.end(); ++i)
+		den_factors.push_back(power(basis.element(i->first), i->second));
+	den = (new mul(den_factors))->setflag(status_flags::dynallocated);
+}
+
+
 /** Implementation of ex::normal() for a sum. It expands terms and performs
  *  fractional addition.
  *  @see ex::normal */
@@ -2173,6 +2711,10 @@ ex add::normal(exmap & repl, exmap & rev_lookup, int level) const
 	else if (level == -max_recursion_level)
 		throw(std::runtime_error("max recursion level reached"));
 
+	ex cached;
+	if (lookup_normal(*this, repl, level, cached))
+		return cached;
+
 	// Normalize children and split each one into numerator and denominator
 	exvector nums, dens;
 	nums.reserve(seq.size()+1);
@@ -2193,6 +2735,17 @@ ex add::normal(exmap & repl, exmap & rev_lookup, int level) const
 	// all denominators
 //std::clog << "add::normal uses " << nums.size() << " summands:\n";
 
+	// Large sums are brought to a common denominator in one go
+	size_t fractions = 0;
+	for (exvector::const_iterator i = dens.begin(); i != dens.end(); ++i)
+		if (!is_exactly_a<numeric>(*i))
+			++fractions;
+	if (fractions >= coprime_basis_min_terms) {
+		ex num, den;
+		add_over_coprime_basis(nums, dens, num, den);
+		return remember_normal(*this, repl, level, frac_cancel(num, den));
+	}
+
 	// Add fractions sequentially
 	exvector::const_iterator num_it = nums.begin(), num_itend = nums.end();
 	exvector::const_iterator den_it = dens.begin(), den_itend = dens.end();
@@ -2218,7 +2771,7 @@ ex add::normal(exmap & repl, exmap & rev_lookup, int level) const
 //std::clog << " common denominator = " << den << std::endl;
 
 	// Cancel common factors from num/den
-	return frac_cancel(num, den);
+	return remember_normal(*this, repl, level, frac_cancel(num, den));
 }
 
 
@@ -2232,6 +2785,10 @@ ex mul::normal(exmap & repl, exmap & rev_lookup, int level) const
 	else if (level == -max_recursion_level)
 		throw(std::runtime_error("max recursion level reached"));
 
+	ex cached;
+	if (lookup_normal(*this, repl, level, cached))
+		return cached;
+
 	// Normalize children, separate into numerator and denominator
 	exvector num; num.reserve(seq.size());
 	exvector den; den.reserve(seq.size());
@@ -2248,8 +2805,9 @@ ex mul::normal(exmap & repl, exmap & rev_lookup, int level) const
 	den.push_back(n.op(1));
 
 	// Perform fraction cancellation
-	return frac_cancel((new mul(num))->setflag(status_flags::dynallocated),
-	                   (new mul(den))->setflag(status_flags::dynallocated));
+	return remember_normal(*this, repl, level,
+	                       frac_cancel((new mul(num))->setflag(status_flags::dynallocated),
+	                                   (new mul(den))->setflag(status_flags::dynallocated)));
 }
 
 
@@ -2583,10 +3141,10 @@ ex expairseq::to_rational(exmap & repl) const
 	}
 	ex oc = overall_coeff.to_rational(repl);
 	if (oc.info(info_flags::numeric))
-		return thisexpairseq(s, overall_coeff);
+		return thisexpairseq(std::move(s), overall_coeff);
 	else
 		s.push_back(combine_ex_with_coeff_to_pair(oc, _ex1));
-	return thisexpairseq(s, default_overall_coeff());
+	return thisexpairseq(std::move(s), default_overall_coeff());
 }
 
 /** Implementation of ex::to_polynomial() for expairseqs. */
@@ -2601,10 +3159,10 @@ ex expairseq::to_polynomial(exmap & repl) const
 	}
 	ex oc = overall_coeff.to_polynomial(repl);
 	if (oc.info(info_flags::numeric))
-		return thisexpairseq(s, overall_coeff);
+		return thisexpairseq(std::move(s), overall_coeff);
 	else
 		s.push_back(combine_ex_with_coeff_to_pair(oc, _ex1));
-	return thisexpairseq(s, default_overall_coeff());
+	return thisexpairseq(std::move(s), default_overall_coeff());
 }
 
 
@@ -58,7 +58,13 @@ struct gcd_options
 		 * it's much faster than PRS (pseudo remainder sequence)
 		 * algorithm. This flag forces GiNaC to use PRS algorithm
 		 */
-		use_sr_gcd = 8
+		use_sr_gcd = 8,
+		/**
+		 * Sparse polynomials in several variables are handled by
+		 * Zippel's sparse modular algorithm before any other one.
+		 * This flag disables it.
+		 */
+		no_sparse_gcd = 16
 
 	};
 };
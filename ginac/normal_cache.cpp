@@ -0,0 +1,225 @@
+/** @file normal_cache.cpp
+ *
+ *  Implementation of the caches of results of gcd(), divide() and normal().
+ *
+ *  Each cache is a list of entries in order of their last use together with
+ *  an index from hash values to list positions.  In thread-safe builds all
+ *  caches are protected by a single mutex. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "normal_cache.h"
+#include "utils.h"
+
+#include <iostream>
+#include <list>
+#include <unordered_map>
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+namespace GiNaC {
+namespace normal_cache {
+
+std::size_t max_entries = 0;
+
+namespace {
+
+struct entry {
+	unsigned hashvalue;
+	ex a, b;
+	unsigned flags;
+	exvector result;
+};
+
+/** Cache of results of one kind. */
+class lru_cache {
+	typedef std::list<entry> entry_list;
+	typedef std::unordered_multimap<unsigned, entry_list::iterator> index_map;
+
+public:
+	lru_cache() : hits(0), misses(0), evictions(0) {}
+
+	bool lookup(const ex & a, const ex & b, unsigned flags, exvector & result);
+	void insert(const ex & a, const ex & b, unsigned flags, const exvector & result);
+	void shrink(std::size_t n);
+	void clear() { index.clear(); entries.clear(); }
+	std::size_t size() const { return entries.size(); }
+
+	unsigned long hits, misses, evictions;
+
+private:
+	index_map::iterator find(unsigned h, const ex & a, const ex & b, unsigned flags);
+
+	entry_list entries;  ///< most recently used first
+	index_map index;
+};
+
+inline unsigned key_hash(const ex & a, const ex & b, unsigned flags)
+{
+	return (rotate_left(a.gethash()) ^ b.gethash()) + flags;
+}
+
+lru_cache::index_map::iterator lru_cache::find(unsigned h, const ex & a, const ex & b, unsigned flags)
+{
+	std::pair<index_map::iterator, index_map::iterator> range = index.equal_range(h);
+	for (index_map::iterator i = range.first; i != range.second; ++i) {
+		const entry & e = *i->second;
+		if (e.flags == flags && e.a.is_equal(a) && e.b.is_equal(b))
+			return i;
+	}
+	return index.end();
+}
+
+bool lru_cache::lookup(const ex & a, const ex & b, unsigned flags, exvector & result)
+{
+	index_map::iterator i = find(key_hash(a, b, flags), a, b, flags);
+	if (i == index.end()) {
+		++misses;
+		return false;
+	}
+	++hits;
+	entries.splice(entries.begin(), entries, i->second);
+	result = i->second->result;
+	return true;
+}
+
+void lru_cache::insert(const ex & a, const ex & b, unsigned flags, const exvector & result)
+{
+	unsigned h = key_hash(a, b, flags);
+	index_map::iterator i = find(h, a, b, flags);
+	if (i != index.end()) {
+		entries.splice(entries.begin(), entries, i->second);
+		i->second->result = result;
+		return;
+	}
+	if (entries.size() >= max_entries)
+		shrink(max_entries - 1);
+	entry e = { h, a, b, flags, result };
+	entries.push_front(e);
+	index.insert(index_map::value_type(h, entries.begin()));
+}
+
+void lru_cache::shrink(std::size_t n)
+{
+	while (entries.size() > n) {
+		entry_list::iterator last = --entries.end();
+		std::pair<index_map::iterator, index_map::iterator> range = index.equal_range(last->hashvalue);
+		for (index_map::iterator i = range.first; i != range.second; ++i) {
+			if (i->second == last) {
+				index.erase(i);
+				break;
+			}
+		}
+		entries.erase(last);
+		++evictions;
+	}
+}
+
+lru_cache *caches()
+{
+	// Deliberately never destroyed: the entries may refer to objects
+	// which are gone at static destruction time.
+	static lru_cache *c = new lru_cache[num_kinds];
+	return c;
+}
+
+#ifdef GINAC_THREAD_SAFE
+pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+inline void lock_caches() { pthread_mutex_lock(&cache_mutex); }
+inline void unlock_caches() { pthread_mutex_unlock(&cache_mutex); }
+#else
+inline void lock_caches() {}
+inline void unlock_caches() {}
+#endif
+
+} // anonymous namespace
+
+void set_capacity(std::size_t n)
+{
+	lock_caches();
+	for (int k = 0; k < num_kinds; ++k)
+		caches()[k].shrink(n);
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&max_entries, n, __ATOMIC_RELAXED);
+#else
+	max_entries = n;
+#endif
+	unlock_caches();
+}
+
+std::size_t get_capacity()
+{
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_load_n(&max_entries, __ATOMIC_RELAXED);
+#else
+	return max_entries;
+#endif
+}
+
+void clear()
+{
+	lock_caches();
+	for (int k = 0; k < num_kinds; ++k)
+		caches()[k].clear();
+	unlock_caches();
+}
+
+statistics get_statistics(kind k)
+{
+	lock_caches();
+	const lru_cache & c = caches()[k];
+	statistics s = { c.size(), max_entries, c.hits, c.misses, c.evictions };
+	unlock_caches();
+	return s;
+}
+
+void reset_statistics()
+{
+	lock_caches();
+	for (int k = 0; k < num_kinds; ++k)
+		caches()[k].hits = caches()[k].misses = caches()[k].evictions = 0;
+	unlock_caches();
+}
+
+std::ostream & operator<<(std::ostream & os, const statistics & s)
+{
+	return os << s.size << "/" << s.capacity << " entries, "
+	          << s.hits << " hits, " << s.misses << " misses, "
+	          << s.evictions << " evictions";
+}
+
+bool lookup(kind k, const ex & a, const ex & b, unsigned flags, exvector & result)
+{
+	lock_caches();
+	bool found = caches()[k].lookup(a, b, flags, result);
+	unlock_caches();
+	return found;
+}
+
+void insert(kind k, const ex & a, const ex & b, unsigned flags, const exvector & result)
+{
+	lock_caches();
+	if (max_entries != 0)
+		caches()[k].insert(a, b, flags, result);
+	unlock_caches();
+}
+
+} // namespace normal_cache
+} // namespace GiNaC
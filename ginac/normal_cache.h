@@ -0,0 +1,107 @@
+/** @file normal_cache.h
+ *
+ *  Interface to the caches of results of gcd(), divide() and normal(). */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_NORMAL_CACHE_H
+#define GINAC_NORMAL_CACHE_H
+
+#include "ex.h"
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace GiNaC {
+
+/** Bounded caches remembering the results of gcd(), divide() and of the
+ *  normalization of sums and products by normal(), so that polynomials
+ *  occurring over and over again (typically the same denominators in a
+ *  large sum of rational functions) are only processed once.  Entries are
+ *  found by hash value and structural equality of the arguments; when a
+ *  cache is full, the least recently used entry is evicted.  Each kind of
+ *  result has its own cache of the same capacity.  The entries keep their
+ *  arguments and results alive, so caching is off by default and has to be
+ *  switched on with set_capacity(). */
+namespace normal_cache {
+
+/** Kinds of cached results. */
+enum kind {
+	gcd_results,     ///< results of gcd(), including cofactors
+	divide_results,  ///< results of divide()
+	normal_results,  ///< normal forms of sums and products
+	num_kinds
+};
+
+/** Usage of one cache. */
+struct statistics {
+	std::size_t size;          ///< number of entries
+	std::size_t capacity;      ///< maximum number of entries
+	unsigned long hits;        ///< lookups finding an entry
+	unsigned long misses;      ///< lookups not finding an entry
+	unsigned long evictions;   ///< entries evicted to make room
+
+	/** Fraction of lookups finding an entry. */
+	double hit_rate() const { return hits + misses ? double(hits) / (hits + misses) : 0; }
+};
+
+/** Set the maximum number of entries of each cache.  Shrinking the caches
+ *  evicts the least recently used entries, zero switches caching off. */
+void set_capacity(std::size_t n);
+
+/** Return the maximum number of entries of each cache. */
+std::size_t get_capacity();
+
+/** Remove all entries from the caches.  The statistics are kept. */
+void clear();
+
+/** Return the usage of the cache of results of the given kind. */
+statistics get_statistics(kind k);
+
+/** Set the hit, miss and eviction counts of all caches to zero. */
+void reset_statistics();
+
+/** Print the usage of a cache. */
+std::ostream & operator<<(std::ostream & os, const statistics & s);
+
+extern std::size_t max_entries;  ///< use is_enabled() and set_capacity()
+
+/** Return whether caching is switched on. */
+inline bool is_enabled()
+{
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_load_n(&max_entries, __ATOMIC_RELAXED) != 0;
+#else
+	return max_entries != 0;
+#endif
+}
+
+/** Look up the result for the arguments a, b and the flags of the
+ *  computation in the cache of the given kind.  Unused arguments should be
+ *  passed as zero. */
+bool lookup(kind k, const ex & a, const ex & b, unsigned flags, exvector & result);
+
+/** Store the result for the arguments a, b and the flags of the
+ *  computation in the cache of the given kind. */
+void insert(kind k, const ex & a, const ex & b, unsigned flags, const exvector & result);
+
+} // namespace normal_cache
+} // namespace GiNaC
+
+#endif // ndef GINAC_NORMAL_CACHE_H
@@ -34,12 +34,17 @@
 #include "archive.h"
 #include "tostring.h"
 #include "utils.h"
+#include "precision_cache.h"
+#include "cln_constants.h"
 
 #include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#endif
 
 // CLN should pollute the global namespace as little as possible.  Hence, we
 // include most of it here and include only the part needed for properly
@@ -160,7 +165,7 @@ numeric::numeric(double d)
 	// We really want to explicitly use the type cl_LF instead of the
 	// more general cl_F, since that would give us a cl_DF only which
 	// will not be promoted to cl_LF if overflow occurs:
-	value = cln::cl_float(d, cln::default_float_format);
+	value = cln::cl_float(d, cln::float_format(Digits));
 	setflag(status_flags::evaluated | status_flags::expanded);
 }
 
@@ -262,9 +267,9 @@ numeric::numeric(const cln::cl_N &z)
  */
 static const cln::cl_F make_real_float(const cln::cl_idecoded_float& dec)
 {
-	cln::cl_F x = cln::cl_float(dec.mantissa, cln::default_float_format);
+	cln::cl_F x = cln::cl_float(dec.mantissa, cln::float_format(Digits));
 	x = cln::scale_float(x, dec.exponent);
-	cln::cl_F sign = cln::cl_float(dec.sign, cln::default_float_format);
+	cln::cl_F sign = cln::cl_float(dec.sign, cln::float_format(Digits));
 	x = cln::float_sign(sign, x);
 	return x;
 }
@@ -528,7 +533,7 @@ static void print_real_cl_N(const print_context & c, const cln::cl_R & x)
 
 		// Anything else
 		c.s << "cln::cl_F(\"";
-		print_real_number(c, cln::cl_float(1.0, cln::default_float_format) * x);
+		print_real_number(c, cln::cl_float(1.0, cln::float_format(Digits)) * x);
 		c.s << "_" << Digits << "\")";
 	}
 }
@@ -794,7 +799,7 @@ ex numeric::eval(int level) const
 ex numeric::evalf(int level) const
 {
 	// level can safely be discarded for numeric objects.
-	return numeric(cln::cl_float(1.0, cln::default_float_format) * value);
+	return numeric(cln::cl_float(1.0, cln::float_format(Digits)) * value);
 }
 
 ex numeric::conjugate() const
@@ -914,7 +919,10 @@ const numeric numeric::power(const numeric &other) const
 		else
 			return *_num0_p;
 	}
-	return numeric(cln::expt(value, other.value));
+	if (cln::instanceof(other.value, cln::cl_I_ring))
+		return numeric(cln::expt(value, other.value));
+	// other exponents go through exp() and log()
+	return numeric(cln_expt(value, other.value));
 }
 
 
@@ -1011,7 +1019,11 @@ const numeric &numeric::power_dyn(const numeric &other) const
 		else
 			return *_num0_p;
 	}
-	return static_cast<const numeric &>((new numeric(cln::expt(value, other.value)))->
+	if (cln::instanceof(other.value, cln::cl_I_ring))
+		return static_cast<const numeric &>((new numeric(cln::expt(value, other.value)))->
+		                                     setflag(status_flags::dynallocated));
+	// other exponents go through exp() and log()
+	return static_cast<const numeric &>((new numeric(cln_expt(value, other.value)))->
 	                                     setflag(status_flags::dynallocated));
 }
 
@@ -1436,12 +1448,259 @@ int numeric::int_length() const
 const numeric I = numeric(cln::complex(cln::cl_I(0),cln::cl_I(1)));
 
 
+/** Precision set by digits_guard objects in the calling thread, 0 if there
+ *  are none. */
+static thread_local long thread_digits = 0;
+
+#ifdef GINAC_THREAD_SAFE
+/** Number of CLN's cached constants, see cln_constants_lock. */
+static const int num_cached_constants = 6;
+
+/** Precision in bits up to which CLN is known to have each constant cached
+ *  with more precision, so that a computation at this precision does not
+ *  touch the cache.  Changed only while cln_constants_lock is held
+ *  exclusively. */
+static long cached_bits[num_cached_constants];
+
+/** Whether computations using the given constants at the given precision
+ *  in bits leave CLN's caches alone. */
+static bool constants_cached(unsigned constants, long bits)
+{
+	for (int i = 0; i < num_cached_constants; ++i)
+		if ((constants & (1u << i)) && cached_bits[i] < bits)
+			return false;
+	return true;
+}
+
+/** Make CLN cache the given constants with more than the given precision
+ *  in bits.  CLN grows its caches by half their length at least, and so
+ *  does this, so that the caches are grown rarely. */
+static void cache_constants(unsigned constants, long bits)
+{
+	for (int i = 0; i < num_cached_constants; ++i) {
+		long &known = cached_bits[i];
+		if (!(constants & (1u << i)) || known >= bits)
+			continue;
+		const long target = std::max(bits, known + known/2);
+		// some words more than target, so the cache is longer than any
+		// request for at most target bits
+		const cln::float_format_t prec = cln::float_format_t(target + 128);
+		switch (1u << i) {
+			case cln_constants_lock::pi:
+				cln::pi(prec);
+				break;
+			case cln_constants_lock::ln2:
+				// CLN has no public access to log(2), but computes the
+				// logarithm of 3 == 3/4*2^2 with a longer one
+				cln::log(cln::cl_float(3, prec));
+				break;
+			case cln_constants_lock::exp1:
+				cln::exp1(prec);
+				break;
+			case cln_constants_lock::zeta3:
+				cln::zeta(3, prec);
+				break;
+			case cln_constants_lock::eulerconst:
+				cln::eulerconst(prec);
+				break;
+			case cln_constants_lock::catalanconst:
+				cln::catalanconst(prec);
+				break;
+		}
+		known = target;
+	}
+}
+
+/** Precision in bits at which CLN computes with numbers like x, or 0 for
+ *  machine precision floats.  The binary exponent of the largest part of x
+ *  is stored in e. */
+static long float_bits(const cln::cl_N &x, long &e)
+{
+	long bits = 0;
+	e = 0;
+	const cln::cl_R parts[] = { cln::realpart(x), cln::imagpart(x) };
+	for (int i = 0; i < 2; ++i) {
+		if (cln::zerop(parts[i]))
+			continue;
+		if (cln::instanceof(parts[i], cln::cl_RA_ring)) {
+			const cln::cl_RA r = cln::the<cln::cl_RA>(parts[i]);
+			e = std::max(e, long(cln::integer_length(cln::numerator(r))) -
+			                long(cln::integer_length(cln::denominator(r))) + 1);
+		} else {
+			// float contagion goes to the least precise format
+			const cln::cl_F f = cln::the<cln::cl_F>(parts[i]);
+			const long b = cln::float_digits(f);
+			bits = bits ? std::min(bits, b) : b;
+			e = std::max(e, long(cln::float_exponent(f)));
+		}
+	}
+	if (bits == 0)
+		bits = long(cln::default_float_format);
+	return bits > std::numeric_limits<double>::digits ? bits : 0;
+}
+
+/** Precision in bits of the constants for a computation with floats of the
+ *  given precision and exponent.  This is generous: CLN's functions work
+ *  with some extra digits, and the argument reduction of the trigonometric
+ *  functions and of exp needs as many more bits of Pi and log(2) as the
+ *  argument has digits before the point. */
+static long constants_bits(long bits, long e)
+{
+	return 2*bits + e + 4096;
+}
+
+static pthread_rwlock_t constants_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+/** Number of cln_constants_lock objects of the calling thread. */
+static thread_local unsigned constants_lock_depth = 0;
+
+/** Whether the calling thread holds constants_rwlock exclusively. */
+static thread_local bool constants_lock_exclusive = false;
+
+static void unlock_constants()
+{
+	if (--constants_lock_depth == 0)
+		pthread_rwlock_unlock(&constants_rwlock);
+}
+
+/** Grow the caches while holding the lock exclusively.  Since this is
+ *  called from constructors, the lock is released if it fails. */
+static void cache_constants_locked(unsigned constants, long bits)
+{
+	try {
+		cache_constants(constants, bits);
+	} catch (...) {
+		unlock_constants();
+		throw;
+	}
+}
+
+/** Take the lock for a computation using the given constants at the given
+ *  precision in bits, 0 for machine precision. */
+static void lock_constants(unsigned constants, long bits)
+{
+	if (constants_lock_depth++ > 0) {
+		if (constants_lock_exclusive) {
+			if (bits > 0)
+				cache_constants_locked(constants, bits);
+			return;
+		}
+		if (bits > 0 && constants_cached(constants, bits))
+			return;
+		// the computations of the outer locks have finished, so it can
+		// be released for taking it exclusively
+		pthread_rwlock_unlock(&constants_rwlock);
+	} else if (bits > 0) {
+		pthread_rwlock_rdlock(&constants_rwlock);
+		if (constants_cached(constants, bits)) {
+			constants_lock_exclusive = false;
+			return;
+		}
+		pthread_rwlock_unlock(&constants_rwlock);
+	}
+	pthread_rwlock_wrlock(&constants_rwlock);
+	constants_lock_exclusive = true;
+	if (bits > 0)
+		cache_constants_locked(constants, bits);
+}
+
+cln_constants_lock::cln_constants_lock(unsigned constants, const cln::cl_N &x)
+{
+	long e;
+	const long bits = float_bits(x, e);
+	lock_constants(constants, bits ? constants_bits(bits, e) : 0);
+}
+
+cln_constants_lock::cln_constants_lock(unsigned constants, const cln::cl_N &x, const cln::cl_N &y)
+{
+	// x^y == exp(y*log(x)) has an exponent of about that of y plus the
+	// number of digits of the exponent of x
+	long ex, ey;
+	long bits = float_bits(x, ex);
+	const long ybits = float_bits(y, ey);
+	if (bits == 0 || ybits == 0)
+		bits = 0;
+	else
+		bits = std::min(bits, ybits);
+	const long e = std::max(ex, ey) + long(cln::integer_length(cln::cl_I(std::max(std::max(ex, -ex), std::max(ey, -ey)))));
+	lock_constants(constants, bits ? constants_bits(bits, e) : 0);
+}
+
+cln_constants_lock::cln_constants_lock(unsigned constants, const cln::float_format_t &prec)
+{
+	const long bits = long(prec) > std::numeric_limits<double>::digits ? long(prec) : 0;
+	lock_constants(constants, bits ? constants_bits(bits, 0) : 0);
+}
+
+cln_constants_lock::~cln_constants_lock()
+{
+	unlock_constants();
+}
+#else
+cln_constants_lock::cln_constants_lock(unsigned constants, const cln::cl_N &x) {}
+cln_constants_lock::cln_constants_lock(unsigned constants, const cln::cl_N &x, const cln::cl_N &y) {}
+cln_constants_lock::cln_constants_lock(unsigned constants, const cln::float_format_t &prec) {}
+cln_constants_lock::~cln_constants_lock() {}
+#endif
+
+enum cln_constant { cln_pi, cln_eulerconst, cln_catalanconst, num_cln_constants };
+
+/** Highest precision in bits at which each constant was asked for.  It is
+ *  only used for the statistics, see precision_cache.h. */
+static long constants_prec[num_cln_constants];
+
+/** Floating point value of a mathematical constant with precision prec.
+ *  CLN remembers the most precise value computed so far in a global cache
+ *  and rounds it for lower precisions, so this only needs to hold the lock
+ *  on that cache and to return a copy sharing no storage with it. */
+static const cln::cl_F constant_float(cln_constant c, const cln::float_format_t &prec)
+{
+	using namespace precision_cache;
+	static const unsigned cached[num_cln_constants] = {
+		cln_constants_lock::pi,
+		cln_constants_lock::eulerconst,
+		cln_constants_lock::catalanconst
+	};
+	cln_constants_lock lock(cached[c], prec);
+	const long known = __atomic_load_n(&constants_prec[c], __ATOMIC_RELAXED);
+	if (known > long(prec))
+		record(constants, truncation);
+	else if (known == long(prec))
+		record(constants, hit);
+	else {
+		record(constants, computation);
+		__atomic_store_n(&constants_prec[c], long(prec), __ATOMIC_RELAXED);
+	}
+	switch (c) {
+		case cln_eulerconst:
+			return unshared(cln::eulerconst(prec));
+		case cln_catalanconst:
+			return unshared(cln::catalanconst(prec));
+		default:
+			return unshared(cln::pi(prec));
+	}
+}
+
+
+/** Argument to pass to CLN's transcendental functions.  For exact arguments
+ *  these return floating point numbers in CLN's default format, which is
+ *  not the right one in threads with a precision of their own, so there the
+ *  argument is converted beforehand.  Exact zeros are left alone since some
+ *  functions have exact values there. */
+static const cln::cl_N float_arg(const numeric &x)
+{
+	if (Digits.thread_override() && x.is_crational() && !x.is_zero())
+		return cln::cl_float(1, cln::float_format(Digits)) * x.to_cl_N();
+	return x.to_cl_N();
+}
+
+
 /** Exponential function.
  *
  *  @return  arbitrary precision numerical exp(x). */
 const numeric exp(const numeric &x)
 {
-	return numeric(cln::exp(x.to_cl_N()));
+	return numeric(cln_exp(float_arg(x)));
 }
 
 
@@ -1454,7 +1713,7 @@ const numeric log(const numeric &x)
 {
 	if (x.is_zero())
 		throw pole_error("log(): logarithmic pole",0);
-	return numeric(cln::log(x.to_cl_N()));
+	return numeric(cln_log(float_arg(x)));
 }
 
 
@@ -1463,7 +1722,9 @@ const numeric log(const numeric &x)
  *  @return  arbitrary precision numerical sin(x). */
 const numeric sin(const numeric &x)
 {
-	return numeric(cln::sin(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::sin(x_)));
 }
 
 
@@ -1472,7 +1733,9 @@ const numeric sin(const numeric &x)
  *  @return  arbitrary precision numerical cos(x). */
 const numeric cos(const numeric &x)
 {
-	return numeric(cln::cos(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::cos(x_)));
 }
 
 
@@ -1481,7 +1744,9 @@ const numeric cos(const numeric &x)
  *  @return  arbitrary precision numerical tan(x). */
 const numeric tan(const numeric &x)
 {
-	return numeric(cln::tan(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::tan(x_)));
 }
 	
 
@@ -1490,7 +1755,9 @@ const numeric tan(const numeric &x)
  *  @return  arbitrary precision numerical asin(x). */
 const numeric asin(const numeric &x)
 {
-	return numeric(cln::asin(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::asin(x_)));
 }
 
 
@@ -1499,7 +1766,9 @@ const numeric asin(const numeric &x)
  *  @return  arbitrary precision numerical acos(x). */
 const numeric acos(const numeric &x)
 {
-	return numeric(cln::acos(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::acos(x_)));
 }
 	
 
@@ -1514,7 +1783,9 @@ const numeric atan(const numeric &x)
 	    x.real().is_zero() &&
 	    abs(x.imag()).is_equal(*_num1_p))
 		throw pole_error("atan(): logarithmic pole",0);
-	return numeric(cln::atan(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::atan(x_)));
 }
 
 
@@ -1529,25 +1800,29 @@ const numeric atan(const numeric &y, const numeric &x)
 {
 	if (x.is_zero() && y.is_zero())
 		return *_num0_p;
-	if (x.is_real() && y.is_real())
-		return numeric(cln::atan(cln::the<cln::cl_R>(x.to_cl_N()),
-		                 cln::the<cln::cl_R>(y.to_cl_N())));
+	if (x.is_real() && y.is_real()) {
+		const cln::cl_N x_ = float_arg(x);
+		const cln::cl_N y_ = float_arg(y);
+		cln_constants_lock lock(cln_constants_lock::elementary, x_, y_);
+		return numeric(unshared(cln::atan(cln::the<cln::cl_R>(x_),
+		                                  cln::the<cln::cl_R>(y_))));
+	}
 
 	// Compute -I*log((x+I*y)/sqrt(x^2+y^2))
 	//      == -I*log((x+I*y)/sqrt((x+I*y)*(x-I*y)))
 	// Do not "simplify" this to -I/2*log((x+I*y)/(x-I*y))) or likewise.
 	// The branch cuts are easily messed up.
-	const cln::cl_N aux_p = x.to_cl_N()+cln::complex(0,1)*y.to_cl_N();
+	const cln::cl_N aux_p = float_arg(x)+cln::complex(0,1)*float_arg(y);
 	if (cln::zerop(aux_p)) {
 		// x+I*y==0 => y/x==I, so this is a pole (we have x!=0).
 		throw pole_error("atan(): logarithmic pole",0);
 	}
-	const cln::cl_N aux_m = x.to_cl_N()-cln::complex(0,1)*y.to_cl_N();
+	const cln::cl_N aux_m = float_arg(x)-cln::complex(0,1)*float_arg(y);
 	if (cln::zerop(aux_m)) {
 		// x-I*y==0 => y/x==-I, so this is a pole (we have x!=0).
 		throw pole_error("atan(): logarithmic pole",0);
 	}
-	return numeric(cln::complex(0,-1)*cln::log(aux_p/cln::sqrt(aux_p*aux_m)));
+	return numeric(cln::complex(0,-1)*cln_log(aux_p/cln::sqrt(aux_p*aux_m)));
 }
 
 
@@ -1556,7 +1831,9 @@ const numeric atan(const numeric &y, const numeric &x)
  *  @return  arbitrary precision numerical sinh(x). */
 const numeric sinh(const numeric &x)
 {
-	return numeric(cln::sinh(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::sinh(x_)));
 }
 
 
@@ -1565,7 +1842,9 @@ const numeric sinh(const numeric &x)
  *  @return  arbitrary precision numerical cosh(x). */
 const numeric cosh(const numeric &x)
 {
-	return numeric(cln::cosh(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::cosh(x_)));
 }
 
 
@@ -1574,7 +1853,9 @@ const numeric cosh(const numeric &x)
  *  @return  arbitrary precision numerical tanh(x). */
 const numeric tanh(const numeric &x)
 {
-	return numeric(cln::tanh(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::tanh(x_)));
 }
 	
 
@@ -1583,7 +1864,9 @@ const numeric tanh(const numeric &x)
  *  @return  arbitrary precision numerical asinh(x). */
 const numeric asinh(const numeric &x)
 {
-	return numeric(cln::asinh(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::asinh(x_)));
 }
 
 
@@ -1592,7 +1875,9 @@ const numeric asinh(const numeric &x)
  *  @return  arbitrary precision numerical acosh(x). */
 const numeric acosh(const numeric &x)
 {
-	return numeric(cln::acosh(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::acosh(x_)));
 }
 
 
@@ -1601,7 +1886,9 @@ const numeric acosh(const numeric &x)
  *  @return  arbitrary precision numerical atanh(x). */
 const numeric atanh(const numeric &x)
 {
-	return numeric(cln::atanh(x.to_cl_N()));
+	const cln::cl_N x_ = float_arg(x);
+	cln_constants_lock lock(cln_constants_lock::elementary, x_);
+	return numeric(unshared(cln::atanh(x_)));
 }
 
 
@@ -1659,12 +1946,12 @@ static cln::cl_N Li2_projection(const cln::cl_N &x,
 	const cln::cl_R im = cln::imagpart(x);
 	if (re > cln::cl_F(".5"))
 		// zeta(2) - Li2(1-x) - log(x)*log(1-x)
-		return(cln::zeta(2)
+		return(cln_zeta(2, prec)
 		       - Li2_series(1-x, prec)
-		       - cln::log(x)*cln::log(1-x));
+		       - cln_log(x)*cln_log(1-x));
 	if ((re <= 0 && cln::abs(im) > cln::cl_F(".75")) || (re < cln::cl_F("-.5")))
 		// -log(1-x)^2 / 2 - Li2(x/(x-1))
-		return(- cln::square(cln::log(1-x))/2
+		return(- cln::square(cln_log(1-x))/2
 		       - Li2_series(x/(x-1), prec));
 	if (re > 0 && cln::abs(im) > cln::cl_LF(".75"))
 		// Li2(x^2)/2 - Li2(-x)
@@ -1685,8 +1972,8 @@ const cln::cl_N Li2_(const cln::cl_N& value)
 		return 0;
 	
 	// what is the desired float format?
-	// first guess: default format
-	cln::float_format_t prec = cln::default_float_format;
+	// first guess: the precision of the calling thread
+	cln::float_format_t prec = cln::float_format(Digits);
 	// second guess: the argument's format
 	if (!instanceof(realpart(value), cln::cl_RA_ring))
 		prec = cln::float_format(cln::the<cln::cl_F>(cln::realpart(value)));
@@ -1694,12 +1981,12 @@ const cln::cl_N Li2_(const cln::cl_N& value)
 		prec = cln::float_format(cln::the<cln::cl_F>(cln::imagpart(value)));
 	
 	if (value==1)  // may cause trouble with log(1-x)
-		return cln::zeta(2, prec);
+		return cln_zeta(2, prec);
 	
 	if (cln::abs(value) > 1)
 		// -log(-x)^2 / 2 - zeta(2) - Li2(1/x)
-		return(- cln::square(cln::log(-value))/2
-		       - cln::zeta(2, prec)
+		return(- cln::square(cln_log(-value))/2
+		       - cln_zeta(2, prec)
 		       - Li2_projection(cln::recip(value), prec));
 	else
 		return Li2_projection(value, prec);
@@ -1727,7 +2014,7 @@ const numeric zeta(const numeric &x)
 	if (x.is_real()) {
 		const int aux = (int)(cln::double_approx(cln::the<cln::cl_R>(x.to_cl_N())));
 		if (cln::zerop(x.to_cl_N()-aux))
-			return numeric(cln::zeta(aux));
+			return numeric(cln_zeta(aux, cln::float_format(Digits)));
 	}
 	throw dunno();
 }
@@ -2026,7 +2313,7 @@ lanczos_coeffs::lanczos_coeffs()
 
 static const cln::float_format_t guess_precision(const cln::cl_N& x)
 {
-	cln::float_format_t prec = cln::default_float_format;
+	cln::float_format_t prec = cln::float_format(Digits);
 	if (!instanceof(realpart(x), cln::cl_RA_ring))
 		prec = cln::float_format(cln::the<cln::cl_F>(realpart(x)));
 	if (!instanceof(imagpart(x), cln::cl_RA_ring))
@@ -2044,16 +2331,16 @@ const cln::cl_N lgamma(const cln::cl_N &x)
 	cln::float_format_t prec = guess_precision(x);
 	lanczos_coeffs lc;
 	if (lc.sufficiently_accurate(prec)) {
-		cln::cl_N pi_val = cln::pi(prec);
+		cln::cl_N pi_val = constant_float(cln_pi, prec);
 		if (realpart(x) < 0.5)
-			return cln::log(pi_val) - cln::log(sin(pi_val*x))
+			return cln_log(pi_val) - cln_log(cln_sin(pi_val*x))
 				- lgamma(1 - x);
 		cln::cl_N A = lc.calc_lanczos_A(x);
 		cln::cl_N temp = x + lc.get_order() - cln::cl_N(1)/2;
-   	cln::cl_N result = log(cln::cl_I(2)*pi_val)/2
-		              + (x-cln::cl_N(1)/2)*log(temp)
+   	cln::cl_N result = cln_log(cln::cl_I(2)*pi_val)/2
+		              + (x-cln::cl_N(1)/2)*cln_log(temp)
 		              - temp
-		              + log(A);
+		              + cln_log(A);
    	return result;
 	}
 	else 
@@ -2072,14 +2359,14 @@ const cln::cl_N tgamma(const cln::cl_N &x)
 	cln::float_format_t prec = guess_precision(x);
 	lanczos_coeffs lc;
 	if (lc.sufficiently_accurate(prec)) {
-		cln::cl_N pi_val = cln::pi(prec);
+		cln::cl_N pi_val = constant_float(cln_pi, prec);
 		if (realpart(x) < 0.5)
-			return pi_val/(cln::sin(pi_val*x))/tgamma(1 - x);
+			return pi_val/cln_sin(pi_val*x)/tgamma(1 - x);
 		cln::cl_N A = lc.calc_lanczos_A(x);
 		cln::cl_N temp = x + lc.get_order() - cln::cl_N(1)/2;
    	cln::cl_N result
-			= sqrt(cln::cl_I(2)*pi_val) * expt(temp, x - cln::cl_N(1)/2)
-			  * exp(-temp) * A;
+			= sqrt(cln::cl_I(2)*pi_val) * cln_expt(temp, x - cln::cl_N(1)/2)
+			  * cln_exp(-temp) * A;
    	return result;
 	}
 	else
@@ -2477,7 +2764,10 @@ const numeric lcm(const numeric &a, const numeric &b)
  *  where imag(x)>0. */
 const numeric sqrt(const numeric &x)
 {
-	return numeric(cln::sqrt(x.to_cl_N()));
+	const cln::cl_N root = cln::sqrt(x.to_cl_N());
+	if (Digits.thread_override() && x.is_crational() && !cln::instanceof(cln::realpart(root), cln::cl_RA_ring))
+		return numeric(cln::sqrt(float_arg(x)));
+	return numeric(root);
 }
 
 
@@ -2496,21 +2786,21 @@ const numeric isqrt(const numeric &x)
 /** Floating point evaluation of Archimedes' constant Pi. */
 ex PiEvalf()
 { 
-	return numeric(cln::pi(cln::default_float_format));
+	return numeric(constant_float(cln_pi, cln::float_format(Digits)));
 }
 
 
 /** Floating point evaluation of Euler's constant gamma. */
 ex EulerEvalf()
 { 
-	return numeric(cln::eulerconst(cln::default_float_format));
+	return numeric(constant_float(cln_eulerconst, cln::float_format(Digits)));
 }
 
 
 /** Floating point evaluation of Catalan's constant. */
 ex CatalanEvalf()
 {
-	return numeric(cln::catalanconst(cln::default_float_format));
+	return numeric(constant_float(cln_catalanconst, cln::float_format(Digits)));
 }
 
 
@@ -2535,7 +2825,11 @@ _numeric_digits::_numeric_digits()
 _numeric_digits& _numeric_digits::operator=(long prec)
 {
 	long digitsdiff = prec - digits;
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&digits, prec, __ATOMIC_RELAXED);
+#else
 	digits = prec;
+#endif
 	cln::default_float_format = cln::float_format(prec);
 
 	// call registered callbacks
@@ -2552,14 +2846,26 @@ _numeric_digits& _numeric_digits::operator=(long prec)
 _numeric_digits::operator long()
 {
 	// BTW, this is approx. unsigned(cln::default_float_format*0.301)-1
+	if (thread_digits)
+		return thread_digits;
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_load_n(&digits, __ATOMIC_RELAXED);
+#else
 	return (long)digits;
+#endif
+}
+
+
+long _numeric_digits::thread_override() const
+{
+	return thread_digits;
 }
 
 
 /** Append global Digits object to ostream. */
 void _numeric_digits::print(std::ostream &os) const
 {
-	os << digits;
+	os << (thread_digits ? thread_digits : digits);
 }
 
 
@@ -2576,6 +2882,21 @@ std::ostream& operator<<(std::ostream &os, const _numeric_digits &e)
 	return os;
 }
 
+
+digits_guard::digits_guard(long prec)
+  : saved(thread_digits)
+{
+	if (prec <= 0)
+		throw std::invalid_argument("digits_guard: precision must be positive");
+	thread_digits = prec;
+}
+
+
+digits_guard::~digits_guard()
+{
+	thread_digits = saved;
+}
+
 //////////
 // static member variables
 //////////
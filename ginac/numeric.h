@@ -53,7 +53,11 @@ typedef void (* digits_changed_callback)(long);
  *  for temprary storing its value e.g.  The user must not create an
  *  own working object of this class!  Since C++ forces us to make the
  *  class definition visible in order to use an object we put in a
- *  flag which prevents other objects of that class to be created. */
+ *  flag which prevents other objects of that class to be created.
+ *
+ *  Assigning to Digits sets the precision of the whole program.  A thread
+ *  may override it for itself with a digits_guard; converting Digits to
+ *  long yields the precision in effect in the calling thread. */
 class _numeric_digits
 {
 // member functions
@@ -63,6 +67,9 @@ public:
 	operator long();
 	void print(std::ostream& os) const;
 	void add_callback(digits_changed_callback callback);
+	/** Return the precision set by a digits_guard in the calling thread,
+	 *  or 0 if there is none. */
+	long thread_override() const;
 // member variables
 private:
 	long digits;                        ///< Number of decimal digits
@@ -72,6 +79,26 @@ private:
 };
 
 
+/** Sets the precision of floating point evaluation in the calling thread to
+ *  prec decimal digits for the lifetime of the object, and restores the
+ *  previous precision afterwards.  Other threads are not affected, so
+ *  several threads can evaluate at different precisions at the same time.
+ *  They only wait for each other while CLN's constants are computed with
+ *  more precision than before, and evaluation of transcendental functions
+ *  at machine precision (at most 15 digits) is serialized.  Guards may be
+ *  nested.  The callbacks registered with Digits are not called. */
+class digits_guard
+{
+public:
+	explicit digits_guard(long prec);
+	~digits_guard();
+private:
+	digits_guard(const digits_guard &);             // not copyable
+	digits_guard & operator=(const digits_guard &);
+	long saved;  ///< previous override of the calling thread
+};
+
+
 /** Exception class thrown when a singularity is encountered. */
 class pole_error : public std::domain_error {
 public:
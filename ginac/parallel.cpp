@@ -0,0 +1,259 @@
+/** @file parallel.cpp
+ *
+ *  Implementation of GiNaC's pool of worker threads. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "parallel.h"
+#include "numeric.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace GiNaC {
+
+#ifdef GINAC_THREAD_SAFE
+
+static unsigned parallel_threads = 0;
+
+unsigned get_parallel_threads()
+{
+	unsigned n = __atomic_load_n(&parallel_threads, __ATOMIC_RELAXED);
+	if (n == 0) {
+		long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		n = ncpu > 0 ? unsigned(ncpu) : 1;
+	}
+	return n;
+}
+
+void set_parallel_threads(unsigned n)
+{
+	__atomic_store_n(&parallel_threads, n, __ATOMIC_RELAXED);
+}
+
+namespace {
+
+/** Set in the threads owned by the pool, to detect nested calls. */
+thread_local bool in_worker_thread = false;
+
+/** A pool of threads that is grown on demand and lives until the end of
+ *  the program.  Only one job is executed at a time. */
+class thread_pool {
+public:
+	thread_pool();
+	bool try_acquire() { return !__atomic_exchange_n(&busy, true, __ATOMIC_ACQUIRE); }
+	void run(size_t n, parallel_task & t, unsigned nthreads);
+private:
+	static void *worker_main(void *arg);
+	void worker_loop(unsigned slot);
+	void drain(unsigned slot);
+	void record_error(const std::string & msg);
+
+	pthread_mutex_t mutex;
+	pthread_cond_t work_cond;   ///< signalled when a new job is posted
+	pthread_cond_t done_cond;   ///< signalled when the last worker finishes
+	std::vector<pthread_t> workers;
+	bool busy;                  ///< a job is being executed
+
+	// The current job, protected by mutex except for next_index
+	parallel_task *task;
+	size_t num_indices;
+	size_t next_index;          ///< next index to hand out (atomic)
+	unsigned num_participants;  ///< number of workers taking part in the job
+	unsigned active;            ///< participating workers not yet finished
+	unsigned long generation;   ///< incremented for every job
+	long job_digits;            ///< precision override of the caller, or 0
+	bool failed;
+	std::string error;
+};
+
+struct worker_arg {
+	thread_pool *pool;
+	unsigned slot;
+};
+
+thread_pool::thread_pool()
+  : busy(false), task(0), num_indices(0), next_index(0), num_participants(0),
+    active(0), generation(0), job_digits(0), failed(false)
+{
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&work_cond, 0);
+	pthread_cond_init(&done_cond, 0);
+}
+
+void *thread_pool::worker_main(void *arg)
+{
+	worker_arg *wa = static_cast<worker_arg *>(arg);
+	thread_pool *pool = wa->pool;
+	unsigned slot = wa->slot;
+	delete wa;
+	in_worker_thread = true;
+	pool->worker_loop(slot);
+	return 0;
+}
+
+void thread_pool::worker_loop(unsigned slot)
+{
+	unsigned long seen = 0;
+	pthread_mutex_lock(&mutex);
+	for (;;) {
+		while (generation == seen)
+			pthread_cond_wait(&work_cond, &mutex);
+		seen = generation;
+		if (slot >= num_participants)
+			continue;
+		const long digits = job_digits;
+		pthread_mutex_unlock(&mutex);
+		if (digits) {
+			digits_guard guard(digits);
+			drain(slot);
+		} else
+			drain(slot);
+		pthread_mutex_lock(&mutex);
+		if (--active == 0)
+			pthread_cond_signal(&done_cond);
+	}
+}
+
+/** Process indices of the current job until there are none left. */
+void thread_pool::drain(unsigned slot)
+{
+	for (;;) {
+		size_t i = __atomic_fetch_add(&next_index, 1, __ATOMIC_RELAXED);
+		if (i >= num_indices)
+			break;
+		try {
+			task->run(i, slot);
+		} catch (const std::exception & e) {
+			record_error(e.what());
+		} catch (...) {
+			record_error("parallel_for(): unknown exception in worker thread");
+		}
+	}
+}
+
+void thread_pool::record_error(const std::string & msg)
+{
+	pthread_mutex_lock(&mutex);
+	if (!failed) {
+		failed = true;
+		error = msg;
+	}
+	pthread_mutex_unlock(&mutex);
+	// skip the remaining indices
+	__atomic_store_n(&next_index, num_indices, __ATOMIC_RELAXED);
+}
+
+void thread_pool::run(size_t n, parallel_task & t, unsigned nthreads)
+{
+	pthread_mutex_lock(&mutex);
+	while (workers.size() + 1 < nthreads) {
+		worker_arg *wa = new worker_arg;
+		wa->pool = this;
+		wa->slot = workers.size() + 1;  // slot 0 is the calling thread
+		pthread_t tid;
+		if (pthread_create(&tid, 0, worker_main, wa) != 0) {
+			delete wa;
+			break;
+		}
+		pthread_detach(tid);
+		workers.push_back(tid);
+	}
+	task = &t;
+	num_indices = n;
+	next_index = 0;
+	num_participants = nthreads < workers.size() + 1 ? nthreads : workers.size() + 1;
+	active = num_participants - 1;
+	job_digits = Digits.thread_override();
+	failed = false;
+	error.clear();
+	++generation;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&mutex);
+
+	drain(0);
+
+	pthread_mutex_lock(&mutex);
+	while (active > 0)
+		pthread_cond_wait(&done_cond, &mutex);
+	task = 0;
+	const bool job_failed = failed;
+	const std::string msg = error;
+	pthread_mutex_unlock(&mutex);
+	__atomic_store_n(&busy, false, __ATOMIC_RELEASE);
+
+	if (job_failed)
+		throw std::runtime_error(msg);
+}
+
+thread_pool & the_pool()
+{
+	// Deliberately never destroyed: worker threads may still be waiting
+	// on its condition variables when the program exits.
+	static thread_pool *pool = new thread_pool;
+	return *pool;
+}
+
+} // anonymous namespace
+
+void parallel_for(size_t n, parallel_task & task, unsigned nthreads)
+{
+	if (nthreads > n)
+		nthreads = n;
+	if (nthreads > 1 && !in_worker_thread) {
+		thread_pool & pool = the_pool();
+		if (pool.try_acquire()) {
+			pool.run(n, task, nthreads);
+			return;
+		}
+	}
+	for (size_t i = 0; i < n; ++i)
+		task.run(i, 0);
+}
+
+#else // ndef GINAC_THREAD_SAFE
+
+unsigned get_parallel_threads()
+{
+	return 1;
+}
+
+void set_parallel_threads(unsigned)
+{
+}
+
+void parallel_for(size_t n, parallel_task & task, unsigned)
+{
+	for (size_t i = 0; i < n; ++i)
+		task.run(i, 0);
+}
+
+#endif // ndef GINAC_THREAD_SAFE
+
+void parallel_for(size_t n, parallel_task & task)
+{
+	parallel_for(n, task, get_parallel_threads());
+}
+
+} // namespace GiNaC
@@ -0,0 +1,73 @@
+/** @file parallel.h
+ *
+ *  Interface to GiNaC's pool of worker threads. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_PARALLEL_H
+#define GINAC_PARALLEL_H
+
+#include <cstddef> // for size_t
+
+namespace GiNaC {
+
+/** Work item for parallel_for().  The function run(i, slot) is called
+ *  exactly once for every index i, from an unspecified thread.  The slot
+ *  number identifies the calling thread: two calls with the same slot never
+ *  run concurrently, so it can be used to index per-thread scratch data.
+ *
+ *  Note that GiNaC objects may only be shared between threads if the
+ *  library was configured with --enable-thread-safe.  Even then, CLN's own
+ *  reference counting is not atomic, so numbers that do not fit into an
+ *  immediate word (bignums, rationals, floats) must not be touched by more
+ *  than one thread at a time.  GiNaC's numeric functions serialize their
+ *  use of CLN's global caches of Pi, log(2) and other constants, so they
+ *  may be called concurrently, but CLN's transcendental functions must not
+ *  be called directly from several threads. */
+struct parallel_task {
+	virtual ~parallel_task() {}
+	virtual void run(size_t i, unsigned slot) = 0;
+};
+
+/** Return the maximum number of threads used by parallel algorithms. This
+ *  defaults to the number of online processors and is always 1 if the
+ *  library is not thread-safe. */
+unsigned get_parallel_threads();
+
+/** Set the maximum number of threads used by parallel algorithms.  Zero
+ *  restores the default. */
+void set_parallel_threads(unsigned n);
+
+/** Call task.run(i, slot) for all i in [0, n) using at most nthreads
+ *  threads, including the calling one, and return when all calls have
+ *  finished.  Indices are handed out dynamically, so idle threads pick up
+ *  the remaining work.  All slot numbers are smaller than nthreads.  Nested
+ *  or concurrent calls are executed sequentially by the calling thread.  If
+ *  a call to run() in a worker thread throws, the remaining indices are
+ *  skipped and a std::runtime_error with the same message is thrown in the
+ *  calling thread.  A precision set with digits_guard in the calling thread
+ *  is in effect in the worker threads, too. */
+void parallel_for(size_t n, parallel_task & task, unsigned nthreads);
+
+/** Like parallel_for(n, task, nthreads) with nthreads = get_parallel_threads(). */
+void parallel_for(size_t n, parallel_task & task);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_PARALLEL_H
@@ -22,10 +22,12 @@
 
 #include "cra_garner.h"
 #include "compiler.h"
+#include "modp_poly.h"
 
 #include <cln/integer.h>
 #include <cln/modinteger.h>
 #include <cstddef>
+#include <stdexcept>
 #include <vector>
 
 namespace cln {
@@ -110,4 +112,57 @@ cl_I integer_cra(const vector<cl_I>& residues,
 	return result;
 }
 
+/// Return a*b mod p for 0 <= a, b < p < 2^31.
+static inline long mul_mod(long a, long b, long p)
+{
+	return (long)((unsigned long long)a * (unsigned long long)b % (unsigned long long)p);
+}
+
+/// Return x mod p in the range 0 <= x < p.
+static inline long reduce(long x, long p)
+{
+	x %= p;
+	return x < 0 ? x + p : x;
+}
+
+word_cra::word_cra(const vector<long>& moduli_)
+  : moduli(moduli_), recips(moduli_.size())
+{
+	for (size_t k = 1; k < moduli.size(); ++k) {
+		long product = reduce(moduli[0], moduli[k]);
+		for (size_t i = 1; i < k; ++i)
+			product = mul_mod(product, reduce(moduli[i], moduli[k]), moduli[k]);
+		recips[k] = GiNaC::recip_mod(product, moduli[k]);
+		if (unlikely(recips[k] == 0))
+			throw std::invalid_argument("word_cra: moduli are not coprime");
+	}
+}
+
+cl_I word_cra::operator()(const vector<long>& residues) const
+{
+	const size_t n = moduli.size();
+	if (unlikely(n == 0 || residues.size() != n))
+		throw std::invalid_argument("word_cra: wrong number of residues");
+
+	// mixed radix digits in the symmetric range
+	vector<long> digits(n);
+	for (size_t k = 0; k < n; ++k) {
+		const long p = moduli[k];
+		long d = reduce(residues[k], p);
+		if (k > 0) {
+			long t = reduce(digits[k-1], p);
+			for (size_t j = k - 1; j-- != 0; )
+				t = (long)(((unsigned long long)t * (unsigned long long)reduce(moduli[j], p)
+				            + (unsigned long long)reduce(digits[j], p)) % (unsigned long long)p);
+			d = mul_mod(reduce(d - t, p), recips[k], p);
+		}
+		digits[k] = d > (p >> 1) ? d - p : d;
+	}
+
+	cl_I u = cl_I(digits[n-1]);
+	for (size_t k = n - 1; k-- != 0; )
+		u = u*cl_I(moduli[k]) + cl_I(digits[k]);
+	return u;
+}
+
 } // namespace cln
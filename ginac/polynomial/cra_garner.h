@@ -31,6 +31,28 @@ namespace cln {
 extern cl_I integer_cra(const std::vector<cl_I>& residues,
 	                const std::vector<cl_I>& moduli);
 
+/**
+ * Garner's algorithm for reconstructing many integers from their residues
+ * modulo the same word-size moduli, which must be pairwise coprime and
+ * smaller than 2^31.  The inverses needed are computed only once, and the
+ * mixed radix digits are computed in machine arithmetic.
+ */
+class word_cra
+{
+public:
+	explicit word_cra(const std::vector<long>& moduli);
+
+	/// Return the integer x in the symmetric range -M/2 < x <= M/2, where
+	/// M is the product of the moduli, such that x = residues[k] modulo
+	/// moduli[k] for all k.
+	cl_I operator()(const std::vector<long>& residues) const;
+
+private:
+	std::vector<long> moduli;
+	/// recips[k] is the inverse of moduli[0]*...*moduli[k-1] modulo moduli[k]
+	std::vector<long> recips;
+};
+
 } // namespace cln
 
 #endif // CL_INTEGER_CRA
@@ -23,6 +23,7 @@
 #include "upoly.h"
 #include "gcd_euclid.h"
 #include "cra_garner.h"
+#include "modp_poly.h"
 #include "debug.h"
 
 #include <cln/numtheory.h>
@@ -102,6 +103,48 @@ static void retract(upoly& p, const umodpoly& cp,
 }
 
 
+#ifdef __SIZEOF_INT128__
+typedef uint64_t modp_word;
+#else
+typedef uint32_t modp_word;
+#endif
+
+/// Convert 0 <= x < 2^64 to a machine integer
+static uint64_t to_uint64(const cln::cl_I& x)
+{
+	return (uint64_t(cln::cl_I_to_uint(x >> 32)) << 32) |
+	       cln::cl_I_to_uint(cln::logand(x, 0xffffffffU));
+}
+
+/// Convert a machine integer to cl_I
+static cln::cl_I from_uint64(uint64_t x)
+{
+	return (cln::cl_I(uint32_t(x >> 32)) << 32) + cln::cl_I(uint32_t(x));
+}
+
+/**
+ * Compute the monic GCD of A mod p and B mod p, where the prime p is small
+ * enough for modp_field, with word-size arithmetic.
+ */
+static void gcd_modp(umodpoly& c, const upoly& A, const upoly& B,
+	             const cln::cl_modint_ring& R)
+{
+	typedef modp_field<modp_word> field_t;
+	const field_t F(modp_word(to_uint64(R->modulus)));
+	std::vector<modp_word> a(A.size()), b(B.size()), g;
+	for (std::size_t i = A.size(); i-- != 0; )
+		a[i] = F.from_uint(modp_word(to_uint64(mod(A[i], R->modulus))));
+	for (std::size_t i = B.size(); i-- != 0; )
+		b[i] = F.from_uint(modp_word(to_uint64(mod(B[i], R->modulus))));
+	modp_canonicalize(a);
+	modp_canonicalize(b);
+	modp_gcd(F, g, a, b);
+
+	c.resize(g.size());
+	for (std::size_t i = g.size(); i-- != 0; )
+		c[i] = R->canonhom(from_uint64(F.to_uint(g[i])));
+}
+
 /// Find the prime which is > p, and does NOT divide g
 static void find_next_prime(cln::cl_I& p, const cln::cl_I& g)
 {
@@ -129,6 +172,8 @@ void mod_gcd(upoly& result, upoly A, upoly B)
 
 	int count = 0;
 	const ring_t p_threshold = ring_t(1) << (8*sizeof(void *));
+	// primes up to this one are handled with word-size arithmetic
+	const ring_t word_limit = from_uint64(modp_field<modp_word>::max_modulus());
 	ring_t p = isqrt(std::min(max_coeff(A), max_coeff(B)));
 	while (true) {
 		if (count >= 8) {
@@ -144,15 +189,20 @@ void mod_gcd(upoly& result, upoly A, upoly B)
 		// Map the polynomials onto Z/p[x]
 		cln::cl_modint_ring Rp = cln::find_modint_ring(p);
 		cln::cl_MI gp = Rp->canonhom(g);
-		umodpoly ap(A.size()), bp(B.size());
-		make_umodpoly(ap, A, Rp);
-		make_umodpoly(bp, B, Rp);
 
 		// Compute the GCD in Z/p[x]
 		umodpoly cp;
-		gcd_euclid(cp, ap, bp);
-		bug_on(cp.size() == 0, "gcd(ap, bp) = 0, with ap = " <<
-			                ap << ", and bp = " << bp);
+		if (p <= word_limit) {
+			gcd_modp(cp, A, B, Rp);
+			bug_on(cp.size() == 0, "gcd(A mod p, B mod p) = 0");
+		} else {
+			umodpoly ap(A.size()), bp(B.size());
+			make_umodpoly(ap, A, Rp);
+			make_umodpoly(bp, B, Rp);
+			gcd_euclid(cp, ap, bp);
+			bug_on(cp.size() == 0, "gcd(ap, bp) = 0, with ap = " <<
+				                ap << ", and bp = " << bp);
+		}
 
 
 		// Normalize the candidate so that its leading coefficient
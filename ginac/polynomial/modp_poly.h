@@ -0,0 +1,373 @@
+/** @file modp_poly.h
+ *
+ *  Arithmetic in prime fields Z/pZ with word-size modulus, and dense
+ *  univariate polynomials over them. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_MODP_POLY_H
+#define GINAC_MODP_POLY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace GiNaC {
+
+/** Inverse of a modulo m for 0 <= a < m < 2^63, by the extended Euclidean
+ *  algorithm.  Returns 0 if a and m are not coprime. */
+inline uint64_t recip_mod(uint64_t a, uint64_t m)
+{
+	int64_t r0 = m, r1 = a, s0 = 0, s1 = 1;
+	while (r1 != 0) {
+		const int64_t q = r0 / r1;
+		int64_t t = r0 - q*r1;
+		r0 = r1;
+		r1 = t;
+		t = s0 - q*s1;
+		s0 = s1;
+		s1 = t;
+	}
+	if (r0 != 1)
+		return 0;
+	return s0 < 0 ? s0 + m : s0;
+}
+
+/** Unsigned type holding the product of two words of type T. */
+template<typename T> struct modp_wide_type { };
+
+template<> struct modp_wide_type<uint32_t>
+{
+	typedef uint64_t type;
+};
+
+#ifdef __SIZEOF_INT128__
+template<> struct modp_wide_type<uint64_t>
+{
+	__extension__ typedef unsigned __int128 type;
+};
+#endif
+
+/** The field Z/pZ for an odd prime p < 2^(w-1), where w is the number of
+ *  bits of the unsigned type T.  Elements are stored in Montgomery form,
+ *  i.e. x is represented by x*2^w mod p, so that multiplication needs no
+ *  division.  Zero is represented by 0. */
+template<typename T> class modp_field
+{
+public:
+	typedef T value_type;
+	typedef typename modp_wide_type<T>::type wide_type;
+	static const unsigned bits = 8*sizeof(T);
+
+	explicit modp_field(T p_) : p(p_)
+	{
+		// Newton iteration for 1/p mod 2^w, each step doubles the
+		// number of correct bits, starting with three.
+		T inv = p;
+		for (int i = 0; i < 6; ++i)
+			inv *= T(2) - p*inv;
+		pinv = T(0) - inv;
+		const wide_type r = (wide_type(1) << bits) % p;
+		r1 = T(r);
+		r2 = T(r*r % p);
+		pp = wide_type(p)*p;
+	}
+
+	/** Largest modulus supported by this type. */
+	static T max_modulus() { return (T(1) << (bits - 1)) - 1; }
+
+	T modulus() const { return p; }
+	T zero() const { return 0; }
+	T one() const { return r1; }
+
+	/** Element represented by the integer x, 0 <= x < p. */
+	T from_uint(T x) const { return reduce(wide_type(x)*r2); }
+	/** Integer 0 <= x < p represented by the element a. */
+	T to_uint(T a) const { return reduce(wide_type(a)); }
+
+	T add(T a, T b) const
+	{
+		const T s = a + b;
+		return s >= p ? s - p : s;
+	}
+	T sub(T a, T b) const { return a >= b ? a - b : a + (p - b); }
+	T neg(T a) const { return a ? p - a : 0; }
+	T mul(T a, T b) const { return reduce(wide_type(a)*b); }
+	T pow(T a, unsigned long e) const
+	{
+		T r = r1;
+		while (e) {
+			if (e & 1)
+				r = mul(r, a);
+			a = mul(a, a);
+			e >>= 1;
+		}
+		return r;
+	}
+	/** Inverse of the non-zero element a. */
+	T inv(T a) const { return from_uint(T(recip_mod(to_uint(a), p))); }
+
+	/** Montgomery reduction t/2^w mod p of 0 <= t < p*2^w. */
+	T reduce(wide_type t) const
+	{
+		const T m = T(t)*pinv;
+		const wide_type u = (t + wide_type(m)*p) >> bits;
+		return u >= p ? T(u - p) : T(u);
+	}
+	/** Add the product a*b to the accumulator 0 <= s < p^2, keeping it in
+	 *  that range.  Sums of products are accumulated this way and passed
+	 *  to reduce() once, without a data dependent branch in the loop. */
+	void lazy_add(wide_type & s, T a, T b) const
+	{
+		s += wide_type(a)*b;
+		s -= s >= pp ? pp : 0;
+	}
+
+private:
+	T p;      ///< modulus
+	T pinv;   ///< -1/p mod 2^w
+	T r1;     ///< 2^w mod p, i.e. the representation of one
+	T r2;     ///< 2^(2*w) mod p
+	wide_type pp;  ///< p^2
+};
+
+// Dense univariate polynomials over a modp_field are vectors of the
+// coefficients in ascending order without leading zeros, the empty vector
+// being the zero polynomial.
+
+/** Below this length polynomials are multiplied by the schoolbook method,
+ *  above it by Karatsuba's. */
+const std::size_t modp_karatsuba_threshold = 32;
+
+/** Remove leading zero coefficients. */
+template<typename T> void modp_canonicalize(std::vector<T> & a)
+{
+	std::size_t n = a.size();
+	while (n && a[n-1] == 0)
+		--n;
+	a.resize(n);
+}
+
+/** Divide a by its leading coefficient. */
+template<typename T> void modp_make_monic(const modp_field<T> & F, std::vector<T> & a)
+{
+	if (a.empty() || a.back() == F.one())
+		return;
+	const T lc_1 = F.inv(a.back());
+	for (std::size_t i = 0; i < a.size(); ++i)
+		a[i] = F.mul(a[i], lc_1);
+}
+
+/** c = a - b. */
+template<typename T>
+void modp_sub(const modp_field<T> & F, std::vector<T> & c, const std::vector<T> & a, const std::vector<T> & b)
+{
+	std::vector<T> r(std::max(a.size(), b.size()), T(0));
+	std::copy(a.begin(), a.end(), r.begin());
+	for (std::size_t i = 0; i < b.size(); ++i)
+		r[i] = F.sub(r[i], b[i]);
+	modp_canonicalize(r);
+	c.swap(r);
+}
+
+/** r[0..na+nb-2] = a*b by the schoolbook method.  The sums of products are
+ *  reduced only once, so that the inner loop can be vectorized. */
+template<typename T>
+void modp_mul_basecase(const modp_field<T> & F, T * r, const T * a, std::size_t na, const T * b, std::size_t nb)
+{
+	typedef typename modp_field<T>::wide_type wide_type;
+	std::vector<wide_type> s(na + nb - 1, wide_type(0));
+	for (std::size_t i = 0; i < na; ++i) {
+		const T ai = a[i];
+		wide_type * si = &s[i];
+		for (std::size_t j = 0; j < nb; ++j)
+			F.lazy_add(si[j], ai, b[j]);
+	}
+	for (std::size_t k = 0; k < s.size(); ++k)
+		r[k] = F.reduce(s[k]);
+}
+
+/** r[0..2n-2] = a*b for a and b of length n by Karatsuba's method. */
+template<typename T>
+void modp_mul_karatsuba(const modp_field<T> & F, T * r, const T * a, const T * b, std::size_t n)
+{
+	if (n < modp_karatsuba_threshold) {
+		modp_mul_basecase(F, r, a, n, b, n);
+		return;
+	}
+
+	// a = a0 + a1*x^h, b = b0 + b1*x^h with a1, b1 of length l <= h
+	const std::size_t h = (n + 1)/2, l = n - h;
+	std::vector<T> sa(a, a + h), sb(b, b + h), z1(2*h - 1);
+	for (std::size_t i = 0; i < l; ++i) {
+		sa[i] = F.add(sa[i], a[h + i]);
+		sb[i] = F.add(sb[i], b[h + i]);
+	}
+	modp_mul_karatsuba(F, r, a, b, h);
+	r[2*h - 1] = 0;
+	modp_mul_karatsuba(F, r + 2*h, a + h, b + h, l);
+	modp_mul_karatsuba(F, &z1[0], &sa[0], &sb[0], h);
+
+	// a0*b1 + a1*b0 = (a0 + a1)*(b0 + b1) - a0*b0 - a1*b1
+	for (std::size_t i = 0; i < 2*h - 1; ++i)
+		z1[i] = F.sub(z1[i], r[i]);
+	for (std::size_t i = 0; i < 2*l - 1; ++i)
+		z1[i] = F.sub(z1[i], r[2*h + i]);
+	for (std::size_t i = 0; i < 2*h - 1; ++i)
+		r[h + i] = F.add(r[h + i], z1[i]);
+}
+
+/** r[0..na+nb-2] = a*b for na >= nb > 0.  The longer factor is cut into
+ *  pieces of the length of the shorter one, which are multiplied by
+ *  Karatsuba's method. */
+template<typename T>
+void modp_mul(const modp_field<T> & F, T * r, const T * a, std::size_t na, const T * b, std::size_t nb)
+{
+	if (nb < modp_karatsuba_threshold) {
+		modp_mul_basecase(F, r, a, na, b, nb);
+		return;
+	}
+	std::fill(r, r + na + nb - 1, T(0));
+	std::vector<T> t(2*nb - 1);
+	for (std::size_t i = 0; i < na; i += nb) {
+		const std::size_t m = std::min(nb, na - i);
+		if (m == nb)
+			modp_mul_karatsuba(F, &t[0], a + i, b, nb);
+		else
+			modp_mul(F, &t[0], b, nb, a + i, m);
+		for (std::size_t k = 0; k < m + nb - 1; ++k)
+			r[i + k] = F.add(r[i + k], t[k]);
+	}
+}
+
+/** c = a*b. */
+template<typename T>
+void modp_mul(const modp_field<T> & F, std::vector<T> & c, const std::vector<T> & a, const std::vector<T> & b)
+{
+	if (a.empty() || b.empty()) {
+		c.clear();
+		return;
+	}
+	std::vector<T> r(a.size() + b.size() - 1);
+	if (a.size() >= b.size())
+		modp_mul(F, &r[0], &a[0], a.size(), &b[0], b.size());
+	else
+		modp_mul(F, &r[0], &b[0], b.size(), &a[0], a.size());
+	c.swap(r);
+}
+
+/** Division with remainder by the non-zero polynomial b, r = a mod b and,
+ *  if q is not null, *q = a div b.  r may be a. */
+template<typename T>
+void modp_remdiv(const modp_field<T> & F, std::vector<T> & r, const std::vector<T> & a, const std::vector<T> & b, std::vector<T> * q = 0)
+{
+	const std::size_t nb = b.size();
+	std::vector<T> x(a);
+	if (x.size() < nb) {
+		if (q)
+			q->clear();
+		r.swap(x);
+		return;
+	}
+
+	const std::size_t nq = x.size() - nb + 1;
+	std::vector<T> y(q ? nq : 0);
+	const T lc_1 = F.inv(b.back());
+	for (std::size_t k = nq; k-- != 0; ) {
+		const T c = F.mul(x[k + nb - 1], lc_1);
+		if (q)
+			y[k] = c;
+		if (c == 0)
+			continue;
+		const T mc = F.neg(c);
+		T * xk = &x[k];
+		for (std::size_t j = 0; j + 1 < nb; ++j)
+			xk[j] = F.add(xk[j], F.mul(mc, b[j]));
+		xk[nb - 1] = 0;
+	}
+	x.resize(nb - 1);
+	modp_canonicalize(x);
+	r.swap(x);
+	if (q) {
+		modp_canonicalize(y);
+		q->swap(y);
+	}
+}
+
+/** c = a*b mod m for the non-zero polynomial m. */
+template<typename T>
+void modp_mulmod(const modp_field<T> & F, std::vector<T> & c, const std::vector<T> & a, const std::vector<T> & b, const std::vector<T> & m)
+{
+	modp_mul(F, c, a, b);
+	modp_remdiv(F, c, c, m);
+}
+
+/** r = a^e mod m for the non-zero polynomial m. */
+template<typename T>
+void modp_powmod(const modp_field<T> & F, std::vector<T> & r, const std::vector<T> & a, unsigned long e, const std::vector<T> & m)
+{
+	std::vector<T> x, y(1, F.one());
+	modp_remdiv(F, x, a, m);
+	while (e) {
+		if (e & 1)
+			modp_mulmod(F, y, y, x, m);
+		e >>= 1;
+		if (e)
+			modp_mulmod(F, x, x, x, m);
+	}
+	modp_remdiv(F, r, y, m);
+}
+
+/** c = monic GCD of a and b, which is zero if both are zero. */
+template<typename T>
+void modp_gcd(const modp_field<T> & F, std::vector<T> & c, const std::vector<T> & a, const std::vector<T> & b)
+{
+	std::vector<T> x(a), y(b), r;
+	if (x.size() < y.size())
+		x.swap(y);
+	while (!y.empty()) {
+		modp_remdiv(F, r, x, y);
+		x.swap(y);
+		y.swap(r);
+	}
+	modp_make_monic(F, x);
+	c.swap(x);
+}
+
+/** d = derivative of a. */
+template<typename T>
+void modp_deriv(const modp_field<T> & F, std::vector<T> & d, const std::vector<T> & a)
+{
+	std::vector<T> r;
+	if (a.size() > 1) {
+		r.resize(a.size() - 1);
+		T k = F.one();
+		for (std::size_t i = 1; i < a.size(); ++i) {
+			r[i - 1] = F.mul(a[i], k);
+			k = F.add(k, F.one());
+		}
+		modp_canonicalize(r);
+	}
+	d.swap(r);
+}
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_MODP_POLY_H
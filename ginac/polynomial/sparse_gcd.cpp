@@ -0,0 +1,920 @@
+/** @file sparse_gcd.cpp
+ *
+ *  Sparse modular GCD of multivariate polynomials over Z.
+ *
+ *  The GCD is computed modulo word-size primes and reconstructed by Chinese
+ *  remaindering.  Modulo the first prime the variables are eliminated one
+ *  by one as in Brown's dense algorithm, but the images are interpolated
+ *  with the support (skeleton) of a previous image instead of recursively,
+ *  as proposed by Zippel: with the skeleton known, a polynomial with t terms
+ *  is determined by t univariate GCDs at the powers of a single evaluation
+ *  point, which are independent of each other and computed in parallel.
+ *  All further primes use the skeleton of the first one.
+ *
+ *  References:
+ *    R. Zippel, "Probabilistic algorithms for sparse polynomials",
+ *      EUROSAM '79, LNCS 72 (1979) 216--226.
+ *    W.S. Brown, "On Euclid's algorithm and the computation of polynomial
+ *      greatest common divisors", J. ACM 18 (1971) 478--504. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sparse_gcd.h"
+#include "sparse_poly.h"
+#include "modp_poly.h"
+#include "primes_factory.h"
+#include "numeric.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cln/integer.h>
+#include <cln/rational.h>
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace GiNaC {
+
+namespace {
+
+typedef modp_field<uint32_t> field;
+
+/** Dense univariate polynomial over the field, see modp_poly.h. */
+typedef std::vector<uint32_t> dpoly;
+
+/** Term of a polynomial over Z_p. */
+struct mterm
+{
+	mterm(packed_monomial m, uint32_t c) : mon(m), coeff(c) { }
+	packed_monomial mon;
+	uint32_t coeff;
+};
+
+/** Polynomial over Z_p in the variables of a monomial_layout, stored as a
+ *  vector of terms sorted by decreasing monomials and without zero
+ *  coefficients.  A polynomial "in k variables" only uses the first k
+ *  variables of the layout; the last of them is stored in the least
+ *  significant field in use, so the terms with the same exponents of the
+ *  first k-1 variables are adjacent. */
+typedef std::vector<mterm> mpoly;
+
+/** Polynomial over Z, in the same order. */
+typedef std::vector<std::pair<packed_monomial, cln::cl_I> > zpoly;
+
+/** Below this number of term evaluations the univariate images of
+ *  zippel::interpolate() are computed by a single thread. */
+const size_t parallel_image_threshold = 20000;
+
+uint32_t dpoly_eval(const field & F, const dpoly & a, uint32_t x)
+{
+	uint32_t r = 0;
+	for (size_t i = a.size(); i-- != 0; )
+		r = F.add(F.mul(r, x), a[i]);
+	return r;
+}
+
+/** The monomial m with the exponent of the variable v set to zero. */
+inline packed_monomial strip(const monomial_layout & L, packed_monomial m, size_t v)
+{
+	return m - L.exponent(m, v)*L.variable(v);
+}
+
+unsigned degree(const monomial_layout & L, const mpoly & A, size_t v)
+{
+	unsigned d = 0;
+	for (mpoly::const_iterator t = A.begin(); t != A.end(); ++t)
+		d = std::max(d, L.exponent(t->mon, v));
+	return d;
+}
+
+/** Coefficients of A, a polynomial in k variables, as dense polynomials in
+ *  the k-th variable, together with the monomials in the other variables.
+ *  They are in decreasing order of the monomials. */
+typedef std::vector<std::pair<packed_monomial, dpoly> > coefficient_vector;
+
+void last_coefficients(const monomial_layout & L, const mpoly & A, size_t k, coefficient_vector & cs)
+{
+	const size_t v = k - 1;
+	cs.clear();
+	for (size_t i = 0; i < A.size(); ) {
+		const packed_monomial m = strip(L, A[i].mon, v);
+		cs.push_back(std::make_pair(m, dpoly(L.exponent(A[i].mon, v) + 1, 0)));
+		dpoly & c = cs.back().second;
+		for (; i < A.size() && strip(L, A[i].mon, v) == m; ++i)
+			c[L.exponent(A[i].mon, v)] = A[i].coeff;
+	}
+}
+
+/** Appends m*c to A for the dense polynomial c in the variable v. */
+void append_coefficient(const monomial_layout & L, mpoly & A, packed_monomial m, const dpoly & c, size_t v)
+{
+	for (size_t e = c.size(); e-- != 0; )
+		if (c[e] != 0)
+			A.push_back(mterm(m + e*L.variable(v), c[e]));
+}
+
+/** Leading coefficient of A, a polynomial in k variables, w.r.t. the first
+ *  k-1 variables. */
+dpoly last_lcoeff(const monomial_layout & L, const mpoly & A, size_t k)
+{
+	const size_t v = k - 1;
+	const packed_monomial m = strip(L, A[0].mon, v);
+	dpoly c(L.exponent(A[0].mon, v) + 1, 0);
+	for (size_t i = 0; i < A.size() && strip(L, A[i].mon, v) == m; ++i)
+		c[L.exponent(A[i].mon, v)] = A[i].coeff;
+	return c;
+}
+
+/** Content of A w.r.t. the first k-1 variables, a monic polynomial in the
+ *  k-th variable. */
+dpoly last_content(const field & F, const monomial_layout & L, const mpoly & A, size_t k)
+{
+	coefficient_vector cs;
+	last_coefficients(L, A, k, cs);
+	dpoly g;
+	for (size_t i = 0; i < cs.size() && g.size() != 1; ++i)
+		modp_gcd(F, g, g, cs[i].second);
+	return g;
+}
+
+/** Multiplies (or if divide is true, exactly divides) the coefficients of
+ *  A, a polynomial in k variables, by the polynomial c in the k-th one. */
+mpoly apply_last(const field & F, const monomial_layout & L, const mpoly & A, size_t k, const dpoly & c, bool divide)
+{
+	if (c.size() == 1 && c[0] == F.one())
+		return A;
+	coefficient_vector cs;
+	last_coefficients(L, A, k, cs);
+	mpoly R;
+	R.reserve(A.size());
+	dpoly r, rem;
+	for (coefficient_vector::const_iterator i = cs.begin(); i != cs.end(); ++i) {
+		if (divide)
+			modp_remdiv(F, rem, i->second, c, &r);
+		else
+			modp_mul(F, r, i->second, c);
+		append_coefficient(L, R, i->first, r, k - 1);
+	}
+	return R;
+}
+
+/** Substitutes x = alpha for the k-th variable x of A. */
+mpoly evaluate_last(const field & F, const monomial_layout & L, const mpoly & A, size_t k, uint32_t alpha)
+{
+	const size_t v = k - 1;
+	mpoly R;
+	for (size_t i = 0; i < A.size(); ) {
+		const packed_monomial m = strip(L, A[i].mon, v);
+		uint32_t s = 0;
+		for (; i < A.size() && strip(L, A[i].mon, v) == m; ++i)
+			s = F.add(s, F.mul(A[i].coeff, F.pow(alpha, L.exponent(A[i].mon, v))));
+		if (s != 0)
+			R.push_back(mterm(m, s));
+	}
+	return R;
+}
+
+void scale(const field & F, mpoly & A, uint32_t s)
+{
+	for (mpoly::iterator t = A.begin(); t != A.end(); ++t)
+		t->coeff = F.mul(t->coeff, s);
+}
+
+/** Transposed Vandermonde systems sum_k c[k]*v[k]^j = y[j-1] for j = 1,
+ *  ..., t, where t is the size of v, the v[k] being non-zero and distinct.
+ *  With the master polynomial P = prod_k (z - v[k]) and Q_k = P/(z - v[k]),
+ *  the solution is c[k] = sum_i Q_k[i]*y[i]/(v[k]*Q_k(v[k])), so a system
+ *  is solved in O(t^2) operations, see R. Zippel, "Interpolating
+ *  polynomials from their values", J. Symb. Comp. 9 (1990) 375--403. */
+class vandermonde
+{
+public:
+	vandermonde(const field & F_, const dpoly & v_) : F(F_), v(v_), Q(v_.size()), d(v_.size())
+	{
+		const size_t t = v.size();
+		dpoly P(1, F.one());
+		for (size_t k = 0; k < t; ++k) {
+			P.push_back(P.back());
+			for (size_t i = P.size() - 2; i != 0; --i)
+				P[i] = F.sub(P[i - 1], F.mul(v[k], P[i]));
+			P[0] = F.neg(F.mul(v[k], P[0]));
+		}
+		for (size_t k = 0; k < t; ++k) {
+			dpoly & q = Q[k];
+			q.resize(t);
+			q[t - 1] = F.one();
+			for (size_t i = t - 1; i != 0; --i)
+				q[i - 1] = F.add(P[i], F.mul(v[k], q[i]));
+			d[k] = F.inv(F.mul(dpoly_eval(F, q, v[k]), v[k]));
+		}
+	}
+
+	size_t size() const { return v.size(); }
+
+	/** The solution c for the right hand side y. */
+	void solve(const dpoly & y, dpoly & c) const
+	{
+		c.assign(v.size(), 0);
+		for (size_t k = 0; k < v.size(); ++k) {
+			uint32_t s = 0;
+			for (size_t i = 0; i < v.size(); ++i)
+				s = F.add(s, F.mul(Q[k][i], y[i]));
+			c[k] = F.mul(s, d[k]);
+		}
+	}
+
+	/** The coefficients a with sum_i a[i]*y[i] = sum_k c[k]*v[k]^j. */
+	void value(size_t j, dpoly & a) const
+	{
+		a.assign(v.size(), 0);
+		for (size_t k = 0; k < v.size(); ++k) {
+			const uint32_t u = F.mul(d[k], F.pow(v[k], j));
+			for (size_t i = 0; i < v.size(); ++i)
+				a[i] = F.add(a[i], F.mul(Q[k][i], u));
+		}
+	}
+
+private:
+	const field & F;
+	const dpoly v;
+	std::vector<dpoly> Q;
+	dpoly d;
+};
+
+/** Computes the univariate images A(x, w^j) and B(x, w^j) for the evaluation
+ *  point w of all variables but the first and their monic GCDs g[j-1], for
+ *  j in a range of values.  The image is cleared if the degrees of A or B
+ *  drop or if the degree of the GCD is not dg. */
+class image_task : public parallel_task
+{
+public:
+	image_task(const field & F_, const monomial_layout & L_, const mpoly & A_, const mpoly & B_,
+	           const dpoly & wa_, const dpoly & wb_, unsigned dg_, size_t n, size_t chunk_)
+		: F(F_), L(L_), A(A_), B(B_), wa(wa_), wb(wb_), dg(dg_), chunk(chunk_),
+		  da(degree(L_, A_, 0)), db(degree(L_, B_, 0)), g(n) { }
+
+	void run(size_t i, unsigned slot)
+	{
+		const size_t begin = i*chunk, end = std::min(begin + chunk, g.size());
+		if (begin >= end)
+			return;
+		dpoly pa(A.size()), pb(B.size());
+		for (size_t t = 0; t < A.size(); ++t)
+			pa[t] = F.mul(A[t].coeff, F.pow(wa[t], begin + 1));
+		for (size_t t = 0; t < B.size(); ++t)
+			pb[t] = F.mul(B[t].coeff, F.pow(wb[t], begin + 1));
+		dpoly a, b;
+		for (size_t j = begin; j < end; ++j) {
+			image(A, pa, wa, da, a);
+			image(B, pb, wb, db, b);
+			if (a.size() == da + 1 && b.size() == db + 1) {
+				modp_gcd(F, g[j], a, b);
+				if (g[j].size() != dg + 1)
+					g[j].clear();
+			}
+		}
+	}
+
+	/** Sums the terms p into a and advances them to the next power. */
+	void image(const mpoly & P, dpoly & p, const dpoly & w, unsigned d, dpoly & a) const
+	{
+		a.assign(d + 1, 0);
+		for (size_t t = 0; t < P.size(); ++t) {
+			const unsigned e = L.exponent(P[t].mon, 0);
+			a[e] = F.add(a[e], p[t]);
+			p[t] = F.mul(p[t], w[t]);
+		}
+		modp_canonicalize(a);
+	}
+
+private:
+	const field & F;
+	const monomial_layout & L;
+	const mpoly & A;
+	const mpoly & B;
+	const dpoly & wa;
+	const dpoly & wb;
+	const unsigned dg;
+	const size_t chunk;
+	const unsigned da, db;
+public:
+	std::vector<dpoly> g;
+};
+
+/** GCD computations modulo a prime. */
+class zippel
+{
+public:
+	zippel(const field & F_, const monomial_layout & L_)
+		: F(F_), L(L_), state(0x9e3779b97f4a7c15ULL ^ F_.modulus()) { }
+
+	/** GCD of the polynomials A and B in k variables, up to a scalar.
+	 *  The variables are eliminated from the last one by Newton
+	 *  interpolation.  Returns false if no lucky evaluation points are
+	 *  found. */
+	bool gcd(const mpoly & A, const mpoly & B, size_t k, mpoly & G);
+
+	/** GCD of the polynomials A and B in k > 1 variables, up to a scalar,
+	 *  assuming its support is the one of skeleton.  All variables but the
+	 *  first are substituted by the powers of a single random point, and
+	 *  the coefficients of the powers of the first variable are solved for
+	 *  from the univariate GCDs.  Returns false if the skeleton does not
+	 *  fit or the point is unsuitable. */
+	bool interpolate(const mpoly & A, const mpoly & B, size_t k, const mpoly & skeleton, mpoly & G);
+
+	/** Test whether B divides A, both polynomials in k variables. */
+	bool divides(const mpoly & A, const mpoly & B, size_t k) const;
+
+private:
+	/** Random non-zero field element. */
+	uint32_t random_element()
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return F.from_uint(uint32_t(state % (F.modulus() - 1)) + 1);
+	}
+
+	const field & F;
+	const monomial_layout & L;
+	uint64_t state;
+};
+
+bool zippel::gcd(const mpoly & A, const mpoly & B, size_t k, mpoly & G)
+{
+	if (A.empty() || B.empty()) {
+		G = A.empty() ? B : A;
+		return true;
+	}
+	const size_t v = k - 1;
+	if (k == 1) {
+		coefficient_vector a, b;
+		last_coefficients(L, A, 1, a);
+		last_coefficients(L, B, 1, b);
+		dpoly g;
+		modp_gcd(F, g, a[0].second, b[0].second);
+		G.clear();
+		append_coefficient(L, G, 0, g, 0);
+		return true;
+	}
+
+	// Remove the contents, their GCD is the content of the result.
+	const dpoly ca = last_content(F, L, A, k);
+	const dpoly cb = last_content(F, L, B, k);
+	dpoly c;
+	modp_gcd(F, c, ca, cb);
+	const mpoly A1 = apply_last(F, L, A, k, ca, true);
+	const mpoly B1 = apply_last(F, L, B, k, cb, true);
+
+	// The images are normalized to have the leading coefficient gamma, a
+	// multiple of the leading coefficient of the GCD (Brown).
+	const dpoly lca = last_lcoeff(L, A1, k);
+	const dpoly lcb = last_lcoeff(L, B1, k);
+	dpoly gamma;
+	modp_gcd(F, gamma, lca, lcb);
+	const unsigned bound = std::min(degree(L, A1, v), degree(L, B1, v)) + unsigned(gamma.size()) - 1;
+
+	std::map<packed_monomial, dpoly, std::greater<packed_monomial> > H;
+	dpoly q(1, F.one());
+	unsigned npoints = 0, failures = 0;
+	packed_monomial lm = 0;
+	mpoly skeleton, image;
+	for (unsigned tries = 0; tries < 2*bound + 64; ++tries) {
+		const uint32_t alpha = random_element();
+		if (dpoly_eval(F, q, alpha) == 0 || dpoly_eval(F, lca, alpha) == 0 ||
+		    dpoly_eval(F, lcb, alpha) == 0)
+			continue;
+		const mpoly Aa = evaluate_last(F, L, A1, k, alpha);
+		const mpoly Ba = evaluate_last(F, L, B1, k, alpha);
+		if (skeleton.empty() || k == 2 || !interpolate(Aa, Ba, k - 1, skeleton, image)) {
+			if (!gcd(Aa, Ba, k - 1, image))
+				return false;
+		}
+
+		// The images are multiples of the image of the GCD. If the
+		// leading monomial is larger than before, alpha is unlucky, if
+		// it is smaller, all previous points were.
+		const packed_monomial m = image[0].mon;
+		if (m == 0) {
+			G.clear();
+			append_coefficient(L, G, 0, c, v);
+			return true;
+		}
+		if (npoints > 0 && m > lm)
+			continue;
+		if (npoints == 0 || m < lm) {
+			H.clear();
+			q.assign(1, F.one());
+			npoints = 0;
+			lm = m;
+			skeleton = image;
+		}
+		scale(F, image, F.mul(dpoly_eval(F, gamma, alpha), F.inv(image[0].coeff)));
+
+		// Newton interpolation: H += (image - H(alpha))*q/q(alpha)
+		for (mpoly::const_iterator t = image.begin(); t != image.end(); ++t)
+			H[t->mon];
+		const uint32_t s = F.inv(dpoly_eval(F, q, alpha));
+		bool changed = false;
+		mpoly::const_iterator t = image.begin();
+		for (std::map<packed_monomial, dpoly>::iterator h = H.begin(); h != H.end(); ) {
+			uint32_t d = F.neg(dpoly_eval(F, h->second, alpha));
+			if (t != image.end() && t->mon == h->first) {
+				d = F.add(d, t->coeff);
+				++t;
+			}
+			if (d != 0) {
+				changed = true;
+				const uint32_t ds = F.mul(d, s);
+				if (h->second.size() < q.size())
+					h->second.resize(q.size(), 0);
+				for (size_t i = 0; i < q.size(); ++i)
+					h->second[i] = F.add(h->second[i], F.mul(ds, q[i]));
+				modp_canonicalize(h->second);
+			}
+			if (h->second.empty())
+				H.erase(h++);
+			else
+				++h;
+		}
+		q.insert(q.begin(), 0);
+		for (size_t i = 0; i + 1 < q.size(); ++i)
+			q[i] = F.sub(q[i], F.mul(alpha, q[i + 1]));
+		++npoints;
+
+		// Test the result when it stops changing, or when the degree
+		// bound is reached.
+		if ((npoints > 1 && !changed) || npoints > bound) {
+			mpoly R;
+			for (std::map<packed_monomial, dpoly>::const_iterator h = H.begin(); h != H.end(); ++h)
+				append_coefficient(L, R, h->first, h->second, v);
+			R = apply_last(F, L, R, k, last_content(F, L, R, k), true);
+			if (divides(A1, R, k) && divides(B1, R, k)) {
+				G = apply_last(F, L, R, k, c, false);
+				return true;
+			}
+			if (npoints > bound) {
+				if (++failures > 2)
+					return false;
+				H.clear();
+				q.assign(1, F.one());
+				npoints = 0;
+				skeleton.clear();
+			}
+		}
+	}
+	return false;
+}
+
+bool zippel::interpolate(const mpoly & A, const mpoly & B, size_t k, const mpoly & skeleton, mpoly & G)
+{
+	// Group the skeleton by the exponent of the first variable.
+	std::vector<size_t> groups;
+	size_t nmax = 0;
+	for (size_t i = 0; i < skeleton.size(); ) {
+		const unsigned e = L.exponent(skeleton[i].mon, 0);
+		const size_t begin = i;
+		while (i < skeleton.size() && L.exponent(skeleton[i].mon, 0) == e)
+			++i;
+		groups.push_back(begin);
+		nmax = std::max(nmax, i - begin);
+	}
+	groups.push_back(skeleton.size());
+	const size_t ngroups = groups.size() - 1;
+	if (ngroups < 2)
+		return false;
+
+	// Values of the monomials at the point w.
+	std::vector<uint32_t> w(k);
+	for (size_t i = 1; i < k; ++i)
+		w[i] = random_element();
+	struct monomial_value
+	{
+		monomial_value(const field & F_, const monomial_layout & L_, const std::vector<uint32_t> & w_)
+			: F(F_), L(L_), w(w_) { }
+		dpoly operator()(const mpoly & P) const
+		{
+			dpoly r(P.size());
+			for (size_t t = 0; t < P.size(); ++t) {
+				r[t] = F.one();
+				for (size_t i = 1; i < w.size(); ++i)
+					r[t] = F.mul(r[t], F.pow(w[i], L.exponent(P[t].mon, i)));
+			}
+			return r;
+		}
+		const field & F;
+		const monomial_layout & L;
+		const std::vector<uint32_t> & w;
+	} value(F, L, w);
+	const dpoly ws = value(skeleton);
+	std::vector<vandermonde> systems;
+	systems.reserve(ngroups);
+	for (size_t g = 0; g < ngroups; ++g) {
+		const dpoly v(ws.begin() + groups[g], ws.begin() + groups[g + 1]);
+		dpoly x(v);
+		std::sort(x.begin(), x.end());
+		if (std::adjacent_find(x.begin(), x.end()) != x.end())
+			return false;
+		systems.push_back(vandermonde(F, v));
+	}
+
+	// The univariate GCDs are monic, i.e. they are the images of G only up
+	// to scalars m[j], m[0] = 1.  Each group needs as many images as it
+	// has terms, the remaining ones give linear equations for the m[j]
+	// (Monagan and de Kleine, "Algorithms for the non-monic case of the
+	// sparse modular GCD algorithm", ISSAC 2005).  Take enough images to
+	// have two more equations than unknowns.
+	size_t n = nmax;
+	for (size_t equations = 0; equations < n + 1; ) {
+		++n;
+		equations = 0;
+		for (size_t g = 0; g < ngroups; ++g)
+			equations += n - systems[g].size();
+	}
+	const unsigned dg = L.exponent(skeleton[0].mon, 0);
+	const dpoly wa = value(A), wb = value(B);
+	const unsigned nthreads = n*(A.size() + B.size()) >= parallel_image_threshold ? get_parallel_threads() : 1;
+	const size_t chunk = (n + nthreads - 1)/nthreads;
+	image_task task(F, L, A, B, wa, wb, dg, n, chunk);
+	parallel_for((n + chunk - 1)/chunk, task, nthreads);
+	const std::vector<dpoly> & images = task.g;
+
+	// The images must fit the skeleton.
+	std::vector<char> in_skeleton(dg + 1, 0);
+	for (size_t g = 0; g < ngroups; ++g)
+		in_skeleton[L.exponent(skeleton[groups[g]].mon, 0)] = 1;
+	for (size_t j = 0; j < n; ++j) {
+		if (images[j].empty())
+			return false;
+		for (unsigned e = 0; e <= dg; ++e)
+			if (images[j][e] != 0 && !in_skeleton[e])
+				return false;
+	}
+
+	// Equations sum_i a[i]*images[i][e]*m[i] = images[j][e]*m[j] for the
+	// images j not needed to solve for the coefficients of x^e.
+	std::vector<dpoly> rows;
+	dpoly a;
+	for (size_t g = 0; g < ngroups; ++g) {
+		const size_t t = systems[g].size();
+		const unsigned e = L.exponent(skeleton[groups[g]].mon, 0);
+		for (size_t j = t; j < n; ++j) {
+			systems[g].value(j + 1, a);
+			dpoly row(n, 0);
+			for (size_t i = 0; i < t; ++i)
+				row[i] = F.mul(a[i], images[i][e]);
+			row[j] = F.sub(row[j], images[j][e]);
+			rows.push_back(row);
+		}
+	}
+
+	// Gaussian elimination for m[1], ..., m[n-1], the column 0 holds the
+	// coefficients of m[0] = 1.
+	size_t rank = 0;
+	for (size_t col = 1; col < n; ++col) {
+		size_t pivot = rank;
+		while (pivot < rows.size() && rows[pivot][col] == 0)
+			++pivot;
+		if (pivot == rows.size())
+			return false;
+		rows[rank].swap(rows[pivot]);
+		dpoly & r = rows[rank];
+		const uint32_t s = F.inv(r[col]);
+		for (size_t i = 0; i < n; ++i)
+			r[i] = F.mul(r[i], s);
+		for (size_t l = 0; l < rows.size(); ++l) {
+			const uint32_t f = rows[l][col];
+			if (l == rank || f == 0)
+				continue;
+			for (size_t i = 0; i < n; ++i)
+				rows[l][i] = F.sub(rows[l][i], F.mul(f, r[i]));
+		}
+		++rank;
+	}
+	for (size_t l = rank; l < rows.size(); ++l)
+		if (rows[l][0] != 0)
+			return false;
+	dpoly m(n);
+	m[0] = F.one();
+	for (size_t col = 1; col < n; ++col)
+		m[col] = F.neg(rows[col - 1][0]);
+
+	G.clear();
+	dpoly y, c;
+	for (size_t g = 0; g < ngroups; ++g) {
+		const size_t t = systems[g].size();
+		const unsigned e = L.exponent(skeleton[groups[g]].mon, 0);
+		y.resize(t);
+		for (size_t j = 0; j < t; ++j)
+			y[j] = F.mul(m[j], images[j][e]);
+		systems[g].solve(y, c);
+		for (size_t i = 0; i < t; ++i)
+			if (c[i] != 0)
+				G.push_back(mterm(skeleton[groups[g] + i].mon, c[i]));
+	}
+	return !G.empty();
+}
+
+bool zippel::divides(const mpoly & A, const mpoly & B, size_t k) const
+{
+	if (A.empty())
+		return true;
+	std::vector<unsigned> degrees(L.nvars(), 0);
+	for (size_t i = 0; i < k; ++i) {
+		const unsigned da = degree(L, A, i), db = degree(L, B, i);
+		if (db > da)
+			return false;
+		degrees[i] = da - db;
+	}
+	const packed_monomial qmax = L.pack(degrees);
+
+	// Division with a heap of the pending products q[i]*B[j], as in
+	// sparse_poly::divide().
+	struct entry
+	{
+		entry(packed_monomial m, size_t i_, size_t j_) : mon(m), i(i_), j(j_) { }
+		bool operator<(const entry & e) const { return mon < e.mon; }
+		packed_monomial mon;
+		size_t i, j;
+	};
+	std::vector<entry> heap;
+	mpoly q;
+	const uint32_t lc_1 = F.inv(B[0].coeff);
+	size_t k_ = 0;
+	while (k_ < A.size() || !heap.empty()) {
+		packed_monomial m;
+		uint32_t c = 0;
+		if (heap.empty() || (k_ < A.size() && A[k_].mon >= heap.front().mon)) {
+			m = A[k_].mon;
+			c = A[k_].coeff;
+			++k_;
+		} else
+			m = heap.front().mon;
+		while (!heap.empty() && heap.front().mon == m) {
+			std::pop_heap(heap.begin(), heap.end());
+			entry & e = heap.back();
+			c = F.sub(c, F.mul(q[e.i].coeff, B[e.j].coeff));
+			if (++e.j < B.size()) {
+				e.mon = q[e.i].mon + B[e.j].mon;
+				std::push_heap(heap.begin(), heap.end());
+			} else
+				heap.pop_back();
+		}
+		if (c == 0)
+			continue;
+		if (!L.divides(B[0].mon, m))
+			return false;
+		const packed_monomial qm = m - B[0].mon;
+		if (!L.divides(qm, qmax))
+			return false;
+		q.push_back(mterm(qm, F.mul(c, lc_1)));
+		if (B.size() > 1) {
+			heap.push_back(entry(qm + B[1].mon, q.size() - 1, 1));
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
+	return true;
+}
+
+/** Image of A modulo p. */
+mpoly reduce(const field & F, const zpoly & A)
+{
+	const cln::cl_I p = F.modulus();
+	mpoly R;
+	R.reserve(A.size());
+	for (zpoly::const_iterator t = A.begin(); t != A.end(); ++t) {
+		const uint32_t c = uint32_t(cln::cl_I_to_ulong(cln::mod(t->second, p)));
+		if (c != 0)
+			R.push_back(mterm(t->first, F.from_uint(c)));
+	}
+	return R;
+}
+
+/** Combines H mod M and G mod p to H mod M*p, with coefficients in the
+ *  symmetric range.  Returns whether H has changed. */
+bool chinese_remainder(const field & F, zpoly & H, cln::cl_I & M, const mpoly & G)
+{
+	const cln::cl_I p = F.modulus();
+	const cln::cl_I Mp = M*p, half = cln::ash(Mp, -1);
+	const uint32_t Minv = F.inv(F.from_uint(uint32_t(cln::cl_I_to_ulong(cln::mod(M, p)))));
+	bool changed = false;
+	zpoly R;
+	R.reserve(std::max(H.size(), G.size()));
+	zpoly::const_iterator h = H.begin();
+	mpoly::const_iterator g = G.begin();
+	while (h != H.end() || g != G.end()) {
+		packed_monomial m;
+		cln::cl_I x = 0;
+		uint32_t y = 0;
+		if (g == G.end() || (h != H.end() && h->first > g->mon)) {
+			m = h->first;
+			x = (h++)->second;
+		} else if (h == H.end() || g->mon > h->first) {
+			m = g->mon;
+			y = (g++)->coeff;
+		} else {
+			m = h->first;
+			x = (h++)->second;
+			y = (g++)->coeff;
+		}
+		const uint32_t xp = F.from_uint(uint32_t(cln::cl_I_to_ulong(cln::mod(x, p))));
+		const uint32_t u = F.to_uint(F.mul(F.sub(y, xp), Minv));
+		if (u != 0) {
+			changed = true;
+			x = x + M*u;
+			if (x > half)
+				x = x - Mp;
+		}
+		if (!zerop(x))
+			R.push_back(std::make_pair(m, x));
+	}
+	H.swap(R);
+	M = Mp;
+	return changed;
+}
+
+/** Integer content of the polynomial P over Q, returns false if it has a
+ *  non-integer coefficient. */
+bool integer_content(const sparse_poly & P, cln::cl_I & c)
+{
+	c = 0;
+	const sparse_poly::term_vector & terms = P.get_terms();
+	for (sparse_poly::term_vector::const_iterator t = terms.begin(); t != terms.end(); ++t) {
+		if (!cln::instanceof(t->coeff, cln::cl_I_ring))
+			return false;
+		c = cln::gcd(c, cln::the<cln::cl_I>(t->coeff));
+	}
+	return true;
+}
+
+/** Exponent bounds of A, packed. */
+std::vector<unsigned> degrees(const monomial_layout & L, const sparse_poly & A)
+{
+	std::vector<unsigned> d(L.nvars(), 0);
+	const sparse_poly::term_vector & terms = A.get_terms();
+	for (sparse_poly::term_vector::const_iterator t = terms.begin(); t != terms.end(); ++t)
+		for (size_t i = 0; i < d.size(); ++i)
+			d[i] = std::max(d[i], L.exponent(t->mon, i));
+	return d;
+}
+
+/** Exact division of A by G, returns false if G does not divide A. */
+bool divide(const monomial_layout & L, const sparse_poly & A, const sparse_poly & G, sparse_poly & Q)
+{
+	std::vector<unsigned> da = degrees(L, A);
+	const std::vector<unsigned> dg = degrees(L, G);
+	for (size_t i = 0; i < da.size(); ++i) {
+		if (dg[i] > da[i])
+			return false;
+		da[i] -= dg[i];
+	}
+	return sparse_poly::divide(A, G, L, L.pack(da), Q);
+}
+
+/** The polynomial c*P. */
+sparse_poly multiply(const sparse_poly & P, const cln::cl_RA & c)
+{
+	sparse_poly::term_vector terms(P.get_terms());
+	for (sparse_poly::term_vector::iterator t = terms.begin(); t != terms.end(); ++t)
+		t->coeff = t->coeff * c;
+	return sparse_poly(terms);
+}
+
+} // anonymous namespace
+
+bool sparse_gcd(const ex & a, const ex & b, const exvector & vars,
+                ex & g, ex * ca, ex * cb)
+{
+	monomial_layout L;
+	std::vector<sparse_poly> ps;
+	exvector es;
+	es.push_back(a);
+	es.push_back(b);
+	if (!ex_to_sparse_polys(es, vars, L, ps) || ps[0].is_zero() || ps[1].is_zero())
+		return false;
+	cln::cl_I conta, contb;
+	if (!integer_content(ps[0], conta) || !integer_content(ps[1], contb))
+		return false;
+	const cln::cl_I c = cln::gcd(conta, contb);
+
+	// Primitive parts, and the leading coefficient of the images.
+	zpoly A, B;
+	const sparse_poly::term_vector & aterms = ps[0].get_terms();
+	const sparse_poly::term_vector & bterms = ps[1].get_terms();
+	for (sparse_poly::term_vector::const_iterator t = aterms.begin(); t != aterms.end(); ++t)
+		A.push_back(std::make_pair(t->mon, cln::exquo(cln::the<cln::cl_I>(t->coeff), conta)));
+	for (sparse_poly::term_vector::const_iterator t = bterms.begin(); t != bterms.end(); ++t)
+		B.push_back(std::make_pair(t->mon, cln::exquo(cln::the<cln::cl_I>(t->coeff), contb)));
+	const cln::cl_I lc = A[0].second * B[0].second;
+	const cln::cl_I gamma = cln::gcd(A[0].second, B[0].second);
+
+	const size_t n = vars.size();
+	zpoly H;
+	cln::cl_I M = 0;
+	packed_monomial lm = 0;
+	mpoly skeleton;
+	unsigned failures = 0;
+	primes_factory primes;
+	long p;
+	while (primes(p, lc)) {
+		if (p > long(field::max_modulus()))
+			return false;
+		const field F(static_cast<uint32_t>(p));
+		zippel z(F, L);
+		const mpoly Ap = reduce(F, A), Bp = reduce(F, B);
+		mpoly G;
+		if (skeleton.empty() || n == 1 || !z.interpolate(Ap, Bp, n, skeleton, G)) {
+			if (!z.gcd(Ap, Bp, n, G)) {
+				if (++failures > 3)
+					return false;
+				continue;
+			}
+		}
+
+		// A constant image means that the GCD is constant. Otherwise,
+		// primes with a larger leading monomial are unlucky, and all
+		// previous primes are if it is smaller.
+		const packed_monomial m = G[0].mon;
+		if (m == 0) {
+			g = numeric(c);
+			if (ca)
+				*ca = sparse_poly_to_ex(multiply(ps[0], cln::recip(cln::cl_RA(c))), vars, L);
+			if (cb)
+				*cb = sparse_poly_to_ex(multiply(ps[1], cln::recip(cln::cl_RA(c))), vars, L);
+			return true;
+		}
+		if (!H.empty() && m > lm)
+			continue;
+		if (H.empty() || m < lm) {
+			H.clear();
+			M = 0;
+			lm = m;
+			skeleton = G;
+		}
+		scale(F, G, F.mul(F.from_uint(uint32_t(cln::cl_I_to_ulong(cln::mod(gamma, p)))),
+		                  F.inv(G[0].coeff)));
+
+		bool changed = true;
+		if (zerop(M)) {
+			for (mpoly::const_iterator t = G.begin(); t != G.end(); ++t) {
+				cln::cl_I x = F.to_uint(t->coeff);
+				if (2*x > p)
+					x = x - p;
+				H.push_back(std::make_pair(t->mon, x));
+			}
+			M = p;
+		} else
+			changed = chinese_remainder(F, H, M, G);
+		if (changed)
+			continue;
+
+		// The images agree, check the primitive part by division.
+		cln::cl_I hcont = 0;
+		for (zpoly::const_iterator t = H.begin(); t != H.end(); ++t)
+			hcont = cln::gcd(hcont, t->second);
+		if (cln::minusp(H[0].second))
+			hcont = -hcont;
+		sparse_poly::term_vector terms;
+		terms.reserve(H.size());
+		for (zpoly::const_iterator t = H.begin(); t != H.end(); ++t)
+			terms.push_back(sparse_poly::term(t->first, cln::exquo(t->second, hcont)));
+		const sparse_poly P(terms);
+		sparse_poly qa, qb;
+		if (divide(L, ps[0], P, qa) && divide(L, ps[1], P, qb)) {
+			g = sparse_poly_to_ex(c == 1 ? P : multiply(P, c), vars, L);
+			if (ca)
+				*ca = sparse_poly_to_ex(c == 1 ? qa : multiply(qa, cln::recip(cln::cl_RA(c))), vars, L);
+			if (cb)
+				*cb = sparse_poly_to_ex(c == 1 ? qb : multiply(qb, cln::recip(cln::cl_RA(c))), vars, L);
+			return true;
+		}
+
+		// The skeleton was wrong, start again.
+		if (++failures > 3)
+			return false;
+		H.clear();
+		M = 0;
+		skeleton.clear();
+	}
+	return false;
+}
+
+} // namespace GiNaC
@@ -0,0 +1,40 @@
+/** @file sparse_gcd.h
+ *
+ *  Interface to the sparse modular GCD of multivariate polynomials. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_POLYNOMIAL_SPARSE_GCD_H
+#define GINAC_POLYNOMIAL_SPARSE_GCD_H
+
+#include "ex.h"
+
+namespace GiNaC {
+
+/** GCD of the polynomials a and b with integer coefficients in the
+ *  variables vars by Zippel's sparse modular algorithm, vars[0] being the
+ *  main variable.  Optionally also computes the cofactors.  Returns false
+ *  (leaving the results untouched) if the polynomials cannot be handled,
+ *  in which case another algorithm has to be used. */
+bool sparse_gcd(const ex & a, const ex & b, const exvector & vars,
+                ex & g, ex * ca = 0, ex * cb = 0);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_POLYNOMIAL_SPARSE_GCD_H
@@ -0,0 +1,608 @@
+/** @file sparse_poly.cpp
+ *
+ *  Implementation of sparse distributed polynomials with packed monomials
+ *  and of the expand() and divide() fast paths built on them. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sparse_poly.h"
+#include "add.h"
+#include "assertion.h"
+#include "mul.h"
+#include "numeric.h"
+#include "operators.h"
+#include "parallel.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cln/integer.h>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace GiNaC {
+
+bool monomial_layout::init(const std::vector<unsigned> & max_exponents)
+{
+	const size_t n = max_exponents.size();
+	shift.resize(n);
+	mask.resize(n);
+	guards = 0;
+	unsigned used = 0;
+	// The last variable goes into the least significant field.
+	for (size_t i = n; i-- > 0; ) {
+		unsigned bits = 0;
+		for (unsigned d = max_exponents[i]; d != 0; d >>= 1)
+			++bits;
+		if (used + bits + 1 > 8*sizeof(packed_monomial))
+			return false;
+		shift[i] = used;
+		mask[i] = (packed_monomial(1) << bits) - 1;
+		guards |= packed_monomial(1) << (used + bits);
+		used += bits + 1;
+	}
+	return true;
+}
+
+packed_monomial monomial_layout::pack(const std::vector<unsigned> & exponents) const
+{
+	packed_monomial m = 0;
+	for (size_t i = 0; i < shift.size(); ++i)
+		m |= packed_monomial(exponents[i]) << shift[i];
+	return m;
+}
+
+namespace {
+
+/** Pending product of the i-th term of one polynomial with the j-th term of
+ *  another one. */
+struct heap_entry
+{
+	heap_entry(packed_monomial m, size_t i_, size_t j_) : mon(m), i(i_), j(j_) { }
+	packed_monomial mon;
+	size_t i, j;
+};
+
+/** Puts the largest monomial on top of the heap. */
+struct heap_less
+{
+	bool operator()(const heap_entry & e1, const heap_entry & e2) const
+	{
+		return e1.mon < e2.mon;
+	}
+};
+
+struct term_greater
+{
+	bool operator()(const sparse_poly::term & t1, const sparse_poly::term & t2) const
+	{
+		return t1.mon > t2.mon;
+	}
+};
+
+/** Multiply the terms [abegin, aend) of a with all terms of b and append the
+ *  result to out (Johnson's algorithm).  The heap contains at most one entry
+ *  per term of a: the one for a[i]*b[j] is replaced by a[i]*b[j+1] when it
+ *  is consumed, and a[i]*b[0] introduces a[i+1]*b[0]. */
+void heap_product(const sparse_poly::term_vector & a, size_t abegin, size_t aend,
+                  const sparse_poly::term_vector & b, sparse_poly::term_vector & out)
+{
+	if (abegin >= aend || b.empty())
+		return;
+	std::vector<heap_entry> heap;
+	heap.reserve(aend - abegin);
+	heap.push_back(heap_entry(a[abegin].mon + b[0].mon, abegin, 0));
+	while (!heap.empty()) {
+		const packed_monomial m = heap.front().mon;
+		cln::cl_RA c = 0;
+		do {
+			std::pop_heap(heap.begin(), heap.end(), heap_less());
+			heap_entry & e = heap.back();
+			const size_t i = e.i;
+			const bool next_row = (e.j == 0 && i + 1 < aend);
+			c += a[i].coeff * b[e.j].coeff;
+			if (++e.j < b.size()) {
+				e.mon = a[i].mon + b[e.j].mon;
+				std::push_heap(heap.begin(), heap.end(), heap_less());
+			} else
+				heap.pop_back();
+			if (next_row) {
+				heap.push_back(heap_entry(a[i + 1].mon + b[0].mon, i + 1, 0));
+				std::push_heap(heap.begin(), heap.end(), heap_less());
+			}
+		} while (!heap.empty() && heap.front().mon == m);
+		if (!zerop(c))
+			out.push_back(sparse_poly::term(m, c));
+	}
+}
+
+/** Below this number of term products multiplication is not parallelized. */
+const size_t parallel_product_threshold = 40000;
+
+/** Copy of a coefficient that shares no memory with the original one, since
+ *  CLN's reference counts must not be touched by several threads at once. */
+cln::cl_RA unshared_copy(const cln::cl_RA & c)
+{
+	const cln::cl_I num = cln::numerator(c) + 1 - 1;
+	if (cln::instanceof(c, cln::cl_I_ring))
+		return num;
+	return num / (cln::denominator(c) + 1 - 1);
+}
+
+/** Multiplies one chunk of the terms of the first polynomial with all terms
+ *  of the second one.  Each thread slot uses its own copy of the second
+ *  polynomial. */
+class product_task : public parallel_task {
+public:
+	product_task(const sparse_poly::term_vector & a_,
+	             const std::vector<sparse_poly::term_vector> & b_, size_t nchunks)
+	 : a(a_), b(b_), chunk_size((a_.size() + nchunks - 1) / nchunks), partial(nchunks) { }
+
+	void run(size_t i, unsigned slot)
+	{
+		const size_t end = std::min((i + 1) * chunk_size, a.size());
+		const size_t begin = std::min(i * chunk_size, end);
+		heap_product(a, begin, end, b[slot], partial[i]);
+	}
+
+	const sparse_poly::term_vector & a;
+	const std::vector<sparse_poly::term_vector> & b;
+	const size_t chunk_size;
+	std::vector<sparse_poly::term_vector> partial;
+};
+
+sparse_poly::term_vector unshared_copy(const sparse_poly::term_vector & v)
+{
+	sparse_poly::term_vector copy;
+	copy.reserve(v.size());
+	for (sparse_poly::term_vector::const_iterator i = v.begin(); i != v.end(); ++i)
+		copy.push_back(sparse_poly::term(i->mon, unshared_copy(i->coeff)));
+	return copy;
+}
+
+} // anonymous namespace
+
+sparse_poly::sparse_poly(packed_monomial m, const cln::cl_RA & c)
+{
+	if (!zerop(c))
+		terms.push_back(term(m, c));
+}
+
+sparse_poly::sparse_poly(const term_vector & t) : terms(t)
+{
+	canonicalize();
+}
+
+void sparse_poly::canonicalize()
+{
+	std::sort(terms.begin(), terms.end(), term_greater());
+	term_vector::iterator out = terms.begin();
+	for (term_vector::const_iterator i = terms.begin(); i != terms.end(); ) {
+		const packed_monomial m = i->mon;
+		cln::cl_RA c = i->coeff;
+		for (++i; i != terms.end() && i->mon == m; ++i)
+			c += i->coeff;
+		if (!zerop(c)) {
+			out->mon = m;
+			out->coeff = c;
+			++out;
+		}
+	}
+	terms.erase(out, terms.end());
+}
+
+sparse_poly sparse_poly::sum(const std::vector<sparse_poly> & v)
+{
+	sparse_poly s;
+	size_t n = 0;
+	for (std::vector<sparse_poly>::const_iterator i = v.begin(); i != v.end(); ++i)
+		n += i->size();
+	s.terms.reserve(n);
+	for (std::vector<sparse_poly>::const_iterator i = v.begin(); i != v.end(); ++i)
+		s.terms.insert(s.terms.end(), i->terms.begin(), i->terms.end());
+	s.canonicalize();
+	return s;
+}
+
+sparse_poly sparse_poly::product(const sparse_poly & a, const sparse_poly & b,
+                                 unsigned nthreads)
+{
+	// The heap holds one entry per term of the first factor, so make it
+	// the shorter one.
+	if (a.size() > b.size())
+		return product(b, a, nthreads);
+
+	sparse_poly p;
+	if (a.is_zero())
+		return p;
+	if (a.size() == 1) {
+		// Multiplication by a term preserves the order.
+		const term & t = a.terms[0];
+		p.terms.reserve(b.size());
+		for (term_vector::const_iterator i = b.terms.begin(); i != b.terms.end(); ++i)
+			p.terms.push_back(term(t.mon + i->mon, t.coeff * i->coeff));
+		return p;
+	}
+
+	if (nthreads > 1 && a.size() * b.size() >= parallel_product_threshold) {
+		// Use more chunks than threads, so that threads finishing early
+		// can pick up the remaining ones.
+		const size_t nchunks = std::min(a.size(), size_t(4) * nthreads);
+		const term_vector a_copy = unshared_copy(a.terms);
+		std::vector<term_vector> b_copies(nthreads);
+		for (unsigned t = 0; t < nthreads; ++t)
+			b_copies[t] = unshared_copy(b.terms);
+		product_task task(a_copy, b_copies, nchunks);
+		parallel_for(nchunks, task, nthreads);
+
+		size_t n = 0;
+		for (size_t i = 0; i < nchunks; ++i)
+			n += task.partial[i].size();
+		p.terms.reserve(n);
+		for (size_t i = 0; i < nchunks; ++i)
+			p.terms.insert(p.terms.end(), task.partial[i].begin(), task.partial[i].end());
+		p.canonicalize();
+		return p;
+	}
+
+	heap_product(a.terms, 0, a.size(), b.terms, p.terms);
+	return p;
+}
+
+sparse_poly sparse_poly::power(const sparse_poly & a, unsigned n, unsigned nthreads)
+{
+	if (n == 0)
+		return sparse_poly(0, 1);
+	if (a.size() == 1)
+		return sparse_poly(a.terms[0].mon * n, cln::expt(a.terms[0].coeff, cln::cl_I(n)));
+	// Repeated multiplication by the (short) base is much cheaper than
+	// squaring for sparse polynomials.
+	sparse_poly p = a;
+	for (unsigned k = 1; k < n; ++k)
+		p = product(a, p, nthreads);
+	return p;
+}
+
+bool sparse_poly::divide(const sparse_poly & a, const sparse_poly & b,
+                         const monomial_layout & layout, packed_monomial qmax,
+                         sparse_poly & q)
+{
+	if (b.is_zero())
+		throw std::overflow_error("sparse_poly::divide: division by zero");
+	q.terms.clear();
+	const term_vector & f = a.terms;
+	const term_vector & g = b.terms;
+	term_vector & quo = q.terms;
+	const packed_monomial lm = g[0].mon;
+	const cln::cl_RA & lc = g[0].coeff;
+
+	// The heap holds the pending products quo[i]*g[j] with j >= 1 (the ones
+	// with j = 0 cancel the leading terms), at most one per quotient term.
+	std::vector<heap_entry> heap;
+	size_t k = 0;
+	while (k < f.size() || !heap.empty()) {
+		packed_monomial m;
+		cln::cl_RA c = 0;
+		if (heap.empty() || (k < f.size() && f[k].mon >= heap.front().mon)) {
+			m = f[k].mon;
+			c = f[k].coeff;
+			++k;
+		} else
+			m = heap.front().mon;
+		while (!heap.empty() && heap.front().mon == m) {
+			std::pop_heap(heap.begin(), heap.end(), heap_less());
+			heap_entry & e = heap.back();
+			c -= quo[e.i].coeff * g[e.j].coeff;
+			if (++e.j < g.size()) {
+				e.mon = quo[e.i].mon + g[e.j].mon;
+				std::push_heap(heap.begin(), heap.end(), heap_less());
+			} else
+				heap.pop_back();
+		}
+		if (zerop(c))
+			continue;
+
+		// The leading term of the remainder must be divisible by lm, and
+		// the quotient must not exceed its degree bounds.
+		if (!layout.divides(lm, m))
+			return false;
+		const packed_monomial qm = m - lm;
+		if (!layout.divides(qm, qmax))
+			return false;
+		quo.push_back(term(qm, c / lc));
+		if (g.size() > 1) {
+			heap.push_back(heap_entry(qm + g[1].mon, quo.size() - 1, 1));
+			std::push_heap(heap.begin(), heap.end(), heap_less());
+		}
+	}
+	return true;
+}
+
+namespace {
+
+/** Variables of sparse polynomials converted from expressions, numbered in
+ *  the order they are encountered. */
+class variable_table
+{
+public:
+	size_t index(const ex & s)
+	{
+		std::pair<std::map<ex, size_t, ex_is_less>::iterator, bool> r =
+			indices.insert(std::make_pair(s, vars.size()));
+		if (r.second)
+			vars.push_back(s);
+		return r.first->second;
+	}
+	size_t find(const ex & s) const
+	{
+		return indices.find(s)->second;
+	}
+	size_t size() const { return vars.size(); }
+	const ex & operator[](size_t i) const { return vars[i]; }
+private:
+	std::map<ex, size_t, ex_is_less> indices;
+	exvector vars;
+};
+
+/** Larger exponents never fit into a packed_monomial together with the
+ *  guard bit, so bounds are capped at this value. */
+const unsigned max_exponent = 1U << 24;
+
+/** Compute upper bounds for the exponents of all symbols in e without
+ *  expanding it, adding the symbols to vars.  The i-th entry of bounds
+ *  belongs to vars[i], missing entries are zero.  Returns false if e is not
+ *  a polynomial over Q in symbols. */
+bool exponent_bounds(const ex & e, variable_table & vars, std::vector<unsigned> & bounds)
+{
+	bounds.clear();
+	if (is_exactly_a<numeric>(e))
+		return ex_to<numeric>(e).is_rational();
+
+	if (is_a<symbol>(e)) {
+		const size_t i = vars.index(e);
+		bounds.resize(i + 1, 0);
+		bounds[i] = 1;
+		return true;
+	}
+
+	if (is_exactly_a<add>(e) || is_exactly_a<mul>(e)) {
+		const bool is_sum = is_exactly_a<add>(e);
+		std::vector<unsigned> b;
+		for (size_t k = 0; k < e.nops(); ++k) {
+			if (!exponent_bounds(e.op(k), vars, b))
+				return false;
+			if (b.size() > bounds.size())
+				bounds.resize(b.size(), 0);
+			for (size_t i = 0; i < b.size(); ++i) {
+				if (is_sum)
+					bounds[i] = std::max(bounds[i], b[i]);
+				else if ((bounds[i] += b[i]) > max_exponent)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	if (is_exactly_a<power>(e)) {
+		const ex & n = e.op(1);
+		if (!n.info(info_flags::posint) || ex_to<numeric>(n) > max_exponent)
+			return false;
+		const unsigned k = ex_to<numeric>(n).to_int();
+		if (!exponent_bounds(e.op(0), vars, bounds))
+			return false;
+		for (size_t i = 0; i < bounds.size(); ++i) {
+			if (bounds[i] > max_exponent / k)
+				return false;
+			bounds[i] *= k;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/** Convert an expression for which exponent_bounds() succeeded. */
+sparse_poly ex_to_sparse_poly(const ex & e, const variable_table & vars,
+                              const monomial_layout & layout, unsigned nthreads)
+{
+	if (is_exactly_a<numeric>(e))
+		return sparse_poly(0, cln::the<cln::cl_RA>(ex_to<numeric>(e).to_cl_N()));
+
+	if (is_a<symbol>(e))
+		return sparse_poly(layout.variable(vars.find(e)), 1);
+
+	if (is_exactly_a<add>(e)) {
+		std::vector<sparse_poly> terms;
+		terms.reserve(e.nops());
+		for (size_t k = 0; k < e.nops(); ++k)
+			terms.push_back(ex_to_sparse_poly(e.op(k), vars, layout, nthreads));
+		return sparse_poly::sum(terms);
+	}
+
+	if (is_exactly_a<mul>(e)) {
+		sparse_poly p = ex_to_sparse_poly(e.op(0), vars, layout, nthreads);
+		for (size_t k = 1; k < e.nops(); ++k)
+			p = sparse_poly::product(p, ex_to_sparse_poly(e.op(k), vars, layout, nthreads), nthreads);
+		return p;
+	}
+
+	GINAC_ASSERT(is_exactly_a<power>(e));
+	return sparse_poly::power(ex_to_sparse_poly(e.op(0), vars, layout, nthreads),
+	                          ex_to<numeric>(e.op(1)).to_int(), nthreads);
+}
+
+ex sparse_poly_to_ex(const sparse_poly & p, const variable_table & vars,
+                     const monomial_layout & layout, unsigned options)
+{
+	epvector seq;
+	seq.reserve(p.size());
+	ex oc = _ex0;
+	const sparse_poly::term_vector & terms = p.get_terms();
+	for (sparse_poly::term_vector::const_iterator t = terms.begin(); t != terms.end(); ++t) {
+		const ex c = (new numeric(t->coeff))->setflag(status_flags::dynallocated);
+		if (t->mon == 0) {
+			oc = c;
+			continue;
+		}
+		epvector factors;
+		for (size_t i = 0; i < vars.size(); ++i) {
+			const unsigned n = layout.exponent(t->mon, i);
+			if (n != 0)
+				factors.push_back(expair(vars[i], numeric(n)));
+		}
+		if (factors.size() == 1)
+			seq.push_back(expair(pow(factors[0].rest, factors[0].coeff), c));
+		else
+			seq.push_back(expair((new mul(std::move(factors)))->setflag(status_flags::dynallocated), c));
+	}
+	return (new add(std::move(seq), oc))->setflag(status_flags::dynallocated |
+	                                   (options == 0 ? status_flags::expanded : 0));
+}
+
+/** Check whether e is a product or power which contains sums, i.e. whether
+ *  there is anything to expand at all. */
+bool is_product_of_sums(const ex & e)
+{
+	if (is_exactly_a<power>(e))
+		return is_exactly_a<add>(e.op(0));
+	if (is_exactly_a<mul>(e)) {
+		for (size_t k = 0; k < e.nops(); ++k)
+			if (is_exactly_a<add>(e.op(k)) ||
+			    (is_exactly_a<power>(e.op(k)) && is_exactly_a<add>(e.op(k).op(0))))
+				return true;
+	}
+	return false;
+}
+
+} // anonymous namespace
+
+bool sparse_expand(const ex & e, ex & result, unsigned options)
+{
+	if (!is_product_of_sums(e))
+		return false;
+
+	variable_table vars;
+	std::vector<unsigned> bounds;
+	if (!exponent_bounds(e, vars, bounds))
+		return false;
+	bounds.resize(vars.size(), 0);
+	monomial_layout layout;
+	if (!layout.init(bounds))
+		return false;
+
+	const unsigned nthreads = (options & expand_options::expand_parallel) ? get_parallel_threads() : 1;
+	const sparse_poly p = ex_to_sparse_poly(e, vars, layout, nthreads);
+	result = sparse_poly_to_ex(p, vars, layout, options);
+	return true;
+}
+
+bool ex_to_sparse_polys(const exvector & es, const exvector & vars,
+                        monomial_layout & layout, std::vector<sparse_poly> & ps)
+{
+	variable_table table;
+	for (size_t i = 0; i < vars.size(); ++i)
+		table.index(vars[i]);
+	std::vector<unsigned> bounds(vars.size(), 0), b;
+	for (size_t k = 0; k < es.size(); ++k) {
+		if (!exponent_bounds(es[k], table, b) || table.size() != vars.size())
+			return false;
+		for (size_t i = 0; i < b.size(); ++i)
+			bounds[i] = std::max(bounds[i], b[i]);
+	}
+	if (!layout.init(bounds))
+		return false;
+
+	ps.clear();
+	ps.reserve(es.size());
+	for (size_t k = 0; k < es.size(); ++k)
+		ps.push_back(ex_to_sparse_poly(es[k], table, layout, 1));
+	return true;
+}
+
+ex sparse_poly_to_ex(const sparse_poly & p, const exvector & vars,
+                     const monomial_layout & layout)
+{
+	variable_table table;
+	for (size_t i = 0; i < vars.size(); ++i)
+		table.index(vars[i]);
+	return sparse_poly_to_ex(p, table, layout, 0);
+}
+
+bool sparse_divide(const ex & a, const ex & b, ex & q, bool & divisible, bool in_z)
+{
+	variable_table vars;
+	std::vector<unsigned> abounds, bbounds;
+	if (!exponent_bounds(a, vars, abounds) || !exponent_bounds(b, vars, bbounds))
+		return false;
+	const size_t n = vars.size();
+	abounds.resize(n, 0);
+	bbounds.resize(n, 0);
+	std::vector<unsigned> bounds(n);
+	for (size_t i = 0; i < n; ++i)
+		bounds[i] = std::max(abounds[i], bbounds[i]);
+	monomial_layout layout;
+	if (!layout.init(bounds))
+		return false;
+
+	const sparse_poly pa = ex_to_sparse_poly(a, vars, layout, 1);
+	const sparse_poly pb = ex_to_sparse_poly(b, vars, layout, 1);
+	if (pb.is_zero())
+		throw std::overflow_error("divide: division by zero");
+	if (pa.is_zero()) {
+		q = _ex0;
+		divisible = true;
+		return true;
+	}
+
+	// The bounds above are only estimates, the exponents of the quotient
+	// are bounded by the actual degrees.
+	std::vector<unsigned> adeg(n, 0), bdeg(n, 0);
+	const sparse_poly::term_vector & aterms = pa.get_terms();
+	const sparse_poly::term_vector & bterms = pb.get_terms();
+	for (size_t i = 0; i < n; ++i) {
+		for (sparse_poly::term_vector::const_iterator t = aterms.begin(); t != aterms.end(); ++t)
+			adeg[i] = std::max(adeg[i], layout.exponent(t->mon, i));
+		for (sparse_poly::term_vector::const_iterator t = bterms.begin(); t != bterms.end(); ++t)
+			bdeg[i] = std::max(bdeg[i], layout.exponent(t->mon, i));
+		if (bdeg[i] > adeg[i]) {
+			divisible = false;
+			return true;
+		}
+		adeg[i] -= bdeg[i];
+	}
+
+	sparse_poly pq;
+	divisible = sparse_poly::divide(pa, pb, layout, layout.pack(adeg), pq);
+	if (divisible && in_z) {
+		const sparse_poly::term_vector & qterms = pq.get_terms();
+		for (sparse_poly::term_vector::const_iterator t = qterms.begin(); t != qterms.end(); ++t) {
+			if (!cln::instanceof(t->coeff, cln::cl_I_ring)) {
+				divisible = false;
+				break;
+			}
+		}
+	}
+	if (divisible)
+		q = sparse_poly_to_ex(pq, vars, layout, 0);
+	return true;
+}
+
+} // namespace GiNaC
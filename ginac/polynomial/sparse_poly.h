@@ -0,0 +1,162 @@
+/** @file sparse_poly.h
+ *
+ *  Sparse distributed multivariate polynomials over Q with exponent vectors
+ *  packed into a machine word. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_POLYNOMIAL_SPARSE_POLY_H
+#define GINAC_POLYNOMIAL_SPARSE_POLY_H
+
+#include "ex.h"
+
+#include <cln/rational.h>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace GiNaC {
+
+/** Exponent vector packed into a single word, see monomial_layout. */
+typedef uint64_t packed_monomial;
+
+/**
+ * Describes how the exponents of a fixed list of variables are packed into
+ * a packed_monomial. Every variable gets a bit field just wide enough for
+ * its maximal exponent plus one guard bit on top, the first variable being
+ * stored in the most significant field.  Thus
+ *
+ * - multiplying monomials is adding words (as long as the maximal exponents
+ *   are respected no carry crosses a field),
+ * - comparing words compares monomials in lexicographic order,
+ * - m1 divides m2 iff no field of m2 - m1 borrows, i.e. iff none of the
+ *   guard bits is set in the difference.
+ *
+ * This is the representation used by Monagan and Pearce, "Sparse Polynomial
+ * Division Using a Heap", J. Symb. Comp. 46 (2011).
+ */
+class monomial_layout
+{
+public:
+	/** Choose fields for variables with the given maximal exponents.
+	 *  Returns false if they do not fit into one packed_monomial. */
+	bool init(const std::vector<unsigned> & max_exponents);
+
+	size_t nvars() const { return shift.size(); }
+	/** The monomial consisting of the i-th variable only. */
+	packed_monomial variable(size_t i) const
+	{
+		return packed_monomial(1) << shift[i];
+	}
+	unsigned exponent(packed_monomial m, size_t i) const
+	{
+		return unsigned((m >> shift[i]) & mask[i]);
+	}
+	/** Pack an exponent vector, the exponents must not exceed the maximal
+	 *  ones given to init(). */
+	packed_monomial pack(const std::vector<unsigned> & exponents) const;
+	/** Test if m1 divides m2. */
+	bool divides(packed_monomial m1, packed_monomial m2) const
+	{
+		return ((m2 - m1) & guards) == 0;
+	}
+private:
+	std::vector<unsigned> shift;
+	std::vector<packed_monomial> mask;
+	packed_monomial guards;
+};
+
+/**
+ * Polynomial over Q in the variables of a monomial_layout, stored as a
+ * vector of terms sorted by decreasing monomials and without zero
+ * coefficients.  Products and quotients are computed term by term using a
+ * heap of pending products, so that the intermediate results never take
+ * more memory than the operands and the result.
+ */
+class sparse_poly
+{
+public:
+	struct term
+	{
+		term(packed_monomial m, const cln::cl_RA & c) : mon(m), coeff(c) { }
+		packed_monomial mon;
+		cln::cl_RA coeff;
+	};
+	typedef std::vector<term> term_vector;
+
+	sparse_poly() { }
+	/** The polynomial c*m. */
+	sparse_poly(packed_monomial m, const cln::cl_RA & c);
+	/** The sum of the terms t, which may be unsorted. */
+	explicit sparse_poly(const term_vector & t);
+
+	bool is_zero() const { return terms.empty(); }
+	size_t size() const { return terms.size(); }
+	const term_vector & get_terms() const { return terms; }
+
+	/** Sum of all polynomials in v. */
+	static sparse_poly sum(const std::vector<sparse_poly> & v);
+	/** Product of a and b, using up to nthreads threads. */
+	static sparse_poly product(const sparse_poly & a, const sparse_poly & b,
+	                           unsigned nthreads = 1);
+	/** n-th power of a. */
+	static sparse_poly power(const sparse_poly & a, unsigned n,
+	                         unsigned nthreads = 1);
+	/** Exact division of a by b.  Returns false if b does not divide a.
+	 *  Exponents of the quotient may not exceed the ones of qmax; if they
+	 *  would, b does not divide a either. */
+	static bool divide(const sparse_poly & a, const sparse_poly & b,
+	                   const monomial_layout & layout, packed_monomial qmax,
+	                   sparse_poly & q);
+private:
+	/** Sort terms and combine the ones with equal monomials. */
+	void canonicalize();
+
+	term_vector terms;
+};
+
+/** Convert the expanded or unexpanded polynomials over Q in es to
+ *  sparse_polys in the given variables, vars[0] being stored in the most
+ *  significant field.  Returns false if one of them contains other symbols
+ *  or if the exponents are too large to be packed into a word. */
+bool ex_to_sparse_polys(const exvector & es, const exvector & vars,
+                        monomial_layout & layout, std::vector<sparse_poly> & ps);
+
+/** Convert a sparse_poly in the given variables back to an expression. */
+ex sparse_poly_to_ex(const sparse_poly & p, const exvector & vars,
+                     const monomial_layout & layout);
+
+/** Expand a polynomial with rational coefficients using sparse_poly.
+ *  Returns false (leaving result untouched) if e is not a polynomial over Q
+ *  in symbols or if its exponents are too large to be packed into a word.
+ *  The option expand_options::expand_parallel multiplies large polynomials
+ *  using several threads. */
+bool sparse_expand(const ex & e, ex & result, unsigned options = 0);
+
+/** Exact division of polynomials over Q using sparse_poly.  Returns false
+ *  if a or b cannot be converted (see sparse_expand()).  Otherwise it
+ *  returns true and sets divisible to whether b divides a, with the quotient
+ *  in q.  If in_z is true, the quotient must have integer coefficients.
+ *  @see divide() */
+bool sparse_divide(const ex & a, const ex & b, ex & q, bool & divisible,
+                   bool in_z = false);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_POLYNOMIAL_SPARSE_POLY_H
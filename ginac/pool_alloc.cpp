@@ -0,0 +1,282 @@
+/** @file pool_alloc.cpp
+ *
+ *  Implementation of GiNaC's allocator for small objects.
+ *
+ *  Blocks of up to max_pooled bytes are rounded up to a multiple of
+ *  granularity and kept in one singly-linked free list per size class.
+ *  Every thread has its own set of free lists, so allocating and releasing
+ *  needs no synchronization.  Since blocks allocated by one thread may be
+ *  released by another one, a thread that accumulates too many free blocks
+ *  passes them on in batches to a shared depot, where other threads pick
+ *  them up before carving up a new chunk.
+ *
+ *  Define GINAC_NO_POOL_ALLOCATOR to pass all requests to ::operator new,
+ *  e.g. when hunting memory errors with valgrind. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "pool_alloc.h"
+
+#include <cstring>
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+namespace GiNaC {
+
+namespace {
+
+#ifdef GINAC_NO_POOL_ALLOCATOR
+const bool use_pool = false;
+#else
+const bool use_pool = true;
+#endif
+
+const std::size_t granularity = 16;
+const std::size_t max_pooled = 256;
+const unsigned num_classes = max_pooled / granularity;
+const std::size_t chunk_size = 64 * 1024;
+
+struct free_block {
+	free_block *next;
+	free_block *next_batch;  ///< links the batches in the depot
+};
+
+/** Free lists and counters of one thread. */
+struct thread_cache {
+	free_block *head[num_classes];
+	unsigned length[num_classes];
+	allocation_counters counters;
+#ifdef GINAC_THREAD_SAFE
+	thread_cache *next_cache;  ///< list of all caches ever created
+	bool in_use;               ///< owned by a running thread
+#endif
+};
+
+inline unsigned size_class(std::size_t size)
+{
+	return size == 0 ? 0 : unsigned((size - 1) / granularity);
+}
+
+/** Increment a counter that may be read by other threads. */
+inline void count(unsigned long & c)
+{
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&c, c + 1, __ATOMIC_RELAXED);
+#else
+	++c;
+#endif
+}
+
+#ifdef GINAC_THREAD_SAFE
+
+/** Number of blocks passed to the depot at once. */
+const unsigned batch_size = 128;
+
+pthread_mutex_t depot_mutex = PTHREAD_MUTEX_INITIALIZER;
+free_block *depot[num_classes];
+thread_cache *all_caches = 0;
+pthread_once_t key_once = PTHREAD_ONCE_INIT;
+pthread_key_t cache_key;
+thread_local thread_cache *my_cache = 0;
+
+void push_to_depot(unsigned cls, free_block *first)
+{
+	pthread_mutex_lock(&depot_mutex);
+	first->next_batch = depot[cls];
+	depot[cls] = first;
+	pthread_mutex_unlock(&depot_mutex);
+}
+
+free_block *pop_from_depot(unsigned cls)
+{
+	pthread_mutex_lock(&depot_mutex);
+	free_block *first = depot[cls];
+	if (first)
+		depot[cls] = first->next_batch;
+	pthread_mutex_unlock(&depot_mutex);
+	return first;
+}
+
+/** Called on thread exit: hand all free blocks to the depot and let the
+ *  next new thread adopt the cache (and its counters). */
+void release_cache(void *arg)
+{
+	thread_cache *c = static_cast<thread_cache *>(arg);
+	for (unsigned cls = 0; cls < num_classes; ++cls) {
+		if (c->head[cls])
+			push_to_depot(cls, c->head[cls]);
+		c->head[cls] = 0;
+		c->length[cls] = 0;
+	}
+	my_cache = 0;
+	__atomic_store_n(&c->in_use, false, __ATOMIC_RELEASE);
+}
+
+void create_key()
+{
+	pthread_key_create(&cache_key, release_cache);
+}
+
+thread_cache *new_cache()
+{
+	pthread_once(&key_once, create_key);
+	thread_cache *c = __atomic_load_n(&all_caches, __ATOMIC_ACQUIRE);
+	for (; c != 0; c = c->next_cache) {
+		if (!__atomic_load_n(&c->in_use, __ATOMIC_RELAXED) &&
+		    !__atomic_exchange_n(&c->in_use, true, __ATOMIC_ACQUIRE))
+			break;
+	}
+	if (!c) {
+		c = static_cast<thread_cache *>(::operator new(sizeof(thread_cache)));
+		std::memset(c, 0, sizeof(thread_cache));
+		c->in_use = true;
+		c->next_cache = __atomic_load_n(&all_caches, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&all_caches, &c->next_cache, c, true,
+		                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+	}
+	my_cache = c;
+	pthread_setspecific(cache_key, c);
+	return c;
+}
+
+inline thread_cache *get_cache()
+{
+	return my_cache ? my_cache : new_cache();
+}
+
+#else // ndef GINAC_THREAD_SAFE
+
+thread_cache the_cache;
+
+inline thread_cache *get_cache()
+{
+	return &the_cache;
+}
+
+#endif // ndef GINAC_THREAD_SAFE
+
+/** Fill the empty free list of a size class. */
+void refill(thread_cache *c, unsigned cls)
+{
+#ifdef GINAC_THREAD_SAFE
+	if (free_block *first = pop_from_depot(cls)) {
+		unsigned n = 0;
+		for (free_block *b = first; b; b = b->next)
+			++n;
+		c->head[cls] = first;
+		c->length[cls] = n;
+		return;
+	}
+#endif
+	const std::size_t size = (cls + 1) * granularity;
+	const std::size_t n = chunk_size / size;
+	char *chunk = static_cast<char *>(::operator new(chunk_size));
+	count(c->counters.chunks);
+	free_block *next = 0;
+	for (std::size_t i = n; i-- > 0; ) {
+		free_block *b = reinterpret_cast<free_block *>(chunk + i * size);
+		b->next = next;
+		next = b;
+	}
+	c->head[cls] = next;
+	c->length[cls] = unsigned(n);
+}
+
+} // anonymous namespace
+
+void *pool_allocate(std::size_t size)
+{
+	thread_cache *c = get_cache();
+	if (!use_pool || size > max_pooled) {
+		count(c->counters.large);
+		return ::operator new(size);
+	}
+	const unsigned cls = size_class(size);
+	if (!c->head[cls])
+		refill(c, cls);
+	free_block *b = c->head[cls];
+	c->head[cls] = b->next;
+	--c->length[cls];
+	count(c->counters.pooled);
+	return b;
+}
+
+void pool_deallocate(void *p, std::size_t size) throw()
+{
+	if (!p)
+		return;
+	thread_cache *c = get_cache();
+	count(c->counters.released);
+	if (!use_pool || size > max_pooled) {
+		::operator delete(p);
+		return;
+	}
+	const unsigned cls = size_class(size);
+	free_block *b = static_cast<free_block *>(p);
+	b->next = c->head[cls];
+	c->head[cls] = b;
+	++c->length[cls];
+#ifdef GINAC_THREAD_SAFE
+	if (c->length[cls] >= 2 * batch_size) {
+		free_block *last = b;
+		for (unsigned i = 1; i < batch_size; ++i)
+			last = last->next;
+		c->head[cls] = last->next;
+		c->length[cls] -= batch_size;
+		last->next = 0;
+		push_to_depot(cls, b);
+	}
+#endif
+}
+
+allocation_counters get_allocation_counters()
+{
+	allocation_counters sum;
+	std::memset(&sum, 0, sizeof(sum));
+#ifdef GINAC_THREAD_SAFE
+	for (thread_cache *c = __atomic_load_n(&all_caches, __ATOMIC_ACQUIRE); c; c = c->next_cache) {
+		sum.pooled += __atomic_load_n(&c->counters.pooled, __ATOMIC_RELAXED);
+		sum.chunks += __atomic_load_n(&c->counters.chunks, __ATOMIC_RELAXED);
+		sum.large += __atomic_load_n(&c->counters.large, __ATOMIC_RELAXED);
+		sum.released += __atomic_load_n(&c->counters.released, __ATOMIC_RELAXED);
+	}
+#else
+	sum = the_cache.counters;
+#endif
+	return sum;
+}
+
+void reset_allocation_counters()
+{
+#ifdef GINAC_THREAD_SAFE
+	// Increments by other threads at the same time may get lost.
+	for (thread_cache *c = __atomic_load_n(&all_caches, __ATOMIC_ACQUIRE); c; c = c->next_cache) {
+		__atomic_store_n(&c->counters.pooled, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&c->counters.chunks, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&c->counters.large, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&c->counters.released, 0, __ATOMIC_RELAXED);
+	}
+#else
+	std::memset(&the_cache.counters, 0, sizeof(allocation_counters));
+#endif
+}
+
+} // namespace GiNaC
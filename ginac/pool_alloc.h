@@ -0,0 +1,102 @@
+/** @file pool_alloc.h
+ *
+ *  Interface to GiNaC's allocator for small objects. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_POOL_ALLOC_H
+#define GINAC_POOL_ALLOC_H
+
+#include <cstddef> // for size_t
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace GiNaC {
+
+/** Allocate size bytes.  Small blocks are taken from per-thread free lists
+ *  of a few size classes, which are refilled in large chunks; larger ones
+ *  come from ::operator new.  Memory of small blocks is recycled but never
+ *  returned to the system.  The block must be released with
+ *  pool_deallocate() using the same size. */
+void *pool_allocate(std::size_t size);
+
+/** Release a block obtained from pool_allocate(size). */
+void pool_deallocate(void *p, std::size_t size) throw();
+
+/** Counters of the small object allocator, summed over all threads. */
+struct allocation_counters {
+	unsigned long pooled;    ///< requests served from a free list
+	unsigned long chunks;    ///< 64 KiB chunks requested from the system to refill the free lists
+	unsigned long large;     ///< requests passed on to ::operator new
+	unsigned long released;  ///< blocks returned to the allocator
+};
+
+/** Return the current values of the allocation counters. */
+allocation_counters get_allocation_counters();
+
+/** Set all allocation counters to zero. */
+void reset_allocation_counters();
+
+/** STL allocator taking its memory from pool_allocate(). */
+template <class T>
+class pool_allocator {
+public:
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef T value_type;
+
+	template <class U> struct rebind { typedef pool_allocator<U> other; };
+
+	pool_allocator() throw() {}
+	pool_allocator(const pool_allocator &) throw() {}
+	template <class U> pool_allocator(const pool_allocator<U> &) throw() {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		if (n > max_size())
+			throw std::bad_alloc();
+		return static_cast<pointer>(pool_allocate(n * sizeof(T)));
+	}
+	void deallocate(pointer p, size_type n) { pool_deallocate(p, n * sizeof(T)); }
+
+	size_type max_size() const throw() { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	template <class U, class... Args>
+	void construct(U *p, Args &&... args) { ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...); }
+	template <class U>
+	void destroy(U *p) { p->~U(); }
+};
+
+template <class T, class U>
+inline bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) { return true; }
+
+template <class T, class U>
+inline bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) { return false; }
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_POOL_ALLOC_H
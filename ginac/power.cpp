@@ -760,7 +760,7 @@ ex power::derivative(const symbol & s) const
 		newseq.reserve(2);
 		newseq.push_back(expair(basis, exponent - _ex1));
 		newseq.push_back(expair(basis.diff(s), _ex1));
-		return mul(newseq, exponent);
+		return (new mul(std::move(newseq), exponent))->setflag(status_flags::dynallocated);
 	} else {
 		// D(b^e) = b^e * (D(e)*ln(b) + e*D(b)/b)
 		return mul(*this,
@@ -1024,7 +1024,7 @@ ex power::expand_add_2(const add & a, unsigned options) const
 	
 	GINAC_ASSERT(sum.size()==(a_nops*(a_nops+1))/2);
 	
-	return (new add(sum))->setflag(status_flags::dynallocated | status_flags::expanded);
+	return (new add(std::move(sum)))->setflag(status_flags::dynallocated | status_flags::expanded);
 }
 
 /** Expand factors of m in m^n where m is a mul and n is an integer.
@@ -1066,11 +1066,11 @@ ex power::expand_mul(const mul & m, const numeric & n, unsigned options, bool fr
 			// the resulting product needs to be reexpanded
 			need_reexpand = true;
 		}
-		distrseq.push_back(p);
+		distrseq.push_back(std::move(p));
 		++cit;
 	}
 
-	const mul & result = static_cast<const mul &>((new mul(distrseq, ex_to<numeric>(m.overall_coeff).power_dyn(n)))->setflag(status_flags::dynallocated));
+	const mul & result = static_cast<const mul &>((new mul(std::move(distrseq), ex_to<numeric>(m.overall_coeff).power_dyn(n)))->setflag(status_flags::dynallocated));
 	if (need_reexpand)
 		return ex(result).expand(options);
 	if (from_expand)
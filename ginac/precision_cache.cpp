@@ -0,0 +1,140 @@
+/** @file precision_cache.cpp
+ *
+ *  Implementation of the bookkeeping of floating point values which are
+ *  kept across changes of the precision.  The values themselves live with
+ *  the code using them, in numeric.cpp and inifcns_nstdsums.cpp. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "precision_cache.h"
+
+#include <iostream>
+
+namespace GiNaC {
+namespace precision_cache {
+
+namespace {
+
+std::size_t budget = 64 << 20;
+std::size_t total_bytes = 0;
+statistics stats[num_kinds];
+
+// The statistics are updated in the polylogarithm code of every thread, so
+// they are counted with atomic operations instead of under a lock.
+#ifdef GINAC_THREAD_SAFE
+template <class T> inline T load(const T & x) { return __atomic_load_n(&x, __ATOMIC_RELAXED); }
+template <class T> inline void store(T & x, T v) { __atomic_store_n(&x, v, __ATOMIC_RELAXED); }
+template <class T> inline void add(T & x, T v) { __atomic_fetch_add(&x, v, __ATOMIC_RELAXED); }
+template <class T> inline void sub(T & x, T v) { __atomic_fetch_sub(&x, v, __ATOMIC_RELAXED); }
+#else
+template <class T> inline T load(const T & x) { return x; }
+template <class T> inline void store(T & x, T v) { x = v; }
+template <class T> inline void add(T & x, T v) { x += v; }
+template <class T> inline void sub(T & x, T v) { x -= v; }
+#endif
+
+} // anonymous namespace
+
+void set_memory_budget(std::size_t bytes)
+{
+	store(budget, bytes);
+}
+
+std::size_t get_memory_budget()
+{
+	return load(budget);
+}
+
+statistics get_statistics(kind k)
+{
+	statistics s;
+	s.bytes = load(stats[k].bytes);
+	s.hits = load(stats[k].hits);
+	s.truncations = load(stats[k].truncations);
+	s.computations = load(stats[k].computations);
+	s.evictions = load(stats[k].evictions);
+	return s;
+}
+
+void reset_statistics()
+{
+	for (int k = 0; k < num_kinds; ++k) {
+		store(stats[k].hits, 0UL);
+		store(stats[k].truncations, 0UL);
+		store(stats[k].computations, 0UL);
+		store(stats[k].evictions, 0UL);
+	}
+}
+
+std::ostream & operator<<(std::ostream & os, const statistics & s)
+{
+	return os << s.bytes << " bytes, " << s.hits << " hits, "
+	          << s.truncations << " truncations, " << s.computations
+	          << " computations, " << s.evictions << " evictions";
+}
+
+void record(kind k, event e)
+{
+	switch (e) {
+		case hit:
+			add(stats[k].hits, 1UL);
+			break;
+		case truncation:
+			add(stats[k].truncations, 1UL);
+			break;
+		case computation:
+			add(stats[k].computations, 1UL);
+			break;
+		case eviction:
+			add(stats[k].evictions, 1UL);
+			break;
+	}
+}
+
+bool reserve(kind k, std::size_t bytes)
+{
+#ifdef GINAC_THREAD_SAFE
+	std::size_t old = __atomic_load_n(&total_bytes, __ATOMIC_RELAXED);
+	do {
+		if (old + bytes > load(budget))
+			return false;
+	} while (!__atomic_compare_exchange_n(&total_bytes, &old, old + bytes, true,
+	                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#else
+	if (total_bytes + bytes > budget)
+		return false;
+	total_bytes += bytes;
+#endif
+	add(stats[k].bytes, bytes);
+	return true;
+}
+
+void release(kind k, std::size_t bytes)
+{
+	sub(total_bytes, bytes);
+	sub(stats[k].bytes, bytes);
+}
+
+bool within_budget()
+{
+	return load(total_bytes) <= load(budget);
+}
+
+} // namespace precision_cache
+} // namespace GiNaC
@@ -0,0 +1,108 @@
+/** @file precision_cache.h
+ *
+ *  Interface to the bookkeeping of floating point values which are kept
+ *  across changes of the precision. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_PRECISION_CACHE_H
+#define GINAC_PRECISION_CACHE_H
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace GiNaC {
+
+/** The lookup tables used for evaluating the Nielsen polylogarithms
+ *  S(n,p,x) are remembered at the highest precision computed so far.
+ *  Requests for a lower precision are served by rounding the remembered
+ *  tables, so that alternating between precisions does not recompute them
+ *  every time.  The memory spent on remembered tables is bounded by a
+ *  budget; tables which do not fit are not remembered.  The tables belong
+ *  to the thread that computed them.
+ *
+ *  CLN itself remembers the values of the constants Pi, Euler and Catalan
+ *  in the same way.  Their requests are counted here, too, but their memory
+ *  is neither accounted for nor bounded by the budget.
+ *
+ *  The statistics are updated without a lock, so a snapshot taken while
+ *  other threads are evaluating need not be consistent. */
+namespace precision_cache {
+
+/** Kinds of remembered values. */
+enum kind {
+	constants,       ///< values of Pi, Euler and Catalan (counted only)
+	polylog_tables,  ///< lookup tables of the Nielsen polylogarithms
+	num_kinds
+};
+
+/** Usage of the cache of one kind of values. */
+struct statistics {
+	std::size_t bytes;           ///< approximate memory of remembered values
+	unsigned long hits;          ///< requests at the remembered precision
+	unsigned long truncations;   ///< requests served by rounding a more precise value
+	unsigned long computations;  ///< requests requiring a new computation
+	unsigned long evictions;     ///< values dropped to stay within the budget
+};
+
+/** Set the maximum memory in bytes used for remembered values.  Values
+ *  exceeding a lowered budget are dropped when they are next used. */
+void set_memory_budget(std::size_t bytes);
+
+/** Return the maximum memory in bytes used for remembered values. */
+std::size_t get_memory_budget();
+
+/** Return the usage of the cache of the given kind of values. */
+statistics get_statistics(kind k);
+
+/** Set the request and eviction counts of all kinds to zero. */
+void reset_statistics();
+
+/** Print the usage of the cache of one kind of values. */
+std::ostream & operator<<(std::ostream & os, const statistics & s);
+
+/** Events counted in the statistics. */
+enum event { hit, truncation, computation, eviction };
+
+/** Count an event for the given kind of values. */
+void record(kind k, event e);
+
+/** Return the approximate memory in bytes of a real floating point number
+ *  with the given number of mantissa bits. */
+inline std::size_t float_bytes(long bits)
+{
+	return std::size_t(bits + 7) / 8 + 16;
+}
+
+/** Account for remembering a value of the given size.  Returns false,
+ *  accounting nothing, if this would exceed the budget. */
+bool reserve(kind k, std::size_t bytes);
+
+/** Account for forgetting a value of the given size. */
+void release(kind k, std::size_t bytes);
+
+/** Return whether the remembered values fit into the budget, which may
+ *  have been lowered since they were stored.  Otherwise they should be
+ *  forgotten when they are next used. */
+bool within_budget();
+
+} // namespace precision_cache
+} // namespace GiNaC
+
+#endif // ndef GINAC_PRECISION_CACHE_H
@@ -21,8 +21,19 @@
  */
 
 #include "print.h"
+#include "constant.h"
+#include "ex.h"
+#include "hash_map.h"
+#include "lst.h"
+#include "numeric.h"
+#include "operators.h"
+#include "power.h"
+#include "symbol.h"
+#include "utils.h"
 
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 
 namespace GiNaC {
 
@@ -39,6 +50,7 @@ GINAC_IMPLEMENT_PRINT_CONTEXT(print_tree, print_context)
 GINAC_IMPLEMENT_PRINT_CONTEXT(print_csrc, print_context)
 GINAC_IMPLEMENT_PRINT_CONTEXT(print_csrc_float, print_csrc)
 GINAC_IMPLEMENT_PRINT_CONTEXT(print_csrc_double, print_csrc)
+GINAC_IMPLEMENT_PRINT_CONTEXT(print_csrc_cse, print_csrc)
 GINAC_IMPLEMENT_PRINT_CONTEXT(print_csrc_cl_N, print_csrc)
 
 print_context::print_context()
@@ -88,9 +100,157 @@ print_csrc_double::print_csrc_double()
 print_csrc_double::print_csrc_double(std::ostream & os, unsigned opt)
 	: print_csrc(os, opt) {}
 
+print_csrc_cse::print_csrc_cse()
+	: print_csrc(std::cout), result_name("res") {}
+print_csrc_cse::print_csrc_cse(std::ostream & os, const std::string & result, unsigned opt)
+	: print_csrc(os, opt), result_name(result) {}
+
 print_csrc_cl_N::print_csrc_cl_N()
 	: print_csrc(std::cout) {}
 print_csrc_cl_N::print_csrc_cl_N(std::ostream & os, unsigned opt)
 	: print_csrc(os, opt) {}
 
+namespace {
+
+/** Integer powers with larger exponents are printed with pow(). */
+const int max_powering_exponent = 1024;
+
+/** Writes the statements for print_csrc_statements().  The expression is rebuilt
+ *  bottom-up with every subexpression that occurs more than once replaced
+ *  by a temporary, whose declaration is printed when it is first needed. */
+class cse_printer : public map_function {
+public:
+	cse_printer(std::ostream & s_, unsigned options_) : s(s_), options(options_), num_temps(0) {}
+
+	void count(const ex & e);
+	ex operator()(const ex & e);
+
+private:
+	static bool is_atom(const ex & e)
+	{
+		return is_a<symbol>(e) || is_a<numeric>(e) || is_a<constant>(e);
+	}
+
+	ex temporary(const ex & value);
+	ex square(const ex & basis, unsigned j);
+	ex integer_power(const ex & basis, int n);
+
+	std::ostream & s;
+	unsigned options;                ///< for print_csrc_double
+	exhashmap<unsigned> uses;        ///< number of occurrences of subexpressions
+	exhashmap<ex> replacements;      ///< temporaries holding subexpressions
+	unsigned num_temps;
+};
+
+/** Count the occurrences of e and of its subexpressions.  The operands of
+ *  a repeated subexpression are only counted once, because it is only
+ *  computed once. */
+void cse_printer::count(const ex & e)
+{
+	if (is_atom(e) || ++uses[e] > 1)
+		return;
+	for (size_t i = 0; i < e.nops(); ++i)
+		count(e.op(i));
+}
+
+/** Return e with repeated subexpressions replaced by temporaries. */
+ex cse_printer::operator()(const ex & e)
+{
+	if (is_atom(e))
+		return e;
+	exhashmap<ex>::const_iterator found = replacements.find(e);
+	if (found != replacements.end())
+		return found->second;
+
+	ex result;
+	if (is_exactly_a<power>(e) && is_exactly_a<numeric>(e.op(1))
+	 && ex_to<numeric>(e.op(1)).is_integer()
+	 && abs(ex_to<numeric>(e.op(1))) <= max_powering_exponent)
+		result = integer_power((*this)(e.op(0)), ex_to<numeric>(e.op(1)).to_int());
+	else
+		result = e.map(*this);
+
+	if (uses[e] > 1 && !is_atom(result)) {
+		result = temporary(result);
+		replacements[e] = result;
+	}
+	return result;
+}
+
+/** Print the declaration of a new temporary with the given value and
+ *  return its symbol. */
+ex cse_printer::temporary(const ex & value)
+{
+	std::ostringstream name;
+	name << "cse" << num_temps++;
+	const symbol t(name.str());
+	s << "double " << t.get_name() << " = ";
+	value.print(print_csrc_double(s, options));
+	s << ";\n";
+	return t;
+}
+
+/** Return a temporary holding basis^(2^j), for a symbol basis.  The
+ *  squares are shared by all powers of the same basis. */
+ex cse_printer::square(const ex & basis, unsigned j)
+{
+	if (j == 0)
+		return basis;
+	const ex key = pow(basis, numeric(1 << j));
+	exhashmap<ex>::const_iterator found = replacements.find(key);
+	if (found != replacements.end())
+		return found->second;
+	const ex t = temporary(pow(square(basis, j - 1), 2));
+	replacements[key] = t;
+	return t;
+}
+
+/** Return basis^n, computed from squares of basis by binary powering. */
+ex cse_printer::integer_power(const ex & basis, int n)
+{
+	unsigned k = std::abs(n);
+	if (k < 4) {
+		// basis^2 and basis^3 of a symbol are printed as products
+		const ex b = is_atom(basis) ? basis : temporary(basis);
+		return pow(b, n);
+	}
+
+	const ex b = is_a<symbol>(basis) ? basis : temporary(basis);
+	ex result = _ex1;
+	for (unsigned j = 0; k != 0; ++j, k >>= 1)
+		if (k & 1)
+			result *= square(b, j);
+	if (n < 0)
+		result = pow(is_a<symbol>(result) ? result : temporary(result), -1);
+	return result;
+}
+
+} // anonymous namespace
+
+void print_csrc_statements(const ex & obj, std::ostream & s, const std::string & result_name, unsigned options)
+{
+	cse_printer p(s, options);
+	if (is_a<lst>(obj)) {
+		for (size_t i = 0; i < obj.nops(); ++i)
+			p.count(obj.op(i));
+		for (size_t i = 0; i < obj.nops(); ++i) {
+			const ex value = p(obj.op(i));
+			s << result_name << "[" << i << "] = ";
+			value.print(print_csrc_double(s, options));
+			s << ";\n";
+		}
+	} else {
+		p.count(obj);
+		const ex value = p(obj);
+		s << result_name << " = ";
+		value.print(print_csrc_double(s, options));
+		s << ";\n";
+	}
+}
+
+void print_csrc_cse::print_statements(const ex & obj) const
+{
+	print_csrc_statements(obj, s, result_name, options);
+}
+
 } // namespace GiNaC
@@ -31,6 +31,8 @@
 
 namespace GiNaC {
 
+class ex;
+
 /** This class stores information about a registered print_context class. */
 class print_context_options {
 public:
@@ -176,6 +178,31 @@ public:
 	print_csrc_cl_N(std::ostream &, unsigned options = 0);
 };
 
+/** Context for C source output using double precision, in which common
+ *  subexpressions and the squares needed for integer powers are computed
+ *  only once.  An expression printed with it is output as the statements
+ *  of print_csrc_statements(), assigning the value to result_name. */
+class print_csrc_cse : public print_csrc
+{
+	GINAC_DECLARE_PRINT_CONTEXT(print_csrc_cse, print_csrc)
+public:
+	print_csrc_cse(std::ostream &, const std::string & result = "res", unsigned options = 0);
+
+	/** Output the statements computing obj.  The print dispatch calls this
+	 *  instead of a print method when an object is printed with this
+	 *  context; the subexpressions are printed with print_csrc_double. */
+	void print_statements(const ex & obj) const;
+
+	const std::string result_name; /**< variable to assign the result to */
+};
+
+/** Output C statements computing obj in double precision, in which common
+ *  subexpressions and the squares needed for integer powers are computed
+ *  only once: declarations "double cse0 = ...;" of temporaries, followed
+ *  by the assignment "<result> = ...;" (or "<result>[i] = ...;" for each
+ *  element i if obj is a lst).  The options are those of print_csrc_double. */
+void print_csrc_statements(const ex & obj, std::ostream & os, const std::string & result = "res", unsigned options = 0);
+
 /** Check if obj is a T, including base classes. */
 template <class T>
 inline bool is_a(const print_context & obj)
@@ -238,9 +265,9 @@ private:
  *  implements the actual function call. */
 class print_functor {
 public:
-	print_functor() : impl(0) {}
+	print_functor() {}
 	print_functor(const print_functor & other) : impl(other.impl.get() ? other.impl->duplicate() : 0) {}
-	print_functor(std::auto_ptr<print_functor_impl> impl_) : impl(impl_) {}
+	print_functor(std::unique_ptr<print_functor_impl> impl_) : impl(std::move(impl_)) {}
 
 	template <class T, class C>
 	print_functor(void f(const T &, const C &, unsigned)) : impl(new print_ptrfun_handler<T, C>(f)) {}
@@ -265,7 +292,7 @@ public:
 	bool is_valid() const { return impl.get(); }
 
 private:
-	std::auto_ptr<print_functor_impl> impl;
+	std::unique_ptr<print_functor_impl> impl;
 };
 
 
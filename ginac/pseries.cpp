@@ -22,6 +22,8 @@
  */
 
 #include "pseries.h"
+#include "dense_series.h"
+#include "lazy_series.h"
 #include "add.h"
 #include "inifcns.h" // for Order function
 #include "lst.h"
@@ -836,45 +838,8 @@ ex pseries::mul_series(const pseries &other) const
 		return pseries(relational(var,point), nul);
 	}
 
-	if (seq.empty() || other.seq.empty()) {
-		return (new pseries(var==point, epvector()))
-		       ->setflag(status_flags::dynallocated);
-	}
-	
 	// Series multiplication
-	epvector new_seq;
-	int a_max = degree(var);
-	int b_max = other.degree(var);
-	int a_min = ldegree(var);
-	int b_min = other.ldegree(var);
-	int cdeg_min = a_min + b_min;
-	int cdeg_max = a_max + b_max;
-	
-	int higher_order_a = std::numeric_limits<int>::max();
-	int higher_order_b = std::numeric_limits<int>::max();
-	if (is_order_function(coeff(var, a_max)))
-		higher_order_a = a_max + b_min;
-	if (is_order_function(other.coeff(var, b_max)))
-		higher_order_b = b_max + a_min;
-	int higher_order_c = std::min(higher_order_a, higher_order_b);
-	if (cdeg_max >= higher_order_c)
-		cdeg_max = higher_order_c - 1;
-	
-	for (int cdeg=cdeg_min; cdeg<=cdeg_max; ++cdeg) {
-		ex co = _ex0;
-		// c(i)=a(0)b(i)+...+a(i)b(0)
-		for (int i=a_min; cdeg-i>=b_min; ++i) {
-			ex a_coeff = coeff(var, i);
-			ex b_coeff = other.coeff(var, cdeg-i);
-			if (!is_order_function(a_coeff) && !is_order_function(b_coeff))
-				co += a_coeff * b_coeff;
-		}
-		if (!co.is_zero())
-			new_seq.push_back(expair(co, numeric(cdeg)));
-	}
-	if (higher_order_c < std::numeric_limits<int>::max())
-		new_seq.push_back(expair(Order(_ex1), numeric(higher_order_c)));
-	return pseries(relational(var, point), new_seq);
+	return dense_series(*this).mul(dense_series(other)).to_pseries(relational(var, point));
 }
 
 
@@ -883,7 +848,7 @@ ex pseries::mul_series(const pseries &other) const
  *  @see ex::series */
 ex mul::series(const relational & r, int order, unsigned options) const
 {
-	pseries acc; // Series accumulator
+	dense_series acc; // Series accumulator
 
 	GINAC_ASSERT(is_a<symbol>(r.lhs()));
 	const ex& sym = r.lhs();
@@ -891,6 +856,11 @@ ex mul::series(const relational & r, int order, unsigned options) const
 	// holds ldegrees of the series of individual factors
 	std::vector<int> ldegrees;
 	std::vector<bool> ldegree_redo;
+	// holds the series of the individual factors, or of their bases if the
+	// exponents are integers, which keep the coefficients computed while
+	// looking for the ldegrees
+	std::vector<lazy_series> factor_series;
+	std::vector<int> factors;
 
 	// find minimal degrees
 	const epvector::const_iterator itbeg = seq.begin();
@@ -908,6 +878,8 @@ ex mul::series(const relational & r, int order, unsigned options) const
 		} else {
 			buf = recombine_pair_to_ex(*it);
 		}
+		factor_series.push_back(lazy_series(buf, r, options));
+		factors.push_back(factor);
 
 		int real_ldegree = 0;
 		bool flag_redo = false;
@@ -919,16 +891,12 @@ ex mul::series(const relational & r, int order, unsigned options) const
 			if ( factor < 0 ) {
 				// This case must terminate, otherwise we would have division by
 				// zero.
-				int orderloop = 0;
-				do {
-					orderloop++;
-					real_ldegree = buf.series(r, orderloop, options).ldegree(sym);
-				} while (real_ldegree == orderloop);
+				real_ldegree = factor_series.back().ldegree();
 			} else {
 				// Here it is possible that buf does not have a ldegree, therefore
 				// check only if ldegree is negative, otherwise reconsider the case
 				// in the second round.
-				real_ldegree = buf.series(r, 0, options).ldegree(sym);
+				real_ldegree = factor_series.back().ldegree(0);
 				if (real_ldegree == 0)
 					flag_redo = true;
 			}
@@ -942,29 +910,16 @@ ex mul::series(const relational & r, int order, unsigned options) const
 	// Second round: determine the remaining positive ldegrees by the series
 	// method.
 	// here we can ignore ldegrees larger than degbound
-	size_t j = 0;
-	for (epvector::const_iterator it=itbeg; it!=itend; ++it) {
+	for (size_t j = 0; j < ldegrees.size(); ++j) {
 		if ( ldegree_redo[j] ) {
-			ex expon = it->coeff;
-			int factor = 1;
-			ex buf;
-			if (expon.info(info_flags::integer)) {
-				buf = it->rest;
-				factor = ex_to<numeric>(expon).to_int();
-			} else {
-				buf = recombine_pair_to_ex(*it);
-			}
-			int real_ldegree = 0;
-			int orderloop = 0;
-			do {
-				orderloop++;
-				real_ldegree = buf.series(r, orderloop, options).ldegree(sym);
-			} while ((real_ldegree == orderloop)
-					&& ( factor*real_ldegree < degbound));
+			const int factor = factors[j];
+			// smallest positive ldegree which makes factor*ldegree reach
+			// the bound
+			const int limit = degbound > factor ? (degbound + factor - 1) / factor : 1;
+			const int real_ldegree = factor_series[j].ldegree(limit);
 			ldegrees[j] = factor * real_ldegree;
 			degbound -= factor * real_ldegree;
 		}
-		j++;
 	}
 
 	int degsum = std::accumulate(ldegrees.begin(), ldegrees.end(), 0);
@@ -976,20 +931,20 @@ ex mul::series(const relational & r, int order, unsigned options) const
 	}
 
 	// Multiply with remaining terms
-	std::vector<int>::const_iterator itd = ldegrees.begin();
-	for (epvector::const_iterator it=itbeg; it!=itend; ++it, ++itd) {
+	for (size_t j = 0; j < ldegrees.size(); ++j) {
 
-		// do series expansion with adjusted order
-		ex op = recombine_pair_to_ex(*it).series(r, order-degsum+(*itd), options);
+		// do series expansion with adjusted order, continuing from the
+		// coefficients already computed
+		ex op = factor_series[j].power(factors[j]).series(order-degsum+ldegrees[j]);
 
 		// Series multiplication
-		if (it == itbeg)
-			acc = ex_to<pseries>(op);
+		if (j == 0)
+			acc = dense_series(ex_to<pseries>(op));
 		else
-			acc = ex_to<pseries>(acc.mul_series(ex_to<pseries>(op)));
+			acc = acc.mul(dense_series(ex_to<pseries>(op)));
 	}
 
-	return acc.mul_const(ex_to<numeric>(overall_coeff));
+	return acc.to_pseries(r).mul_const(ex_to<numeric>(overall_coeff));
 }
 
 
@@ -1049,38 +1004,16 @@ ex pseries::power_const(const numeric &p, int deg) const
 	if (seq.size() == 1 && is_order_function(seq[0].rest) && p.real().is_negative())
 		throw pole_error("pseries::power_const(): division by zero",1);
 	
-	// Compute coefficients of the powered series
-	exvector co;
-	co.reserve(numcoeff);
-	co.push_back(power(coeff(var, ldeg), p));
-	for (int i=1; i<numcoeff; ++i) {
-		ex sum = _ex0;
-		for (int j=1; j<=i; ++j) {
-			ex c = coeff(var, j + ldeg);
-			if (is_order_function(c)) {
-				co.push_back(Order(_ex1));
-				break;
-			} else
-				sum += (p * j - (i - j)) * co[i - j] * c;
-		}
-		co.push_back(sum / coeff(var, ldeg) / i);
-	}
-	
-	// Construct new series (of non-zero coefficients)
-	epvector new_seq;
-	bool higher_order = false;
-	for (int i=0; i<numcoeff; ++i) {
-		if (!co[i].is_zero())
-			new_seq.push_back(expair(co[i], p * ldeg + i));
-		if (is_order_function(co[i])) {
-			higher_order = true;
-			break;
-		}
+	// O(x^n)^m = O(x^(n*m))
+	if (seq.size() == 1 && is_order_function(seq[0].rest)) {
+		epvector epv;
+		epv.push_back(expair(Order(_ex1), p * ldeg));
+		return (new pseries(relational(var,point), epv))
+		       ->setflag(status_flags::dynallocated);
 	}
-	if (!higher_order)
-		new_seq.push_back(expair(Order(_ex1), p * ldeg + numcoeff));
 
-	return pseries(relational(var,point), new_seq);
+	// Compute coefficients of the powered series
+	return dense_series(*this).power(p, deg).to_pseries(relational(var,point));
 }
 
 
@@ -1167,21 +1100,17 @@ ex power::series(const relational & r, int order, unsigned options) const
 	}
 	const ex& sym = r.lhs();
 	// find existing minimal degree
+	const lazy_series basis_series(basis, r, options);
 	ex eb = basis.expand();
 	int real_ldegree = 0;
 	if (eb.info(info_flags::rational_function))
 		real_ldegree = eb.ldegree(sym-r.rhs());
-	if (real_ldegree == 0) {
-		int orderloop = 0;
-		do {
-			orderloop++;
-			real_ldegree = basis.series(r, orderloop, options).ldegree(sym);
-		} while (real_ldegree == orderloop);
-	}
+	if (real_ldegree == 0)
+		real_ldegree = basis_series.ldegree();
 
 	if (!(real_ldegree*numexp).is_integer())
 		throw std::runtime_error("pseries::power_const(): trying to assemble a Puiseux series");
-	ex e = basis.series(r, (order + real_ldegree*(1-numexp)).to_int(), options);
+	ex e = basis_series.series((order + real_ldegree*(1-numexp)).to_int());
 	
 	ex result;
 	try {
@@ -24,6 +24,7 @@
 #define GINAC_PTR_H
 
 #include "assertion.h"
+#include "stats.h"
 
 #include <cstddef> // for size_t
 #include <functional>
@@ -31,15 +32,37 @@
 
 namespace GiNaC {
 
-/** Base class for reference-counted objects. */
+/** Base class for reference-counted objects.
+ *
+ *  If GINAC_THREAD_SAFE is defined (configure with --enable-thread-safe),
+ *  the reference counter is manipulated with atomic operations so that
+ *  objects can be shared between threads. */
 class refcounted {
 public:
 	refcounted() throw() : refcount(0) {}
 
+#ifdef GINAC_THREAD_SAFE
+	unsigned int add_reference() throw() { return __atomic_add_fetch(&refcount, 1, __ATOMIC_RELAXED); }
+	unsigned int remove_reference() throw() { return __atomic_sub_fetch(&refcount, 1, __ATOMIC_ACQ_REL); }
+	unsigned int get_refcount() const throw() { return __atomic_load_n(&refcount, __ATOMIC_ACQUIRE); }
+	void set_refcount(unsigned int r) throw() { __atomic_store_n(&refcount, r, __ATOMIC_RELEASE); }
+	/** Add a reference unless the object is about to be deleted. */
+	bool try_add_reference() throw()
+	{
+		unsigned int r = __atomic_load_n(&refcount, __ATOMIC_RELAXED);
+		do {
+			if (r == 0)
+				return false;
+		} while (!__atomic_compare_exchange_n(&refcount, &r, r + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+		return true;
+	}
+#else
 	unsigned int add_reference() throw() { return ++refcount; }
 	unsigned int remove_reference() throw() { return --refcount; }
 	unsigned int get_refcount() const throw() { return refcount; }
 	void set_refcount(unsigned int r) throw() { refcount = r; }
+	bool try_add_reference() throw() { return refcount != 0 && ++refcount; }
+#endif
 
 private:
 	unsigned int refcount; ///< reference counter
@@ -56,9 +79,10 @@ private:
 template <class T> class ptr {
 	friend class std::less< ptr<T> >;
 
-	// NB: This implementation of reference counting is not thread-safe.
-	// The reference counter needs to be incremented/decremented atomically,
-	// and makewritable() requires locking.
+	// NB: This implementation of reference counting is only thread-safe if
+	// GINAC_THREAD_SAFE is defined.  Even then, a single ptr object must not
+	// be modified by one thread while another thread accesses it; only the
+	// pointee may be shared.
 
 public:
     // no default ctor: a ptr is never unbound
@@ -67,9 +91,9 @@ public:
 	ptr(T *t) throw() : p(t) { GINAC_ASSERT(p); p->set_refcount(1); }
 
 	/** Bind ptr to existing reference-counted object. */
-	explicit ptr(T &t) throw() : p(&t) { p->add_reference(); }
+	explicit ptr(T &t) throw() : p(&t) { count(stats::reference_copies); p->add_reference(); }
 
-	ptr(const ptr & other) throw() : p(other.p) { p->add_reference(); }
+	ptr(const ptr & other) throw() : p(other.p) { count(stats::reference_copies); p->add_reference(); }
 
 	~ptr()
 	{
@@ -83,6 +107,7 @@ public:
 		// NB2: Cache other.p, because if "other" is a subexpression of p,
 		//      deleting p will also invalidate "other".
 		T *otherp = other.p;
+		count(stats::reference_copies);
 		otherp->add_reference();
 		if (p->remove_reference() == 0)
 			delete p;
@@ -90,6 +115,16 @@ public:
 		return *this;
 	}
 
+	/** Exchange the objects of this and other without touching their
+	 *  reference counts, so both stay bound. */
+	ptr &operator=(ptr && other) throw()
+	{
+		// Our old object is released when other is destroyed.
+		count(stats::reference_moves);
+		swap(other);
+		return *this;
+	}
+
 	T &operator*() const throw() { return *p; }
 	T *operator->() const throw() { return p; }
 
@@ -100,9 +135,13 @@ public:
 	void makewritable()
 	{
 		if (p->get_refcount() > 1) {
+			stats::count(stats::duplications);
 			T *p2 = p->duplicate();
 			p2->set_refcount(1);
-			p->remove_reference();
+			// Another thread may have dropped its reference in the
+			// meantime, in which case we are the last owner.
+			if (p->remove_reference() == 0)
+				delete p;
 			p = p2;
 		}
 	}
@@ -145,6 +184,14 @@ public:
 	}
 
 private:
+	/** Count a copy or move (see stats.h). */
+	static void count(stats::event e) throw()
+	{
+#ifdef GINAC_COUNT_REFERENCES
+		stats::count(e);
+#endif
+	}
+
 	T *p;
 };
 
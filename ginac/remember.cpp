@@ -158,7 +158,9 @@ bool remember_table::lookup_entry(function const & f, ex & result) const
 {
 	unsigned entry = f.gethash() & (table_size-1);
 	GINAC_ASSERT(entry<size());
-	return operator[](entry).lookup_entry(f,result);
+	const bool found = operator[](entry).lookup_entry(f,result);
+	stats::count(found ? stats::remember_hits : stats::remember_misses);
+	return found;
 }
 
 void remember_table::add_entry(function const & f, ex const & result)
@@ -0,0 +1,277 @@
+/** @file sparse_matrix.cpp
+ *
+ *  Implementation of sparse matrices of polynomials and of the elimination
+ *  of sparse linear systems with Markowitz pivoting. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "sparse_matrix.h"
+#include "add.h"
+#include "normal.h"
+#include "numeric.h"
+#include "operators.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <set>
+
+namespace GiNaC {
+
+namespace {
+
+/** Number of the shortest rows searched for the pivot with the smallest
+ *  Markowitz cost. */
+const unsigned pivot_search_rows = 4;
+
+struct column_less {
+	bool operator()(const sparse_matrix::entry & e, unsigned c) const { return e.first < c; }
+};
+
+/** Return the element of row r in column c, which must be non-zero. */
+const ex & element(const sparse_matrix::row_type & r, unsigned c)
+{
+	sparse_matrix::row_type::const_iterator i = std::lower_bound(r.begin(), r.end(), c, column_less());
+	GINAC_ASSERT(i != r.end() && i->first == c);
+	return i->second;
+}
+
+/** Check whether row r has a non-zero element in column c. */
+bool has_column(const sparse_matrix::row_type & r, unsigned c)
+{
+	sparse_matrix::row_type::const_iterator i = std::lower_bound(r.begin(), r.end(), c, column_less());
+	return i != r.end() && i->first == c;
+}
+
+} // anonymous namespace
+
+/** Append row r, whose elements must be sorted by column.  The row is
+ *  multiplied by the least common multiple of the denominators of its
+ *  elements, which makes them polynomials.  Returns false, without adding
+ *  the row, if some element is not a rational function with rational
+ *  coefficients.  The elements of r are destroyed. */
+bool sparse_matrix::add_row(row_type & r)
+{
+	exvector num, den;
+	num.reserve(r.size());
+	den.reserve(r.size());
+	ex l = _ex1;
+	for (row_type::const_iterator i = r.begin(); i != r.end(); ++i) {
+		const ex nd = i->second.numer_denom();
+		if (!nd.op(0).info(info_flags::rational_polynomial) ||
+		    !nd.op(1).info(info_flags::rational_polynomial))
+			return false;
+		num.push_back(nd.op(0));
+		den.push_back(nd.op(1));
+		l = lcm(l, nd.op(1));
+	}
+
+	row_type p;
+	p.reserve(r.size());
+	for (size_t i = 0; i < r.size(); ++i) {
+		ex q;
+		divide(l, den[i], q);
+		const ex e = (num[i] * q).expand();
+		if (!e.is_zero())
+			p.push_back(entry(r[i].first, e));
+	}
+	remove_content(p);
+
+	nonzero += p.size();
+	m.push_back(row_type());
+	m.back().swap(p);
+	return true;
+}
+
+/** Solve the linear system whose augmented matrix is this, i.e. the first
+ *  n columns are the coefficients and the remaining q = cols()-n ones the
+ *  right hand sides.  The n x q solution matrix is stored in sol in
+ *  row-major order.  Unknowns which are not determined by the system are
+ *  given by the corresponding elements of vars (n x q, too).  Returns false
+ *  if the system is inconsistent.  The elements are destroyed.
+ *
+ *  The pivots are chosen to minimize the fill-in, with Markowitz' cost
+ *  (row length - 1) * (column length - 1) among the elements of the
+ *  shortest rows.  Rows are combined without fractions, and every row is
+ *  divided by the GCD of its elements afterwards. */
+bool sparse_matrix::solve(unsigned n, const exvector & vars, exvector & sol)
+{
+	GINAC_ASSERT(n <= ncols && vars.size() == n*(ncols-n));
+	const unsigned q = ncols - n;
+
+	// Active rows are the ones not used as pivot rows yet, ordered by
+	// length.  col_rows lists the rows which may have an element in the
+	// column, col_count the number of active rows which do.
+	std::set<std::pair<size_t, unsigned> > active;
+	std::vector<bool> is_active(m.size(), false);
+	std::vector<unsigned> col_count(n, 0);
+	std::vector<std::vector<unsigned> > col_rows(n);
+	for (unsigned r = 0; r < m.size(); ++r) {
+		if (m[r].empty())
+			continue;
+		if (m[r].front().first >= n)
+			return false;  // 0 == non-zero
+		active.insert(std::make_pair(m[r].size(), r));
+		is_active[r] = true;
+		for (row_type::const_iterator i = m[r].begin(); i != m[r].end() && i->first < n; ++i) {
+			++col_count[i->first];
+			col_rows[i->first].push_back(r);
+		}
+	}
+
+	std::vector<std::pair<unsigned, unsigned> > pivots;
+	std::vector<unsigned> fill;
+	while (!active.empty()) {
+		// Choose the pivot, preferring numbers among elements of equal cost.
+		unsigned r0 = 0, c0 = 0;
+		size_t best_cost = size_t(-1);
+		bool best_numeric = false;
+		unsigned searched = 0;
+		for (std::set<std::pair<size_t, unsigned> >::const_iterator a = active.begin();
+		     a != active.end() && searched < pivot_search_rows; ++a, ++searched) {
+			const row_type & row = m[a->second];
+			for (row_type::const_iterator i = row.begin(); i != row.end() && i->first < n; ++i) {
+				const size_t cost = (row.size() - 1) * (col_count[i->first] - 1);
+				const bool num = is_exactly_a<numeric>(i->second);
+				if (cost < best_cost || (cost == best_cost && num && !best_numeric)) {
+					best_cost = cost;
+					best_numeric = num;
+					r0 = a->second;
+					c0 = i->first;
+				}
+			}
+		}
+
+		active.erase(std::make_pair(m[r0].size(), r0));
+		is_active[r0] = false;
+		for (row_type::const_iterator i = m[r0].begin(); i != m[r0].end() && i->first < n; ++i)
+			--col_count[i->first];
+		pivots.push_back(std::make_pair(r0, c0));
+
+		// Eliminate column c0 from the active rows.
+		const std::vector<unsigned> & rows_c0 = col_rows[c0];
+		for (std::vector<unsigned>::const_iterator r = rows_c0.begin(); r != rows_c0.end(); ++r) {
+			row_type & row = m[*r];
+			if (!is_active[*r] || !has_column(row, c0))
+				continue;
+			active.erase(std::make_pair(row.size(), *r));
+			for (row_type::const_iterator i = row.begin(); i != row.end() && i->first < n; ++i)
+				--col_count[i->first];
+
+			fill.clear();
+			combine(row, m[r0], c0, n, fill);
+			for (std::vector<unsigned>::const_iterator c = fill.begin(); c != fill.end(); ++c)
+				col_rows[*c].push_back(*r);
+
+			if (row.empty()) {
+				is_active[*r] = false;
+				continue;
+			}
+			if (row.front().first >= n)
+				return false;
+			active.insert(std::make_pair(row.size(), *r));
+			for (row_type::const_iterator i = row.begin(); i != row.end() && i->first < n; ++i)
+				++col_count[i->first];
+		}
+		std::vector<unsigned>().swap(col_rows[c0]);
+	}
+
+	// Back substitution, the pivot rows still contain the columns of all
+	// later pivots.
+	sol = vars;
+	for (size_t k = pivots.size(); k-- != 0; ) {
+		const row_type & row = m[pivots[k].first];
+		const unsigned c0 = pivots[k].second;
+		const ex & piv = element(row, c0);
+		for (unsigned co = 0; co < q; ++co) {
+			exvector terms;
+			terms.reserve(row.size());
+			for (row_type::const_iterator i = row.begin(); i != row.end(); ++i) {
+				if (i->first < n) {
+					if (i->first != c0)
+						terms.push_back(-i->second * sol[i->first*q+co]);
+				} else if (i->first == n + co)
+					terms.push_back(i->second);
+			}
+			const ex s = (new add(terms))->setflag(status_flags::dynallocated);
+			sol[c0*q+co] = (s / piv).normal();
+		}
+	}
+	return true;
+}
+
+/** Replace row r2 by the combination of r2 and the pivot row r0 in which
+ *  column c0 vanishes, p*r2 - f*r0, where p and f are the elements in
+ *  column c0 divided by their GCD.  If p is one, only the elements in the
+ *  columns of r0 change.  The unknowns are the first n columns, those in
+ *  which r0 introduces new elements are appended to fill. */
+void sparse_matrix::combine(row_type & r2, const row_type & r0, unsigned c0, unsigned n, std::vector<unsigned> & fill) const
+{
+	ex p, f;
+	gcd(element(r0, c0), element(r2, c0), &p, &f);
+	const bool scale = !p.is_equal(_ex1);
+
+	row_type result;
+	result.reserve(r2.size() + r0.size());
+	row_type::const_iterator i = r2.begin(), j = r0.begin();
+	while (i != r2.end() || j != r0.end()) {
+		if (j == r0.end() || (i != r2.end() && i->first < j->first)) {
+			result.push_back(scale ? entry(i->first, (p * i->second).expand()) : *i);
+			++i;
+		} else if (i == r2.end() || j->first < i->first) {
+			result.push_back(entry(j->first, (-f * j->second).expand()));
+			if (j->first < n)
+				fill.push_back(j->first);
+			++j;
+		} else {
+			if (i->first != c0) {
+				const ex e = scale ? (p * i->second - f * j->second).expand()
+				                   : (i->second - f * j->second).expand();
+				if (!e.is_zero())
+					result.push_back(entry(i->first, e));
+			}
+			++i;
+			++j;
+		}
+	}
+
+	remove_content(result);
+	r2.swap(result);
+}
+
+/** Divide the elements of row r by their GCD. */
+void sparse_matrix::remove_content(row_type & r) const
+{
+	if (r.empty())
+		return;
+	ex g = r.front().second;
+	for (row_type::const_iterator i = r.begin() + 1; i != r.end(); ++i) {
+		if (g.is_equal(_ex1) || g.is_equal(_ex_1))
+			return;
+		g = gcd(g, i->second);
+	}
+	if (g.is_equal(_ex1) || g.is_equal(_ex_1))
+		return;
+	for (row_type::iterator i = r.begin(); i != r.end(); ++i) {
+		ex q;
+		divide(i->second, g, q);
+		i->second = q;
+	}
+}
+
+} // namespace GiNaC
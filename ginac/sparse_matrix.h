@@ -0,0 +1,62 @@
+/** @file sparse_matrix.h
+ *
+ *  Interface to sparse matrices of polynomials, used by lsolve() for large
+ *  sparse linear systems. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_SPARSE_MATRIX_H
+#define GINAC_SPARSE_MATRIX_H
+
+#include "ex.h"
+
+#include <utility>
+#include <vector>
+
+namespace GiNaC {
+
+/** Matrix stored as compressed rows, i.e. for every row the list of its
+ *  non-zero elements as (column, element) pairs sorted by column.  The
+ *  elements are expanded polynomials with rational coefficients. */
+class sparse_matrix {
+public:
+	typedef std::pair<unsigned, ex> entry;
+	typedef std::vector<entry> row_type;
+
+	explicit sparse_matrix(unsigned c) : ncols(c), nonzero(0) {}
+
+	bool add_row(row_type & r);
+	bool solve(unsigned n, const exvector & vars, exvector & sol);
+
+	unsigned rows() const { return m.size(); }
+	unsigned cols() const { return ncols; }
+	size_t nonzeros() const { return nonzero; }
+
+private:
+	void combine(row_type & r2, const row_type & r0, unsigned c0, unsigned n, std::vector<unsigned> & fill) const;
+	void remove_content(row_type & r) const;
+
+	std::vector<row_type> m;
+	unsigned ncols;
+	size_t nonzero;
+};
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_SPARSE_MATRIX_H
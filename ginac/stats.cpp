@@ -0,0 +1,171 @@
+/** @file stats.cpp
+ *
+ *  Implementation of the runtime statistics of GiNaC's core operations.
+ *
+ *  In thread-safe builds the event counters are incremented atomically and
+ *  the allocation counters are protected by a mutex.  Both only happen
+ *  while counting is switched on. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "stats.h"
+#include "basic.h"
+
+#include <iostream>
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+namespace GiNaC {
+namespace stats {
+
+bool stats_on = false;
+
+namespace {
+
+unsigned long event_count[num_events];
+
+// Class names are static strings, so their addresses serve as keys.
+typedef std::map<const char *, unsigned long> allocation_map;
+
+allocation_map & allocations()
+{
+	// Deliberately never destroyed: objects may be allocated during
+	// static destruction.
+	static allocation_map *m = new allocation_map;
+	return *m;
+}
+
+#ifdef GINAC_THREAD_SAFE
+pthread_mutex_t allocations_mutex = PTHREAD_MUTEX_INITIALIZER;
+inline void lock_allocations() { pthread_mutex_lock(&allocations_mutex); }
+inline void unlock_allocations() { pthread_mutex_unlock(&allocations_mutex); }
+#else
+inline void lock_allocations() {}
+inline void unlock_allocations() {}
+#endif
+
+const char *event_names[num_events] = {
+	"ex::compare() calls",
+	"ex::compare() calls on different objects",
+	"basic::compare() calls",
+	"basic::compare() calls with equal hash values",
+	"compare_same_type() calls",
+	"ex::is_equal() calls",
+	"ex::is_equal() calls on different objects",
+	"basic::is_equal() calls",
+	"basic::is_equal() calls with equal hash values",
+	"is_equal_same_type() calls",
+	"cached hash values used",
+	"hash values computed",
+	"evaluations",
+	"expansions",
+	"remember table hits",
+	"remember table misses",
+	"operand sequences copied",
+	"shared objects duplicated",
+	"reference copies",
+	"reference moves"
+};
+
+} // anonymous namespace
+
+void enable()
+{
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&stats_on, true, __ATOMIC_RELAXED);
+#else
+	stats_on = true;
+#endif
+}
+
+void disable()
+{
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&stats_on, false, __ATOMIC_RELAXED);
+#else
+	stats_on = false;
+#endif
+}
+
+void record(event e)
+{
+#ifdef GINAC_THREAD_SAFE
+	__atomic_fetch_add(&event_count[e], 1, __ATOMIC_RELAXED);
+#else
+	++event_count[e];
+#endif
+}
+
+void record_allocation(const basic & obj)
+{
+	const char *name = obj.class_name();
+	lock_allocations();
+	++allocations()[name];
+	unlock_allocations();
+}
+
+counters snapshot()
+{
+	counters c;
+	for (unsigned i = 0; i < num_events; ++i) {
+#ifdef GINAC_THREAD_SAFE
+		c.count[i] = __atomic_load_n(&event_count[i], __ATOMIC_RELAXED);
+#else
+		c.count[i] = event_count[i];
+#endif
+	}
+	lock_allocations();
+	for (allocation_map::const_iterator i = allocations().begin(); i != allocations().end(); ++i)
+		c.allocations[i->first] = i->second;
+	unlock_allocations();
+	return c;
+}
+
+void reset()
+{
+	for (unsigned i = 0; i < num_events; ++i) {
+#ifdef GINAC_THREAD_SAFE
+		// Increments by other threads at the same time may get lost.
+		__atomic_store_n(&event_count[i], 0, __ATOMIC_RELAXED);
+#else
+		event_count[i] = 0;
+#endif
+	}
+	lock_allocations();
+	allocations().clear();
+	unlock_allocations();
+}
+
+const char *event_name(event e)
+{
+	return event_names[e];
+}
+
+std::ostream & operator<<(std::ostream & os, const counters & c)
+{
+	for (unsigned i = 0; i < num_events; ++i)
+		os << event_names[i] << ": " << c.count[i] << std::endl;
+	for (std::map<std::string, unsigned long>::const_iterator i = c.allocations.begin(); i != c.allocations.end(); ++i)
+		os << "allocated " << i->first << " objects: " << i->second << std::endl;
+	return os;
+}
+
+} // namespace stats
+} // namespace GiNaC
@@ -0,0 +1,125 @@
+/** @file stats.h
+ *
+ *  Interface to the runtime statistics of GiNaC's core operations. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_STATS_H
+#define GINAC_STATS_H
+
+#include <iosfwd>
+#include <map>
+#include <string>
+
+namespace GiNaC {
+
+class basic;
+
+/** Counters of comparisons, hashing, evaluation and allocations, for
+ *  finding out where a computation spends its time.  Counting is off by
+ *  default; while it is off, every counting point costs a single test of a
+ *  global flag.  Copies and moves of ptr are so frequent that they are only
+ *  counted if GINAC_COUNT_REFERENCES is defined when compiling GiNaC (and
+ *  the program); otherwise reference_copies and reference_moves stay 0. */
+namespace stats {
+
+/** Counted events. */
+enum event {
+	compares,                 ///< ex::compare() calls
+	nontrivial_compares,      ///< ex::compare() calls on different objects
+	basic_compares,           ///< basic::compare() calls
+	compare_same_hashvalue,   ///< basic::compare() calls finding equal hash values
+	compare_same_type,        ///< compare_same_type() calls
+	is_equals,                ///< ex::is_equal() calls
+	nontrivial_is_equals,     ///< ex::is_equal() calls on different objects
+	basic_is_equals,          ///< basic::is_equal() calls
+	is_equal_same_hashvalue,  ///< basic::is_equal() calls finding equal hash values
+	is_equal_same_type,       ///< is_equal_same_type() calls
+	gethash_cached,           ///< basic::gethash() calls returning the cached value
+	gethash_computed,         ///< basic::gethash() calls computing the value
+	evals,                    ///< evaluations of objects wrapped into an ex
+	expands,                  ///< ex::expand() calls on not yet expanded objects
+	remember_hits,            ///< function values found in remember tables
+	remember_misses,          ///< function values not found in remember tables
+	sequence_copies,          ///< operand sequences copied to construct a sum, product or container
+	duplications,             ///< objects duplicated because they were shared when modified
+	reference_copies,         ///< copies of ptr (and thus ex), changing a reference count
+	reference_moves,          ///< moves of ptr (and thus ex), leaving the reference count alone
+	num_events
+};
+
+/** Values of all counters at some point in time. */
+struct counters {
+	unsigned long count[num_events];
+	std::map<std::string, unsigned long> allocations;  ///< heap-allocated objects by class name
+
+	unsigned long operator[](event e) const { return count[e]; }
+};
+
+/** Start counting. */
+void enable();
+
+/** Stop counting.  The counters keep their values. */
+void disable();
+
+extern bool stats_on;  ///< use is_enabled(), enable() and disable()
+
+/** Return whether counting is switched on. */
+inline bool is_enabled()
+{
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_load_n(&stats_on, __ATOMIC_RELAXED);
+#else
+	return stats_on;
+#endif
+}
+
+/** Return the current values of all counters. */
+counters snapshot();
+
+/** Set all counters to zero. */
+void reset();
+
+/** Return a short description of an event, as printed by operator<<. */
+const char *event_name(event e);
+
+/** Print all counters, one per line. */
+std::ostream & operator<<(std::ostream & os, const counters & c);
+
+void record(event e);
+void record_allocation(const basic & obj);
+
+/** Count an event, if counting is switched on. */
+inline void count(event e)
+{
+	if (is_enabled())
+		record(e);
+}
+
+/** Count the allocation of obj on the heap, if counting is switched on. */
+inline void count_allocation(const basic & obj)
+{
+	if (is_enabled())
+		record_allocation(obj);
+}
+
+} // namespace stats
+} // namespace GiNaC
+
+#endif // ndef GINAC_STATS_H
@@ -46,7 +46,7 @@ GINAC_IMPLEMENT_REGISTERED_CLASS_OPT(symbol, basic,
 
 // symbol
 
-symbol::symbol() : serial(next_serial++), name(""), TeX_name("")
+symbol::symbol() : serial(get_next_serial()), name(""), TeX_name("")
 {
 	setflag(status_flags::evaluated | status_flags::expanded);
 }
@@ -67,14 +67,14 @@ possymbol::possymbol() : realsymbol() { }
 
 // symbol
 
-symbol::symbol(const std::string & initname) : serial(next_serial++),
+symbol::symbol(const std::string & initname) : serial(get_next_serial()),
 	name(initname), TeX_name("")
 {
 	setflag(status_flags::evaluated | status_flags::expanded);
 }
 
 symbol::symbol(const std::string & initname, const std::string & texname) :
-	serial(next_serial++), name(initname), TeX_name(texname)
+	serial(get_next_serial()), name(initname), TeX_name(texname)
 {
 	setflag(status_flags::evaluated | status_flags::expanded);
 }
@@ -101,7 +101,7 @@ possymbol::possymbol(const std::string & initname, const std::string & texname)
 void symbol::read_archive(const archive_node &n, lst &sym_lst)
 {
 	inherited::read_archive(n, sym_lst);
-	serial = next_serial++;
+	serial = get_next_serial();
 	std::string tmp_name;
 	n.find_string("name", tmp_name);
 
@@ -344,6 +344,16 @@ static const std::string& get_default_TeX_name(const std::string& name)
 		return name;
 }
 
+/** Return a fresh serial number for a new symbol. */
+unsigned symbol::get_next_serial()
+{
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_fetch_add(&next_serial, 1, __ATOMIC_RELAXED);
+#else
+	return next_serial++;
+#endif
+}
+
 GINAC_BIND_UNARCHIVER(symbol);
 GINAC_BIND_UNARCHIVER(realsymbol);
 GINAC_BIND_UNARCHIVER(possymbol);
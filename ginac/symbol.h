@@ -85,6 +85,7 @@ protected:
 	mutable std::string name;        ///< printname of this symbol
 	std::string TeX_name;            ///< LaTeX name of this symbol
 private:
+	static unsigned get_next_serial();
 	static unsigned next_serial;
 };
 GINAC_DECLARE_UNARCHIVER(symbol);
@@ -0,0 +1,207 @@
+/** @file unique_table.cpp
+ *
+ *  Implementation of the hash-consing table of expressions.
+ *
+ *  The table holds weak references: registered objects carry the flag
+ *  status_flags::unique and remove themselves when they are deleted or
+ *  modified.  Equality tests are done without holding the table lock, on
+ *  candidates that were pinned by adding a reference, because comparing may
+ *  release subexpressions (see ex::share()), which in turn may unregister
+ *  other objects.  In thread-safe builds two threads may therefore register
+ *  equal objects at the same time; this costs some memory but is harmless,
+ *  since equality never relies on pointer identity alone. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "unique_table.h"
+#include "add.h"
+#include "function.h"
+#include "mul.h"
+#include "pool_alloc.h"
+#include "power.h"
+
+#include <vector>
+#ifdef GINAC_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+namespace GiNaC {
+
+bool hash_consing_on = false;
+
+namespace {
+
+struct table_entry {
+	const basic *obj;
+	unsigned hash;
+	table_entry *next;
+};
+
+/** Chained hash table of weak references, indexed by the hash values of
+ *  the objects. */
+class unique_table {
+public:
+	unique_table() : buckets(1024, static_cast<table_entry *>(0)), count(0) {}
+
+	/** Pin all registered objects with hash value h. */
+	template <class Out> void find(unsigned h, Out & candidates) const
+	{
+		for (const table_entry *e = buckets[h & (buckets.size() - 1)]; e; e = e->next) {
+			if (e->hash != h)
+				continue;
+			basic *b = const_cast<basic *>(e->obj);
+			// The object may be about to be deleted by another thread.
+			if (b->try_add_reference()) {
+				candidates.push_back(ptr<basic>(*b));
+				b->remove_reference();
+			}
+		}
+	}
+
+	void insert(const basic & obj, unsigned h)
+	{
+		if (count >= buckets.size())
+			grow();
+		table_entry *e = static_cast<table_entry *>(pool_allocate(sizeof(table_entry)));
+		e->obj = &obj;
+		e->hash = h;
+		table_entry *& head = buckets[h & (buckets.size() - 1)];
+		e->next = head;
+		head = e;
+		++count;
+	}
+
+	void remove(const basic & obj, unsigned h)
+	{
+		for (table_entry **pe = &buckets[h & (buckets.size() - 1)]; *pe; pe = &(*pe)->next) {
+			if ((*pe)->obj == &obj) {
+				table_entry *e = *pe;
+				*pe = e->next;
+				pool_deallocate(e, sizeof(table_entry));
+				--count;
+				return;
+			}
+		}
+	}
+
+	size_t size() const { return count; }
+
+private:
+	void grow()
+	{
+		std::vector<table_entry *> old(2 * buckets.size(), static_cast<table_entry *>(0));
+		old.swap(buckets);
+		for (size_t i = 0; i < old.size(); ++i) {
+			for (table_entry *e = old[i]; e; ) {
+				table_entry *next = e->next;
+				table_entry *& head = buckets[e->hash & (buckets.size() - 1)];
+				e->next = head;
+				head = e;
+				e = next;
+			}
+		}
+	}
+
+	std::vector<table_entry *> buckets;  ///< size is a power of two
+	size_t count;
+};
+
+unique_table & the_table()
+{
+	// Deliberately never destroyed: registered objects may be deleted
+	// during static destruction.
+	static unique_table *table = new unique_table;
+	return *table;
+}
+
+#ifdef GINAC_THREAD_SAFE
+pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+inline void lock_table() { pthread_mutex_lock(&table_mutex); }
+inline void unlock_table() { pthread_mutex_unlock(&table_mutex); }
+#else
+inline void lock_table() {}
+inline void unlock_table() {}
+#endif
+
+typedef std::vector<ptr<basic>, pool_allocator<ptr<basic> > > candidate_vector;
+
+} // anonymous namespace
+
+void set_hash_consing(bool on)
+{
+#ifdef GINAC_THREAD_SAFE
+	__atomic_store_n(&hash_consing_on, on, __ATOMIC_RELAXED);
+#else
+	hash_consing_on = on;
+#endif
+}
+
+size_t hash_consing_table_size()
+{
+	lock_table();
+	const size_t n = the_table().size();
+	unlock_table();
+	return n;
+}
+
+bool is_hash_consable(const basic & obj)
+{
+	return is_exactly_a<add>(obj) || is_exactly_a<mul>(obj) ||
+	       is_exactly_a<power>(obj) || is_exactly_a<function>(obj);
+}
+
+ptr<basic> unique_instance(const basic & obj)
+{
+	GINAC_ASSERT(obj.flags & status_flags::evaluated);
+	const unsigned h = obj.gethash();
+
+	candidate_vector candidates;
+	lock_table();
+	the_table().find(h, candidates);
+	unlock_table();
+	for (candidate_vector::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
+		if ((*i)->is_equal(obj))
+			return *i;
+	}
+
+	basic *b;
+	if (obj.flags & status_flags::dynallocated)
+		b = const_cast<basic *>(&obj);
+	else {
+		b = obj.duplicate();
+		b->setflag(status_flags::dynallocated);
+	}
+	ptr<basic> result(*b);
+	lock_table();
+	b->setflag(status_flags::unique);
+	the_table().insert(*b, h);
+	unlock_table();
+	return result;
+}
+
+void unregister_unique(const basic & obj)
+{
+	const unsigned h = obj.gethash();
+	lock_table();
+	the_table().remove(obj, h);
+	obj.clearflag(status_flags::unique);
+	unlock_table();
+}
+
+} // namespace GiNaC
@@ -0,0 +1,72 @@
+/** @file unique_table.h
+ *
+ *  Interface to the hash-consing table of expressions. */
+
+/*
+ *  GiNaC Copyright (C) 1999-2014 Johannes Gutenberg University Mainz, Germany
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef GINAC_UNIQUE_TABLE_H
+#define GINAC_UNIQUE_TABLE_H
+
+#include "ptr.h"
+
+#include <cstddef> // for size_t
+
+namespace GiNaC {
+
+class basic;
+
+/** Switch hash-consing on or off (it is off by default).  While it is on,
+ *  every evaluated sum, product, power and function that is wrapped into an
+ *  ex is looked up in a table of all such objects alive, and an existing
+ *  equal one is used instead of the new one, at the price of a table lookup
+ *  for every new object.  Whether this saves memory or time depends on how
+ *  often subexpressions recur; the timing programs in check/ switch it on
+ *  if the environment variable GINAC_HASH_CONSING is set, for comparison.
+ *  Objects created while hash-consing was off are never registered. */
+void set_hash_consing(bool on);
+
+extern bool hash_consing_on;  ///< use get_hash_consing() and set_hash_consing()
+
+/** Return whether hash-consing is switched on. */
+inline bool get_hash_consing()
+{
+#ifdef GINAC_THREAD_SAFE
+	return __atomic_load_n(&hash_consing_on, __ATOMIC_RELAXED);
+#else
+	return hash_consing_on;
+#endif
+}
+
+/** Return the number of objects currently registered in the table. */
+size_t hash_consing_table_size();
+
+/** Check whether objects of the class of obj are hash-consed. */
+bool is_hash_consable(const basic & obj);
+
+/** Return an object equal to the evaluated object obj: either one already
+ *  registered or obj itself (copied to the heap if necessary), which is
+ *  then registered.  Used by ex::construct_from_basic(). */
+ptr<basic> unique_instance(const basic & obj);
+
+/** Remove obj from the table, called when it is deleted or modified. */
+void unregister_unique(const basic & obj);
+
+} // namespace GiNaC
+
+#endif // ndef GINAC_UNIQUE_TABLE_H